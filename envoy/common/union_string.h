@@ -117,6 +117,18 @@ public:
                    absl::get<InlinedStringVector>(buffer_).begin(), unary_op);
   }
 
+  /**
+   * Transforms the inlined vector data in place using the given BufferOperation, which is passed
+   * a pointer to the data and its size. Unlike inlineTransform(), this lets the operation process
+   * many characters at a time.
+   * @param buffer_op the operation to be performed on the data.
+   */
+  template <typename BufferOperation> void inlineTransformBuffer(BufferOperation&& buffer_op) {
+    ASSERT(type() == Type::Inline);
+    InlinedStringVector& data = absl::get<InlinedStringVector>(buffer_);
+    buffer_op(data.data(), data.size());
+  }
+
   /**
    * Trim trailing whitespaces from the InlinedString. Only supported by the "Inline" InlinedString
    * representation.
@@ -701,6 +701,18 @@ public:
    * will be canceled immediately.
    */
   virtual bool hedgeOnPerTryTimeout() const PURE;
+
+  /**
+   * @return the percentile of the recent response times of the upstream cluster after which a
+   * hedged request should be sent, if hedging on the response time is enabled.
+   */
+  virtual absl::optional<double> hedgeOnResponseTimePercentile() const PURE;
+
+  /**
+   * @return the largest percentage of the recent requests of the upstream cluster that may be
+   * hedged on the response time.
+   */
+  virtual double hedgeBudgetPercent() const PURE;
 };
 
 class MetadataMatchCriterion {
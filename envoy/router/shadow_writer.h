@@ -4,16 +4,44 @@
 #include <memory>
 #include <string>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/http/async_client.h"
+#include "envoy/http/header_map.h"
 #include "envoy/http/message.h"
 
 namespace Envoy {
 namespace Router {
 
 /**
- * Interface used to shadow complete requests to an alternate upstream cluster in a "fire and
- * forget" fashion. Right now this interface takes a fully buffered request and cannot be used for
- * streaming. This is sufficient for current use cases.
+ * A request being streamed to a shadow cluster. The stream is valid until the request is ended by
+ * sending data with end_stream set, sending trailers or resetting it. The response is discarded.
+ */
+class ShadowStream {
+public:
+  virtual ~ShadowStream() = default;
+
+  /**
+   * Send request body data to the shadow. The data is drained.
+   * @param data supplies the data to send.
+   * @param end_stream supplies whether this is the last data of the request.
+   */
+  virtual void sendData(Buffer::Instance& data, bool end_stream) PURE;
+
+  /**
+   * Send the request trailers to the shadow, which ends the request.
+   * @param trailers supplies the trailers to send.
+   */
+  virtual void sendTrailers(const Http::RequestTrailerMap& trailers) PURE;
+
+  /**
+   * Abandon the request, e.g. if the downstream request is reset before it is complete.
+   */
+  virtual void reset() PURE;
+};
+
+/**
+ * Interface used to shadow requests to an alternate upstream cluster in a "fire and forget"
+ * fashion, either as fully buffered requests or by streaming the request body as it arrives.
  */
 class ShadowWriter {
 public:
@@ -27,6 +55,18 @@ public:
    */
   virtual void shadow(const std::string& cluster, Http::RequestMessagePtr&& request,
                       const Http::AsyncClient::RequestOptions& options) PURE;
+
+  /**
+   * Start streaming a request to a shadow cluster.
+   * @param cluster supplies the cluster name to shadow to.
+   * @param headers supplies the request headers.
+   * @param options supplies the options of the shadowed request.
+   * @return the stream to send the rest of the request to, or nullptr if the request can't be
+   *         shadowed, e.g. because the cluster doesn't exist.
+   */
+  virtual ShadowStream* streamingShadow(const std::string& cluster,
+                                        Http::RequestHeaderMapPtr&& headers,
+                                        const Http::AsyncClient::RequestOptions& options) PURE;
 };
 
 using ShadowWriterPtr = std::unique_ptr<ShadowWriter>;
@@ -39,6 +39,12 @@
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * Returns the ThreadLocalCluster of a cluster that was added or updated. When deferred cluster
+ * creation is enabled, calling it creates the thread local cluster if it does not exist yet.
+ */
+using ThreadLocalClusterCommand = const std::function<ThreadLocalCluster&()>;
+
 /**
  * ClusterUpdateCallbacks provide a way to expose Cluster lifecycle events in the
  * ClusterManager.
@@ -50,16 +56,26 @@ public:
   /**
    * onClusterAddOrUpdate is called when a new cluster is added or an existing cluster
    * is updated in the ClusterManager.
-   * @param cluster is the ThreadLocalCluster that represents the updated
-   * cluster.
+   * @param cluster_name is the name of the added or updated cluster.
+   * @param get_cluster returns the ThreadLocalCluster that represents the updated cluster. It
+   * should only be called by callbacks that are interested in the cluster, as it may create it.
    */
-  virtual void onClusterAddOrUpdate(ThreadLocalCluster& cluster) PURE;
+  virtual void onClusterAddOrUpdate(absl::string_view cluster_name,
+                                    ThreadLocalClusterCommand& get_cluster) PURE;
 
   /**
    * onClusterRemoval is called when a cluster is removed; the argument is the cluster name.
    * @param cluster_name is the name of the removed cluster.
    */
   virtual void onClusterRemoval(const std::string& cluster_name) PURE;
+
+  /**
+   * @param cluster_name is the name of a cluster.
+   * @return whether the callbacks keep a reference to the ThreadLocalCluster of the cluster. The
+   * ThreadLocalCluster of a cluster which is tracked by callbacks is never dropped when it is idle.
+   * Callbacks which don't override this are considered to track every cluster.
+   */
+  virtual bool tracksCluster(absl::string_view) const { return true; }
 };
 
 /**
@@ -129,6 +129,11 @@ public:
    */
   virtual Outlier::DetectorHostMonitor& outlierDetector() const PURE;
 
+  /**
+   * @return the host's retry token bucket, if the cluster has retry token buckets per host.
+   */
+  virtual RetryTokenBucketOptRef retryTokenBucket() const PURE;
+
   /**
    * @return the host's health checker monitor.
    */
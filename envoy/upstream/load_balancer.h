@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 
@@ -106,6 +107,31 @@ struct SelectedPoolAndConnection {
   const Network::Connection& connection_;
 };
 
+/**
+ * Callbacks used to inform a load balancer of the response times of the hosts it chose.
+ */
+class ResponseTimeCallbacks {
+public:
+  virtual ~ResponseTimeCallbacks() = default;
+
+  /**
+   * Called on the worker that chose the host when a response from the host is complete.
+   * @param host supplies the host that served the request.
+   * @param response_time supplies the time from the start of the upstream request to the end of
+   *        the response.
+   */
+  virtual void onHostResponseTime(const HostDescription& host,
+                                  std::chrono::microseconds response_time) PURE;
+
+  /**
+   * Called on the worker that chose the host when a request to the host is reset or times out
+   * before its response is complete.
+   * @param host supplies the host that the request was sent to.
+   * @param elapsed supplies the time from the start of the upstream request to its failure.
+   */
+  virtual void onHostFailure(const HostDescription& host, std::chrono::microseconds elapsed) PURE;
+};
+
 /**
  * Abstract load balancing interface.
  */
@@ -137,6 +163,14 @@ public:
    */
   virtual OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() PURE;
 
+  /**
+   * Returns callbacks that may be used to inform the load balancer of the response times of the
+   * hosts it chose. Load balancers which do not take response times into account will return
+   * nullopt.
+   * @return optional response time callbacks for this load balancer.
+   */
+  virtual OptRef<ResponseTimeCallbacks> responseTimeCallbacks() PURE;
+
   /**
    * Returns a specific pool and existing connection to be used for the specified host.
    *
@@ -177,6 +211,13 @@ public:
    * @return LoadBalancerPtr a new worker local load balancer.
    */
   virtual LoadBalancerPtr create(LoadBalancerParams params) PURE;
+
+  /**
+   * @return bool whether workers should create a new load balancer whenever the hosts of the
+   * cluster change. Load balancers that keep state across host updates follow the updates of
+   * the worker local priority set themselves and return false.
+   */
+  virtual bool recreateOnHostChange() const { return true; }
 };
 
 using LoadBalancerFactorySharedPtr = std::shared_ptr<LoadBalancerFactory>;
@@ -110,6 +110,12 @@ public:
    * and LocalOrigin type returns success rate for local origin errors.
    */
   virtual double successRate(SuccessRateMonitorType type) const PURE;
+
+  /**
+   * @return the number of consecutive failures of the host, i.e. the longest of its current
+   *         streaks of 5xx, gateway failures and local origin failures.
+   */
+  virtual uint32_t consecutiveFailures() const PURE;
 };
 
 using DetectorHostMonitorPtr = std::unique_ptr<DetectorHostMonitor>;
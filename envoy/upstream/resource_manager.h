@@ -2,11 +2,14 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 #include "envoy/common/pure.h"
 #include "envoy/common/resource.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -73,5 +76,67 @@ public:
   virtual uint64_t maxConnectionsPerHost() PURE;
 };
 
+/**
+ * A token bucket limiting the retries to a cluster or a host by its rate of successful responses:
+ * a retry takes a token, and a successful response puts back a fraction of one. It is shared by
+ * all the workers.
+ */
+class RetryTokenBucket {
+public:
+  virtual ~RetryTokenBucket() = default;
+
+  /**
+   * Takes a token for a retry.
+   * @return false if the bucket has no token left, in which case there should be no retry.
+   */
+  virtual bool tryTakeToken() PURE;
+
+  /**
+   * @return true if the bucket has a token left.
+   */
+  virtual bool hasToken() const PURE;
+
+  /**
+   * Puts back the fraction of a token earned by a successful response.
+   */
+  virtual void onSuccess() PURE;
+};
+
+using RetryTokenBucketPtr = std::unique_ptr<RetryTokenBucket>;
+using RetryTokenBucketOptRef = absl::optional<std::reference_wrapper<RetryTokenBucket>>;
+
+/**
+ * The retry token buckets of a cluster and of its hosts, and how the retries to the cluster avoid
+ * its hosts.
+ */
+class RetryTokenBuckets {
+public:
+  virtual ~RetryTokenBuckets() = default;
+
+  /**
+   * @return the bucket of the cluster, which every retry takes a token from.
+   */
+  virtual RetryTokenBucket& clusterBucket() PURE;
+
+  /**
+   * @return a new bucket for a host of the cluster, or nullptr if hosts don't have buckets.
+   */
+  virtual RetryTokenBucketPtr createHostBucket() const PURE;
+
+  /**
+   * @return the number of consecutive failures from which retries avoid a host, or 0 if they
+   *         don't avoid hosts by their failures.
+   */
+  virtual uint32_t hostFailureStreak() const PURE;
+
+  /**
+   * @return the number of hosts a retry may select to find one to not avoid.
+   */
+  virtual uint32_t hostSelectionMaxAttempts() const PURE;
+};
+
+using RetryTokenBucketsPtr = std::unique_ptr<RetryTokenBuckets>;
+using RetryTokenBucketsOptRef = absl::optional<std::reference_wrapper<RetryTokenBuckets>>;
+
 } // namespace Upstream
 } // namespace Envoy
@@ -654,6 +654,8 @@ public:
   COUNTER(upstream_cx_none_healthy)                                                                \
   COUNTER(upstream_cx_overflow)                                                                    \
   COUNTER(upstream_cx_pool_overflow)                                                               \
+  COUNTER(upstream_cx_preconnect_hit)                                                              \
+  COUNTER(upstream_cx_preconnect_waste)                                                            \
   COUNTER(upstream_cx_protocol_error)                                                              \
   COUNTER(upstream_cx_rx_bytes_total)                                                              \
   COUNTER(upstream_cx_total)                                                                       \
@@ -666,6 +668,9 @@ public:
   COUNTER(upstream_internal_redirect_succeeded_total)                                              \
   COUNTER(upstream_rq_cancelled)                                                                   \
   COUNTER(upstream_rq_completed)                                                                   \
+  COUNTER(upstream_rq_cross_worker)                                                                \
+  COUNTER(upstream_rq_hedge)                                                                       \
+  COUNTER(upstream_rq_hedge_overflow)                                                              \
   COUNTER(upstream_rq_maintenance_mode)                                                            \
   COUNTER(upstream_rq_max_duration_reached)                                                        \
   COUNTER(upstream_rq_pending_failure_eject)                                                       \
@@ -677,8 +682,10 @@ public:
   COUNTER(upstream_rq_retry)                                                                       \
   COUNTER(upstream_rq_retry_backoff_exponential)                                                   \
   COUNTER(upstream_rq_retry_backoff_ratelimited)                                                   \
+  COUNTER(upstream_rq_retry_host_skipped)                                                          \
   COUNTER(upstream_rq_retry_limit_exceeded)                                                        \
   COUNTER(upstream_rq_retry_overflow)                                                              \
+  COUNTER(upstream_rq_retry_token_bucket_exhausted)                                                \
   COUNTER(upstream_rq_retry_success)                                                               \
   COUNTER(upstream_rq_rx_reset)                                                                    \
   COUNTER(upstream_rq_timeout)                                                                     \
@@ -805,6 +812,45 @@ using ClusterTimeoutBudgetStatsPtr = std::unique_ptr<ClusterTimeoutBudgetStats>;
 using ClusterTimeoutBudgetStatsOptRef =
     absl::optional<std::reference_wrapper<ClusterTimeoutBudgetStats>>;
 
+/**
+ * Tracks the recent response times of the requests of a cluster, to hedge the requests that take
+ * longer than most. It is shared by all the workers.
+ */
+class ResponseTimeTracker {
+public:
+  virtual ~ResponseTimeTracker() = default;
+
+  /**
+   * Records the time a request took to receive its response headers.
+   * @param response_time supplies the response time of the request.
+   */
+  virtual void recordResponseTime(std::chrono::microseconds response_time) PURE;
+
+  /**
+   * @param percentile supplies the percentile, between 0 and 100.
+   * @return the percentile of the recent response times, or absl::nullopt if there are too few
+   *         recent requests for it to be meaningful.
+   */
+  virtual absl::optional<std::chrono::microseconds>
+  responseTimePercentile(double percentile) const PURE;
+
+  /**
+   * Counts a hedged request if the recent hedged requests are below a share of the recent
+   * requests.
+   * @param budget_percent supplies the share of the recent requests that may be hedged.
+   * @return true if the request may be hedged.
+   */
+  virtual bool tryHedge(double budget_percent) PURE;
+
+  /**
+   * Gives back a hedged request counted by tryHedge() which was not sent after all.
+   */
+  virtual void cancelHedge() PURE;
+};
+
+using ResponseTimeTrackerPtr = std::unique_ptr<ResponseTimeTracker>;
+using ResponseTimeTrackerOptRef = absl::optional<std::reference_wrapper<ResponseTimeTracker>>;
+
 /**
  * All extension protocol specific options returned by the method at
  *   NamedNetworkFilterConfigFactory::createProtocolOptions
@@ -890,6 +936,12 @@ public:
    */
   virtual float peekaheadRatio() const PURE;
 
+  /**
+   * @return the window over which stream arrival rates are averaged if adaptive preconnecting is
+   *         enabled, absl::nullopt otherwise.
+   */
+  virtual const absl::optional<std::chrono::milliseconds> adaptivePreconnectWindow() const PURE;
+
   /**
    * @return soft limit on size of the cluster's connections read and write buffers.
    */
@@ -1049,6 +1101,12 @@ public:
    */
   virtual ResourceManager& resourceManager(ResourcePriority priority) const PURE;
 
+  /**
+   * @return absl::optional<std::reference_wrapper<RetryTokenBuckets>> the retry token buckets of
+   *         this cluster and of its hosts, if configured.
+   */
+  virtual RetryTokenBucketsOptRef retryTokenBuckets() const PURE;
+
   /**
    * @return TransportSocketMatcher& the transport socket matcher associated
    * factory.
@@ -1098,6 +1156,12 @@ public:
    */
   virtual ClusterTimeoutBudgetStatsOptRef timeoutBudgetStats() const PURE;
 
+  /**
+   * @return absl::optional<std::reference_wrapper<ResponseTimeTracker>> the recent response times
+   * of the requests of this cluster, if tracked.
+   */
+  virtual ResponseTimeTrackerOptRef responseTimeTracker() const PURE;
+
   /**
    * @return std::shared_ptr<UpstreamLocalAddressSelector> as upstream local address selector.
    */
@@ -1131,6 +1195,11 @@ public:
    */
   virtual bool connectionPoolPerDownstreamConnection() const PURE;
 
+  /**
+   * @return whether the HTTP/2 connections to each host are shared by all the workers.
+   */
+  virtual bool shareHttp2ConnectionsAcrossWorkers() const PURE;
+
   /**
    * @return true if this cluster is configured to ignore hosts for the purpose of load balancing
    * computations until they have been health checked for the first time.
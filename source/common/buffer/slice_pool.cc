@@ -0,0 +1,183 @@
+#include "source/common/buffer/slice_pool.h"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "source/common/common/macros.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Buffer {
+
+namespace {
+
+// One size class per multiple of SizeClassGranularity up to MaxPooledSize.
+constexpr size_t NumSizeClasses = SlicePool::MaxPooledSize / SlicePool::SizeClassGranularity;
+
+// @return the size class of storage of size bytes, or NumSizeClasses if that size is not pooled.
+size_t sizeClass(uint64_t size) {
+  if (size == 0 || size > SlicePool::MaxPooledSize ||
+      size % SlicePool::SizeClassGranularity != 0) {
+    return NumSizeClasses;
+  }
+  return size / SlicePool::SizeClassGranularity - 1;
+}
+
+uint64_t classSize(size_t size_class) {
+  return (size_class + 1) * SlicePool::SizeClassGranularity;
+}
+
+std::atomic<uint64_t> max_bytes_per_thread{SlicePool::DefaultMaxBytesPerThread};
+
+// Only the owning thread writes the counters of a pool, so they are updated without atomic
+// read-modify-write operations. They are atomics so that stats() can read them from any thread.
+void add(std::atomic<uint64_t>& counter, int64_t delta) {
+  counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+class ThreadPool;
+
+struct Registry {
+  absl::Mutex mutex_;
+  absl::flat_hash_set<const ThreadPool*> pools_ ABSL_GUARDED_BY(mutex_);
+  // Counters of the pools of threads that have exited.
+  uint64_t exited_hits_ ABSL_GUARDED_BY(mutex_){};
+  uint64_t exited_misses_ ABSL_GUARDED_BY(mutex_){};
+};
+
+// The registry is never destroyed, as threads may exit after static destruction has started.
+Registry& registry() { MUTABLE_CONSTRUCT_ON_FIRST_USE(Registry); }
+
+class ThreadPool {
+public:
+  ThreadPool() {
+    Registry& registry = Buffer::registry();
+    absl::MutexLock lock(&registry.mutex_);
+    registry.pools_.insert(this);
+  }
+
+  ~ThreadPool() {
+    destroyed_ = true;
+    trim(0);
+    Registry& registry = Buffer::registry();
+    absl::MutexLock lock(&registry.mutex_);
+    registry.exited_hits_ += hits_.load(std::memory_order_relaxed);
+    registry.exited_misses_ += misses_.load(std::memory_order_relaxed);
+    registry.pools_.erase(this);
+  }
+
+  // @return the pool of the calling thread, or nullptr if the thread is exiting and its pool has
+  //         already been destroyed.
+  static ThreadPool* get() {
+    if (destroyed_) {
+      return nullptr;
+    }
+    static thread_local ThreadPool pool;
+    return &pool;
+  }
+
+  uint8_t* allocate(size_t size_class, uint64_t size) {
+    std::vector<uint8_t*>& free_list = free_lists_[size_class];
+    if (free_list.empty()) {
+      add(misses_, 1);
+      return new uint8_t[size];
+    }
+    uint8_t* mem = free_list.back();
+    free_list.pop_back();
+    add(pooled_bytes_, -static_cast<int64_t>(size));
+    add(hits_, 1);
+    return mem;
+  }
+
+  void release(size_t size_class, uint8_t* mem, uint64_t size) {
+    const uint64_t max_bytes = max_bytes_per_thread.load(std::memory_order_relaxed);
+    if (pooled_bytes_.load(std::memory_order_relaxed) + size > max_bytes) {
+      delete[] mem;
+      trim(max_bytes);
+      return;
+    }
+    free_lists_[size_class].push_back(mem);
+    add(pooled_bytes_, size);
+  }
+
+  void addStats(SlicePool::Stats& stats) const {
+    stats.hits_ += hits_.load(std::memory_order_relaxed);
+    stats.misses_ += misses_.load(std::memory_order_relaxed);
+    stats.pooled_bytes_ += pooled_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Free pooled storage, largest size classes first, until at most max_bytes are pooled.
+  void trim(uint64_t max_bytes) {
+    for (size_t size_class = NumSizeClasses; size_class-- > 0;) {
+      std::vector<uint8_t*>& free_list = free_lists_[size_class];
+      const uint64_t size = classSize(size_class);
+      while (pooled_bytes_.load(std::memory_order_relaxed) > max_bytes && !free_list.empty()) {
+        delete[] free_list.back();
+        free_list.pop_back();
+        add(pooled_bytes_, -static_cast<int64_t>(size));
+      }
+    }
+  }
+
+private:
+  // Set once the pool of the thread is destroyed, so that storage released by thread local objects
+  // destroyed later goes back to the heap.
+  static thread_local bool destroyed_;
+
+  std::array<std::vector<uint8_t*>, NumSizeClasses> free_lists_;
+  std::atomic<uint64_t> pooled_bytes_{};
+  std::atomic<uint64_t> hits_{};
+  std::atomic<uint64_t> misses_{};
+};
+
+thread_local bool ThreadPool::destroyed_ = false;
+
+} // namespace
+
+uint8_t* SlicePool::allocate(uint64_t size) {
+  const size_t size_class = sizeClass(size);
+  if (size_class < NumSizeClasses) {
+    if (ThreadPool* pool = ThreadPool::get(); pool != nullptr) {
+      return pool->allocate(size_class, size);
+    }
+  }
+  return new uint8_t[size];
+}
+
+void SlicePool::release(uint8_t* mem, uint64_t size) {
+  const size_t size_class = sizeClass(size);
+  if (size_class < NumSizeClasses) {
+    if (ThreadPool* pool = ThreadPool::get(); pool != nullptr) {
+      pool->release(size_class, mem, size);
+      return;
+    }
+  }
+  delete[] mem;
+}
+
+void SlicePool::setMaxBytesPerThread(uint64_t max_bytes) {
+  max_bytes_per_thread = max_bytes;
+  // Allocations only take storage out of the pools, so the other threads free their excess when
+  // they next release storage.
+  if (ThreadPool* pool = ThreadPool::get(); pool != nullptr) {
+    pool->trim(max_bytes);
+  }
+}
+
+uint64_t SlicePool::maxBytesPerThread() { return max_bytes_per_thread; }
+
+SlicePool::Stats SlicePool::stats() {
+  Registry& registry = Buffer::registry();
+  absl::MutexLock lock(&registry.mutex_);
+  Stats stats{registry.exited_hits_, registry.exited_misses_, 0};
+  for (const ThreadPool* pool : registry.pools_) {
+    pool->addStats(stats);
+  }
+  return stats;
+}
+
+} // namespace Buffer
+} // namespace Envoy
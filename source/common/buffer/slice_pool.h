@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * A per-thread pool for the backing storage of Buffer::Slice. Released storage is kept in free
+ * lists per size class, so that a worker reading from sockets into buffers and draining them again
+ * recycles slice storage instead of going through the general purpose allocator. Storage may be
+ * released on a different thread than the one that allocated it, in which case it joins the pool
+ * of the releasing thread.
+ *
+ * Storage is pooled in size classes of multiples of SizeClassGranularity, the granularity of
+ * Slice::sliceSize(), up to MaxPooledSize. The primary size class is Slice::default_slice_size_,
+ * which read reservations use. Larger storage goes to the heap. Each thread pools at most
+ * maxBytesPerThread() bytes. The limit is lowered to zero while the shrink heap overload action is
+ * saturated, see Memory::HeapShrinker.
+ */
+class SlicePool {
+public:
+  struct Stats {
+    // Allocations of a pooled size served from a free list.
+    uint64_t hits_{};
+    // Allocations of a pooled size that went to the heap.
+    uint64_t misses_{};
+    // Bytes currently held in the free lists of all threads.
+    uint64_t pooled_bytes_{};
+  };
+
+  static constexpr uint64_t SizeClassGranularity = 4096;
+  static constexpr uint64_t MaxPooledSize = 65536;
+  static constexpr uint64_t DefaultMaxBytesPerThread = 1024 * 1024;
+
+  /**
+   * @param size supplies the number of bytes to allocate.
+   * @return storage of size bytes, which must be released with release().
+   */
+  static uint8_t* allocate(uint64_t size);
+
+  /**
+   * Return storage obtained from allocate() to the pool of the calling thread, or to the heap if
+   * the pool is full or does not pool that size.
+   * @param mem supplies the storage.
+   * @param size supplies the size the storage was allocated with.
+   */
+  static void release(uint8_t* mem, uint64_t size);
+
+  /**
+   * Set the number of bytes each thread may pool. The calling thread frees its excess right away,
+   * and the other threads pooling more than that free the excess the next time they release
+   * storage.
+   */
+  static void setMaxBytesPerThread(uint64_t max_bytes);
+  static uint64_t maxBytesPerThread();
+
+  /**
+   * @return the statistics of the pools of all threads, including threads that have exited.
+   */
+  static Stats stats();
+};
+
+} // namespace Buffer
+} // namespace Envoy
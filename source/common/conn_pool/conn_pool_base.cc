@@ -1,5 +1,7 @@
 #include "source/common/conn_pool/conn_pool_base.h"
 
+#include <cmath>
+
 #include "source/common/common/assert.h"
 #include "source/common/common/debug_recursion_checker.h"
 #include "source/common/network/transport_socket_options_impl.h"
@@ -96,9 +98,11 @@ bool ConnPoolImplBase::shouldCreateNewConnection(float global_preconnect_ratio)
     //
     // Local preconnect does not need to anticipate a stream. It is called as
     // new streams are established or torn down and simply attempts to maintain
-    // the correct ratio of streams and anticipated capacity.
+    // the correct ratio of streams and anticipated capacity, and the capacity
+    // for the streams adaptive preconnect expects.
     return shouldConnect(pending_streams_.size(), num_active_streams_, connecting_stream_capacity_,
-                         perUpstreamPreconnectRatio());
+                         perUpstreamPreconnectRatio()) ||
+           shouldAdaptivePreconnect();
   }
 }
 
@@ -106,6 +110,58 @@ float ConnPoolImplBase::perUpstreamPreconnectRatio() const {
   return host_->cluster().perUpstreamPreconnectRatio();
 }
 
+uint64_t ConnPoolImplBase::adaptivePreconnectStreams() const {
+  const absl::optional<std::chrono::milliseconds> window =
+      host_->cluster().adaptivePreconnectWindow();
+  if (!window.has_value() || connect_time_ == 0) {
+    return 0;
+  }
+  const double elapsed =
+      std::chrono::duration<double>(dispatcher_.approximateMonotonicTime() - last_stream_arrival_)
+          .count();
+  const double arrival_rate =
+      stream_arrival_rate_ * std::exp(-elapsed / std::chrono::duration<double>(*window).count());
+  // Limit the expected streams to the streams in use, so that at most twice the current demand is
+  // provisioned.
+  return std::min<uint64_t>(std::llround(arrival_rate * connect_time_),
+                            pending_streams_.size() + num_active_streams_);
+}
+
+bool ConnPoolImplBase::shouldAdaptivePreconnect() const {
+  const int64_t expected_streams = adaptivePreconnectStreams();
+  if (expected_streams == 0) {
+    return false;
+  }
+  // The capacity for new streams is the connecting capacity not claimed by pending streams plus
+  // the unused capacity of the ready connections. Stop counting once it is enough.
+  int64_t spare_capacity = static_cast<int64_t>(connecting_stream_capacity_) -
+                           static_cast<int64_t>(pending_streams_.size());
+  for (auto it = ready_clients_.begin();
+       it != ready_clients_.end() && spare_capacity < expected_streams; ++it) {
+    spare_capacity += (*it)->currentUnusedCapacity();
+  }
+  return spare_capacity < expected_streams;
+}
+
+void ConnPoolImplBase::recordStreamArrival(std::chrono::milliseconds window) {
+  // A count of the arrivals which decays exponentially with the window is a moving average of the
+  // arrival rate, which needs neither buckets nor timers.
+  const MonotonicTime now = dispatcher_.approximateMonotonicTime();
+  const double window_seconds = std::chrono::duration<double>(window).count();
+  const double elapsed = std::chrono::duration<double>(now - last_stream_arrival_).count();
+  stream_arrival_rate_ =
+      stream_arrival_rate_ * std::exp(-elapsed / window_seconds) + 1 / window_seconds;
+  last_stream_arrival_ = now;
+}
+
+void ConnPoolImplBase::recordConnectTime(const ActiveClient& client) {
+  const double connect_time =
+      std::chrono::duration<double>(dispatcher_.approximateMonotonicTime() -
+                                    client.connect_start_time_)
+          .count();
+  connect_time_ = connect_time_ == 0 ? connect_time : 0.75 * connect_time_ + 0.25 * connect_time;
+}
+
 ConnPoolImplBase::ConnectionResult ConnPoolImplBase::tryCreateNewConnections() {
   ASSERT(!is_draining_for_deletion_);
   ConnPoolImplBase::ConnectionResult result;
@@ -152,6 +208,9 @@ ConnPoolImplBase::tryCreateNewConnection(float global_preconnect_ratio) {
     ASSERT(std::numeric_limits<uint64_t>::max() - connecting_stream_capacity_ >=
            static_cast<uint64_t>(client->currentUnusedCapacity()));
     ASSERT(client->real_host_description_);
+    // The connection is created ahead of demand if the connecting capacity already covers all
+    // pending streams.
+    client->preconnected_ = pending_streams_.size() <= connecting_stream_capacity_;
     // Increase the connecting capacity to reflect the streams this connection can serve.
     incrConnectingAndConnectedStreamCapacity(client->currentUnusedCapacity(), *client);
     LinkedList::moveIntoList(std::move(client), owningList(client->state()));
@@ -180,6 +239,10 @@ void ConnPoolImplBase::attachStreamToClient(Envoy::ConnectionPool::ActiveClient&
     return;
   }
   ENVOY_CONN_LOG(debug, "creating stream", client);
+  if (client.preconnected_) {
+    client.preconnected_ = false;
+    traffic_stats.upstream_cx_preconnect_hit_.inc();
+  }
 
   // Latch capacity before updating remaining streams.
   uint64_t capacity = client.currentUnusedCapacity();
@@ -257,6 +320,12 @@ ConnectionPool::Cancellable* ConnPoolImplBase::newStreamImpl(AttachContext& cont
   ASSERT(!is_draining_for_deletion_);
   ASSERT(!deferred_deleting_);
 
+  const absl::optional<std::chrono::milliseconds> adaptive_preconnect_window =
+      host_->cluster().adaptivePreconnectWindow();
+  if (adaptive_preconnect_window.has_value()) {
+    recordStreamArrival(adaptive_preconnect_window.value());
+  }
+
   ASSERT(static_cast<ssize_t>(connecting_stream_capacity_) ==
          connectingCapacity(connecting_clients_) +
              connectingCapacity(early_data_clients_)); // O(n) debug check.
@@ -484,6 +553,11 @@ void ConnPoolImplBase::onConnectionEvent(ActiveClient& client, absl::string_view
     ENVOY_CONN_LOG(debug, "client disconnected, failure reason: {}", client, failure_reason);
 
     Envoy::Upstream::reportUpstreamCxDestroy(host_, event);
+    if (client.preconnected_) {
+      // The connection was created ahead of demand, but never served a stream.
+      client.preconnected_ = false;
+      host_->cluster().trafficStats()->upstream_cx_preconnect_waste_.inc();
+    }
     const bool incomplete_stream = client.closingWithIncompleteStream();
     if (incomplete_stream) {
       Envoy::Upstream::reportUpstreamCxDestroyActiveRequest(host_, event);
@@ -566,6 +640,9 @@ void ConnPoolImplBase::onConnectionEvent(ActiveClient& client, absl::string_view
     client.has_handshake_completed_ = true;
     client.conn_connect_ms_->complete();
     client.conn_connect_ms_.reset();
+    if (host_->cluster().adaptivePreconnectWindow().has_value()) {
+      recordConnectTime(client);
+    }
     if (client.state() == ActiveClient::State::Connecting ||
         client.state() == ActiveClient::State::ReadyForEarlyData) {
       transitionActiveClientState(client,
@@ -647,8 +724,14 @@ bool ConnPoolImplBase::connectingConnectionIsExcess(const ActiveClient& client)
   // If preconnect ratio is set, it also factors in the anticipated load based on both queued
   // streams and active streams, and makes sure the connecting capacity would still be sufficient to
   // serve that even with the most recent client removed.
+  //
+  // If adaptive preconnect is enabled, the remaining connecting capacity must also cover the
+  // streams it expects.
   return (pending_streams_.size() + num_active_streams_) * perUpstreamPreconnectRatio() <=
-         (connecting_stream_capacity_ - client.currentUnusedCapacity() + num_active_streams_);
+             (connecting_stream_capacity_ - client.currentUnusedCapacity() +
+              num_active_streams_) &&
+         static_cast<int64_t>(connecting_stream_capacity_) - client.currentUnusedCapacity() >=
+             static_cast<int64_t>(pending_streams_.size() + adaptivePreconnectStreams());
 }
 
 void ConnPoolImplBase::onPendingStreamCancel(PendingStream& stream,
@@ -765,6 +848,9 @@ ActiveClient::ActiveClient(ConnPoolImplBase& parent, uint32_t lifetime_stream_li
       parent_.host()->cluster().trafficStats()->upstream_cx_length_ms_,
       parent_.dispatcher().timeSource());
   connect_timer_->enableTimer(parent_.host()->cluster().connectTimeout());
+  if (parent_.host()->cluster().adaptivePreconnectWindow().has_value()) {
+    connect_start_time_ = parent_.dispatcher().approximateMonotonicTime();
+  }
   parent_.host()->stats().cx_total_.inc();
   parent_.host()->stats().cx_active_.inc();
   parent_.host()->cluster().trafficStats()->upstream_cx_total_.inc();
@@ -143,8 +143,12 @@ public:
   Stats::TimespanPtr conn_length_;
   Event::TimerPtr connect_timer_;
   Event::TimerPtr connection_duration_timer_;
+  // The time the connection was created, to track how long connecting takes.
+  MonotonicTime connect_start_time_;
   bool resources_released_{false};
   bool timed_out_{false};
+  // True if the connection was created ahead of demand and has not served a stream yet.
+  bool preconnected_{false};
   // TODO(danzh) remove this once http codec exposes the handshake state for h3.
   bool has_handshake_completed_{false};
 
@@ -342,6 +346,14 @@ protected:
 
   float perUpstreamPreconnectRatio() const;
 
+  // Returns the number of streams expected to arrive while a new connection is established, based
+  // on the recent stream arrival rate and connect times, if adaptive preconnect is enabled.
+  uint64_t adaptivePreconnectStreams() const;
+
+  // A helper function which determines if adaptive preconnect needs more connections for the
+  // streams expected to arrive.
+  bool shouldAdaptivePreconnect() const;
+
   ConnectionPool::Cancellable*
   addPendingStream(Envoy::ConnectionPool::PendingStreamPtr&& pending_stream) {
     LinkedList::moveIntoList(std::move(pending_stream), pending_streams_);
@@ -393,6 +405,10 @@ private:
   // Prerequisite: the given clients shouldn't be idle.
   void drainClients(std::list<ActiveClientPtr>& clients);
 
+  // Update the moving averages used by adaptive preconnect.
+  void recordStreamArrival(std::chrono::milliseconds window);
+  void recordConnectTime(const ActiveClient& client);
+
   std::list<PendingStreamPtr> pending_streams_;
 
   // The number of streams currently attached to clients.
@@ -405,6 +421,12 @@ private:
   // True iff this object is in the deferred delete list.
   bool deferred_deleting_{false};
 
+  // The moving average of the stream arrival rate in streams per second, as of the last arrival.
+  double stream_arrival_rate_{0};
+  MonotonicTime last_stream_arrival_;
+  // The moving average of the connect time in seconds, zero until the first connection is up.
+  double connect_time_{0};
+
   Event::SchedulableCallbackPtr upstream_ready_cb_;
   Common::DebugRecursionChecker recursion_checker_;
 };
@@ -117,6 +117,10 @@ private:
       return additional_request_chance_;
     }
     bool hedgeOnPerTryTimeout() const override { return false; }
+    absl::optional<double> hedgeOnResponseTimePercentile() const override {
+      return absl::nullopt;
+    }
+    double hedgeBudgetPercent() const override { return 0; }
 
     const envoy::type::v3::FractionalPercent additional_request_chance_;
   };
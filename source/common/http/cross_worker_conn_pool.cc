@@ -0,0 +1,704 @@
+#include "source/common/http/cross_worker_conn_pool.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/dump_state_utils.h"
+#include "source/common/event/deferred_task.h"
+#include "source/common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+MetadataMapVector copyMetadata(const MetadataMapVector& metadata_map_vector) {
+  MetadataMapVector copy;
+  copy.reserve(metadata_map_vector.size());
+  for (const auto& metadata_map : metadata_map_vector) {
+    copy.push_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  return copy;
+}
+
+// Moves the slices of the buffer into a new buffer which can be handed to another thread. When the
+// stream has a memory account, the data is copied and drained instead: moved slices keep their
+// account, which is not thread safe, and would then be charged and credited from the other thread.
+std::shared_ptr<Buffer::Instance> handOver(Buffer::Instance& data, bool accounted) {
+  auto buffer = std::make_shared<Buffer::OwnedImpl>();
+  if (accounted) {
+    buffer->add(data);
+    data.drain(data.length());
+  } else {
+    buffer->move(data);
+  }
+  return buffer;
+}
+
+} // namespace
+
+CrossWorkerPoolOwner::CrossWorkerPoolOwner(CrossWorkerConnPool& pool)
+    : pool_(&pool), dispatcher_(pool.dispatcher()) {}
+
+ConnectionPool::Instance* CrossWorkerPoolOwner::localPool() {
+  return pool_ != nullptr ? pool_->localPool() : nullptr;
+}
+
+void CrossWorkerPoolOwner::onRemoteStreamDone() {
+  ASSERT(remote_streams_.load() > 0);
+  --remote_streams_;
+  if (pool_ != nullptr) {
+    pool_->onRemoteStreamDone();
+  }
+}
+
+CrossWorkerPoolOwnerSharedPtr
+CrossWorkerConnPoolRegistry::ownerOrRegister(const Key& key,
+                                             const CrossWorkerPoolOwnerSharedPtr& candidate) {
+  absl::MutexLock lock(&mutex_);
+  std::weak_ptr<CrossWorkerPoolOwner>& entry = owners_[key];
+  CrossWorkerPoolOwnerSharedPtr owner = entry.lock();
+  if (owner == nullptr || owner->detached()) {
+    entry = candidate;
+    return candidate;
+  }
+  return owner;
+}
+
+void CrossWorkerConnPoolRegistry::unregister(const Key& key, const CrossWorkerPoolOwner& owner) {
+  absl::MutexLock lock(&mutex_);
+  auto it = owners_.find(key);
+  if (it == owners_.end()) {
+    return;
+  }
+  CrossWorkerPoolOwnerSharedPtr registered = it->second.lock();
+  if (registered == nullptr || registered.get() == &owner) {
+    owners_.erase(it);
+  }
+}
+
+CrossWorkerStream::CrossWorkerStream(CrossWorkerConnPool& pool,
+                                     CrossWorkerPoolOwnerSharedPtr owner,
+                                     ResponseDecoder& decoder,
+                                     ConnectionPool::Callbacks& callbacks,
+                                     const ConnectionPool::Instance::StreamOptions& options)
+    : pool_(&pool), worker_dispatcher_(pool.dispatcher()), host_(pool.host()),
+      owner_(std::move(owner)), options_(options), worker_(*this, decoder, callbacks),
+      owner_stream_(*this) {}
+
+void CrossWorkerStream::start() {
+  // Counted before the hand over, so that the owner does not go idle while the stream is on its
+  // way.
+  ++owner_->remote_streams_;
+  postToOwner([](OwnerStream& owner) { owner.start(); });
+}
+
+void CrossWorkerStream::onPoolDestroyed() {
+  pool_ = nullptr;
+  worker_.onPoolDestroyed();
+}
+
+void CrossWorkerStream::postToOwner(std::function<void(OwnerStream&)> event) {
+  owner_->dispatcher().post(
+      [self = shared_from_this(), event = std::move(event)]() { event(self->owner_stream_); });
+}
+
+void CrossWorkerStream::postToWorker(std::function<void(WorkerStream&)> event) {
+  worker_dispatcher_.post(
+      [self = shared_from_this(), event = std::move(event)]() { event(self->worker_); });
+}
+
+Status CrossWorkerStream::WorkerStream::encodeHeaders(const RequestHeaderMap& headers,
+                                                      bool end_stream) {
+  ASSERT(state_ == State::Active);
+  if (state_ != State::Active) {
+    return okStatus();
+  }
+  local_end_stream_ = end_stream;
+  // The caller keeps its headers, so the owner gets a copy. Encoding errors of the owner's codec
+  // surface as a reset of the stream.
+  auto copy = std::make_shared<RequestHeaderMapPtr>(createHeaderMap<RequestHeaderMapImpl>(headers));
+  parent_.postToOwner([copy, end_stream](OwnerStream& owner) {
+    owner.encodeHeaders(std::move(*copy), end_stream);
+  });
+  maybeDone();
+  return okStatus();
+}
+
+void CrossWorkerStream::WorkerStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  ASSERT(state_ == State::Active);
+  if (state_ != State::Active) {
+    return;
+  }
+  local_end_stream_ = true;
+  auto copy =
+      std::make_shared<RequestTrailerMapPtr>(createHeaderMap<RequestTrailerMapImpl>(trailers));
+  parent_.postToOwner([copy](OwnerStream& owner) { owner.encodeTrailers(std::move(*copy)); });
+  maybeDone();
+}
+
+void CrossWorkerStream::WorkerStream::enableTcpTunneling() {
+  if (state_ == State::Active) {
+    parent_.postToOwner([](OwnerStream& owner) { owner.enableTcpTunneling(); });
+  }
+}
+
+void CrossWorkerStream::WorkerStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(state_ == State::Active);
+  if (state_ != State::Active) {
+    return;
+  }
+  local_end_stream_ = end_stream;
+  auto buffer = handOver(data, account_ != nullptr);
+  parent_.postToOwner(
+      [buffer, end_stream](OwnerStream& owner) { owner.encodeData(*buffer, end_stream); });
+  maybeDone();
+}
+
+void CrossWorkerStream::WorkerStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  if (state_ != State::Active) {
+    return;
+  }
+  auto copy = std::make_shared<MetadataMapVector>(copyMetadata(metadata_map_vector));
+  parent_.postToOwner([copy](OwnerStream& owner) { owner.encodeMetadata(*copy); });
+}
+
+void CrossWorkerStream::WorkerStream::resetStream(StreamResetReason reason) {
+  if (state_ != State::Active) {
+    return;
+  }
+  done();
+  parent_.postToOwner([reason](OwnerStream& owner) { owner.resetStream(reason); });
+  // As with the codecs, a local reset raises the reset callbacks right away.
+  runResetCallbacks(reason);
+}
+
+void CrossWorkerStream::WorkerStream::readDisable(bool disable) {
+  if (state_ == State::Active) {
+    parent_.postToOwner([disable](OwnerStream& owner) { owner.readDisable(disable); });
+  }
+}
+
+void CrossWorkerStream::WorkerStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (state_ == State::Active) {
+    parent_.postToOwner([timeout](OwnerStream& owner) { owner.setFlushTimeout(timeout); });
+  }
+}
+
+void CrossWorkerStream::WorkerStream::cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) {
+  ASSERT(state_ == State::Pending);
+  if (state_ != State::Pending) {
+    return;
+  }
+  done();
+  parent_.postToOwner([cancel_policy](OwnerStream& owner) { owner.cancel(cancel_policy); });
+}
+
+void CrossWorkerStream::WorkerStream::onPoolReady(const ReadyInfo& info) {
+  if (state_ != State::Pending) {
+    // Cancelled while the owner created the stream. The owner resets it on the cancellation.
+    return;
+  }
+  state_ = State::Active;
+  buffer_limit_ = info.buffer_limit_;
+  connection_info_ = std::make_shared<Network::ConnectionInfoSetterImpl>(info.local_address_,
+                                                                         info.remote_address_);
+  connection_info_->setSslConnection(info.ssl_connection_);
+  if (info.connection_id_.has_value()) {
+    connection_info_->setConnectionID(info.connection_id_.value());
+  }
+  stream_info_ = std::make_unique<StreamInfo::StreamInfoImpl>(
+      parent_.worker_dispatcher_.timeSource(), connection_info_);
+  if (info.protocol_.has_value()) {
+    stream_info_->protocol(info.protocol_.value());
+  }
+
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->onPoolReady(*this, info.host_, *stream_info_, info.protocol_);
+}
+
+void CrossWorkerStream::WorkerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                    absl::string_view transport_failure_reason,
+                                                    Upstream::HostDescriptionConstSharedPtr host) {
+  if (state_ != State::Pending) {
+    return;
+  }
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  done();
+  callbacks->onPoolFailure(reason, transport_failure_reason, host);
+}
+
+void CrossWorkerStream::WorkerStream::onOwnerDetached() {
+  if (state_ != State::Pending) {
+    return;
+  }
+  CrossWorkerConnPool* pool = parent_.pool_;
+  ASSERT(pool != nullptr);
+  if (pool->draining()) {
+    onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                  "cross worker pool draining", parent_.host_);
+    return;
+  }
+  // The owner was drained or went idle while the stream was handed over, so the stream goes to
+  // the new owner, which may be this worker.
+  parent_.owner_ = pool->currentOwner();
+  parent_.start();
+}
+
+void CrossWorkerStream::WorkerStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  if (state_ == State::Active) {
+    decoder_.decode1xxHeaders(std::move(headers));
+  }
+}
+
+void CrossWorkerStream::WorkerStream::decodeHeaders(ResponseHeaderMapPtr&& headers,
+                                                    bool end_stream) {
+  if (state_ != State::Active) {
+    return;
+  }
+  remote_end_stream_ = end_stream;
+  decoder_.decodeHeaders(std::move(headers), end_stream);
+  maybeDone();
+}
+
+void CrossWorkerStream::WorkerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (state_ != State::Active) {
+    return;
+  }
+  remote_end_stream_ = end_stream;
+  decoder_.decodeData(data, end_stream);
+  maybeDone();
+}
+
+void CrossWorkerStream::WorkerStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  if (state_ != State::Active) {
+    return;
+  }
+  remote_end_stream_ = true;
+  decoder_.decodeTrailers(std::move(trailers));
+  maybeDone();
+}
+
+void CrossWorkerStream::WorkerStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  if (state_ == State::Active) {
+    decoder_.decodeMetadata(std::move(metadata_map));
+  }
+}
+
+void CrossWorkerStream::WorkerStream::onResetStream(StreamResetReason reason,
+                                                    absl::string_view transport_failure_reason) {
+  if (state_ != State::Active) {
+    return;
+  }
+  details_ = std::string(transport_failure_reason);
+  done();
+  runResetCallbacks(reason);
+}
+
+void CrossWorkerStream::WorkerStream::onPoolDestroyed() {
+  switch (state_) {
+  case State::Pending:
+    parent_.postToOwner([](OwnerStream& owner) {
+      owner.cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    });
+    onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                  "cross worker pool destroyed", parent_.host_);
+    break;
+  case State::Active:
+    resetStream(StreamResetReason::ConnectionTermination);
+    break;
+  case State::Done:
+    break;
+  }
+}
+
+void CrossWorkerStream::WorkerStream::releaseState() {
+  stream_info_.reset();
+  connection_info_.reset();
+  account_.reset();
+  bytes_meter_.reset();
+}
+
+void CrossWorkerStream::WorkerStream::maybeDone() {
+  if (state_ == State::Active && local_end_stream_ && remote_end_stream_) {
+    done();
+  }
+}
+
+void CrossWorkerStream::WorkerStream::done() {
+  ASSERT(state_ != State::Done);
+  state_ = State::Done;
+  callbacks_ = nullptr;
+  if (parent_.pool_ != nullptr) {
+    parent_.pool_->onStreamDone(parent_);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  auto buffer = handOver(data, encoder_->getStream().account() != nullptr);
+  parent_.postToWorker(
+      [buffer, end_stream](WorkerStream& worker) { worker.decodeData(*buffer, end_stream); });
+  onEndStream(remote_end_stream_, end_stream);
+}
+
+void CrossWorkerStream::OwnerStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  auto moved = std::make_shared<MetadataMapPtr>(std::move(metadata_map));
+  parent_.postToWorker([moved](WorkerStream& worker) { worker.decodeMetadata(std::move(*moved)); });
+}
+
+void CrossWorkerStream::OwnerStream::decode1xxHeaders(ResponseHeaderMapPtr&& headers) {
+  auto moved = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  parent_.postToWorker(
+      [moved](WorkerStream& worker) { worker.decode1xxHeaders(std::move(*moved)); });
+}
+
+void CrossWorkerStream::OwnerStream::decodeHeaders(ResponseHeaderMapPtr&& headers,
+                                                   bool end_stream) {
+  auto moved = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  parent_.postToWorker([moved, end_stream](WorkerStream& worker) {
+    worker.decodeHeaders(std::move(*moved), end_stream);
+  });
+  onEndStream(remote_end_stream_, end_stream);
+}
+
+void CrossWorkerStream::OwnerStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  auto moved = std::make_shared<ResponseTrailerMapPtr>(std::move(trailers));
+  parent_.postToWorker([moved](WorkerStream& worker) { worker.decodeTrailers(std::move(*moved)); });
+  onEndStream(remote_end_stream_, true);
+}
+
+void CrossWorkerStream::OwnerStream::dumpState(std::ostream& os, int indent_level) const {
+  const char* spaces = spacesForLevel(indent_level);
+  os << spaces << "CrossWorkerStream::OwnerStream " << this << DUMP_MEMBER(local_end_stream_)
+     << DUMP_MEMBER(remote_end_stream_) << "\n";
+}
+
+void CrossWorkerStream::OwnerStream::onResetStream(StreamResetReason reason,
+                                                   absl::string_view transport_failure_reason) {
+  if (state_ != State::Active) {
+    return;
+  }
+  parent_.postToWorker([reason, details = std::string(transport_failure_reason)](
+                           WorkerStream& worker) { worker.onResetStream(reason, details); });
+  done();
+}
+
+void CrossWorkerStream::OwnerStream::onAboveWriteBufferHighWatermark() {
+  parent_.postToWorker([](WorkerStream& worker) { worker.onAboveWriteBufferHighWatermark(); });
+}
+
+void CrossWorkerStream::OwnerStream::onBelowWriteBufferLowWatermark() {
+  parent_.postToWorker([](WorkerStream& worker) { worker.onBelowWriteBufferLowWatermark(); });
+}
+
+void CrossWorkerStream::OwnerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                   absl::string_view transport_failure_reason,
+                                                   Upstream::HostDescriptionConstSharedPtr host) {
+  ASSERT(state_ == State::Pending);
+  parent_.postToWorker(
+      [reason, details = std::string(transport_failure_reason), host](WorkerStream& worker) {
+        worker.onPoolFailure(reason, details, host);
+      });
+  done();
+}
+
+void CrossWorkerStream::OwnerStream::onPoolReady(RequestEncoder& encoder,
+                                                 Upstream::HostDescriptionConstSharedPtr host,
+                                                 StreamInfo::StreamInfo& info,
+                                                 absl::optional<Protocol> protocol) {
+  ASSERT(state_ == State::Pending);
+  state_ = State::Active;
+  cancellable_ = nullptr;
+  encoder_ = &encoder;
+  Stream& stream = encoder.getStream();
+  stream.addCallbacks(*this);
+
+  ReadyInfo ready;
+  ready.host_ = std::move(host);
+  ready.protocol_ = protocol;
+  ready.local_address_ = stream.connectionInfoProvider().localAddress();
+  ready.remote_address_ = stream.connectionInfoProvider().remoteAddress();
+  ready.ssl_connection_ = info.downstreamAddressProvider().sslConnection();
+  ready.connection_id_ = info.downstreamAddressProvider().connectionID();
+  ready.buffer_limit_ = stream.bufferLimit();
+  parent_.postToWorker([ready = std::move(ready)](WorkerStream& worker) {
+    worker.onPoolReady(ready);
+  });
+}
+
+void CrossWorkerStream::OwnerStream::start() {
+  ASSERT(state_ == State::Idle);
+  CrossWorkerPoolOwner& owner = *parent_.owner_;
+  ConnectionPool::Instance* pool = owner.detached() ? nullptr : owner.localPool();
+  if (pool == nullptr) {
+    // Done before the hand back, after which the worker may pick another owner.
+    owner.onRemoteStreamDone();
+    parent_.postToWorker([](WorkerStream& worker) { worker.onOwnerDetached(); });
+    return;
+  }
+
+  state_ = State::Pending;
+  keep_alive_ = parent_.shared_from_this();
+  ConnectionPool::Cancellable* cancellable = pool->newStream(*this, *this, parent_.options_);
+  if (state_ == State::Pending) {
+    cancellable_ = cancellable;
+  }
+}
+
+void CrossWorkerStream::OwnerStream::encodeHeaders(RequestHeaderMapPtr&& headers,
+                                                   bool end_stream) {
+  if (state_ != State::Active) {
+    return;
+  }
+  request_headers_ = std::move(headers);
+  const Status status = encoder_->encodeHeaders(*request_headers_, end_stream);
+  if (!status.ok()) {
+    ENVOY_LOG(debug, "failed to encode request headers of a cross worker stream: {}",
+              status.message());
+    // This raises the reset callbacks, which hand the reset over to the worker.
+    encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+    return;
+  }
+  onEndStream(local_end_stream_, end_stream);
+}
+
+void CrossWorkerStream::OwnerStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (state_ != State::Active) {
+    return;
+  }
+  encoder_->encodeData(data, end_stream);
+  onEndStream(local_end_stream_, end_stream);
+}
+
+void CrossWorkerStream::OwnerStream::encodeTrailers(RequestTrailerMapPtr&& trailers) {
+  if (state_ != State::Active) {
+    return;
+  }
+  request_trailers_ = std::move(trailers);
+  encoder_->encodeTrailers(*request_trailers_);
+  onEndStream(local_end_stream_, true);
+}
+
+void CrossWorkerStream::OwnerStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  if (state_ == State::Active) {
+    encoder_->encodeMetadata(metadata_map_vector);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::enableTcpTunneling() {
+  if (state_ == State::Active) {
+    encoder_->enableTcpTunneling();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::readDisable(bool disable) {
+  if (state_ == State::Active) {
+    encoder_->getStream().readDisable(disable);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  if (state_ == State::Active) {
+    encoder_->getStream().setFlushTimeout(timeout);
+  }
+}
+
+void CrossWorkerStream::OwnerStream::cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) {
+  switch (state_) {
+  case State::Pending:
+    cancellable_->cancel(cancel_policy);
+    done();
+    break;
+  case State::Active:
+    // The stream became ready while the cancellation was handed over.
+    resetStream(StreamResetReason::LocalReset);
+    break;
+  case State::Idle:
+  case State::Done:
+    break;
+  }
+}
+
+void CrossWorkerStream::OwnerStream::resetStream(StreamResetReason reason) {
+  if (state_ == State::Pending) {
+    cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    return;
+  }
+  if (state_ != State::Active) {
+    return;
+  }
+  // The worker has already raised its reset callbacks.
+  Stream& stream = encoder_->getStream();
+  stream.removeCallbacks(*this);
+  done();
+  stream.resetStream(reason);
+}
+
+void CrossWorkerStream::OwnerStream::releaseState() {
+  request_headers_.reset();
+  request_trailers_.reset();
+}
+
+void CrossWorkerStream::OwnerStream::onEndStream(bool& end_stream_flag, bool end_stream) {
+  if (!end_stream || state_ != State::Active) {
+    return;
+  }
+  end_stream_flag = true;
+  if (local_end_stream_ && remote_end_stream_) {
+    done();
+  }
+}
+
+void CrossWorkerStream::OwnerStream::done() {
+  ASSERT(state_ == State::Pending || state_ == State::Active);
+  state_ = State::Done;
+  cancellable_ = nullptr;
+  encoder_ = nullptr;
+  CrossWorkerPoolOwner& owner = *parent_.owner_;
+  owner.onRemoteStreamDone();
+  Event::DeferredTaskUtil::deferredRun(owner.dispatcher(), [self = std::move(keep_alive_)]() {
+    self->owner_stream_.releaseState();
+  });
+}
+
+CrossWorkerConnPool::CrossWorkerConnPool(Event::Dispatcher& dispatcher,
+                                         Upstream::HostConstSharedPtr host,
+                                         CrossWorkerConnPoolRegistrySharedPtr registry,
+                                         CrossWorkerConnPoolRegistry::Key key,
+                                         LocalPoolFactory local_pool_factory)
+    : dispatcher_(dispatcher), host_(std::move(host)), registry_(std::move(registry)),
+      key_(std::move(key)), local_pool_factory_(std::move(local_pool_factory)) {
+  attach();
+}
+
+CrossWorkerConnPool::~CrossWorkerConnPool() {
+  destroying_ = true;
+  // The streams handed over to the owner must not outlive their pool on this worker.
+  auto streams = std::move(streams_);
+  streams_.clear();
+  for (auto& entry : streams) {
+    CrossWorkerStreamSharedPtr& stream = entry.second;
+    stream->onPoolDestroyed();
+    Event::DeferredTaskUtil::deferredRun(dispatcher_,
+                                         [stream]() { stream->releaseWorkerState(); });
+  }
+
+  detach();
+  if (isOwner()) {
+    // The streams of the other workers are reset by the destruction of the local pool, and must
+    // not call back into this pool when they are done.
+    owner_->pool_ = nullptr;
+    local_pool_.reset();
+  }
+}
+
+void CrossWorkerConnPool::deleteIsPending() {
+  // A pool pending deletion must not get new streams from the other workers.
+  detach();
+  if (isOwner()) {
+    local_pool_->deleteIsPending();
+  }
+}
+
+void CrossWorkerConnPool::addIdleCallback(IdleCb cb) { idle_callbacks_.emplace_back(cb); }
+
+bool CrossWorkerConnPool::isIdle() const {
+  if (isOwner()) {
+    return local_pool_->isIdle() && owner_->remote_streams_.load() == 0;
+  }
+  return streams_.empty();
+}
+
+void CrossWorkerConnPool::drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) {
+  if (drain_behavior == Envoy::ConnectionPool::DrainBehavior::DrainAndDelete) {
+    draining_ = true;
+    detach();
+  }
+  if (isOwner()) {
+    // The local pool reports itself idle once drained.
+    local_pool_->drainConnections(drain_behavior);
+  } else {
+    checkForIdleAndNotify();
+  }
+}
+
+bool CrossWorkerConnPool::maybePreconnect(float preconnect_ratio) {
+  return isOwner() && local_pool_->maybePreconnect(preconnect_ratio);
+}
+
+bool CrossWorkerConnPool::hasActiveConnections() const {
+  if (isOwner()) {
+    return local_pool_->hasActiveConnections() || owner_->remote_streams_.load() > 0;
+  }
+  return !streams_.empty();
+}
+
+ConnectionPool::Cancellable*
+CrossWorkerConnPool::newStream(ResponseDecoder& response_decoder,
+                               ConnectionPool::Callbacks& callbacks,
+                               const Instance::StreamOptions& options) {
+  ASSERT(!draining_);
+  CrossWorkerPoolOwnerSharedPtr owner = currentOwner();
+  if (isOwner()) {
+    return local_pool_->newStream(response_decoder, callbacks, options);
+  }
+
+  auto stream = std::make_shared<CrossWorkerStream>(*this, std::move(owner), response_decoder,
+                                                    callbacks, options);
+  streams_.emplace(stream.get(), stream);
+  host_->cluster().trafficStats()->upstream_rq_cross_worker_.inc();
+  stream->start();
+  return &stream->cancellable();
+}
+
+CrossWorkerPoolOwnerSharedPtr CrossWorkerConnPool::currentOwner() {
+  if (!isOwner() && owner_->detached()) {
+    ENVOY_LOG(debug, "owner of the shared pool of {} went away", host_->hostname());
+    attach();
+  }
+  return owner_;
+}
+
+void CrossWorkerConnPool::onStreamDone(CrossWorkerStream& stream) {
+  auto it = streams_.find(&stream);
+  ASSERT(it != streams_.end());
+  Event::DeferredTaskUtil::deferredRun(
+      dispatcher_, [stream = std::move(it->second)]() { stream->releaseWorkerState(); });
+  streams_.erase(it);
+  checkForIdleAndNotify();
+}
+
+void CrossWorkerConnPool::onRemoteStreamDone() { checkForIdleAndNotify(); }
+
+void CrossWorkerConnPool::attach() {
+  auto candidate = std::make_shared<CrossWorkerPoolOwner>(*this);
+  owner_ = registry_->ownerOrRegister(key_, candidate);
+  if (owner_ == candidate) {
+    ENVOY_LOG(debug, "worker becomes the owner of the shared pool of {}", host_->hostname());
+    local_pool_ = local_pool_factory_();
+    local_pool_->addIdleCallback([this]() { checkForIdleAndNotify(); });
+  }
+}
+
+void CrossWorkerConnPool::detach() {
+  if (isOwner() && !owner_->detached()) {
+    owner_->detached_ = true;
+    registry_->unregister(key_, *owner_);
+  }
+}
+
+void CrossWorkerConnPool::checkForIdleAndNotify() {
+  if (destroying_ || !isIdle()) {
+    return;
+  }
+  // A pool which hands its streams over stays around as long as its owner does, so that the
+  // owner is not looked up again for every stream.
+  if (!isOwner() && !draining_ && !owner_->detached()) {
+    return;
+  }
+  for (auto& callback : idle_callbacks_) {
+    callback();
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
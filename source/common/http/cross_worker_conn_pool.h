@@ -0,0 +1,357 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/http/codec_helper.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Http {
+
+class CrossWorkerConnPool;
+
+/**
+ * The handle of a worker whose HTTP/2 connection pool is shared with the other workers. Streams of
+ * the other workers are handed over to the owner's dispatcher and created on its pool.
+ */
+class CrossWorkerPoolOwner {
+public:
+  explicit CrossWorkerPoolOwner(CrossWorkerConnPool& pool);
+
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+
+  // True once the owner stopped accepting streams of other workers. Set on the owner thread, read
+  // by the other workers to find a new owner.
+  bool detached() const { return detached_.load(); }
+
+  // Only called on the owner thread.
+  // @return the pool the streams of other workers are created on, nullptr if it is gone.
+  ConnectionPool::Instance* localPool();
+  void onRemoteStreamDone();
+
+  // The pool of the owner, cleared when it is destroyed. Only accessed on the owner thread.
+  CrossWorkerConnPool* pool_;
+  std::atomic<bool> detached_{false};
+  // The number of streams of other workers which have been handed over to the owner and are not
+  // done yet. The owner does not report itself idle while there are any.
+  std::atomic<uint32_t> remote_streams_{0};
+
+private:
+  Event::Dispatcher& dispatcher_;
+};
+
+using CrossWorkerPoolOwnerSharedPtr = std::shared_ptr<CrossWorkerPoolOwner>;
+
+/**
+ * Maps each shared pool to its current owner. One registry is shared by all the workers of a
+ * cluster manager. Lookups only happen when a worker creates its pool or its owner went away.
+ */
+class CrossWorkerConnPoolRegistry {
+public:
+  // The host, the priority and the hash key of the pools which share the owner's connections.
+  using Key = std::tuple<const Upstream::HostDescription*, Upstream::ResourcePriority,
+                         std::vector<uint8_t>>;
+
+  /**
+   * @return the current owner of the pools with the given key. If there is none, the candidate
+   *         is registered as the owner and returned.
+   */
+  CrossWorkerPoolOwnerSharedPtr ownerOrRegister(const Key& key,
+                                                const CrossWorkerPoolOwnerSharedPtr& candidate);
+
+  /**
+   * Removes the owner from the registry if it is still the registered owner of the key.
+   */
+  void unregister(const Key& key, const CrossWorkerPoolOwner& owner);
+
+private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<Key, std::weak_ptr<CrossWorkerPoolOwner>> owners_ ABSL_GUARDED_BY(mutex_);
+};
+
+using CrossWorkerConnPoolRegistrySharedPtr = std::shared_ptr<CrossWorkerConnPoolRegistry>;
+
+/**
+ * A stream of one worker which is carried by a stream of the owner's pool. The stream has two
+ * halves: the worker stream is the encoder and the cancellable handle given to the caller on the
+ * worker, the owner stream is the decoder and the callbacks of the stream on the owner's pool.
+ * Every event of one half is posted to the dispatcher of the other half. Each half is only accessed
+ * on its own thread, and the posted closures keep the object alive until both halves are done.
+ */
+class CrossWorkerStream : public std::enable_shared_from_this<CrossWorkerStream>,
+                          Logger::Loggable<Logger::Id::pool> {
+public:
+  CrossWorkerStream(CrossWorkerConnPool& pool, CrossWorkerPoolOwnerSharedPtr owner,
+                    ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks,
+                    const ConnectionPool::Instance::StreamOptions& options);
+
+  // Hands the stream over to the owner. Called on the worker thread.
+  void start();
+
+  // Called on the worker thread when its pool is destroyed with the stream still in flight.
+  void onPoolDestroyed();
+
+  // Releases the state of the worker stream once the caller cannot refer to it anymore.
+  void releaseWorkerState() { worker_.releaseState(); }
+
+  ConnectionPool::Cancellable& cancellable() { return worker_; }
+
+private:
+  // The connection data of the owner's stream, copied over to the worker stream once it is ready.
+  struct ReadyInfo {
+    Upstream::HostDescriptionConstSharedPtr host_;
+    absl::optional<Protocol> protocol_;
+    Network::Address::InstanceConstSharedPtr local_address_;
+    Network::Address::InstanceConstSharedPtr remote_address_;
+    Ssl::ConnectionInfoConstSharedPtr ssl_connection_;
+    absl::optional<uint64_t> connection_id_;
+    uint32_t buffer_limit_{};
+  };
+
+  class WorkerStream : public RequestEncoder,
+                       public Stream,
+                       public StreamCallbackHelper,
+                       public ConnectionPool::Cancellable {
+  public:
+    WorkerStream(CrossWorkerStream& parent, ResponseDecoder& decoder,
+                 ConnectionPool::Callbacks& callbacks)
+        : parent_(parent), decoder_(decoder), callbacks_(&callbacks) {}
+
+    // Http::RequestEncoder
+    Status encodeHeaders(const RequestHeaderMap& headers, bool end_stream) override;
+    void encodeTrailers(const RequestTrailerMap& trailers) override;
+    void enableTcpTunneling() override;
+
+    // Http::StreamEncoder
+    void encodeData(Buffer::Instance& data, bool end_stream) override;
+    Stream& getStream() override { return *this; }
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+    Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+    void resetStream(StreamResetReason reason) override;
+    void readDisable(bool disable) override;
+    uint32_t bufferLimit() const override { return buffer_limit_; }
+    absl::string_view responseDetails() override { return details_; }
+    const Network::ConnectionInfoProvider& connectionInfoProvider() override {
+      return *connection_info_;
+    }
+    void setFlushTimeout(std::chrono::milliseconds timeout) override;
+    Buffer::BufferMemoryAccountSharedPtr account() const override { return account_; }
+    void setAccount(Buffer::BufferMemoryAccountSharedPtr account) override { account_ = account; }
+    const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+    // ConnectionPool::Cancellable
+    void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) override;
+
+    // Events of the owner stream.
+    void onPoolReady(const ReadyInfo& info);
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       absl::string_view transport_failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host);
+    void onOwnerDetached();
+    void decode1xxHeaders(ResponseHeaderMapPtr&& headers);
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream);
+    void decodeData(Buffer::Instance& data, bool end_stream);
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers);
+    void decodeMetadata(MetadataMapPtr&& metadata_map);
+    void onResetStream(StreamResetReason reason, absl::string_view transport_failure_reason);
+    void onAboveWriteBufferHighWatermark() { runHighWatermarkCallbacks(); }
+    void onBelowWriteBufferLowWatermark() { runLowWatermarkCallbacks(); }
+
+    void onPoolDestroyed();
+    // Releases the state which must be destroyed on the worker thread.
+    void releaseState();
+
+  private:
+    enum class State { Pending, Active, Done };
+
+    void maybeDone();
+    void done();
+
+    CrossWorkerStream& parent_;
+    ResponseDecoder& decoder_;
+    // The callbacks of the caller. Cleared once the caller has been notified.
+    ConnectionPool::Callbacks* callbacks_;
+    State state_{State::Pending};
+    bool remote_end_stream_{};
+    uint32_t buffer_limit_{};
+    std::string details_;
+    std::shared_ptr<Network::ConnectionInfoSetterImpl> connection_info_;
+    std::unique_ptr<StreamInfo::StreamInfoImpl> stream_info_;
+    Buffer::BufferMemoryAccountSharedPtr account_;
+    StreamInfo::BytesMeterSharedPtr bytes_meter_{std::make_shared<StreamInfo::BytesMeter>()};
+  };
+
+  class OwnerStream : public ResponseDecoder,
+                      public StreamCallbacks,
+                      public ConnectionPool::Callbacks {
+  public:
+    explicit OwnerStream(CrossWorkerStream& parent) : parent_(parent) {}
+
+    // Http::StreamDecoder
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+
+    // Http::ResponseDecoder
+    void decode1xxHeaders(ResponseHeaderMapPtr&& headers) override;
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) override;
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers) override;
+    void dumpState(std::ostream& os, int indent_level) const override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason,
+                       absl::string_view transport_failure_reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+    // ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       absl::string_view transport_failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                     StreamInfo::StreamInfo& info, absl::optional<Protocol> protocol) override;
+
+    // Events of the worker stream.
+    void start();
+    void encodeHeaders(RequestHeaderMapPtr&& headers, bool end_stream);
+    void encodeData(Buffer::Instance& data, bool end_stream);
+    void encodeTrailers(RequestTrailerMapPtr&& trailers);
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector);
+    void enableTcpTunneling();
+    void readDisable(bool disable);
+    void setFlushTimeout(std::chrono::milliseconds timeout);
+    void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy);
+    void resetStream(StreamResetReason reason);
+
+    // Releases the state which must be destroyed on the owner thread.
+    void releaseState();
+
+  private:
+    enum class State { Idle, Pending, Active, Done };
+
+    // Sets the end stream flag of one direction, and completes the stream once both are set.
+    void onEndStream(bool& end_stream_flag, bool end_stream);
+    void done();
+
+    CrossWorkerStream& parent_;
+    State state_{State::Idle};
+    // Set while the stream is on the owner's pool, as the pool and the codec refer to the stream.
+    std::shared_ptr<CrossWorkerStream> keep_alive_;
+    bool local_end_stream_{};
+    bool remote_end_stream_{};
+    ConnectionPool::Cancellable* cancellable_{};
+    RequestEncoder* encoder_{};
+    // The request headers and trailers are kept until the stream is done, as the encoder of the
+    // owner's pool may refer to them.
+    RequestHeaderMapPtr request_headers_;
+    RequestTrailerMapPtr request_trailers_;
+  };
+
+  void postToOwner(std::function<void(OwnerStream&)> event);
+  void postToWorker(std::function<void(WorkerStream&)> event);
+
+  // The pool of the worker, cleared when it is destroyed. Only accessed on the worker thread.
+  CrossWorkerConnPool* pool_;
+  Event::Dispatcher& worker_dispatcher_;
+  const Upstream::HostDescriptionConstSharedPtr host_;
+  // Only changed by the worker while the stream is not on the pool of an owner.
+  CrossWorkerPoolOwnerSharedPtr owner_;
+  const ConnectionPool::Instance::StreamOptions options_;
+  WorkerStream worker_;
+  OwnerStream owner_stream_;
+};
+
+using CrossWorkerStreamSharedPtr = std::shared_ptr<CrossWorkerStream>;
+
+/**
+ * An HTTP/2 connection pool which shares the connections of one worker, the owner, with the other
+ * workers of the cluster manager. This is meant for clusters which get few requests spread over
+ * many workers, where every worker would otherwise keep its own mostly idle connection to every
+ * host. The first worker which needs a pool for a host becomes its owner and creates a regular
+ * pool. The pools of the other workers hand their streams over to the owner's dispatcher, at the
+ * cost of two thread hops per request. Body buffers move between the workers without copies,
+ * unless the stream has a memory account: the body is then copied, so that the account is only
+ * ever charged and credited on its own worker.
+ * When the owner's pool is drained or idle, the next stream makes a new owner.
+ */
+class CrossWorkerConnPool : public ConnectionPool::Instance, Logger::Loggable<Logger::Id::pool> {
+public:
+  using LocalPoolFactory = std::function<ConnectionPool::InstancePtr()>;
+
+  CrossWorkerConnPool(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
+                      CrossWorkerConnPoolRegistrySharedPtr registry,
+                      CrossWorkerConnPoolRegistry::Key key, LocalPoolFactory local_pool_factory);
+  ~CrossWorkerConnPool() override;
+
+  // Event::DeferredDeletable
+  void deleteIsPending() override;
+
+  // Http::ConnectionPool::Instance
+  void addIdleCallback(IdleCb cb) override;
+  bool isIdle() const override;
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) override;
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float preconnect_ratio) override;
+  bool hasActiveConnections() const override;
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks,
+                                         const Instance::StreamOptions& options) override;
+  absl::string_view protocolDescription() const override { return "HTTP/2 cross worker"; }
+
+  // True if this pool owns the connections shared with the other workers.
+  bool isOwner() const { return local_pool_ != nullptr; }
+  bool draining() const { return draining_; }
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+  ConnectionPool::Instance* localPool() { return local_pool_.get(); }
+
+  // @return the owner new streams are handed over to. This pool becomes the owner if the previous
+  //         owner went away and no other worker took over.
+  CrossWorkerPoolOwnerSharedPtr currentOwner();
+
+  // Called by a stream of this pool once the worker side of the stream is done.
+  void onStreamDone(CrossWorkerStream& stream);
+
+  // Called on the owner once a stream of another worker is done.
+  void onRemoteStreamDone();
+
+private:
+  // Becomes the owner, or starts handing streams over to the current owner.
+  void attach();
+  // Stops accepting streams of the other workers.
+  void detach();
+  void checkForIdleAndNotify();
+
+  Event::Dispatcher& dispatcher_;
+  const Upstream::HostConstSharedPtr host_;
+  const CrossWorkerConnPoolRegistrySharedPtr registry_;
+  const CrossWorkerConnPoolRegistry::Key key_;
+  const LocalPoolFactory local_pool_factory_;
+  CrossWorkerPoolOwnerSharedPtr owner_;
+  // The pool of this worker if it is the owner.
+  ConnectionPool::InstancePtr local_pool_;
+  // The streams handed over to another worker which are not done on this worker yet.
+  absl::flat_hash_map<CrossWorkerStream*, CrossWorkerStreamSharedPtr> streams_;
+  std::list<Instance::IdleCb> idle_callbacks_;
+  bool draining_{};
+  bool destroying_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,260 @@
+#include "source/common/http/header_char_utility.h"
+
+#include <array>
+#include <cstdint>
+
+#include "source/common/common/assert.h"
+
+#include "absl/strings/ascii.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#define ENVOY_HEADER_CHAR_UTILITY_X86_64
+#include <immintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~"
+//       / DIGIT / ALPHA
+constexpr bool isTokenChar(uint8_t c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '!' ||
+         c == '#' || c == '$' || c == '%' || c == '&' || c == '\'' || c == '*' || c == '+' ||
+         c == '-' || c == '.' || c == '^' || c == '_' || c == '`' || c == '|' || c == '~';
+}
+
+// field-vchar = VCHAR / obs-text, plus the SP and HTAB allowed between them. This matches
+// nghttp2_check_header_value().
+constexpr bool isHeaderValueChar(uint8_t c) { return c == '\t' || (c >= 0x20 && c != 0x7f); }
+
+template <bool (*Predicate)(uint8_t)> constexpr std::array<bool, 256> makeCharTable() {
+  std::array<bool, 256> table{};
+  for (size_t c = 0; c < table.size(); ++c) {
+    table[c] = Predicate(static_cast<uint8_t>(c));
+  }
+  return table;
+}
+
+constexpr std::array<bool, 256> TokenCharTable = makeCharTable<isTokenChar>();
+constexpr std::array<bool, 256> HeaderValueCharTable = makeCharTable<isHeaderValueChar>();
+
+void toLowerCaseScalar(char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = absl::ascii_tolower(data[i]);
+  }
+}
+
+bool isTokenScalar(const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (!TokenCharTable[static_cast<uint8_t>(data[i])]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isValidHeaderValueScalar(const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (!HeaderValueCharTable[static_cast<uint8_t>(data[i])]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr HeaderCharUtility::Kernels ScalarKernels{toLowerCaseScalar, isTokenScalar,
+                                                   isValidHeaderValueScalar};
+
+#ifdef ENVOY_HEADER_CHAR_UTILITY_X86_64
+
+// Token characters are classified 16 or 32 at a time by splitting each byte into nibbles and
+// looking both up with a byte shuffle. The entry of a low nibble has bit h set if the character
+// with that low nibble and high nibble h is a token character. The entry of a high nibble is the
+// bit for that high nibble, and zero for bytes >= 0x80. A byte is a token character iff the
+// entries of its nibbles share a bit.
+struct TokenNibbleTables {
+  alignas(16) uint8_t low_[16];
+  alignas(16) uint8_t high_[16];
+};
+
+constexpr TokenNibbleTables makeTokenNibbleTables() {
+  TokenNibbleTables tables{};
+  for (uint8_t c = 0; c < 0x80; ++c) {
+    if (isTokenChar(c)) {
+      tables.low_[c & 0x0f] |= 1 << (c >> 4);
+    }
+  }
+  for (uint8_t high = 0; high < 8; ++high) {
+    tables.high_[high] = 1 << high;
+  }
+  return tables;
+}
+
+constexpr TokenNibbleTables TokenTables = makeTokenNibbleTables();
+
+__attribute__((target("sse4.2"))) void toLowerCaseSse42(char* data, size_t size) {
+  const __m128i before_upper = _mm_set1_epi8('A' - 1);
+  const __m128i after_upper = _mm_set1_epi8('Z' + 1);
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i* chunk = reinterpret_cast<__m128i*>(data + i);
+    const __m128i v = _mm_loadu_si128(chunk);
+    // Bytes >= 0x80 compare as negative, so they are never considered upper case.
+    const __m128i is_upper =
+        _mm_and_si128(_mm_cmpgt_epi8(v, before_upper), _mm_cmpgt_epi8(after_upper, v));
+    _mm_storeu_si128(chunk, _mm_or_si128(v, _mm_and_si128(is_upper, case_bit)));
+  }
+  toLowerCaseScalar(data + i, size - i);
+}
+
+__attribute__((target("sse4.2"))) bool isTokenSse42(const char* data, size_t size) {
+  const __m128i low_table = _mm_load_si128(reinterpret_cast<const __m128i*>(TokenTables.low_));
+  const __m128i high_table = _mm_load_si128(reinterpret_cast<const __m128i*>(TokenTables.high_));
+  const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i low = _mm_shuffle_epi8(low_table, _mm_and_si128(v, nibble_mask));
+    const __m128i high =
+        _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi16(v, 4), nibble_mask));
+    const __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+    if (_mm_movemask_epi8(invalid) != 0) {
+      return false;
+    }
+  }
+  return isTokenScalar(data + i, size - i);
+}
+
+__attribute__((target("sse4.2"))) bool isValidHeaderValueSse42(const char* data, size_t size) {
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i htab = _mm_set1_epi8('\t');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i minus_one = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // Control characters are 0x00-0x1f; bytes >= 0x80 compare as negative and are valid.
+    const __m128i is_control =
+        _mm_and_si128(_mm_cmpgt_epi8(space, v), _mm_cmpgt_epi8(v, minus_one));
+    const __m128i invalid =
+        _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(v, htab), is_control), _mm_cmpeq_epi8(v, del));
+    if (_mm_movemask_epi8(invalid) != 0) {
+      return false;
+    }
+  }
+  return isValidHeaderValueScalar(data + i, size - i);
+}
+
+// The AVX2 kernels process 32 bytes at a time and hand the remainder to the SSE4.2 kernels, which
+// AVX2 capable CPUs also support.
+
+__attribute__((target("avx2"))) void toLowerCaseAvx2(char* data, size_t size) {
+  const __m256i before_upper = _mm256_set1_epi8('A' - 1);
+  const __m256i after_upper = _mm256_set1_epi8('Z' + 1);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i* chunk = reinterpret_cast<__m256i*>(data + i);
+    const __m256i v = _mm256_loadu_si256(chunk);
+    const __m256i is_upper =
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, before_upper), _mm256_cmpgt_epi8(after_upper, v));
+    _mm256_storeu_si256(chunk, _mm256_or_si256(v, _mm256_and_si256(is_upper, case_bit)));
+  }
+  toLowerCaseSse42(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) bool isTokenAvx2(const char* data, size_t size) {
+  // Byte shuffles operate within 128-bit lanes, so both lanes get a copy of the tables.
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(TokenTables.low_)));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(TokenTables.high_)));
+  const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble_mask));
+    const __m256i high =
+        _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble_mask));
+    const __m256i invalid = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+    if (_mm256_movemask_epi8(invalid) != 0) {
+      return false;
+    }
+  }
+  return isTokenSse42(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) bool isValidHeaderValueAvx2(const char* data, size_t size) {
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i htab = _mm256_set1_epi8('\t');
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i minus_one = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i is_control =
+        _mm256_and_si256(_mm256_cmpgt_epi8(space, v), _mm256_cmpgt_epi8(v, minus_one));
+    const __m256i invalid = _mm256_or_si256(
+        _mm256_andnot_si256(_mm256_cmpeq_epi8(v, htab), is_control), _mm256_cmpeq_epi8(v, del));
+    if (_mm256_movemask_epi8(invalid) != 0) {
+      return false;
+    }
+  }
+  return isValidHeaderValueSse42(data + i, size - i);
+}
+
+constexpr HeaderCharUtility::Kernels Sse42Kernels{toLowerCaseSse42, isTokenSse42,
+                                                  isValidHeaderValueSse42};
+constexpr HeaderCharUtility::Kernels Avx2Kernels{toLowerCaseAvx2, isTokenAvx2,
+                                                 isValidHeaderValueAvx2};
+
+#endif
+
+} // namespace
+
+const HeaderCharUtility::Kernels* HeaderCharUtility::kernels(Implementation implementation) {
+  switch (implementation) {
+  case Implementation::Scalar:
+    return &ScalarKernels;
+  case Implementation::Sse42:
+#ifdef ENVOY_HEADER_CHAR_UTILITY_X86_64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+      return &Sse42Kernels;
+    }
+#endif
+    return nullptr;
+  case Implementation::Avx2:
+#ifdef ENVOY_HEADER_CHAR_UTILITY_X86_64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2")) {
+      return &Avx2Kernels;
+    }
+#endif
+    return nullptr;
+  }
+  PANIC_DUE_TO_CORRUPT_ENUM;
+}
+
+HeaderCharUtility::Implementation HeaderCharUtility::activeImplementation() {
+  static const Implementation implementation = []() {
+    for (const Implementation candidate : {Implementation::Avx2, Implementation::Sse42}) {
+      if (kernels(candidate) != nullptr) {
+        return candidate;
+      }
+    }
+    return Implementation::Scalar;
+  }();
+  return implementation;
+}
+
+const HeaderCharUtility::Kernels& HeaderCharUtility::active() {
+  static const Kernels& active_kernels = *kernels(activeImplementation());
+  return active_kernels;
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Character level kernels for validating and normalizing header names and values. These are on
+ * the hot path of HTTP/1 parsing, where every byte of every header passes through them, so each
+ * kernel has vectorized implementations for x86-64 in addition to the portable scalar one. The
+ * fastest implementation supported by the CPU is selected once, at first use.
+ */
+class HeaderCharUtility {
+public:
+  enum class Implementation { Scalar, Sse42, Avx2 };
+
+  /**
+   * The kernels of one implementation. All implementations produce identical results.
+   */
+  struct Kernels {
+    void (*to_lower_case_)(char* data, size_t size);
+    bool (*is_token_)(const char* data, size_t size);
+    bool (*is_valid_header_value_)(const char* data, size_t size);
+  };
+
+  /**
+   * Converts the ASCII upper case characters in data to lower case, in place.
+   */
+  static void toLowerCase(char* data, size_t size) { active().to_lower_case_(data, size); }
+
+  /**
+   * @return whether all characters of s are token characters, as defined in RFC 9110, section
+   *         5.6.2. Note that an empty string is not a valid token, but this returns true for it.
+   */
+  static bool isToken(absl::string_view s) { return active().is_token_(s.data(), s.size()); }
+
+  /**
+   * @return whether all characters of s may appear in a header value. These are the visible ASCII
+   *         characters, SP, HTAB and obs-text (%x80-FF), as defined in RFC 9110, section 5.5.
+   */
+  static bool isValidHeaderValue(absl::string_view s) {
+    return active().is_valid_header_value_(s.data(), s.size());
+  }
+
+  /**
+   * @return the implementation selected for this CPU.
+   */
+  static Implementation activeImplementation();
+
+  /**
+   * @return the kernels of the given implementation, or nullptr if it isn't supported by this CPU
+   *         or build. Intended for tests and benchmarks comparing the implementations.
+   */
+  static const Kernels* kernels(Implementation implementation);
+
+private:
+  static const Kernels& active();
+};
+
+} // namespace Http
+} // namespace Envoy
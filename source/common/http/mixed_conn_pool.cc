@@ -92,6 +92,8 @@ void HttpConnPoolImplMixed::onConnected(Envoy::ConnectionPool::ActiveClient& cli
     state_.incrConnectingAndConnectedStreamCapacity(new_client->effectiveConcurrentStreamLimit() -
                                                     old_effective_limit);
   }
+  new_client->connect_start_time_ = client.connect_start_time_;
+  new_client->preconnected_ = client.preconnected_;
   new_client->setState(ActiveClient::State::Connecting);
   LinkedList::moveIntoList(std::move(new_client), owningList(new_client->state()));
 }
@@ -86,6 +86,14 @@ public:
    */
   virtual IoUringResult prepareClose(os_fd_t fd, void* user_data) PURE;
 
+  /**
+   * Prepares a cancellation of the previously submitted request identified by
+   * `cancelling_user_data` and puts it into the submission queue.
+   * Returns IoUringResult::Failed in case the submission queue is full already
+   * and IoUringResult::Ok otherwise.
+   */
+  virtual IoUringResult prepareCancel(void* cancelling_user_data, void* user_data) PURE;
+
   /**
    * Submits the entries in the submission queue to the kernel using the
    * `io_uring_enter()` system call.
@@ -97,6 +105,8 @@ public:
   virtual IoUringResult submit() PURE;
 };
 
+using IoUringPtr = std::unique_ptr<IoUring>;
+
 /**
  * Abstract factory for IoUring wrappers.
  */
@@ -68,13 +68,16 @@ void IoUringImpl::forEveryCompletion(CompletionCb completion_cb) {
   int ret = eventfd_read(event_fd_, &v);
   RELEASE_ASSERT(ret == 0, "unable to drain eventfd");
 
-  unsigned count = io_uring_peek_batch_cqe(&ring_, cqes_.data(), io_uring_size_);
-
-  for (unsigned i = 0; i < count; ++i) {
-    struct io_uring_cqe* cqe = cqes_[i];
-    completion_cb(reinterpret_cast<void*>(cqe->user_data), cqe->res);
+  // The completion queue may hold more entries than fit into `cqes_`. Keep consuming them, since
+  // the eventfd has been drained already and won't signal the remaining ones again.
+  unsigned count;
+  while ((count = io_uring_peek_batch_cqe(&ring_, cqes_.data(), io_uring_size_)) > 0) {
+    for (unsigned i = 0; i < count; ++i) {
+      struct io_uring_cqe* cqe = cqes_[i];
+      completion_cb(reinterpret_cast<void*>(cqe->user_data), cqe->res);
+    }
+    io_uring_cq_advance(&ring_, count);
   }
-  io_uring_cq_advance(&ring_, count);
 }
 
 IoUringResult IoUringImpl::prepareAccept(os_fd_t fd, struct sockaddr* remote_addr,
@@ -137,6 +140,17 @@ IoUringResult IoUringImpl::prepareClose(os_fd_t fd, void* user_data) {
   return IoUringResult::Ok;
 }
 
+IoUringResult IoUringImpl::prepareCancel(void* cancelling_user_data, void* user_data) {
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr) {
+    return IoUringResult::Failed;
+  }
+
+  io_uring_prep_cancel(sqe, cancelling_user_data, 0);
+  io_uring_sqe_set_data(sqe, user_data);
+  return IoUringResult::Ok;
+}
+
 IoUringResult IoUringImpl::submit() {
   int res = io_uring_submit(&ring_);
   RELEASE_ASSERT(res >= 0 || res == -EBUSY, "unable to submit io_uring queue entries");
@@ -0,0 +1,519 @@
+#include "source/common/io/io_uring_worker_impl.h"
+
+#include <algorithm>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/utility.h"
+#include "source/common/io/io_uring_impl.h"
+
+#include "absl/container/fixed_array.h"
+
+namespace Envoy {
+namespace Io {
+
+namespace {
+
+// Same bound as IoSocketHandleImpl::write() uses for a single writev().
+constexpr uint64_t MaxWriteSlices = 16;
+
+class AcceptRequest : public Request {
+public:
+  explicit AcceptRequest(IoUringSocketEntry& socket) : Request(RequestType::Accept, socket) {}
+
+  sockaddr_storage remote_addr_{};
+  socklen_t remote_addr_len_{sizeof(remote_addr_)};
+};
+
+class ConnectRequest : public Request {
+public:
+  ConnectRequest(IoUringSocketEntry& socket,
+                 const Network::Address::InstanceConstSharedPtr& address)
+      : Request(RequestType::Connect, socket), address_(address) {}
+
+  // Keeps the sockaddr alive until the kernel has consumed it.
+  const Network::Address::InstanceConstSharedPtr address_;
+};
+
+class ReadRequest : public Request {
+public:
+  ReadRequest(IoUringSocketEntry& socket, uint32_t size)
+      : Request(RequestType::Read, socket), reservation_(buffer_.reserveSingleSlice(size)) {
+    iov_.iov_base = reservation_.slice().mem_;
+    iov_.iov_len = reservation_.length();
+  }
+
+  // The kernel reads directly into a reservation of `buffer_`, whose slice is later moved into
+  // the socket's read buffer without copying.
+  Buffer::OwnedImpl buffer_;
+  Buffer::ReservationSingleSlice reservation_;
+  struct iovec iov_;
+};
+
+class WriteRequest : public Request {
+public:
+  WriteRequest(IoUringSocketEntry& socket, const Buffer::RawSliceVector& slices)
+      : Request(RequestType::Write, socket), iovecs_(slices.size()) {
+    for (size_t i = 0; i < slices.size(); i++) {
+      iovecs_[i].iov_base = slices[i].mem_;
+      iovecs_[i].iov_len = slices[i].len_;
+    }
+  }
+
+  absl::FixedArray<struct iovec> iovecs_;
+};
+
+} // namespace
+
+IoUringWorkerImpl::IoUringWorkerImpl(uint32_t io_uring_size, bool use_submission_queue_polling,
+                                     uint32_t read_buffer_size, Event::Dispatcher& dispatcher)
+    : IoUringWorkerImpl(std::make_unique<IoUringImpl>(io_uring_size, use_submission_queue_polling),
+                        read_buffer_size, dispatcher) {}
+
+IoUringWorkerImpl::IoUringWorkerImpl(IoUringPtr io_uring, uint32_t read_buffer_size,
+                                     Event::Dispatcher& dispatcher)
+    : io_uring_(std::move(io_uring)), read_buffer_size_(read_buffer_size),
+      dispatcher_(dispatcher) {
+  const os_fd_t event_fd = io_uring_->registerEventfd();
+  file_event_ = dispatcher_.createFileEvent(
+      event_fd, [this](uint32_t) { onFileEvent(); }, Event::PlatformDefaultTriggerType,
+      Event::FileReadyType::Read);
+  submit_cb_ = dispatcher_.createSchedulableCallback([this]() { submit(); });
+}
+
+IoUringWorkerImpl::~IoUringWorkerImpl() {
+  ENVOY_LOG(trace, "destructing io_uring worker, {} sockets left", sockets_.size());
+
+  // Requests in flight reference memory owned by the sockets, so wait for all of them to
+  // complete before the ring goes away.
+  for (auto& socket : sockets_) {
+    socket->close(false);
+  }
+  while (!sockets_.empty()) {
+    submit();
+    onFileEvent();
+  }
+
+  file_event_.reset();
+  io_uring_->unregisterEventfd();
+}
+
+IoUringAcceptSocket& IoUringWorkerImpl::addAcceptSocket(os_fd_t fd, Event::FileReadyCb cb) {
+  ENVOY_LOG(trace, "add accept socket, fd = {}", fd);
+  auto socket = std::make_unique<IoUringAcceptSocket>(fd, *this, std::move(cb));
+  IoUringAcceptSocket& ref = *socket;
+  LinkedList::moveIntoListBack(std::move(socket), sockets_);
+  return ref;
+}
+
+IoUringStreamSocket& IoUringWorkerImpl::addStreamSocket(os_fd_t fd, bool connected,
+                                                        Event::FileReadyCb cb) {
+  ENVOY_LOG(trace, "add stream socket, fd = {}, connected = {}", fd, connected);
+  auto socket = std::make_unique<IoUringStreamSocket>(fd, connected, *this, std::move(cb));
+  IoUringStreamSocket& ref = *socket;
+  LinkedList::moveIntoListBack(std::move(socket), sockets_);
+  return ref;
+}
+
+template <class F> void IoUringWorkerImpl::prepare(F prepare_fn) {
+  IoUringResult res = prepare_fn();
+  if (res == IoUringResult::Failed) {
+    // The submission queue is full. Hand the queued entries over to the kernel and retry.
+    submit();
+    res = prepare_fn();
+    RELEASE_ASSERT(res == IoUringResult::Ok, "unable to prepare io_uring request");
+  }
+  submit_cb_->scheduleCallbackCurrentIteration();
+}
+
+Request* IoUringWorkerImpl::submitAcceptRequest(IoUringAcceptSocket& socket) {
+  auto req = std::make_unique<AcceptRequest>(socket);
+  ENVOY_LOG(trace, "submit accept request, fd = {}, req = {}", socket.fd(), fmt::ptr(req.get()));
+  prepare([&]() {
+    return io_uring_->prepareAccept(socket.fd(),
+                                    reinterpret_cast<struct sockaddr*>(&req->remote_addr_),
+                                    &req->remote_addr_len_, req.get());
+  });
+  return req.release();
+}
+
+Request*
+IoUringWorkerImpl::submitConnectRequest(IoUringStreamSocket& socket,
+                                        const Network::Address::InstanceConstSharedPtr& address) {
+  auto req = std::make_unique<ConnectRequest>(socket, address);
+  ENVOY_LOG(trace, "submit connect request, fd = {}, req = {}", socket.fd(), fmt::ptr(req.get()));
+  prepare([&]() { return io_uring_->prepareConnect(socket.fd(), req->address_, req.get()); });
+  return req.release();
+}
+
+Request* IoUringWorkerImpl::submitReadRequest(IoUringStreamSocket& socket) {
+  auto req = std::make_unique<ReadRequest>(socket, read_buffer_size_);
+  ENVOY_LOG(trace, "submit read request, fd = {}, req = {}", socket.fd(), fmt::ptr(req.get()));
+  prepare([&]() { return io_uring_->prepareReadv(socket.fd(), &req->iov_, 1, 0, req.get()); });
+  return req.release();
+}
+
+Request* IoUringWorkerImpl::submitWriteRequest(IoUringStreamSocket& socket,
+                                               const Buffer::Instance& data) {
+  auto req = std::make_unique<WriteRequest>(socket, data.getRawSlices(MaxWriteSlices));
+  ENVOY_LOG(trace, "submit write request, fd = {}, req = {}", socket.fd(), fmt::ptr(req.get()));
+  prepare([&]() {
+    return io_uring_->prepareWritev(socket.fd(), req->iovecs_.data(), req->iovecs_.size(), 0,
+                                    req.get());
+  });
+  return req.release();
+}
+
+Request* IoUringWorkerImpl::submitCloseRequest(IoUringSocketEntry& socket) {
+  auto req = std::make_unique<Request>(RequestType::Close, socket);
+  ENVOY_LOG(trace, "submit close request, fd = {}, req = {}", socket.fd(), fmt::ptr(req.get()));
+  prepare([&]() { return io_uring_->prepareClose(socket.fd(), req.get()); });
+  return req.release();
+}
+
+Request* IoUringWorkerImpl::submitCancelRequest(IoUringSocketEntry& socket,
+                                                Request* request_to_cancel) {
+  auto req = std::make_unique<Request>(RequestType::Cancel, socket);
+  ENVOY_LOG(trace, "submit cancel request, fd = {}, req = {}, cancelling = {}", socket.fd(),
+            fmt::ptr(req.get()), fmt::ptr(request_to_cancel));
+  prepare([&]() { return io_uring_->prepareCancel(request_to_cancel, req.get()); });
+  return req.release();
+}
+
+void IoUringWorkerImpl::onFileEvent() {
+  io_uring_->forEveryCompletion([this](void* user_data, int32_t result) {
+    ASSERT(user_data != nullptr);
+    std::unique_ptr<Request> req(static_cast<Request*>(user_data));
+    IoUringSocketEntry& socket = req->socket();
+    ENVOY_LOG(trace, "completion, fd = {}, req = {}, result = {}", socket.fd(),
+              fmt::ptr(req.get()), result);
+    socket.onRequestCompletion(*req, result);
+    if (socket.closed()) {
+      socket.removeFromList(sockets_);
+    }
+  });
+}
+
+void IoUringWorkerImpl::submit() {
+  if (io_uring_->submit() == IoUringResult::Busy) {
+    // The completion queue is overcommitted. Completions are processed in this iteration, so try
+    // again on the next one.
+    ENVOY_LOG(trace, "io_uring submission is busy, retrying on the next iteration");
+    submit_cb_->scheduleCallbackNextIteration();
+  }
+}
+
+IoUringSocketEntry::IoUringSocketEntry(os_fd_t fd, IoUringWorkerImpl& parent,
+                                       Event::FileReadyCb cb)
+    : fd_(fd), parent_(parent), cb_(std::move(cb)) {}
+
+void IoUringSocketEntry::close(bool flush_writes) {
+  ENVOY_LOG(trace, "close io_uring socket, fd = {}, flush_writes = {}", fd_, flush_writes);
+  closing_ = true;
+  cb_ = nullptr;
+  cancelRequests(!flush_writes);
+  maybeSubmitClose();
+}
+
+void IoUringSocketEntry::onRequestCompletion(Request& req, int32_t result) {
+  switch (req.type()) {
+  case RequestType::Cancel:
+    ASSERT(inflight_cancels_ > 0);
+    inflight_cancels_--;
+    break;
+  case RequestType::Close:
+    closed_ = true;
+    return;
+  default:
+    cancelled_requests_.erase(&req);
+    onIoCompletion(req, result);
+    break;
+  }
+  maybeSubmitClose();
+}
+
+void IoUringSocketEntry::notify(uint32_t events) {
+  if (cb_ != nullptr && events != 0) {
+    cb_(events);
+  }
+}
+
+void IoUringSocketEntry::cancel(Request* req) {
+  if (req == nullptr || !cancelled_requests_.insert(req).second) {
+    return;
+  }
+  parent_.submitCancelRequest(*this, req);
+  inflight_cancels_++;
+}
+
+void IoUringSocketEntry::maybeSubmitClose() {
+  if (!closing_ || close_submitted_ || inflight_cancels_ > 0 || hasInflightRequests()) {
+    return;
+  }
+  close_submitted_ = true;
+  parent_.submitCloseRequest(*this);
+}
+
+IoUringAcceptSocket::IoUringAcceptSocket(os_fd_t fd, IoUringWorkerImpl& parent,
+                                         Event::FileReadyCb cb)
+    : IoUringSocketEntry(fd, parent, std::move(cb)) {}
+
+IoUringAcceptSocket::~IoUringAcceptSocket() {
+  for (const auto& accepted : accepted_sockets_) {
+    Api::OsSysCallsSingleton::get().close(accepted.fd_);
+  }
+}
+
+absl::optional<IoUringAcceptSocket::AcceptedSocket> IoUringAcceptSocket::popAcceptedSocket() {
+  if (accepted_sockets_.empty()) {
+    return absl::nullopt;
+  }
+  AcceptedSocket accepted = accepted_sockets_.front();
+  accepted_sockets_.pop_front();
+  return accepted;
+}
+
+void IoUringAcceptSocket::enableRead() {
+  read_enabled_ = true;
+  maybeSubmitAccept();
+}
+
+void IoUringAcceptSocket::disableRead() { read_enabled_ = false; }
+
+uint32_t IoUringAcceptSocket::readyEvents() const {
+  return accepted_sockets_.empty() ? 0 : Event::FileReadyType::Read;
+}
+
+void IoUringAcceptSocket::onIoCompletion(Request& req, int32_t result) {
+  ASSERT(&req == accept_req_);
+  accept_req_ = nullptr;
+
+  if (result < 0) {
+    if (result != -ECANCELED) {
+      ENVOY_LOG(debug, "accept failed, fd = {}, error = {}", fd_, errorDetails(-result));
+    }
+  } else if (closing_) {
+    Api::OsSysCallsSingleton::get().close(result);
+  } else {
+    const auto& accept_req = static_cast<const AcceptRequest&>(req);
+    accepted_sockets_.push_back({result, accept_req.remote_addr_, accept_req.remote_addr_len_});
+  }
+
+  if (closing_) {
+    return;
+  }
+  maybeSubmitAccept();
+  notify(readyEvents());
+}
+
+void IoUringAcceptSocket::cancelRequests(bool) { cancel(accept_req_); }
+
+void IoUringAcceptSocket::maybeSubmitAccept() {
+  if (!read_enabled_ || closing_ || accept_req_ != nullptr) {
+    return;
+  }
+  accept_req_ = parent_.submitAcceptRequest(*this);
+}
+
+IoUringStreamSocket::IoUringStreamSocket(os_fd_t fd, bool connected, IoUringWorkerImpl& parent,
+                                         Event::FileReadyCb cb)
+    : IoUringSocketEntry(fd, parent, std::move(cb)), connected_(connected) {}
+
+void IoUringStreamSocket::connect(const Network::Address::InstanceConstSharedPtr& address) {
+  ASSERT(!connected_ && !connecting());
+  connect_req_ = parent_.submitConnectRequest(*this, address);
+}
+
+void IoUringStreamSocket::awaitConnect() {
+  ASSERT(!connected_ && !connecting());
+  connect_event_ = parent_.dispatcher().createFileEvent(
+      fd_,
+      [this](uint32_t) {
+        connect_event_.reset();
+        int error = 0;
+        socklen_t error_size = sizeof(error);
+        const Api::SysCallIntResult result = Api::OsSysCallsSingleton::get().getsockopt(
+            fd_, SOL_SOCKET, SO_ERROR, &error, &error_size);
+        onConnectCompleted(result.return_value_ == 0 ? -error : -result.errno_);
+      },
+      Event::FileTriggerType::Edge, Event::FileReadyType::Write);
+}
+
+uint64_t IoUringStreamSocket::write(Buffer::Instance& data) {
+  if (!writable()) {
+    return 0;
+  }
+  // Appending never moves the bytes referenced by an in-flight write. The buffer is filled up to
+  // its limit, the rest of the input is left to the caller as a partial write.
+  const uint64_t length =
+      std::min<uint64_t>(data.length(), parent_.readBufferSize() - write_buffer_.length());
+  write_buffer_.move(data, length);
+  maybeSubmitWrite();
+  return length;
+}
+
+bool IoUringStreamSocket::writable() const {
+  return connected_ && !closing_ && write_error_ == 0 &&
+         write_buffer_.length() < parent_.readBufferSize();
+}
+
+void IoUringStreamSocket::shutdown(int how) {
+  if (write_req_ != nullptr || write_buffer_.length() > 0) {
+    pending_shutdown_ = how;
+    return;
+  }
+  Api::OsSysCallsSingleton::get().shutdown(fd_, how);
+}
+
+void IoUringStreamSocket::enableRead() {
+  read_enabled_ = true;
+  maybeSubmitRead();
+}
+
+void IoUringStreamSocket::disableRead() { read_enabled_ = false; }
+
+uint32_t IoUringStreamSocket::readyEvents() const {
+  uint32_t events = 0;
+  if (read_buffer_.length() > 0 || read_eof_ || read_error_ != 0) {
+    events |= Event::FileReadyType::Read;
+  }
+  if (read_eof_) {
+    events |= Event::FileReadyType::Closed;
+  }
+  if (writable() || write_error_ != 0 || connect_error_ != 0) {
+    events |= Event::FileReadyType::Write;
+  }
+  return events;
+}
+
+void IoUringStreamSocket::onIoCompletion(Request& req, int32_t result) {
+  switch (req.type()) {
+  case RequestType::Read:
+    onReadCompleted(req, result);
+    break;
+  case RequestType::Write:
+    onWriteCompleted(result);
+    break;
+  case RequestType::Connect:
+    ASSERT(&req == connect_req_);
+    connect_req_ = nullptr;
+    onConnectCompleted(result);
+    break;
+  default:
+    PANIC_DUE_TO_CORRUPT_ENUM;
+  }
+}
+
+void IoUringStreamSocket::cancelRequests(bool cancel_writes) {
+  cancel(read_req_);
+  cancel(connect_req_);
+  connect_event_.reset();
+  if (cancel_writes) {
+    // Make sure a partially completed write isn't resubmitted.
+    write_error_ = ECANCELED;
+    cancel(write_req_);
+  }
+}
+
+void IoUringStreamSocket::maybeSubmitRead() {
+  if (!read_enabled_ || !connected_ || closing_ || read_req_ != nullptr || read_eof_ ||
+      read_error_ != 0 || read_buffer_.length() >= parent_.readBufferSize()) {
+    return;
+  }
+  read_req_ = parent_.submitReadRequest(*this);
+}
+
+void IoUringStreamSocket::maybeSubmitWrite() {
+  if (!connected_ || write_req_ != nullptr || write_error_ != 0 || write_buffer_.length() == 0) {
+    return;
+  }
+  write_req_ = parent_.submitWriteRequest(*this, write_buffer_);
+}
+
+void IoUringStreamSocket::onReadCompleted(Request& req, int32_t result) {
+  ASSERT(&req == read_req_);
+  read_req_ = nullptr;
+
+  if (result > 0) {
+    auto& read_req = static_cast<ReadRequest&>(req);
+    read_req.reservation_.commit(result);
+    read_buffer_.move(read_req.buffer_);
+  } else if (result == 0) {
+    read_eof_ = true;
+  } else if (result != -ECANCELED) {
+    ENVOY_LOG(debug, "read failed, fd = {}, error = {}", fd_, errorDetails(-result));
+    read_error_ = -result;
+  }
+
+  if (closing_) {
+    return;
+  }
+  maybeSubmitRead();
+  notify(readyEvents() & (Event::FileReadyType::Read | Event::FileReadyType::Closed));
+}
+
+void IoUringStreamSocket::onWriteCompleted(int32_t result) {
+  write_req_ = nullptr;
+
+  if (result < 0) {
+    if (result != -ECANCELED) {
+      ENVOY_LOG(debug, "write failed, fd = {}, error = {}", fd_, errorDetails(-result));
+      write_error_ = -result;
+    }
+    write_buffer_.drain(write_buffer_.length());
+  } else {
+    write_buffer_.drain(result);
+  }
+
+  // Keep flushing even if the owner has closed the socket already.
+  maybeSubmitWrite();
+  if (write_req_ == nullptr && pending_shutdown_.has_value()) {
+    Api::OsSysCallsSingleton::get().shutdown(fd_, pending_shutdown_.value());
+    pending_shutdown_.reset();
+  }
+
+  if (closing_) {
+    return;
+  }
+  notify(readyEvents() & Event::FileReadyType::Write);
+}
+
+void IoUringStreamSocket::onConnectCompleted(int32_t result) {
+  if (result == 0) {
+    connected_ = true;
+  } else if (result != -ECANCELED) {
+    connect_error_ = -result;
+  }
+
+  if (closing_) {
+    return;
+  }
+  maybeSubmitRead();
+  notify(Event::FileReadyType::Write);
+}
+
+IoUringWorkerFactoryImpl::IoUringWorkerFactoryImpl(uint32_t io_uring_size,
+                                                   bool use_submission_queue_polling,
+                                                   uint32_t read_buffer_size,
+                                                   ThreadLocal::SlotAllocator& tls)
+    : io_uring_size_(io_uring_size), use_submission_queue_polling_(use_submission_queue_polling),
+      read_buffer_size_(read_buffer_size), tls_(tls) {}
+
+OptRef<IoUringWorkerImpl> IoUringWorkerFactoryImpl::getIoUringWorker() {
+  if (!tls_.currentThreadRegistered()) {
+    return absl::nullopt;
+  }
+  return tls_.get();
+}
+
+void IoUringWorkerFactoryImpl::onServerInitialized() {
+  tls_.set([io_uring_size = io_uring_size_,
+            use_submission_queue_polling = use_submission_queue_polling_,
+            read_buffer_size = read_buffer_size_](Event::Dispatcher& dispatcher) {
+    return std::make_shared<IoUringWorkerImpl>(io_uring_size, use_submission_queue_polling,
+                                               read_buffer_size, dispatcher);
+  });
+}
+
+} // namespace Io
+} // namespace Envoy
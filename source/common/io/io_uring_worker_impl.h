@@ -0,0 +1,330 @@
+#pragma once
+
+#include <list>
+
+#include "envoy/common/optref.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/linked_object.h"
+#include "source/common/common/logger.h"
+#include "source/common/io/io_uring.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Io {
+
+class IoUringSocketEntry;
+class IoUringAcceptSocket;
+class IoUringStreamSocket;
+
+enum class RequestType : uint8_t { Accept, Connect, Read, Write, Close, Cancel };
+
+/**
+ * Base class of every request submitted to the ring by an IoUringWorkerImpl. The address of the
+ * request is used as the `user_data` of the submission queue entry, and the request is owned by
+ * the worker until its completion has been delivered to the socket.
+ */
+class Request {
+public:
+  Request(RequestType type, IoUringSocketEntry& socket) : type_(type), socket_(socket) {}
+  virtual ~Request() = default;
+
+  RequestType type() const { return type_; }
+  IoUringSocketEntry& socket() const { return socket_; }
+
+private:
+  const RequestType type_;
+  IoUringSocketEntry& socket_;
+};
+
+/**
+ * Per-thread owner of an io_uring instance. The worker registers the ring's eventfd with the
+ * thread's dispatcher, so completions are processed by the event loop like any other file event.
+ * Submissions prepared during one loop iteration are flushed to the kernel with a single
+ * io_uring_enter() at the end of that iteration.
+ */
+class IoUringWorkerImpl : public ThreadLocal::ThreadLocalObject,
+                          protected Logger::Loggable<Logger::Id::io> {
+public:
+  IoUringWorkerImpl(uint32_t io_uring_size, bool use_submission_queue_polling,
+                    uint32_t read_buffer_size, Event::Dispatcher& dispatcher);
+  IoUringWorkerImpl(IoUringPtr io_uring, uint32_t read_buffer_size,
+                    Event::Dispatcher& dispatcher);
+  ~IoUringWorkerImpl() override;
+
+  /**
+   * Registers a listening socket with the worker. Accepted connections are queued in the socket
+   * and `cb` is called with Event::FileReadyType::Read once they are available.
+   */
+  IoUringAcceptSocket& addAcceptSocket(os_fd_t fd, Event::FileReadyCb cb);
+
+  /**
+   * Registers a connected or connecting stream socket with the worker.
+   * @param connected supplies whether reads may be submitted immediately. When false, reads are
+   *        deferred until IoUringStreamSocket::connect() or IoUringStreamSocket::awaitConnect()
+   *        completes successfully.
+   */
+  IoUringStreamSocket& addStreamSocket(os_fd_t fd, bool connected, Event::FileReadyCb cb);
+
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+  uint32_t readBufferSize() const { return read_buffer_size_; }
+  size_t numSockets() const { return sockets_.size(); }
+
+  // Helpers used by sockets to submit requests. The returned request is owned by the worker.
+  Request* submitAcceptRequest(IoUringAcceptSocket& socket);
+  Request* submitConnectRequest(IoUringStreamSocket& socket,
+                                const Network::Address::InstanceConstSharedPtr& address);
+  Request* submitReadRequest(IoUringStreamSocket& socket);
+  Request* submitWriteRequest(IoUringStreamSocket& socket, const Buffer::Instance& data);
+  Request* submitCloseRequest(IoUringSocketEntry& socket);
+  Request* submitCancelRequest(IoUringSocketEntry& socket, Request* request_to_cancel);
+
+private:
+  template <class F> void prepare(F prepare_fn);
+  void onFileEvent();
+  void submit();
+
+  IoUringPtr io_uring_;
+  const uint32_t read_buffer_size_;
+  Event::Dispatcher& dispatcher_;
+  Event::FileEventPtr file_event_;
+  Event::SchedulableCallbackPtr submit_cb_;
+  std::list<std::unique_ptr<IoUringSocketEntry>> sockets_;
+};
+
+/**
+ * State of a socket driven by an IoUringWorkerImpl. The entry emulates readiness-based IO on top
+ * of the completion-based ring: completed data is buffered in the entry and the owner is notified
+ * with the same event bits an Event::FileEvent would deliver. The entry is owned by the worker
+ * and outlives the owning IoHandle until all of its in-flight requests have completed.
+ */
+class IoUringSocketEntry : public LinkedObject<IoUringSocketEntry>,
+                           protected Logger::Loggable<Logger::Id::io> {
+public:
+  IoUringSocketEntry(os_fd_t fd, IoUringWorkerImpl& parent, Event::FileReadyCb cb);
+  virtual ~IoUringSocketEntry() = default;
+
+  os_fd_t fd() const { return fd_; }
+
+  /**
+   * Replaces the callback used to deliver events. A null callback detaches the owner while
+   * keeping buffered data, e.g. between listener filters and connection creation.
+   */
+  void setFileReadyCb(Event::FileReadyCb cb) { cb_ = std::move(cb); }
+
+  /**
+   * Detaches the owner, cancels in-flight requests and closes the fd through the ring once they
+   * have completed.
+   * @param flush_writes supplies whether in-flight writes are allowed to complete first.
+   */
+  void close(bool flush_writes);
+
+  /**
+   * Allows or disallows the entry to keep a read (or accept) request in flight.
+   */
+  virtual void enableRead() PURE;
+  virtual void disableRead() PURE;
+
+  /**
+   * @return the Event::FileReadyType bits which would be reported as ready right now.
+   */
+  virtual uint32_t readyEvents() const PURE;
+
+  /**
+   * Handles the completion of a request previously submitted for this entry.
+   */
+  void onRequestCompletion(Request& req, int32_t result);
+
+  /**
+   * @return true once the close request for the fd has completed and the entry can be removed.
+   */
+  bool closed() const { return closed_; }
+
+protected:
+  void notify(uint32_t events);
+  // Submits a cancellation of `req` unless one has been submitted already.
+  void cancel(Request* req);
+  // Submits the close request once nothing is in flight any more.
+  void maybeSubmitClose();
+
+  // Handles the completion of an accept, connect, read or write request.
+  virtual void onIoCompletion(Request& req, int32_t result) PURE;
+  // Cancels every request which must not outlive the owner.
+  virtual void cancelRequests(bool cancel_writes) PURE;
+  virtual bool hasInflightRequests() const PURE;
+
+  const os_fd_t fd_;
+  IoUringWorkerImpl& parent_;
+  Event::FileReadyCb cb_;
+  bool closing_{false};
+  bool close_submitted_{false};
+  bool closed_{false};
+  uint32_t inflight_cancels_{0};
+  absl::flat_hash_set<Request*> cancelled_requests_;
+};
+
+using IoUringSocketEntryPtr = std::unique_ptr<IoUringSocketEntry>;
+
+/**
+ * Listening socket which keeps one accept request in flight while reading is enabled.
+ */
+class IoUringAcceptSocket : public IoUringSocketEntry {
+public:
+  struct AcceptedSocket {
+    os_fd_t fd_;
+    sockaddr_storage remote_addr_;
+    socklen_t remote_addr_len_;
+  };
+
+  IoUringAcceptSocket(os_fd_t fd, IoUringWorkerImpl& parent, Event::FileReadyCb cb);
+  ~IoUringAcceptSocket() override;
+
+  /**
+   * @return the oldest accepted socket which hasn't been handed out yet, if any.
+   */
+  absl::optional<AcceptedSocket> popAcceptedSocket();
+
+  // IoUringSocketEntry
+  void enableRead() override;
+  void disableRead() override;
+  uint32_t readyEvents() const override;
+
+private:
+  // IoUringSocketEntry
+  void onIoCompletion(Request& req, int32_t result) override;
+  void cancelRequests(bool cancel_writes) override;
+  bool hasInflightRequests() const override { return accept_req_ != nullptr; }
+
+  void maybeSubmitAccept();
+
+  bool read_enabled_{false};
+  Request* accept_req_{nullptr};
+  std::list<AcceptedSocket> accepted_sockets_;
+};
+
+/**
+ * Stream socket which keeps at most one read and one write request in flight. Read data is
+ * committed into a buffer owned by the entry, so it can be moved into connection buffers without
+ * copying.
+ */
+class IoUringStreamSocket : public IoUringSocketEntry {
+public:
+  IoUringStreamSocket(os_fd_t fd, bool connected, IoUringWorkerImpl& parent,
+                      Event::FileReadyCb cb);
+
+  /**
+   * Submits an asynchronous connect. Event::FileReadyType::Write is delivered on completion and
+   * the outcome can be retrieved with connectError().
+   */
+  void connect(const Network::Address::InstanceConstSharedPtr& address);
+  /**
+   * Waits for a connect which was issued on the fd before the worker took it over. The ring can't
+   * report the outcome of such a connect, so it is awaited with a file event of the dispatcher,
+   * then completes like connect().
+   */
+  void awaitConnect();
+  bool connecting() const { return connect_req_ != nullptr || connect_event_ != nullptr; }
+  // errno of the completed connect, 0 on success.
+  int connectError() const { return connect_error_; }
+
+  /**
+   * Moves as much of `data` as the write buffer accepts, up to the read buffer size, and submits
+   * a write if none is in flight.
+   * @return the number of bytes taken from `data`.
+   */
+  uint64_t write(Buffer::Instance& data);
+  // True if write() would accept at least one byte.
+  bool writable() const;
+  // errno of the first failed write, 0 if no write has failed.
+  int writeError() const { return write_error_; }
+
+  /**
+   * Shuts down the socket once all buffered data has been written.
+   */
+  void shutdown(int how);
+
+  // Data read from the socket but not consumed by the owner yet.
+  Buffer::Instance& readBuffer() { return read_buffer_; }
+  bool readEof() const { return read_eof_; }
+  // errno of the failed read, 0 if no read has failed.
+  int readError() const { return read_error_; }
+
+  // IoUringSocketEntry
+  void enableRead() override;
+  void disableRead() override;
+  uint32_t readyEvents() const override;
+
+private:
+  // IoUringSocketEntry
+  void onIoCompletion(Request& req, int32_t result) override;
+  void cancelRequests(bool cancel_writes) override;
+  bool hasInflightRequests() const override {
+    return read_req_ != nullptr || write_req_ != nullptr || connect_req_ != nullptr;
+  }
+
+  void maybeSubmitRead();
+  void maybeSubmitWrite();
+  void onReadCompleted(Request& req, int32_t result);
+  void onWriteCompleted(int32_t result);
+  void onConnectCompleted(int32_t result);
+
+  bool connected_;
+  bool read_enabled_{false};
+  bool read_eof_{false};
+  int read_error_{0};
+  int write_error_{0};
+  int connect_error_{0};
+  absl::optional<int> pending_shutdown_;
+  Request* read_req_{nullptr};
+  Request* write_req_{nullptr};
+  Request* connect_req_{nullptr};
+  // Set while awaiting a connect issued before the worker took the fd over.
+  Event::FileEventPtr connect_event_;
+  Buffer::OwnedImpl read_buffer_;
+  Buffer::OwnedImpl write_buffer_;
+};
+
+/**
+ * Abstract factory providing the IoUringWorkerImpl of the calling thread.
+ */
+class IoUringWorkerFactory {
+public:
+  virtual ~IoUringWorkerFactory() = default;
+
+  /**
+   * @return the worker of the current thread, or absl::nullopt if the thread has no worker.
+   */
+  virtual OptRef<IoUringWorkerImpl> getIoUringWorker() PURE;
+
+  /**
+   * Creates a worker for every registered thread. Must be called on the main thread once the
+   * server's threads are registered with thread local storage.
+   */
+  virtual void onServerInitialized() PURE;
+};
+
+using IoUringWorkerFactorySharedPtr = std::shared_ptr<IoUringWorkerFactory>;
+
+class IoUringWorkerFactoryImpl : public IoUringWorkerFactory {
+public:
+  IoUringWorkerFactoryImpl(uint32_t io_uring_size, bool use_submission_queue_polling,
+                           uint32_t read_buffer_size, ThreadLocal::SlotAllocator& tls);
+
+  // IoUringWorkerFactory
+  OptRef<IoUringWorkerImpl> getIoUringWorker() override;
+  void onServerInitialized() override;
+
+private:
+  const uint32_t io_uring_size_;
+  const bool use_submission_queue_polling_;
+  const uint32_t read_buffer_size_;
+  ThreadLocal::TypedSlot<IoUringWorkerImpl> tls_;
+};
+
+} // namespace Io
+} // namespace Envoy
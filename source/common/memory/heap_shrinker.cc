@@ -1,5 +1,6 @@
 #include "source/common/memory/heap_shrinker.h"
 
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/memory/utils.h"
 #include "source/common/stats/symbol_table.h"
 
@@ -17,7 +18,12 @@ HeapShrinker::HeapShrinker(Event::Dispatcher& dispatcher, Server::OverloadManage
   const auto action_name = Server::OverloadActionNames::get().ShrinkHeap;
   if (overload_manager.registerForAction(
           action_name, dispatcher,
-          [this](Server::OverloadActionState state) { active_ = state.isSaturated(); })) {
+          [this](Server::OverloadActionState state) {
+            active_ = state.isSaturated();
+            // Stop pooling buffer slice storage on the workers, so that it can be released too.
+            Buffer::SlicePool::setMaxBytesPerThread(
+                active_ ? 0 : Buffer::SlicePool::DefaultMaxBytesPerThread);
+          })) {
     Envoy::Stats::StatNameManagedStorage stat_name(
         absl::StrCat("overload.", action_name, ".shrink_count"), stats.symbolTable());
     shrink_counter_ = &stats.counterFromStatName(stat_name.statName());
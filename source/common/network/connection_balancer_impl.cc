@@ -1,5 +1,8 @@
 #include "source/common/network/connection_balancer_impl.h"
 
+#include <thread>
+#include <utility>
+
 namespace Envoy {
 namespace Network {
 
@@ -34,5 +37,85 @@ ExactConnectionBalancerImpl::pickTargetHandler(BalancedConnectionHandler&) {
   return *min_connection_handler;
 }
 
+LeastLoadedConnectionBalancerImpl::~LeastLoadedConnectionBalancerImpl() {
+  Slot* slot = head_.load();
+  while (slot != nullptr) {
+    delete std::exchange(slot, slot->next_);
+  }
+}
+
+void LeastLoadedConnectionBalancerImpl::registerHandler(BalancedConnectionHandler& handler) {
+  absl::MutexLock lock(&lock_);
+  for (Slot* slot = head_.load(); slot != nullptr; slot = slot->next_) {
+    if (slot->handler_.load() == nullptr) {
+      slot->handler_.store(&handler);
+      return;
+    }
+  }
+
+  auto* slot = new Slot();
+  slot->handler_.store(&handler);
+  slot->next_ = head_.load();
+  head_.store(slot);
+}
+
+void LeastLoadedConnectionBalancerImpl::unregisterHandler(BalancedConnectionHandler& handler) {
+  absl::MutexLock lock(&lock_);
+  for (Slot* slot = head_.load(); slot != nullptr; slot = slot->next_) {
+    if (slot->handler_.load() == &handler) {
+      slot->handler_.store(nullptr);
+      break;
+    }
+  }
+
+  // A pick that starts after the slot is cleared cannot see the handler anymore. Wait for the
+  // picks that started before, so that the handler can be destroyed once this returns.
+  const uint32_t previous_epoch = epoch_.fetch_add(1) & 1;
+  while (active_picks_[previous_epoch].load() != 0) {
+    std::this_thread::yield();
+  }
+}
+
+BalancedConnectionHandler&
+LeastLoadedConnectionBalancerImpl::pickTargetHandler(BalancedConnectionHandler& current_handler) {
+  // The pick must be counted in the epoch which is current once it is counted: a pick counted in
+  // an epoch that has already been flipped may not be waited for. Count it again if the epoch
+  // changed in between.
+  uint32_t epoch = epoch_.load();
+  while (true) {
+    active_picks_[epoch & 1].fetch_add(1);
+    const uint32_t current_epoch = epoch_.load();
+    if (current_epoch == epoch) {
+      break;
+    }
+    active_picks_[epoch & 1].fetch_sub(1);
+    epoch = current_epoch;
+  }
+  std::atomic<uint64_t>& active_picks = active_picks_[epoch & 1];
+
+  const uint64_t current_connections = current_handler.numConnections();
+  BalancedConnectionHandler* min_connection_handler = &current_handler;
+  uint64_t min_connections = current_connections;
+  for (Slot* slot = head_.load(); slot != nullptr; slot = slot->next_) {
+    BalancedConnectionHandler* handler = slot->handler_.load();
+    if (handler == nullptr || handler == &current_handler) {
+      continue;
+    }
+    const uint64_t connections = handler->numConnections();
+    if (connections < min_connections) {
+      min_connection_handler = handler;
+      min_connections = connections;
+    }
+  }
+
+  if (current_connections - min_connections <= max_imbalance_) {
+    min_connection_handler = &current_handler;
+  }
+  min_connection_handler->incNumConnections();
+
+  active_picks.fetch_sub(1);
+  return *min_connection_handler;
+}
+
 } // namespace Network
 } // namespace Envoy
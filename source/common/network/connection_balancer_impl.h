@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "envoy/config/listener/v3/listener.pb.h"
 #include "envoy/network/connection_balancer.h"
 #include "envoy/registry/registry.h"
@@ -44,6 +46,48 @@ private:
   std::vector<BalancedConnectionHandler*> handlers_ ABSL_GUARDED_BY(lock_);
 };
 
+/**
+ * Implementation of connection balancer that sends each connection to the handler with the fewest
+ * connections without taking a lock on the accept path. Connection counts are the per-handler
+ * atomics maintained by the handlers themselves, so connections accepted in parallel by different
+ * handlers may pick the same target and counts are only approximately balanced. A connection stays
+ * on the accepting handler unless it has more than max_imbalance connections above the least
+ * loaded handler, which avoids cross-thread transfers when the handlers are already balanced. This
+ * balancer should be used when connection lifetimes are skewed and accept throughput matters.
+ */
+class LeastLoadedConnectionBalancerImpl : public ConnectionBalancer {
+public:
+  explicit LeastLoadedConnectionBalancerImpl(uint32_t max_imbalance = 0)
+      : max_imbalance_(max_imbalance) {}
+  ~LeastLoadedConnectionBalancerImpl() override;
+
+  // ConnectionBalancer
+  void registerHandler(BalancedConnectionHandler& handler) override;
+  void unregisterHandler(BalancedConnectionHandler& handler) override;
+  BalancedConnectionHandler& pickTargetHandler(BalancedConnectionHandler& current_handler) override;
+
+private:
+  // Handlers are kept in a singly linked list of slots which is only ever prepended to. Slots are
+  // reused but not freed until the balancer is destroyed, so pickers can walk the list while
+  // handlers are registered and unregistered.
+  struct Slot {
+    std::atomic<BalancedConnectionHandler*> handler_{};
+    Slot* next_{};
+  };
+
+  const uint32_t max_imbalance_;
+  std::atomic<Slot*> head_{};
+  // The number of picks in progress for each of two epochs. unregisterHandler() flips the epoch
+  // and waits for the picks of the previous epoch, which may still be using the handler, to
+  // finish. Picks starting after the flip are counted in the other epoch, so the wait is bounded
+  // even when connections are accepted continuously. A pick checks that the epoch did not change
+  // while it was being counted.
+  std::atomic<uint32_t> epoch_{};
+  std::atomic<uint64_t> active_picks_[2]{};
+  // Serializes registerHandler() and unregisterHandler().
+  absl::Mutex lock_;
+};
+
 /**
  * A NOP connection balancer implementation that always continues execution after incrementing
  * the handler's connection count.
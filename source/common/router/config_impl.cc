@@ -73,6 +73,44 @@ void mergeTransforms(Http::HeaderTransforms& dest, const Http::HeaderTransforms&
                                 src.headers_to_remove.end());
 }
 
+// Returns the first route in [begin, end) which matches the request and is accepted by `cb`.
+template <class Iterator, class RouteGetter>
+RouteConstSharedPtr findFirstMatchingRoute(Iterator begin, Iterator end, RouteGetter get_route,
+                                           const RouteCallback& cb,
+                                           const Http::RequestHeaderMap& headers,
+                                           const StreamInfo::StreamInfo& stream_info,
+                                           uint64_t random_value) {
+  for (auto it = begin; it != end; ++it) {
+    const RouteEntryImplBaseConstSharedPtr& route = get_route(*it);
+    if (!headers.Path() && !route->supportsPathlessHeaders()) {
+      continue;
+    }
+
+    RouteConstSharedPtr route_entry = route->matches(headers, stream_info, random_value);
+    if (nullptr == route_entry) {
+      continue;
+    }
+
+    if (cb) {
+      RouteEvalStatus eval_status = (std::next(it) == end) ? RouteEvalStatus::NoMoreRoutes
+                                                           : RouteEvalStatus::HasMoreRoutes;
+      RouteMatchStatus match_status = cb(route_entry, eval_status);
+      if (match_status == RouteMatchStatus::Accept) {
+        return route_entry;
+      }
+      if (match_status == RouteMatchStatus::Continue &&
+          eval_status == RouteEvalStatus::NoMoreRoutes) {
+        return nullptr;
+      }
+      continue;
+    }
+
+    return route_entry;
+  }
+
+  return nullptr;
+}
+
 RouteEntryImplBaseConstSharedPtr createAndValidateRoute(
     const envoy::config::route::v3::Route& route_config, const VirtualHostImpl& vhost,
     const OptionalHttpFilters& optional_http_filters,
@@ -222,7 +260,14 @@ std::string SslRedirector::newPath(const Http::RequestHeaderMap& headers) const
 HedgePolicyImpl::HedgePolicyImpl(const envoy::config::route::v3::HedgePolicy& hedge_policy)
     : initial_requests_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(hedge_policy, initial_requests, 1)),
       additional_request_chance_(hedge_policy.additional_request_chance()),
-      hedge_on_per_try_timeout_(hedge_policy.hedge_on_per_try_timeout()) {}
+      hedge_on_per_try_timeout_(hedge_policy.hedge_on_per_try_timeout()) {
+  if (hedge_policy.has_hedge_on_response_time()) {
+    const auto& hedge_on_response_time = hedge_policy.hedge_on_response_time();
+    hedge_on_response_time_percentile_ = hedge_on_response_time.percentile();
+    hedge_budget_percent_ =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(hedge_on_response_time, budget_percent, 10.0);
+  }
+}
 
 HedgePolicyImpl::HedgePolicyImpl() : initial_requests_(1), hedge_on_per_try_timeout_(false) {}
 
@@ -1796,6 +1841,14 @@ VirtualHostImpl::VirtualHostImpl(
       routes_.emplace_back(createAndValidateRoute(route, *this, optional_http_filters,
                                                   factory_context, validator, validation_clusters));
     }
+
+    if (virtual_host.enable_route_path_index()) {
+      auto route_path_index = std::make_unique<RoutePathIndex>();
+      for (uint32_t i = 0; i < routes_.size(); i++) {
+        route_path_index->addRoute(i, routes_[i]->matchType(), routes_[i]->matcher());
+      }
+      route_path_index_ = std::move(route_path_index);
+    }
   }
 
   if (!virtual_host.virtual_clusters().empty()) {
@@ -1974,38 +2027,34 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const RouteCallback& cb
     ENVOY_LOG(debug, "failed to match incoming request: {}", static_cast<int>(match.match_state_));
 
     return nullptr;
-  } else {
-    // Check for a route that matches the request.
-    for (auto route = routes_.begin(); route != routes_.end(); ++route) {
-      if (!headers.Path() && !(*route)->supportsPathlessHeaders()) {
-        continue;
-      }
-
-      RouteConstSharedPtr route_entry = (*route)->matches(headers, stream_info, random_value);
-      if (nullptr == route_entry) {
-        continue;
+  } else if (route_path_index_ != nullptr) {
+    absl::optional<absl::string_view> path;
+    if (headers.Path()) {
+      // Strip the request path the same way the path matchers of the indexed routes do.
+      absl::string_view sanitized_path =
+          Http::PathUtil::removeQueryAndFragment(headers.getPathValue());
+      if (global_route_config_.ignorePathParametersInPathMatching()) {
+        sanitized_path = sanitized_path.substr(0, sanitized_path.find(';'));
       }
-
-      if (cb) {
-        RouteEvalStatus eval_status = (std::next(route) == routes_.end())
-                                          ? RouteEvalStatus::NoMoreRoutes
-                                          : RouteEvalStatus::HasMoreRoutes;
-        RouteMatchStatus match_status = cb(route_entry, eval_status);
-        if (match_status == RouteMatchStatus::Accept) {
-          return route_entry;
-        }
-        if (match_status == RouteMatchStatus::Continue &&
-            eval_status == RouteEvalStatus::NoMoreRoutes) {
-          return nullptr;
-        }
-        continue;
-      }
-
-      return route_entry;
+      path = sanitized_path;
     }
-  }
-
-  return nullptr;
+    RoutePathIndex::Candidates candidates;
+    route_path_index_->findCandidates(path, candidates);
+    return findFirstMatchingRoute(
+        candidates.begin(), candidates.end(),
+        [this](uint32_t index) -> const RouteEntryImplBaseConstSharedPtr& {
+          return routes_[index];
+        },
+        cb, headers, stream_info, random_value);
+  }
+
+  // Check for a route that matches the request.
+  return findFirstMatchingRoute(
+      routes_.begin(), routes_.end(),
+      [](const RouteEntryImplBaseConstSharedPtr& route) -> const RouteEntryImplBaseConstSharedPtr& {
+        return route;
+      },
+      cb, headers, stream_info, random_value);
 }
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::RequestHeaderMap& headers) const {
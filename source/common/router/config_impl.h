@@ -30,6 +30,7 @@
 #include "source/common/router/header_formatter.h"
 #include "source/common/router/header_parser.h"
 #include "source/common/router/metadatamatchcriteria_impl.h"
+#include "source/common/router/route_path_index.h"
 #include "source/common/router/router_ratelimit.h"
 #include "source/common/router/tls_context_match_criteria_impl.h"
 #include "source/common/stats/symbol_table.h"
@@ -337,6 +338,8 @@ private:
   std::unique_ptr<envoy::config::route::v3::HedgePolicy> hedge_policy_;
   std::unique_ptr<const CatchAllVirtualCluster> virtual_cluster_catch_all_;
   Matcher::MatchTreeSharedPtr<Http::HttpMatchingData> matcher_;
+  // Set if the routes are looked up by path rather than evaluated one by one.
+  RoutePathIndexConstPtr route_path_index_;
   // Keep small members (bools and enums) at the end of class, to reduce alignment overhead.
   uint32_t retry_shadow_buffer_limit_{std::numeric_limits<uint32_t>::max()};
   SslRequirements ssl_requirements_;
@@ -452,11 +455,17 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  absl::optional<double> hedgeOnResponseTimePercentile() const override {
+    return hedge_on_response_time_percentile_;
+  }
+  double hedgeBudgetPercent() const override { return hedge_budget_percent_; }
 
 private:
   const uint32_t initial_requests_;
   const envoy::type::v3::FractionalPercent additional_request_chance_;
   const bool hedge_on_per_try_timeout_;
+  absl::optional<double> hedge_on_response_time_percentile_;
+  double hedge_budget_percent_{};
 };
 using DefaultHedgePolicy = ConstSingleton<HedgePolicyImpl>;
 
@@ -1,5 +1,6 @@
 #include "source/common/router/retry_state_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -111,6 +112,12 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy,
   backoff_strategy_ = std::make_unique<JitteredExponentialBackOffStrategy>(
       base_interval.count(), max_interval.count(), random_);
   host_selection_max_attempts_ = route_policy.hostSelectionMaxAttempts();
+  retry_token_buckets_ = cluster_.retryTokenBuckets();
+  if (retry_token_buckets_.has_value()) {
+    // Leave the retries room to find a host the token buckets don't avoid.
+    host_selection_max_attempts_ = std::max(host_selection_max_attempts_,
+                                            retry_token_buckets_->get().hostSelectionMaxAttempts());
+  }
 
   // Merge in the headers.
   if (request_headers.EnvoyRetryOn()) {
@@ -322,6 +329,12 @@ RetryStatus RetryStateImpl::shouldRetry(RetryDecision would_retry, DoRetryCallba
     return RetryStatus::No;
   }
 
+  if (retry_token_buckets_.has_value() &&
+      !retry_token_buckets_->get().clusterBucket().tryTakeToken()) {
+    cluster_.trafficStats()->upstream_rq_retry_token_bucket_exhausted_.inc();
+    return RetryStatus::NoOverflow;
+  }
+
   ASSERT(!backoff_callback_ && !next_loop_callback_);
   cluster_.resourceManager(priority_).retries().inc();
   cluster_.trafficStats()->upstream_rq_retry_.inc();
@@ -341,6 +354,49 @@ RetryStatus RetryStateImpl::shouldRetry(RetryDecision would_retry, DoRetryCallba
   return RetryStatus::Yes;
 }
 
+void RetryStateImpl::onHostAttempted(Upstream::HostDescriptionConstSharedPtr host) {
+  std::for_each(retry_host_predicates_.begin(), retry_host_predicates_.end(),
+                [&host](auto predicate) { predicate->onHostAttempted(host); });
+  if (retry_priority_) {
+    retry_priority_->onHostAttempted(host);
+  }
+
+  // Every attempt after the first one is a retry, which takes a token of the host.
+  if (host_attempted_) {
+    Upstream::RetryTokenBucketOptRef host_bucket = host->retryTokenBucket();
+    if (host_bucket.has_value()) {
+      host_bucket->get().tryTakeToken();
+    }
+  }
+  host_attempted_ = true;
+}
+
+bool RetryStateImpl::shouldSelectAnotherHost(const Upstream::Host& host) {
+  if (std::any_of(retry_host_predicates_.begin(), retry_host_predicates_.end(),
+                  [&host](auto predicate) { return predicate->shouldSelectAnotherHost(host); })) {
+    return true;
+  }
+  if (shouldAvoidHost(host)) {
+    cluster_.trafficStats()->upstream_rq_retry_host_skipped_.inc();
+    return true;
+  }
+  return false;
+}
+
+bool RetryStateImpl::shouldAvoidHost(const Upstream::Host& host) const {
+  if (!retry_token_buckets_.has_value()) {
+    return false;
+  }
+  const Upstream::RetryTokenBucketOptRef host_bucket = host.retryTokenBucket();
+  if (host_bucket.has_value() && !host_bucket->get().hasToken()) {
+    return true;
+  }
+  // The host is likely failing, and about to be ejected if outlier detection enforces it.
+  const uint32_t host_failure_streak = retry_token_buckets_->get().hostFailureStreak();
+  return host_failure_streak > 0 &&
+         host.outlierDetector().consecutiveFailures() >= host_failure_streak;
+}
+
 RetryStatus RetryStateImpl::shouldRetryHeaders(const Http::ResponseHeaderMap& response_headers,
                                                const Http::RequestHeaderMap& original_request,
                                                DoRetryHeaderCallback callback) {
@@ -68,19 +68,8 @@ public:
                                DoRetryResetCallback callback) override;
   RetryStatus shouldHedgeRetryPerTryTimeout(DoRetryCallback callback) override;
 
-  void onHostAttempted(Upstream::HostDescriptionConstSharedPtr host) override {
-    std::for_each(retry_host_predicates_.begin(), retry_host_predicates_.end(),
-                  [&host](auto predicate) { predicate->onHostAttempted(host); });
-    if (retry_priority_) {
-      retry_priority_->onHostAttempted(host);
-    }
-  }
-
-  bool shouldSelectAnotherHost(const Upstream::Host& host) override {
-    return std::any_of(
-        retry_host_predicates_.begin(), retry_host_predicates_.end(),
-        [&host](auto predicate) { return predicate->shouldSelectAnotherHost(host); });
-  }
+  void onHostAttempted(Upstream::HostDescriptionConstSharedPtr host) override;
+  bool shouldSelectAnotherHost(const Upstream::Host& host) override;
 
   const Upstream::HealthyAndDegradedLoad& priorityLoadForRetry(
       const Upstream::PrioritySet& priority_set,
@@ -115,6 +104,8 @@ private:
   RetryDecision wouldRetryFromReset(const Http::StreamResetReason reset_reason,
                                     Http3Used http3_used, bool& disable_http3);
   RetryStatus shouldRetry(RetryDecision would_retry, DoRetryCallback callback);
+  // Returns if the retry token buckets of the cluster have a retry avoid the host.
+  bool shouldAvoidHost(const Upstream::Host& host) const;
 
   const Upstream::ClusterInfo& cluster_;
   const VirtualCluster* vcluster_;
@@ -134,6 +125,8 @@ private:
   std::vector<Upstream::RetryHostPredicateSharedPtr> retry_host_predicates_;
   Upstream::RetryPrioritySharedPtr retry_priority_;
   uint32_t host_selection_max_attempts_;
+  Upstream::RetryTokenBucketsOptRef retry_token_buckets_;
+  bool host_attempted_{};
   std::vector<uint32_t> retriable_status_codes_;
   std::vector<Http::HeaderMatcherSharedPtr> retriable_headers_;
   std::vector<ResetHeaderParserSharedPtr> reset_headers_{};
@@ -0,0 +1,124 @@
+#include "source/common/router/route_path_index.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+
+namespace Envoy {
+namespace Router {
+
+void RoutePathIndex::addRoute(uint32_t route_index, PathMatchType match_type,
+                              absl::string_view path) {
+  if (match_type != PathMatchType::Prefix && match_type != PathMatchType::Exact &&
+      match_type != PathMatchType::PathSeparatedPrefix) {
+    ASSERT(unindexed_routes_.empty() || unindexed_routes_.back() < route_index);
+    unindexed_routes_.push_back(route_index);
+    return;
+  }
+
+  // Keys are lowercased so that case insensitive routes can share the trie with case sensitive
+  // ones. The case of the request path is checked when the candidate is evaluated.
+  const std::string key = absl::AsciiStrToLower(path);
+  Node* node = &root_;
+  size_t pos = 0;
+  while (pos < key.size()) {
+    auto it = node->children_.find(key[pos]);
+    if (it == node->children_.end()) {
+      auto child = std::make_unique<Node>();
+      child->label_ = key.substr(pos);
+      node = node->children_.emplace(key[pos], std::move(child)).first->second.get();
+      num_nodes_++;
+      break;
+    }
+
+    Node* child = it->second.get();
+    const absl::string_view remaining = absl::string_view(key).substr(pos);
+    const size_t common =
+        std::mismatch(child->label_.begin(),
+                      child->label_.begin() + std::min(child->label_.size(), remaining.size()),
+                      remaining.begin())
+            .first -
+        child->label_.begin();
+    if (common < child->label_.size()) {
+      // Split the edge so that the key ends at, or branches off from, a node.
+      auto split = std::make_unique<Node>();
+      split->label_ = child->label_.substr(0, common);
+      std::unique_ptr<Node> tail = std::move(it->second);
+      tail->label_ = tail->label_.substr(common);
+      const char tail_first = tail->label_[0];
+      split->children_.emplace(tail_first, std::move(tail));
+      it->second = std::move(split);
+      child = it->second.get();
+      num_nodes_++;
+    }
+    node = child;
+    pos += common;
+  }
+
+  switch (match_type) {
+  case PathMatchType::Prefix:
+    node->prefix_routes_.push_back(route_index);
+    break;
+  case PathMatchType::Exact:
+    node->exact_routes_.push_back(route_index);
+    break;
+  case PathMatchType::PathSeparatedPrefix:
+    node->path_separated_prefix_routes_.push_back(route_index);
+    break;
+  default:
+    PANIC_DUE_TO_CORRUPT_ENUM;
+  }
+}
+
+void RoutePathIndex::findCandidates(absl::optional<absl::string_view> path,
+                                    Candidates& candidates) const {
+  candidates.clear();
+
+  if (path.has_value()) {
+    const absl::string_view request_path = path.value();
+    const Node* node = &root_;
+    size_t pos = 0;
+    while (true) {
+      candidates.insert(candidates.end(), node->prefix_routes_.begin(),
+                        node->prefix_routes_.end());
+      const bool at_end = pos == request_path.size();
+      if (at_end || request_path[pos] == '/') {
+        candidates.insert(candidates.end(), node->path_separated_prefix_routes_.begin(),
+                          node->path_separated_prefix_routes_.end());
+      }
+      if (at_end) {
+        candidates.insert(candidates.end(), node->exact_routes_.begin(),
+                          node->exact_routes_.end());
+        break;
+      }
+
+      const auto it = node->children_.find(absl::ascii_tolower(request_path[pos]));
+      if (it == node->children_.end()) {
+        break;
+      }
+      const std::string& label = it->second->label_;
+      if (request_path.size() - pos < label.size() ||
+          !absl::EqualsIgnoreCase(label, request_path.substr(pos, label.size()))) {
+        break;
+      }
+      node = it->second.get();
+      pos += label.size();
+    }
+
+    // Routes are collected from the shortest key to the longest, which is rarely the order they
+    // were configured in.
+    std::sort(candidates.begin(), candidates.end());
+  }
+
+  if (!unindexed_routes_.empty()) {
+    const size_t num_indexed = candidates.size();
+    candidates.insert(candidates.end(), unindexed_routes_.begin(), unindexed_routes_.end());
+    std::inplace_merge(candidates.begin(), candidates.begin() + num_indexed, candidates.end());
+  }
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/router/router.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index over the routes of a virtual host which narrows a request path down to the routes that
+ * can possibly match it. Prefix, exact path and path separated prefix routes are stored in a radix
+ * trie keyed by their lowercased path, so a lookup only visits the trie nodes along the request
+ * path. All other routes are returned for every lookup.
+ *
+ * The index is conservative: it may return routes whose path does not match (e.g. case sensitive
+ * routes differing only in case), so every candidate still has to be evaluated with
+ * Matchable::matches(). Candidates are returned in configuration order, which keeps first-match
+ * semantics intact.
+ */
+class RoutePathIndex {
+public:
+  using Candidates = absl::InlinedVector<uint32_t, 8>;
+
+  /**
+   * Adds the route at position `route_index` of the virtual host.
+   * @param match_type supplies the path match type of the route. Routes of any type other than
+   *        Prefix, Exact and PathSeparatedPrefix are evaluated for every request.
+   * @param path supplies the path, prefix or path separated prefix of the route.
+   * Routes must be added in ascending `route_index` order.
+   */
+  void addRoute(uint32_t route_index, PathMatchType match_type, absl::string_view path);
+
+  /**
+   * Collects the routes which may match a request.
+   * @param path supplies the request path with the query string and fragment removed, or
+   *        absl::nullopt if the request has no path.
+   * @param candidates receives the indices of the candidate routes in ascending order.
+   */
+  void findCandidates(absl::optional<absl::string_view> path, Candidates& candidates) const;
+
+  /**
+   * @return the number of trie nodes, for tests.
+   */
+  uint64_t numNodes() const { return num_nodes_; }
+
+private:
+  struct Node {
+    // Label of the edge from the parent node. Empty for the root node.
+    std::string label_;
+    std::vector<uint32_t> prefix_routes_;
+    std::vector<uint32_t> exact_routes_;
+    std::vector<uint32_t> path_separated_prefix_routes_;
+    // Children keyed by the first character of their label.
+    absl::flat_hash_map<char, std::unique_ptr<Node>> children_;
+  };
+
+  Node root_;
+  uint64_t num_nodes_{1};
+  // Routes which can't be indexed by path, in configuration order.
+  std::vector<uint32_t> unindexed_routes_;
+};
+
+using RoutePathIndexConstPtr = std::unique_ptr<const RoutePathIndex>;
+
+} // namespace Router
+} // namespace Envoy
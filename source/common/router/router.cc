@@ -61,6 +61,30 @@ bool schemeIsHttp(const Http::RequestHeaderMap& downstream_headers,
 
 constexpr uint64_t TimeoutPrecisionFactor = 100;
 
+// A slice of a buffer which isn't modified anymore, shared with other buffers by reference.
+class SharedBufferFragment : public Buffer::BufferFragment {
+public:
+  SharedBufferFragment(std::shared_ptr<const Buffer::Instance> buffer,
+                       const Buffer::RawSlice& slice)
+      : buffer_(std::move(buffer)), slice_(slice) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return slice_.mem_; }
+  size_t size() const override { return slice_.len_; }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const Buffer::Instance> buffer_;
+  const Buffer::RawSlice slice_;
+};
+
+void addSharedFragments(const std::shared_ptr<const Buffer::Instance>& buffer,
+                        Buffer::Instance& to) {
+  for (const Buffer::RawSlice& slice : buffer->getRawSlices()) {
+    to.addBufferFragment(*new SharedBufferFragment(buffer, slice));
+  }
+}
+
 } // namespace
 
 // Express percentage as [0, TimeoutPrecisionFactor] because stats do not accept floating point
@@ -459,6 +483,7 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
     return Http::FilterHeadersStatus::StopIteration;
   }
   cluster_ = cluster->info();
+  report_response_time_to_lb_ = cluster->loadBalancer().responseTimeCallbacks().has_value();
 
   // Set up stat prefixes, etc.
   request_vcluster_ = route_entry_->virtualCluster(headers);
@@ -696,6 +721,8 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::RequestHeaderMap& headers,
   upstream_requests_.front()->acceptHeadersFromRouter(end_stream);
   if (end_stream) {
     onRequestComplete();
+  } else {
+    maybeStartStreamingShadows();
   }
 
   return Http::FilterHeadersStatus::StopIteration;
@@ -746,6 +773,10 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
   // a backoff timer.
   ASSERT(upstream_requests_.size() <= 1);
 
+  if (!shadow_streams_.empty()) {
+    sendDataToShadowStreams(data, end_stream);
+  }
+
   bool buffering = (retry_state_ && retry_state_->enabled()) || !active_shadow_policies_.empty() ||
                    (route_entry_ && route_entry_->internalRedirectPolicy().enabled());
   if (buffering &&
@@ -808,6 +839,10 @@ Http::FilterTrailersStatus Filter::decodeTrailers(Http::RequestTrailerMap& trail
   if (shadow_headers_) {
     shadow_trailers_ = Http::createHeaderMap<Http::RequestTrailerMapImpl>(trailers);
   }
+  for (ShadowStream* shadow_stream : shadow_streams_) {
+    shadow_stream->sendTrailers(trailers);
+  }
+  shadow_streams_.clear();
 
   // upstream_requests_.size() cannot be > 1 because that only happens when a per
   // try timeout occurs with hedge_on_per_try_timeout enabled but the per
@@ -855,6 +890,10 @@ void Filter::cleanup() {
     response_timeout_->disableTimer();
     response_timeout_.reset();
   }
+  if (response_time_hedge_timer_) {
+    response_time_hedge_timer_->disableTimer();
+    response_time_hedge_timer_.reset();
+  }
 }
 
 absl::optional<absl::string_view> Filter::getShadowCluster(const ShadowPolicy& policy,
@@ -894,16 +933,72 @@ void Filter::maybeDoShadowing() {
       request->trailers(Http::createHeaderMap<Http::RequestTrailerMapImpl>(*shadow_trailers_));
     }
 
-    auto options = Http::AsyncClient::RequestOptions()
-                       .setTimeout(timeout_.global_timeout_)
-                       .setParentSpan(callbacks_->activeSpan())
-                       .setChildSpanName("mirror")
-                       .setSampled(shadow_policy.traceSampled())
-                       .setIsShadow(true);
-    if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.closer_shadow_behavior")) {
-      options.setFilterConfig(config_);
+    config_.shadowWriter().shadow(std::string(cluster_name.value()), std::move(request),
+                                  shadowRequestOptions(shadow_policy));
+  }
+}
+
+void Filter::maybeStartStreamingShadows() {
+  // The body of the request is streamed to the shadows as it arrives rather than buffered until
+  // the request is complete. If we got an immediate reset, the request is shadowed once complete
+  // as before, in case it is retried.
+  if (active_shadow_policies_.empty() || upstream_requests_.empty() ||
+      !Runtime::runtimeFeatureEnabled("envoy.reloadable_features.streaming_shadow")) {
+    return;
+  }
+
+  for (const auto& shadow_policy_wrapper : active_shadow_policies_) {
+    const auto& shadow_policy = shadow_policy_wrapper.get();
+
+    const absl::optional<absl::string_view> cluster_name =
+        getShadowCluster(shadow_policy, *downstream_headers_);
+
+    // The cluster name got from headers is empty.
+    if (!cluster_name.has_value()) {
+      continue;
+    }
+
+    ShadowStream* shadow_stream = config_.shadowWriter().streamingShadow(
+        std::string(cluster_name.value()),
+        Http::createHeaderMap<Http::RequestHeaderMapImpl>(*shadow_headers_),
+        shadowRequestOptions(shadow_policy));
+    if (shadow_stream != nullptr) {
+      shadow_streams_.push_back(shadow_stream);
     }
-    config_.shadowWriter().shadow(std::string(cluster_name.value()), std::move(request), options);
+  }
+
+  // The shadows don't need the request to be buffered anymore.
+  active_shadow_policies_.clear();
+  shadow_headers_.reset();
+}
+
+Http::AsyncClient::RequestOptions Filter::shadowRequestOptions(const ShadowPolicy& shadow_policy) {
+  auto options = Http::AsyncClient::RequestOptions()
+                     .setTimeout(timeout_.global_timeout_)
+                     .setParentSpan(callbacks_->activeSpan())
+                     .setChildSpanName("mirror")
+                     .setSampled(shadow_policy.traceSampled())
+                     .setIsShadow(true);
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.closer_shadow_behavior")) {
+    options.setFilterConfig(config_);
+  }
+  return options;
+}
+
+void Filter::sendDataToShadowStreams(Buffer::Instance& data, bool end_stream) {
+  // Instead of copying the data for every shadow, its slices are shared by the upstream request
+  // and the shadows through fragments, and freed once all of them have drained their fragments.
+  auto shared_data = std::make_shared<Buffer::OwnedImpl>();
+  shared_data->move(data);
+  for (ShadowStream* shadow_stream : shadow_streams_) {
+    Buffer::OwnedImpl shadow_data;
+    addSharedFragments(shared_data, shadow_data);
+    shadow_stream->sendData(shadow_data, end_stream);
+  }
+  addSharedFragments(shared_data, data);
+
+  if (end_stream) {
+    shadow_streams_.clear();
   }
 }
 
@@ -930,12 +1025,36 @@ void Filter::onRequestComplete() {
         upstream_request->setupPerTryTimeout();
       }
     }
+
+    setupResponseTimeHedge();
+  }
+}
+
+void Filter::setupResponseTimeHedge() {
+  const absl::optional<double> percentile =
+      route_entry_->hedgePolicy().hedgeOnResponseTimePercentile();
+  Upstream::ResponseTimeTrackerOptRef response_time_tracker = cluster_->responseTimeTracker();
+  if (!percentile.has_value() || !response_time_tracker.has_value() || !retry_state_) {
+    return;
+  }
+
+  const absl::optional<std::chrono::microseconds> hedge_timeout =
+      response_time_tracker->get().responseTimePercentile(percentile.value());
+  if (hedge_timeout.has_value()) {
+    response_time_hedge_timer_ =
+        callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeHedgeTimeout(); });
+    response_time_hedge_timer_->enableHRTimer(hedge_timeout.value());
   }
 }
 
 void Filter::onDestroy() {
   // Reset any in-flight upstream requests.
   resetAll();
+  // Abandon the shadows of a request which was not received in full.
+  for (ShadowStream* shadow_stream : shadow_streams_) {
+    shadow_stream->reset();
+  }
+  shadow_streams_.clear();
   cleanup();
 }
 
@@ -961,6 +1080,7 @@ void Filter::onResponseTimeout() {
     if (upstream_request->upstreamHost()) {
       upstream_request->upstreamHost()->stats().rq_timeout_.inc();
     }
+    reportHostFailureToLb(*upstream_request);
 
     if (upstream_request->awaitingHeaders()) {
       if (cluster_->timeoutBudgetStats().has_value()) {
@@ -1012,7 +1132,7 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
       // back.
       upstream_request.retried(true);
 
-      // TODO: cluster stat for hedge attempted.
+      cluster_->trafficStats()->upstream_rq_hedge_.inc();
     } else if (retry_status == RetryStatus::NoOverflow) {
       callbacks_->streamInfo().setResponseFlag(StreamInfo::ResponseFlag::UpstreamOverflow);
     } else if (retry_status == RetryStatus::NoRetryLimitExceeded) {
@@ -1022,6 +1142,42 @@ void Filter::onSoftPerTryTimeout(UpstreamRequest& upstream_request) {
   }
 }
 
+// Called when the first upstream request takes longer than the configured percentile of the
+// response times of the cluster.
+void Filter::onResponseTimeHedgeTimeout() {
+  // Only hedge the first attempt while it's the only request in flight. The request may have been
+  // retried or hedged on a per try timeout since the timer was armed, in which case the attempt
+  // count went up or a retry is pending.
+  if (downstream_response_started_ || !retry_state_ || pending_retries_ > 0 ||
+      attempt_count_ > 1 || upstream_requests_.size() != 1 ||
+      !upstream_requests_.front()->awaitingHeaders() || upstream_requests_.front()->retried()) {
+    return;
+  }
+
+  UpstreamRequest& upstream_request = *upstream_requests_.front();
+  Upstream::ResponseTimeTracker& response_time_tracker = cluster_->responseTimeTracker()->get();
+  if (!response_time_tracker.tryHedge(route_entry_->hedgePolicy().hedgeBudgetPercent())) {
+    cluster_->trafficStats()->upstream_rq_hedge_overflow_.inc();
+    return;
+  }
+
+  // Unlike on a per try timeout, not getting a hedged request isn't an error for the request, so
+  // no response flag is set if the retry limits don't allow one.
+  const RetryStatus retry_status = retry_state_->shouldHedgeRetryPerTryTimeout(
+      [this, can_use_http3 = upstream_request.upstreamStreamOptions().can_use_http3_]() -> void {
+        doRetry(/*can_send_early_data*/ false, can_use_http3);
+      });
+  if (retry_status == RetryStatus::Yes) {
+    runRetryOptionsPredicates(upstream_request);
+    pending_retries_++;
+    upstream_request.retried(true);
+    cluster_->trafficStats()->upstream_rq_hedge_.inc();
+  } else {
+    // The budget only counts the hedged requests which are sent.
+    response_time_tracker.cancelHedge();
+  }
+}
+
 void Filter::onPerTryIdleTimeout(UpstreamRequest& upstream_request) {
   onPerTryTimeoutCommon(upstream_request,
                         cluster_->trafficStats()->upstream_rq_per_try_idle_timeout_,
@@ -1044,6 +1200,7 @@ void Filter::onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Cou
   if (upstream_request.upstreamHost()) {
     upstream_request.upstreamHost()->stats().rq_timeout_.inc();
   }
+  reportHostFailureToLb(upstream_request);
 
   upstream_request.resetStream();
 
@@ -1058,6 +1215,13 @@ void Filter::onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Cou
 
   // Remove this upstream request from the list now that we're done with it.
   upstream_request.removeFromList(upstream_requests_);
+
+  // The request may have been hedged on the response time, in which case the hedged request
+  // might still see an upstream response.
+  if (numRequestsAwaitingHeaders() > 0 || pending_retries_ > 0) {
+    return;
+  }
+
   onUpstreamTimeoutAbort(StreamInfo::ResponseFlag::UpstreamRequestTimeout, response_code_details);
 }
 
@@ -1094,6 +1258,32 @@ void Filter::updateOutlierDetection(Upstream::Outlier::Result result,
   }
 }
 
+OptRef<Upstream::ResponseTimeCallbacks> Filter::lbResponseTimeCallbacks() {
+  if (!report_response_time_to_lb_) {
+    return {};
+  }
+  // Look the cluster up again, its load balancer may have been replaced since decodeHeaders().
+  Upstream::ThreadLocalCluster* cluster =
+      config_.cm_.getThreadLocalCluster(route_entry_->clusterName());
+  if (cluster == nullptr) {
+    return {};
+  }
+  return cluster->loadBalancer().responseTimeCallbacks();
+}
+
+void Filter::reportHostFailureToLb(UpstreamRequest& upstream_request) {
+  if (upstream_request.upstreamHost() == nullptr) {
+    return;
+  }
+  if (OptRef<Upstream::ResponseTimeCallbacks> lb_callbacks = lbResponseTimeCallbacks();
+      lb_callbacks.has_value()) {
+    lb_callbacks->onHostFailure(
+        *upstream_request.upstreamHost(),
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            callbacks_->dispatcher().timeSource().monotonicTime() - upstream_request.startTime()));
+  }
+}
+
 void Filter::chargeUpstreamAbort(Http::Code code, bool dropped, UpstreamRequest& upstream_request) {
   if (downstream_response_started_) {
     if (upstream_request.grpcRqSuccessDeferred()) {
@@ -1209,6 +1399,10 @@ void Filter::onUpstreamReset(Http::StreamResetReason reset_reason,
   // config param set to true.
   updateOutlierDetection(Upstream::Outlier::Result::LocalOriginConnectFailed, upstream_request,
                          absl::nullopt);
+  // A request dropped by the circuit breakers never reached the host.
+  if (reset_reason != Http::StreamResetReason::Overflow) {
+    reportHostFailureToLb(upstream_request);
+  }
 
   if (maybeRetryReset(reset_reason, upstream_request)) {
     return;
@@ -1377,6 +1571,18 @@ void Filter::onUpstreamHeaders(uint64_t response_code, Http::ResponseHeaderMapPt
     upstream_request.upstreamHost()->outlierDetector().putHttpResponseCode(response_code);
   }
 
+  // Successful responses earn back retry tokens of the cluster and of the host.
+  Upstream::RetryTokenBucketsOptRef retry_token_buckets = cluster_->retryTokenBuckets();
+  if (retry_token_buckets.has_value() &&
+      !Http::CodeUtility::is5xx(grpc_status.has_value() ? grpc_to_http_status : response_code)) {
+    retry_token_buckets->get().clusterBucket().onSuccess();
+    Upstream::RetryTokenBucketOptRef host_bucket =
+        upstream_request.upstreamHost()->retryTokenBucket();
+    if (host_bucket.has_value()) {
+      host_bucket->get().onSuccess();
+    }
+  }
+
   if (headers->EnvoyImmediateHealthCheckFail() != nullptr) {
     upstream_request.upstreamHost()->healthChecker().setUnhealthy(
         Upstream::HealthCheckHostMonitor::UnhealthyType::ImmediateHealthCheckFail);
@@ -1468,6 +1674,16 @@ void Filter::onUpstreamHeaders(uint64_t response_code, Http::ResponseHeaderMapPt
     if (!config_.suppress_envoy_headers_) {
       headers->setEnvoyUpstreamServiceTime(ms.count());
     }
+
+    Upstream::ResponseTimeTrackerOptRef response_time_tracker = cluster_->responseTimeTracker();
+    if (response_time_tracker.has_value()) {
+      // Hedged requests start after the end of the downstream request, so they are measured from
+      // their own start.
+      response_time_tracker->get().recordResponseTime(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              response_received_time -
+              std::max(downstream_request_complete_time_, upstream_request.startTime())));
+    }
   }
 
   upstream_request.upstreamCanary(
@@ -1561,6 +1777,14 @@ void Filter::onUpstreamComplete(UpstreamRequest& upstream_request) {
         FilterUtility::percentageOfTimeout(response_time, timeout_.global_timeout_));
   }
 
+  if (OptRef<Upstream::ResponseTimeCallbacks> lb_callbacks = lbResponseTimeCallbacks();
+      lb_callbacks.has_value()) {
+    lb_callbacks->onHostResponseTime(
+        *upstream_request.upstreamHost(),
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            dispatcher.timeSource().monotonicTime() - upstream_request.startTime()));
+  }
+
   if (config_.emit_dynamic_stats_ && !callbacks_->streamInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     upstream_request.upstreamHost()->outlierDetector().putResponseTime(response_time);
@@ -366,7 +366,7 @@ public:
   Filter(FilterConfig& config, FilterStats& stats)
       : config_(config), stats_(stats), downstream_1xx_headers_encoded_(false),
         downstream_response_started_(false), downstream_end_stream_(false), is_retry_(false),
-        request_buffer_overflowed_(false) {}
+        request_buffer_overflowed_(false), report_response_time_to_lb_(false) {}
 
   ~Filter() override;
 
@@ -573,6 +573,9 @@ private:
                                                      const Http::HeaderMap& headers) const;
 
   void maybeDoShadowing();
+  void maybeStartStreamingShadows();
+  Http::AsyncClient::RequestOptions shadowRequestOptions(const ShadowPolicy& shadow_policy);
+  void sendDataToShadowStreams(Buffer::Instance& data, bool end_stream);
   bool maybeRetryReset(Http::StreamResetReason reset_reason, UpstreamRequest& upstream_request);
   uint32_t numRequestsAwaitingHeaders();
   void onGlobalTimeout();
@@ -581,6 +584,8 @@ private:
   // Handle an upstream request aborted due to a local timeout.
   void onSoftPerTryTimeout();
   void onSoftPerTryTimeout(UpstreamRequest& upstream_request);
+  void setupResponseTimeHedge();
+  void onResponseTimeHedgeTimeout();
   void onUpstreamTimeoutAbort(StreamInfo::ResponseFlag response_flag, absl::string_view details);
   // Handle an "aborted" upstream request, meaning we didn't see response
   // headers (e.g. due to a reset). Handles recording stats and responding
@@ -601,6 +606,10 @@ private:
                                                 uint64_t status_code);
   void updateOutlierDetection(Upstream::Outlier::Result result, UpstreamRequest& upstream_request,
                               absl::optional<uint64_t> code);
+  // The response time callbacks of the load balancer of the cluster, if it has any.
+  OptRef<Upstream::ResponseTimeCallbacks> lbResponseTimeCallbacks();
+  // Reports an upstream request which was reset or timed out to the load balancer.
+  void reportHostFailureToLb(UpstreamRequest& upstream_request);
   void doRetry(bool can_send_early_data, bool can_use_http3);
   void runRetryOptionsPredicates(UpstreamRequest& retriable_request);
   // Called immediately after a non-5xx header is received from upstream, performs stats accounting
@@ -620,6 +629,7 @@ private:
   const VirtualCluster* request_vcluster_;
   RouteStatsContextOptRef route_stats_context_;
   Event::TimerPtr response_timeout_;
+  Event::TimerPtr response_time_hedge_timer_;
   FilterUtility::TimeoutData timeout_;
   FilterUtility::HedgingParams hedging_params_;
   Http::Code timeout_response_code_ = Http::Code::GatewayTimeout;
@@ -639,6 +649,9 @@ private:
   std::vector<std::reference_wrapper<const ShadowPolicy>> active_shadow_policies_{};
   std::unique_ptr<Http::RequestHeaderMap> shadow_headers_;
   std::unique_ptr<Http::RequestTrailerMap> shadow_trailers_;
+  // Shadows the request body is streamed to as it arrives. They are owned by the shadow writer and
+  // valid until the request is ended or they are reset.
+  std::vector<ShadowStream*> shadow_streams_;
   // The stream lifetime configured by request header.
   absl::optional<std::chrono::milliseconds> dynamic_max_stream_duration_;
   // list of cookies to add to upstream headers
@@ -651,6 +664,8 @@ private:
   bool include_attempt_count_in_request_ : 1;
   bool request_buffer_overflowed_ : 1;
   bool conn_pool_new_stream_with_early_data_and_http3_ : 1;
+  // Whether the load balancer of the cluster takes response times into account.
+  bool report_response_time_to_lb_ : 1;
   uint32_t attempt_count_{1};
   uint32_t pending_retries_{0};
 
@@ -4,13 +4,37 @@
 #include <string>
 
 #include "source/common/common/assert.h"
+#include "source/common/http/header_map_impl.h"
 #include "source/common/http/headers.h"
+#include "source/common/tracing/common_values.h"
+#include "source/common/tracing/http_tracer_impl.h"
+#include "source/common/tracing/null_span_impl.h"
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 
 namespace Envoy {
 namespace Router {
 
+namespace {
+
+// Switch authority to add a shadow postfix. This allows upstream logging to make more sense.
+void addShadowPostfix(Http::RequestHeaderMap& headers) {
+  ASSERT(!headers.getHostValue().empty());
+  auto parts = StringUtil::splitToken(headers.getHostValue(), ":");
+  ASSERT(!parts.empty() && parts.size() <= 2);
+  headers.setHost(parts.size() == 2 ? absl::StrJoin(parts, "-shadow:")
+                                    : absl::StrCat(headers.getHostValue(), "-shadow"));
+}
+
+Http::AsyncClient::RequestOptions shadowOptions(const Http::AsyncClient::RequestOptions& options) {
+  Http::AsyncClient::RequestOptions actual_options(options);
+  actual_options.setIsShadow(true);
+  return actual_options;
+}
+
+} // namespace
+
 void ShadowWriterImpl::shadow(const std::string& cluster, Http::RequestMessagePtr&& request,
                               const Http::AsyncClient::RequestOptions& options) {
   // It's possible that the cluster specified in the route configuration no longer exists due
@@ -22,21 +46,123 @@ void ShadowWriterImpl::shadow(const std::string& cluster, Http::RequestMessagePt
     return;
   }
 
-  ASSERT(!request->headers().getHostValue().empty());
-  // Switch authority to add a shadow postfix. This allows upstream logging to make more sense.
-  auto parts = StringUtil::splitToken(request->headers().getHostValue(), ":");
-  ASSERT(!parts.empty() && parts.size() <= 2);
-  request->headers().setHost(parts.size() == 2
-                                 ? absl::StrJoin(parts, "-shadow:")
-                                 : absl::StrCat(request->headers().getHostValue(), "-shadow"));
-  const auto& shadow_options = options.is_shadow ? options : [options] {
-    Http::AsyncClient::RequestOptions actual_options(options);
-    actual_options.setIsShadow(true);
-    return actual_options;
-  }();
+  addShadowPostfix(request->headers());
+  const auto& shadow_options = options.is_shadow ? options : shadowOptions(options);
   // This is basically fire and forget. We don't handle cancelling.
   thread_local_cluster->httpAsyncClient().send(std::move(request), *this, shadow_options);
 }
 
+ShadowStream* ShadowWriterImpl::streamingShadow(const std::string& cluster,
+                                                Http::RequestHeaderMapPtr&& headers,
+                                                const Http::AsyncClient::RequestOptions& options) {
+  // See shadow() about clusters removed by CDS.
+  const auto thread_local_cluster = cm_.getThreadLocalCluster(cluster);
+  if (thread_local_cluster == nullptr) {
+    ENVOY_LOG(debug, "shadow cluster '{}' does not exist", cluster);
+    return nullptr;
+  }
+
+  addShadowPostfix(*headers);
+  Http::AsyncClient& async_client = thread_local_cluster->httpAsyncClient();
+  // Async client streams don't trace, so the child span of a shadowed request is handled here.
+  Tracing::SpanPtr child_span;
+  if (options.parent_span_ != nullptr) {
+    child_span = options.parent_span_->spawnChild(
+        Tracing::EgressConfig::get(),
+        options.child_span_name_.empty() ? absl::StrCat("async ", cluster, " egress")
+                                         : options.child_span_name_,
+        async_client.dispatcher().timeSource().systemTime());
+  } else {
+    child_span = std::make_unique<Tracing::NullSpan>();
+  }
+  if (options.sampled_.has_value()) {
+    child_span->setSampled(options.sampled_.value());
+  }
+
+  auto shadow_stream =
+      std::make_unique<ShadowStreamImpl>(std::move(headers), std::move(child_span));
+  if (!shadow_stream->start(async_client, options.is_shadow ? options : shadowOptions(options))) {
+    return nullptr;
+  }
+  // The stream deletes itself once the request has been ended and the async stream is done.
+  return shadow_stream.release();
+}
+
+ShadowStreamImpl::ShadowStreamImpl(Http::RequestHeaderMapPtr&& headers,
+                                   Tracing::SpanPtr&& child_span)
+    : headers_(std::move(headers)), child_span_(std::move(child_span)) {}
+
+bool ShadowStreamImpl::start(Http::AsyncClient& async_client,
+                             const Http::AsyncClient::StreamOptions& options) {
+  stream_ = async_client.start(*this, options);
+  if (stream_ == nullptr) {
+    return false;
+  }
+  child_span_->injectContext(*headers_, nullptr);
+  stream_->sendHeaders(*headers_, false);
+  return true;
+}
+
+void ShadowStreamImpl::sendData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(!request_ended_);
+  if (stream_ != nullptr && stream_->isAboveWriteBufferHighWatermark()) {
+    // The shadow is not keeping up with the request. Rather than buffering the rest of the body
+    // for it, give up on it.
+    ENVOY_LOG(debug, "shadow stream is above its write buffer high watermark, resetting it");
+    stream_->reset();
+  }
+  if (stream_ != nullptr) {
+    stream_->sendData(data, end_stream);
+  }
+  if (end_stream) {
+    endRequest();
+  }
+}
+
+void ShadowStreamImpl::sendTrailers(const Http::RequestTrailerMap& trailers) {
+  ASSERT(!request_ended_);
+  if (stream_ != nullptr) {
+    // The async stream only references the trailers, so they are kept with the headers.
+    trailers_ = Http::createHeaderMap<Http::RequestTrailerMapImpl>(trailers);
+    stream_->sendTrailers(*trailers_);
+  }
+  endRequest();
+}
+
+void ShadowStreamImpl::reset() {
+  ASSERT(!request_ended_);
+  if (stream_ != nullptr) {
+    stream_->reset();
+  }
+  endRequest();
+}
+
+void ShadowStreamImpl::onHeaders(Http::ResponseHeaderMapPtr&& headers, bool) {
+  child_span_->setTag(Tracing::Tags::get().HttpStatusCode, headers->getStatusValue());
+}
+
+void ShadowStreamImpl::onComplete() { onStreamDone(); }
+
+void ShadowStreamImpl::onReset() {
+  child_span_->setTag(Tracing::Tags::get().Error, Tracing::Tags::get().True);
+  child_span_->setTag(Tracing::Tags::get().ErrorReason, "Reset");
+  onStreamDone();
+}
+
+void ShadowStreamImpl::onStreamDone() {
+  child_span_->finishSpan();
+  stream_ = nullptr;
+  if (request_ended_) {
+    delete this;
+  }
+}
+
+void ShadowStreamImpl::endRequest() {
+  request_ended_ = true;
+  if (stream_ == nullptr) {
+    delete this;
+  }
+}
+
 } // namespace Router
 } // namespace Envoy
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "envoy/router/shadow_writer.h"
+#include "envoy/tracing/trace_driver.h"
 #include "envoy/upstream/cluster_manager.h"
 
 namespace Envoy {
@@ -22,6 +23,8 @@ public:
   // Router::ShadowWriter
   void shadow(const std::string& cluster, Http::RequestMessagePtr&& request,
               const Http::AsyncClient::RequestOptions& options) override;
+  ShadowStream* streamingShadow(const std::string& cluster, Http::RequestHeaderMapPtr&& headers,
+                                const Http::AsyncClient::RequestOptions& options) override;
 
   // Http::AsyncClient::Callbacks
   void onSuccess(const Http::AsyncClient::Request&, Http::ResponseMessagePtr&&) override {}
@@ -33,5 +36,45 @@ private:
   Upstream::ClusterManager& cm_;
 };
 
+/**
+ * Implementation of ShadowStream on top of an async client stream. It owns the request headers
+ * and trailers, which the async client stream only references, and deletes itself once both the
+ * request has been ended by the router and the async client stream has completed or been reset.
+ */
+class ShadowStreamImpl : Logger::Loggable<Logger::Id::router>,
+                         public ShadowStream,
+                         public Http::AsyncClient::StreamCallbacks {
+public:
+  ShadowStreamImpl(Http::RequestHeaderMapPtr&& headers, Tracing::SpanPtr&& child_span);
+
+  /**
+   * Start the async client stream and send the headers.
+   * @return false if the stream could not be started, in which case the caller deletes this.
+   */
+  bool start(Http::AsyncClient& async_client, const Http::AsyncClient::StreamOptions& options);
+
+  // Router::ShadowStream
+  void sendData(Buffer::Instance& data, bool end_stream) override;
+  void sendTrailers(const Http::RequestTrailerMap& trailers) override;
+  void reset() override;
+
+  // Http::AsyncClient::StreamCallbacks
+  void onHeaders(Http::ResponseHeaderMapPtr&& headers, bool end_stream) override;
+  void onData(Buffer::Instance&, bool) override {}
+  void onTrailers(Http::ResponseTrailerMapPtr&&) override {}
+  void onComplete() override;
+  void onReset() override;
+
+private:
+  void onStreamDone();
+  void endRequest();
+
+  Http::RequestHeaderMapPtr headers_;
+  Http::RequestTrailerMapPtr trailers_;
+  Tracing::SpanPtr child_span_;
+  Http::AsyncClient::Stream* stream_{};
+  bool request_ended_{};
+};
+
 } // namespace Router
 } // namespace Envoy
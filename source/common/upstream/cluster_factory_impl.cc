@@ -120,10 +120,14 @@ ClusterFactoryImplBase::create(Server::Configuration::ServerFactoryContext& serv
     if (cluster.health_checks().size() != 1) {
       throw EnvoyException("Multiple health checks not supported");
     } else {
+      const auto& health_check_config = cluster.health_checks()[0];
       new_cluster_pair.first->setHealthChecker(HealthCheckerFactory::create(
-          cluster.health_checks()[0], *new_cluster_pair.first, context.runtime(),
+          health_check_config, *new_cluster_pair.first, context.runtime(),
           context.mainThreadDispatcher(), context.logManager(), context.messageValidationVisitor(),
-          context.api()));
+          context.api(),
+          health_check_config.share_across_clusters()
+              ? SharedHealthCheckScheduler::get(context.singletonManager())
+              : nullptr));
     }
   }
 
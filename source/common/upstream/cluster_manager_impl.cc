@@ -1,5 +1,6 @@
 #include "source/common/upstream/cluster_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -327,6 +328,15 @@ ClusterManagerImpl::ClusterManagerImpl(
     local_cluster_name_ = cm_config.local_cluster_name();
   }
 
+  if (cm_config.has_deferred_cluster_creation()) {
+    deferred_cluster_creation_ = true;
+    const auto& deferred_config = cm_config.deferred_cluster_creation();
+    if (deferred_config.has_idle_timeout()) {
+      deferred_cluster_idle_timeout_ =
+          std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(deferred_config, idle_timeout));
+    }
+  }
+
   // Initialize the XdsResourceDelegate extension, if set on the bootstrap config.
   if (bootstrap.has_xds_delegate_extension()) {
     auto& factory = Config::Utility::getAndCheckFactory<Config::XdsResourcesDelegateFactory>(
@@ -801,12 +811,14 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
 
     ENVOY_LOG(debug, "removing cluster {}", cluster_name);
     tls_.runOnAllThreads([cluster_name](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
-      ASSERT(cluster_manager->thread_local_clusters_.count(cluster_name) == 1);
+      ASSERT(cluster_manager->thread_local_clusters_.count(cluster_name) == 1 ||
+             cluster_manager->thread_local_deferred_clusters_.count(cluster_name) == 1);
       ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
       for (auto& cb : cluster_manager->update_callbacks_) {
         cb->onClusterRemoval(cluster_name);
       }
       cluster_manager->thread_local_clusters_.erase(cluster_name);
+      cluster_manager->thread_local_deferred_clusters_.erase(cluster_name);
     });
   }
 
@@ -956,13 +968,7 @@ void ClusterManagerImpl::updateClusterCounts() {
 
 ThreadLocalCluster* ClusterManagerImpl::getThreadLocalCluster(absl::string_view cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = *tls_;
-
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry != cluster_manager.thread_local_clusters_.end()) {
-    return entry->second.get();
-  } else {
-    return nullptr;
-  }
+  return cluster_manager.getOrCreateCluster(cluster);
 }
 
 void ClusterManagerImpl::maybePreconnect(
@@ -1001,6 +1007,7 @@ absl::optional<HttpPoolData>
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPool(
     ResourcePriority priority, absl::optional<Http::Protocol> protocol,
     LoadBalancerContext* context) {
+  markUsed();
   // Select a host and create a connection pool for it if it does not already exist.
   auto pool = httpConnPoolImpl(priority, protocol, context, false);
   if (pool == nullptr) {
@@ -1022,6 +1029,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPool(
 absl::optional<TcpPoolData>
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::tcpConnPool(
     ResourcePriority priority, LoadBalancerContext* context) {
+  markUsed();
   // Select a host and create a connection pool for it if it does not already exist.
   auto pool = tcpConnPoolImpl(priority, context, false);
   if (pool == nullptr) {
@@ -1105,10 +1113,29 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
 
   HostMapConstSharedPtr host_map = cm_cluster.cluster().prioritySet().crossPriorityHostMap();
 
+  ThreadLocalClusterManagerImpl::ClusterInitializationObjectConstSharedPtr initialization_object;
+  if (deferred_cluster_creation_) {
+    initialization_object = createClusterInitializationObject(cm_cluster, host_map);
+  }
+
   pending_cluster_creations_.erase(cm_cluster.cluster().info()->name());
   tls_.runOnAllThreads([info = cm_cluster.cluster().info(), params = std::move(params),
-                        add_or_update_cluster, load_balancer_factory, map = std::move(host_map)](
+                        add_or_update_cluster, load_balancer_factory, map = std::move(host_map),
+                        initialization_object = std::move(initialization_object)](
                            OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
+    if (initialization_object != nullptr) {
+      cluster_manager->thread_local_deferred_clusters_[info->name()] = initialization_object;
+      // Clusters that this thread has not created yet are created from the object when they are
+      // first used, so there is nothing else to update.
+      if (!cluster_manager->thread_local_clusters_.contains(info->name())) {
+        if (add_or_update_cluster) {
+          ENVOY_LOG(debug, "deferring TLS cluster {}", info->name());
+          cluster_manager->notifyClusterAddOrUpdate(info->name());
+        }
+        return;
+      }
+    }
+
     ThreadLocalClusterManagerImpl::ClusterEntry* new_cluster = nullptr;
     if (add_or_update_cluster) {
       if (cluster_manager->thread_local_clusters_.count(info->name()) > 0) {
@@ -1130,13 +1157,28 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(ClusterManagerCluster& cm_
     }
 
     if (new_cluster != nullptr) {
-      for (auto& cb : cluster_manager->update_callbacks_) {
-        cb->onClusterAddOrUpdate(*new_cluster);
-      }
+      cluster_manager->notifyClusterAddOrUpdate(info->name());
     }
   });
 }
 
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterInitializationObjectConstSharedPtr
+ClusterManagerImpl::createClusterInitializationObject(
+    ClusterManagerCluster& cm_cluster, const HostMapConstSharedPtr& cross_priority_host_map) {
+  auto object = std::make_shared<ThreadLocalClusterManagerImpl::ClusterInitializationObject>();
+  object->info_ = cm_cluster.cluster().info();
+  object->load_balancer_factory_ = cm_cluster.loadBalancerFactory();
+  const auto& host_sets = cm_cluster.cluster().prioritySet().hostSetsPerPriority();
+  object->per_priority_.reserve(host_sets.size());
+  for (const auto& host_set : host_sets) {
+    object->per_priority_.push_back(
+        {host_set->priority(), HostSetImpl::updateHostsParams(*host_set),
+         host_set->localityWeights(), host_set->overprovisioningFactor()});
+  }
+  object->cross_priority_host_map_ = cross_priority_host_map;
+  return object;
+}
+
 void ClusterManagerImpl::postThreadLocalHealthFailure(const HostSharedPtr& host) {
   tls_.runOnAllThreads([host](OptRef<ThreadLocalClusterManagerImpl> cluster_manager) {
     cluster_manager->onHostHealthFailure(host);
@@ -1145,6 +1187,7 @@ void ClusterManagerImpl::postThreadLocalHealthFailure(const HostSharedPtr& host)
 
 Host::CreateConnectionData ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::tcpConn(
     LoadBalancerContext* context) {
+  markUsed();
   HostConstSharedPtr logical_host = chooseHost(context);
   if (logical_host) {
     auto conn_info = logical_host->createConnection(
@@ -1196,8 +1239,9 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::updateHost
   priority_set_.updateHosts(priority, std::move(update_hosts_params), std::move(locality_weights),
                             hosts_added, hosts_removed, overprovisioning_factor,
                             std::move(cross_priority_host_map));
-  // If an LB is thread aware, create a new worker local LB on membership changes.
-  if (lb_factory_ != nullptr) {
+  // If an LB is thread aware, create a new worker local LB on membership changes, unless it
+  // follows the updates of the worker local priority set itself.
+  if (lb_factory_ != nullptr && lb_factory_->recreateOnHostChange()) {
     ENVOY_LOG(debug, "re-creating local LB for TLS cluster {}", name);
     lb_ = lb_factory_->create({priority_set_, parent_.local_priority_set_});
   }
@@ -1347,6 +1391,11 @@ void ClusterManagerImpl::notifyClusterDiscoveryStatus(absl::string_view name,
       });
 }
 
+bool ClusterManagerImpl::threadLocalClusterCreated(absl::string_view name) {
+  ThreadLocalClusterManagerImpl& cluster_manager = *tls_;
+  return cluster_manager.thread_local_clusters_.contains(name);
+}
+
 ClusterDiscoveryManager
 ClusterManagerImpl::createAndSwapClusterDiscoveryManager(std::string thread_name) {
   ThreadLocalClusterManagerImpl& cluster_manager = *tls_;
@@ -1407,6 +1456,14 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
         *this, local_cluster_params->info_, local_cluster_params->load_balancer_factory_);
     local_priority_set_ = &thread_local_clusters_[local_cluster_name]->prioritySet();
   }
+
+  if (parent_.deferred_cluster_idle_timeout_.has_value()) {
+    idle_cluster_timer_ = dispatcher.createTimer([this]() {
+      dropIdleClusters();
+      idle_cluster_timer_->enableTimer(parent_.deferred_cluster_idle_timeout_.value());
+    });
+    idle_cluster_timer_->enableTimer(parent_.deferred_cluster_idle_timeout_.value());
+  }
 }
 
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImpl() {
@@ -1446,8 +1503,13 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::removeTcpConn(
 
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::removeHosts(
     const std::string& name, const HostVector& hosts_removed) {
-  ASSERT(thread_local_clusters_.find(name) != thread_local_clusters_.end());
-  const auto& cluster_entry = thread_local_clusters_[name];
+  auto it = thread_local_clusters_.find(name);
+  if (it == thread_local_clusters_.end()) {
+    // A deferred cluster that was not created on this thread has no connection pools.
+    ASSERT(thread_local_deferred_clusters_.contains(name));
+    return;
+  }
+  const auto& cluster_entry = it->second;
   ENVOY_LOG(debug, "removing hosts for TLS cluster {} removed {}", name, hosts_removed.size());
 
   // We need to go through and purge any connection pools for hosts that got deleted.
@@ -1500,6 +1562,78 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
   }
 }
 
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::getOrCreateCluster(absl::string_view name) {
+  auto it = thread_local_clusters_.find(name);
+  if (it != thread_local_clusters_.end()) {
+    it->second->markUsed();
+    return it->second.get();
+  }
+  return createDeferredCluster(name);
+}
+
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::createDeferredCluster(absl::string_view name) {
+  auto it = thread_local_deferred_clusters_.find(name);
+  if (it == thread_local_deferred_clusters_.end()) {
+    return nullptr;
+  }
+
+  const ClusterInitializationObject& object = *it->second;
+  const std::string& cluster_name = object.info_->name();
+  ENVOY_LOG(debug, "creating deferred TLS cluster {}", cluster_name);
+  auto cluster_entry =
+      std::make_unique<ClusterEntry>(*this, object.info_, object.load_balancer_factory_);
+  for (const auto& per_priority : object.per_priority_) {
+    PrioritySet::UpdateHostsParams update_hosts_params = per_priority.update_hosts_params_;
+    cluster_entry->updateHosts(cluster_name, per_priority.priority_,
+                               std::move(update_hosts_params), per_priority.locality_weights_,
+                               *per_priority.update_hosts_params_.hosts, {},
+                               per_priority.overprovisioning_factor_,
+                               object.cross_priority_host_map_);
+  }
+
+  ClusterEntry* cluster = cluster_entry.get();
+  thread_local_clusters_[cluster_name] = std::move(cluster_entry);
+  return cluster;
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::dropIdleClusters() {
+  std::vector<std::string> idle_clusters;
+  for (const auto& [name, cluster_entry] : thread_local_clusters_) {
+    // Only deferred clusters can be created again. This excludes the local cluster.
+    if (cluster_entry->checkIdle() && thread_local_deferred_clusters_.contains(name) &&
+        !trackedByUpdateCallbacks(name)) {
+      idle_clusters.push_back(name);
+    }
+  }
+
+  for (const std::string& name : idle_clusters) {
+    ENVOY_LOG(debug, "dropping idle TLS cluster {}", name);
+    thread_local_clusters_.erase(name);
+  }
+}
+
+bool ClusterManagerImpl::ThreadLocalClusterManagerImpl::trackedByUpdateCallbacks(
+    const std::string& name) const {
+  // The callbacks keep a reference to the clusters they track, which would dangle if the cluster
+  // was dropped. Notifying them of the drop would only make them create the cluster again.
+  return std::any_of(update_callbacks_.begin(), update_callbacks_.end(),
+                     [&name](const ClusterUpdateCallbacks* cb) { return cb->tracksCluster(name); });
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::notifyClusterAddOrUpdate(
+    const std::string& name) {
+  ThreadLocalClusterCommand get_cluster = [this, &name]() -> ThreadLocalCluster& {
+    ClusterEntry* cluster = getOrCreateCluster(name);
+    ASSERT(cluster != nullptr);
+    return *cluster;
+  };
+  for (auto& cb : update_callbacks_) {
+    cb->onClusterAddOrUpdate(name, get_cluster);
+  }
+}
+
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ConnPoolsContainer*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::getHttpConnPoolsContainer(
     const HostConstSharedPtr& host, bool allocate) {
@@ -1685,17 +1819,44 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
     context->downstreamConnection()->hashKey(hash_key);
   }
 
+  // Connections are only shared across workers if they do not depend on the request.
+  // The config validation rejects clusters which also have a pool per downstream connection.
+  const bool share_across_workers =
+      cluster_info_->shareHttp2ConnectionsAcrossWorkers() && upstream_options->empty() &&
+      !have_transport_socket_options && upstream_protocols.size() == 1 &&
+      upstream_protocols[0] == Http::Protocol::Http2;
+
   ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
 
   // Note: to simplify this, we assume that the factory is only called in the scope of this
   // function. Otherwise, we'd need to capture a few of these variables by value.
   ConnPoolsContainer::ConnPools::PoolOptRef pool =
       container.pools_->getPool(priority, hash_key, [&]() {
-        auto pool = parent_.parent_.factory_.allocateConnPool(
-            parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
-            alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
-            have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
-            parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_);
+        Http::ConnectionPool::InstancePtr pool;
+        if (share_across_workers) {
+          // The shared pool may create the pool of its worker after this function returned, and
+          // after this ClusterEntry is gone, so the factory only captures what the thread local
+          // cluster manager owns. HTTP/2 pools don't use the QUIC info, which is owned by the
+          // factory instead of this ClusterEntry.
+          pool = std::make_unique<Http::CrossWorkerConnPool>(
+              parent_.thread_local_dispatcher_, host, parent_.parent_.cross_worker_conn_pools_,
+              Http::CrossWorkerConnPoolRegistry::Key{host.get(), priority, hash_key},
+              [&factory = parent_.parent_.factory_, &dispatcher = parent_.thread_local_dispatcher_,
+               host, priority, upstream_protocols, alternate_protocol_options,
+               &time_source = parent_.parent_.time_source_,
+               &state = parent_.cluster_manager_state_,
+               quic_info = std::make_shared<Http::PersistentQuicInfoPtr>()]() mutable {
+                return factory.allocateConnPool(dispatcher, host, priority, upstream_protocols,
+                                                alternate_protocol_options, nullptr, nullptr,
+                                                time_source, state, *quic_info);
+              });
+        } else {
+          pool = parent_.parent_.factory_.allocateConnPool(
+              parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
+              alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
+              have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
+              parent_.parent_.time_source_, parent_.cluster_manager_state_, quic_info_);
+        }
 
         pool->addIdleCallback([&parent = parent_, host, priority, hash_key]() {
           parent.httpConnPoolIsIdle(host, priority, hash_key);
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "envoy/api/api.h"
@@ -31,6 +32,7 @@
 #include "source/common/config/grpc_mux_impl.h"
 #include "source/common/config/subscription_factory_impl.h"
 #include "source/common/http/async_client_impl.h"
+#include "source/common/http/cross_worker_conn_pool.h"
 #include "source/common/http/http_server_properties_cache_impl.h"
 #include "source/common/http/http_server_properties_cache_manager_impl.h"
 #include "source/common/quic/quic_stat_names.h"
@@ -438,6 +440,14 @@ protected:
    */
   ClusterDiscoveryManager createAndSwapClusterDiscoveryManager(std::string thread_name);
 
+  /**
+   * Checks whether the current thread created its ThreadLocalCluster for a cluster. With deferred
+   * cluster creation, it is only created when the cluster is first looked up.
+   *
+   * Protected, so tests can use it.
+   */
+  bool threadLocalClusterCreated(absl::string_view name);
+
 private:
   /**
    * Thread local cached cluster data. Each thread local cluster gets updates from the parent
@@ -515,7 +525,10 @@ private:
       // Upstream::ThreadLocalCluster
       const PrioritySet& prioritySet() override { return priority_set_; }
       ClusterInfoConstSharedPtr info() override { return cluster_info_; }
-      LoadBalancer& loadBalancer() override { return *lb_; }
+      LoadBalancer& loadBalancer() override {
+        markUsed();
+        return *lb_;
+      }
       absl::optional<HttpPoolData> httpConnPool(ResourcePriority priority,
                                                 absl::optional<Http::Protocol> downstream_protocol,
                                                 LoadBalancerContext* context) override;
@@ -542,6 +555,13 @@ private:
       void drainConnPools(DrainConnectionsHostPredicate predicate,
                           ConnectionPool::DrainBehavior behavior);
 
+      void markUsed() { used_ = true; }
+      // Returns whether the cluster was not used since the last call. A cluster with an async
+      // client is never idle, as dropping it would reset the streams of the client.
+      bool checkIdle() {
+        return !std::exchange(used_, false) && lazy_http_async_client_ == nullptr;
+      }
+
     private:
       Http::ConnectionPool::Instance*
       httpConnPoolImpl(ResourcePriority priority,
@@ -589,10 +609,32 @@ private:
       // If multiple bit fields are set, it is acceptable as long as the status of override host is
       // in any of these statuses.
       const HostUtility::HostStatusSet override_host_statuses_{};
+      // Only read when deferred clusters are dropped after an idle timeout.
+      bool used_{true};
     };
 
     using ClusterEntryPtr = std::unique_ptr<ClusterEntry>;
 
+    // Everything needed to create the ClusterEntry of a deferred cluster, i.e. the complete host
+    // sets of the cluster rather than the changes of an update. It is built once per cluster update
+    // on the main thread and shared by all workers.
+    struct ClusterInitializationObject {
+      struct PerPriority {
+        uint32_t priority_;
+        PrioritySet::UpdateHostsParams update_hosts_params_;
+        LocalityWeightsConstSharedPtr locality_weights_;
+        uint32_t overprovisioning_factor_;
+      };
+
+      ClusterInfoConstSharedPtr info_;
+      LoadBalancerFactorySharedPtr load_balancer_factory_;
+      std::vector<PerPriority> per_priority_;
+      HostMapConstSharedPtr cross_priority_host_map_;
+    };
+
+    using ClusterInitializationObjectConstSharedPtr =
+        std::shared_ptr<const ClusterInitializationObject>;
+
     struct LocalClusterParams {
       LoadBalancerFactorySharedPtr load_balancer_factory_;
       ClusterInfoConstSharedPtr info_;
@@ -620,6 +662,17 @@ private:
                                  HostMapConstSharedPtr cross_priority_host_map);
     void onHostHealthFailure(const HostSharedPtr& host);
 
+    // Returns the cluster, creating it first if it is deferred, or nullptr if it does not exist.
+    ClusterEntry* getOrCreateCluster(absl::string_view name);
+    ClusterEntry* createDeferredCluster(absl::string_view name);
+    // Drops the deferred clusters that were not used since the last call, unless update callbacks
+    // track them.
+    void dropIdleClusters();
+    bool trackedByUpdateCallbacks(const std::string& name) const;
+    // Notifies the update callbacks. Deferred clusters are only created if a callback asks for
+    // them.
+    void notifyClusterAddOrUpdate(const std::string& name);
+
     ConnPoolsContainer* getHttpConnPoolsContainer(const HostConstSharedPtr& host,
                                                   bool allocate = false);
 
@@ -629,6 +682,11 @@ private:
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
     absl::flat_hash_map<std::string, ClusterEntryPtr> thread_local_clusters_;
+    // With deferred cluster creation, holds every cluster known to this thread, including the ones
+    // in thread_local_clusters_, which are created from these objects.
+    absl::flat_hash_map<std::string, ClusterInitializationObjectConstSharedPtr>
+        thread_local_deferred_clusters_;
+    Event::TimerPtr idle_cluster_timer_;
 
     ClusterConnectivityState cluster_manager_state_;
 
@@ -746,6 +804,9 @@ private:
                       const uint64_t timeout);
   ProtobufTypes::MessagePtr dumpClusterConfigs(const Matchers::StringMatcher& name_matcher);
   static ClusterManagerStats generateStats(Stats::Scope& scope);
+  ThreadLocalClusterManagerImpl::ClusterInitializationObjectConstSharedPtr
+  createClusterInitializationObject(ClusterManagerCluster& cm_cluster,
+                                    const HostMapConstSharedPtr& cross_priority_host_map);
 
   /**
    * @return ClusterDataPtr contains the previous cluster in the cluster_map, or
@@ -795,6 +856,8 @@ private:
   LoadStatsReporterPtr load_stats_reporter_;
   // The name of the local cluster of this Envoy instance if defined.
   absl::optional<std::string> local_cluster_name_;
+  bool deferred_cluster_creation_{};
+  absl::optional<std::chrono::milliseconds> deferred_cluster_idle_timeout_;
   Grpc::AsyncClientManagerPtr async_client_manager_;
   Server::ConfigTracker::EntryOwnerPtr config_tracker_entry_;
   TimeSource& time_source_;
@@ -816,6 +879,9 @@ private:
 
   std::unique_ptr<Config::XdsResourcesDelegate> xds_resources_delegate_;
   std::unique_ptr<Config::XdsConfigTracker> xds_config_tracker_;
+  // The owners of the HTTP/2 connections shared across workers.
+  const Http::CrossWorkerConnPoolRegistrySharedPtr cross_worker_conn_pools_{
+      std::make_shared<Http::CrossWorkerConnPoolRegistry>()};
 };
 
 } // namespace Upstream
@@ -17,8 +17,12 @@ public:
   ThreadLocalClusterOptRef threadLocalCluster() { return thread_local_cluster_; };
 
   // ClusterUpdateCallbacks
-  void onClusterAddOrUpdate(ThreadLocalCluster& cluster) override;
+  void onClusterAddOrUpdate(absl::string_view cluster_name,
+                            ThreadLocalClusterCommand& get_cluster) override;
   void onClusterRemoval(const std::string& cluster) override;
+  bool tracksCluster(absl::string_view cluster_name) const override {
+    return cluster_name == cluster_name_;
+  }
 
 private:
   const std::string cluster_name_;
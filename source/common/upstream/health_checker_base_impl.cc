@@ -1,5 +1,7 @@
 #include "source/common/upstream/health_checker_base_impl.h"
 
+#include <cmath>
+
 #include "envoy/config/core/v3/address.pb.h"
 #include "envoy/config/core/v3/health_check.pb.h"
 #include "envoy/data/core/v3/health_check_event.pb.h"
@@ -11,6 +13,87 @@
 namespace Envoy {
 namespace Upstream {
 
+SINGLETON_MANAGER_REGISTRATION(shared_health_check_scheduler);
+
+SharedHealthCheckSchedulerSharedPtr
+SharedHealthCheckScheduler::get(Singleton::Manager& singleton_manager) {
+  return singleton_manager.getTyped<SharedHealthCheckScheduler>(
+      SINGLETON_MANAGER_REGISTERED_NAME(shared_health_check_scheduler),
+      [] { return std::make_shared<SharedHealthCheckScheduler>(); });
+}
+
+bool SharedHealthCheckScheduler::subscribe(const Key& key,
+                                           SharedHealthCheckSubscriber& subscriber) {
+  auto [it, inserted] = groups_.try_emplace(key);
+  Group& group = it->second;
+  if (inserted) {
+    // The fractional parts of consecutive multiples of the golden ratio are spread evenly over
+    // [0, 1), however many groups there end up being.
+    group.phase_ = std::fmod(++num_groups_created_ * 0.6180339887498949, 1.0);
+  }
+  group.subscribers_.push_back(&subscriber);
+  return group.subscribers_.size() == 1;
+}
+
+void SharedHealthCheckScheduler::unsubscribe(const Key& key,
+                                             SharedHealthCheckSubscriber& subscriber) {
+  auto it = groups_.find(key);
+  ASSERT(it != groups_.end());
+  std::vector<SharedHealthCheckSubscriber*>& subscribers = it->second.subscribers_;
+  const bool was_prober = subscribers.front() == &subscriber;
+  subscribers.erase(std::find(subscribers.begin(), subscribers.end(), &subscriber));
+  if (subscribers.empty()) {
+    groups_.erase(it);
+  } else if (was_prober) {
+    subscribers.front()->onProbingStarted();
+  }
+}
+
+void SharedHealthCheckScheduler::publish(const Key& key, SharedHealthCheckSubscriber& prober,
+                                         const SharedHealthCheckResult& result) {
+  auto it = groups_.find(key);
+  if (it == groups_.end()) {
+    return;
+  }
+  // Applying a result runs the callbacks of the cluster of the subscriber, which may remove hosts
+  // and thereby sessions of the group. Work on a copy and skip the sessions that are gone.
+  const std::vector<SharedHealthCheckSubscriber*> subscribers = it->second.subscribers_;
+  for (SharedHealthCheckSubscriber* subscriber : subscribers) {
+    if (subscriber == &prober) {
+      continue;
+    }
+    it = groups_.find(key);
+    if (it == groups_.end()) {
+      return;
+    }
+    if (std::find(it->second.subscribers_.begin(), it->second.subscribers_.end(), subscriber) ==
+        it->second.subscribers_.end()) {
+      continue;
+    }
+    subscriber->onSharedResult(result);
+  }
+}
+
+std::chrono::milliseconds SharedHealthCheckScheduler::nextCheckInterval(const Key& key) {
+  auto it = groups_.find(key);
+  ASSERT(it != groups_.end());
+  Group& group = it->second;
+  std::chrono::milliseconds interval = std::chrono::milliseconds::max();
+  for (const SharedHealthCheckSubscriber* subscriber : group.subscribers_) {
+    // Sessions without any result yet have no interval.
+    if (subscriber->nextCheckInterval().count() > 0) {
+      interval = std::min(interval, subscriber->nextCheckInterval());
+    }
+  }
+  if (!group.phase_applied_) {
+    group.phase_applied_ = true;
+    interval = std::max(std::chrono::milliseconds(1),
+                        std::chrono::milliseconds(static_cast<int64_t>(interval.count() *
+                                                                       group.phase_)));
+  }
+  return interval;
+}
+
 HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
                                              const envoy::config::core::v3::HealthCheck& config,
                                              Event::Dispatcher& dispatcher,
@@ -42,7 +125,16 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
       member_update_cb_{cluster_.prioritySet().addMemberUpdateCb(
           [this](const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
             onClusterMemberUpdate(hosts_added, hosts_removed);
-          })} {}
+          })},
+      shared_config_hash_(config.share_across_clusters() ? MessageUtil::hash(config) : 0) {}
+
+void HealthCheckerImplBase::setSharedScheduler(
+    SharedHealthCheckSchedulerSharedPtr shared_scheduler) {
+  ASSERT(active_sessions_.empty());
+  if (shared_config_hash_ != 0) {
+    shared_scheduler_ = std::move(shared_scheduler);
+  }
+}
 
 std::shared_ptr<const Network::TransportSocketOptionsImpl>
 HealthCheckerImplBase::initTransportSocketOptions(
@@ -262,6 +354,10 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
   // implementation specific state is destroyed.
   interval_timer_.reset();
   timeout_timer_.reset();
+  if (shared_key_.has_value()) {
+    parent_.shared_scheduler_->unsubscribe(*shared_key_, *this);
+    shared_key_.reset();
+  }
   if (!host_->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent_.decHealthy();
   }
@@ -276,7 +372,23 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
   }
 }
 
+void HealthCheckerImplBase::ActiveHealthCheckSession::start() {
+  if (parent_.shared_scheduler_ != nullptr) {
+    shared_key_.emplace(parent_.shared_config_hash_, host_->healthCheckAddress()->asString());
+    probing_ = parent_.shared_scheduler_->subscribe(*shared_key_, *this);
+  }
+  onInitialInterval();
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degraded) {
+  applySuccess(degraded);
+
+  timeout_timer_->disableTimer();
+  publishResult({true, degraded, envoy::data::core::v3::ACTIVE, false});
+  scheduleNextCheck();
+}
+
+HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::applySuccess(bool degraded) {
   // If we are healthy, reset the # of unhealthy to zero.
   num_unhealthy_ = 0;
 
@@ -333,8 +445,8 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degrade
   first_check_ = false;
   parent_.runCallbacks(host_, changed_state);
 
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval(HealthState::Healthy, changed_state));
+  next_interval_ = parent_.interval(HealthState::Healthy, changed_state);
+  return changed_state;
 }
 
 namespace {
@@ -402,7 +514,46 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(
   }
 
   if (interval_timer_ != nullptr) {
-    interval_timer_->enableTimer(parent_.interval(HealthState::Unhealthy, changed_state));
+    next_interval_ = parent_.interval(HealthState::Unhealthy, changed_state);
+    publishResult({false, false, type, retriable});
+    scheduleNextCheck();
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onSharedResult(
+    const SharedHealthCheckResult& result) {
+  if (result.success_) {
+    applySuccess(result.degraded_);
+  } else {
+    const HealthTransition changed_state = setUnhealthy(result.failure_type_, result.retriable_);
+    next_interval_ = parent_.interval(HealthState::Unhealthy, changed_state);
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onProbingStarted() {
+  probing_ = true;
+  // A check that is pending or in flight schedules the next one once it completes.
+  if (!interval_timer_->enabled() && !timeout_timer_->enabled()) {
+    interval_timer_->enableTimer(parent_.shared_scheduler_->nextCheckInterval(*shared_key_));
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::publishResult(
+    const SharedHealthCheckResult& result) {
+  if (shared_key_.has_value() && probing_) {
+    parent_.shared_scheduler_->publish(*shared_key_, *this, result);
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::scheduleNextCheck() {
+  // It's possible that applying the result caused this session to be deferred deleted.
+  if (interval_timer_ == nullptr) {
+    return;
+  }
+  if (!shared_key_.has_value()) {
+    interval_timer_->enableTimer(next_interval_);
+  } else if (probing_) {
+    interval_timer_->enableTimer(parent_.shared_scheduler_->nextCheckInterval(*shared_key_));
   }
 }
 
@@ -7,6 +7,8 @@
 #include "envoy/data/core/v3/health_check_event.pb.h"
 #include "envoy/event/timer.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
 #include "envoy/stats/scope.h"
 #include "envoy/type/matcher/string.pb.h"
 #include "envoy/upstream/health_checker.h"
@@ -15,6 +17,8 @@
 #include "source/common/common/matchers.h"
 #include "source/common/network/transport_socket_options_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -55,6 +59,96 @@ struct HealthCheckerEqualTo {
   }
 };
 
+/**
+ * The result of a health check, as applied to the hosts of all sessions sharing the check.
+ */
+struct SharedHealthCheckResult {
+  bool success_;
+  bool degraded_;
+  envoy::data::core::v3::HealthCheckFailureType failure_type_;
+  bool retriable_;
+};
+
+/**
+ * A health check session which shares its checks with the sessions of other clusters.
+ */
+class SharedHealthCheckSubscriber {
+public:
+  virtual ~SharedHealthCheckSubscriber() = default;
+
+  /**
+   * Applies the result of a check sent by another subscriber to the host of this subscriber.
+   */
+  virtual void onSharedResult(const SharedHealthCheckResult& result) PURE;
+
+  /**
+   * Called when this subscriber takes over sending the checks of its group.
+   */
+  virtual void onProbingStarted() PURE;
+
+  /**
+   * @return the interval this subscriber would wait for before its next check, given its last
+   *         result.
+   */
+  virtual std::chrono::milliseconds nextCheckInterval() const PURE;
+};
+
+/**
+ * Deduplicates the health checks of hosts that appear in several clusters with the same health
+ * check config. Sessions checking the same address with the same config form a group, and only
+ * the first session of a group (the prober) sends checks. Its results are applied to the hosts of
+ * all the other sessions of the group. When the prober goes away, the next session takes over.
+ *
+ * The probes of the groups are also given phases spread evenly over the check interval, so that
+ * the checks of many hosts added at once do not keep firing together. Only used on the main
+ * thread.
+ */
+class SharedHealthCheckScheduler : public Singleton::Instance {
+public:
+  using Key = std::pair<uint64_t, std::string>;
+
+  static std::shared_ptr<SharedHealthCheckScheduler> get(Singleton::Manager& singleton_manager);
+
+  /**
+   * Adds a session to the group of its key.
+   * @return true if the session is the prober of its group.
+   */
+  bool subscribe(const Key& key, SharedHealthCheckSubscriber& subscriber);
+
+  /**
+   * Removes a session from its group. If it was the prober, the next session takes over.
+   */
+  void unsubscribe(const Key& key, SharedHealthCheckSubscriber& subscriber);
+
+  /**
+   * Applies the result of a check sent by the prober to all the other sessions of its group.
+   */
+  void publish(const Key& key, SharedHealthCheckSubscriber& prober,
+               const SharedHealthCheckResult& result);
+
+  /**
+   * @return the interval the prober should wait for before the next check, which is the shortest
+   *         one of all sessions of the group. The first interval of a group is shortened to the
+   *         phase of the group.
+   */
+  std::chrono::milliseconds nextCheckInterval(const Key& key);
+
+  size_t numGroups() const { return groups_.size(); }
+
+private:
+  struct Group {
+    std::vector<SharedHealthCheckSubscriber*> subscribers_;
+    // Phase of the group's probes, as a fraction of the interval.
+    double phase_{};
+    bool phase_applied_{};
+  };
+
+  absl::flat_hash_map<Key, Group> groups_;
+  uint64_t num_groups_created_{};
+};
+
+using SharedHealthCheckSchedulerSharedPtr = std::shared_ptr<SharedHealthCheckScheduler>;
+
 /**
  * Base implementation for all health checkers.
  */
@@ -72,14 +166,26 @@ public:
     return transport_socket_match_metadata_;
   }
 
+  /**
+   * Shares the checks of the hosts of this health checker with the health checkers of other
+   * clusters, if enabled by the config. Must be called before start().
+   */
+  void setSharedScheduler(SharedHealthCheckSchedulerSharedPtr shared_scheduler);
+
 protected:
-  class ActiveHealthCheckSession : public Event::DeferredDeletable {
+  class ActiveHealthCheckSession : public Event::DeferredDeletable,
+                                   public SharedHealthCheckSubscriber {
   public:
     ~ActiveHealthCheckSession() override;
     HealthTransition setUnhealthy(envoy::data::core::v3::HealthCheckFailureType type,
                                   bool retriable);
     void onDeferredDeleteBase();
-    void start() { onInitialInterval(); }
+    void start();
+
+    // Upstream::SharedHealthCheckSubscriber
+    void onSharedResult(const SharedHealthCheckResult& result) override;
+    void onProbingStarted() override;
+    std::chrono::milliseconds nextCheckInterval() const override { return next_interval_; }
 
   protected:
     ActiveHealthCheckSession(HealthCheckerImplBase& parent, HostSharedPtr host);
@@ -95,6 +201,12 @@ protected:
     // been health checked.
     // Returns the changed state to use following the flag update.
     HealthTransition clearPendingFlag(HealthTransition changed_state);
+    HealthTransition applySuccess(bool degraded);
+    // Shares the result of a check sent by this session, if it is the prober of a shared group.
+    void publishResult(const SharedHealthCheckResult& result);
+    // Arms the interval timer for the next check, unless the checks of the host are sent by the
+    // session of another cluster.
+    void scheduleNextCheck();
     virtual void onInterval() PURE;
     void onIntervalBase();
     virtual void onTimeout() PURE;
@@ -109,6 +221,12 @@ protected:
     uint32_t num_healthy_{};
     bool first_check_{true};
     TimeSource& time_source_;
+    std::chrono::milliseconds next_interval_{};
+    // Set when the session shares its checks with the sessions of other clusters.
+    absl::optional<SharedHealthCheckScheduler::Key> shared_key_;
+    // Whether this session sends the checks of its host. Always true for sessions which do not
+    // share their checks. A session that does not send checks still sends its initial check.
+    bool probing_{true};
   };
 
   using ActiveHealthCheckSessionPtr = std::unique_ptr<ActiveHealthCheckSession>;
@@ -180,6 +298,9 @@ private:
   const std::shared_ptr<const Network::TransportSocketOptionsImpl> transport_socket_options_;
   const MetadataConstSharedPtr transport_socket_match_metadata_;
   const Common::CallbackHandlePtr member_update_cb_;
+  // Hash of the config if it enables sharing checks across clusters, zero otherwise.
+  const uint64_t shared_config_hash_;
+  SharedHealthCheckSchedulerSharedPtr shared_scheduler_;
 };
 
 class HealthCheckEventLoggerImpl : public HealthCheckEventLogger {
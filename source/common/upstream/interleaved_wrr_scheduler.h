@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "envoy/upstream/scheduler.h"
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+// Interleaved Weighted Round Robin (IWRR) Scheduler
+// -------------------------------------------------
+// The picks are made in rounds: round r visits, in order, every object whose weight is at least
+// r, and the rounds go from 1 to the largest weight before starting over. An object of weight w is
+// thus picked once in each of the first w rounds of a cycle, interleaved with the other objects of
+// these rounds. The weights are rounded to integers of at least 1.
+//
+// The objects are kept in a vector sorted by decreasing weight, so the objects visited by a round
+// are a prefix of it, which shrinks from one round to the next. A pick is then an increment of an
+// index into the vector, amortized constant time, where the EdfScheduler takes logarithmic time.
+// Adding an object is constant time, and the vector is sorted on the first pick that follows.
+// Memory use is linear in the number of objects, whatever their weights.
+//
+// NOTE: The weight of an object is the one it was added with: the weight calculation passed to the
+// picks is ignored. This scheduler is meant for objects whose weights don't change between the
+// rebuilds of the scheduler, like the hosts of the round robin LB outside of slow start.
+template <class C> class InterleavedWrrScheduler : public Scheduler<C> {
+public:
+  // See scheduler.h for an explanation of each public method.
+  std::shared_ptr<C> peekAgain(std::function<double(const C&)>) override {
+    std::shared_ptr<C> ret = pickEntry();
+    if (ret) {
+      prepick_list_.push_back(ret);
+    }
+    return ret;
+  }
+
+  std::shared_ptr<C> pickAndAdd(std::function<double(const C&)>) override {
+    while (!prepick_list_.empty()) {
+      // The entry was already picked by peekAgain.
+      std::shared_ptr<C> ret = prepick_list_.front().lock();
+      prepick_list_.pop_front();
+      if (ret) {
+        return ret;
+      }
+    }
+    return pickEntry();
+  }
+
+  void add(double weight, std::shared_ptr<C> entry) override {
+    ASSERT(weight > 0);
+    const uint32_t rounded_weight = static_cast<uint32_t>(std::clamp<double>(
+        std::round(weight), 1, std::numeric_limits<uint32_t>::max()));
+    entries_.push_back({rounded_weight, entry});
+    sorted_ = false;
+  }
+
+  bool empty() const override { return entries_.empty(); }
+
+private:
+  /**
+   * Picks the entry at the index in the current round, moving to the next round at the end of the
+   * current one. Expired entries are removed.
+   */
+  std::shared_ptr<C> pickEntry() {
+    if (!sorted_) {
+      // The order of the entries of the same weight is kept, so that equal weights get regular RR
+      // behavior.
+      std::stable_sort(entries_.begin(), entries_.end(),
+                       [](const Entry& a, const Entry& b) { return a.weight_ > b.weight_; });
+      round_ = 1;
+      index_ = 0;
+      eligible_ = entries_.size();
+      sorted_ = true;
+    }
+
+    while (!entries_.empty()) {
+      if (index_ >= eligible_) {
+        nextRound();
+        continue;
+      }
+      std::shared_ptr<C> ret = entries_[index_].entry_.lock();
+      if (!ret) {
+        // The vector stays sorted, and the next entry takes the place of the expired one.
+        entries_.erase(entries_.begin() + index_);
+        eligible_--;
+        continue;
+      }
+      index_++;
+      return ret;
+    }
+    return nullptr;
+  }
+
+  void nextRound() {
+    ASSERT(!entries_.empty());
+    index_ = 0;
+    if (round_ >= entries_.front().weight_) {
+      round_ = 1;
+      eligible_ = entries_.size();
+      return;
+    }
+    round_++;
+    // The entry with the largest weight is always eligible, so this stops at 1 at the least.
+    while (entries_[eligible_ - 1].weight_ < round_) {
+      eligible_--;
+    }
+  }
+
+  struct Entry {
+    uint32_t weight_;
+    // We only hold a weak pointer, like the EdfScheduler, so that entries can be lazily removed.
+    std::weak_ptr<C> entry_;
+  };
+
+  // Entries sorted by decreasing weight once sorted_ is set.
+  std::vector<Entry> entries_;
+  bool sorted_{true};
+  // Current round, from 1 to the largest weight.
+  uint32_t round_{1};
+  // Index of the next entry to pick in the current round.
+  size_t index_{};
+  // Number of entries of weight at least round_, which make the current round.
+  size_t eligible_{};
+  std::list<std::weak_ptr<C>> prepick_list_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
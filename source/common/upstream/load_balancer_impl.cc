@@ -810,7 +810,11 @@ void EdfLoadBalancerBase::refresh(uint32_t priority) {
       // Skip edf creation.
       return;
     }
-    scheduler.edf_ = std::make_unique<EdfScheduler<const Host>>();
+    if (useInterleavedScheduler() && noHostsAreInSlowStart()) {
+      scheduler.edf_ = std::make_unique<InterleavedWrrScheduler<const Host>>();
+    } else {
+      scheduler.edf_ = std::make_unique<EdfScheduler<const Host>>();
+    }
 
     // Populate scheduler with host list.
     // TODO(mattklein123): We must build the EDF schedule even if all of the hosts are currently
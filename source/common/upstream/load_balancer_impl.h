@@ -18,6 +18,7 @@
 #include "source/common/protobuf/utility.h"
 #include "source/common/runtime/runtime_protos.h"
 #include "source/common/upstream/edf_scheduler.h"
+#include "source/common/upstream/interleaved_wrr_scheduler.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -52,6 +53,7 @@ public:
   OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
     return {};
   }
+  OptRef<ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
 protected:
   /**
@@ -417,10 +419,10 @@ public:
 
 protected:
   struct Scheduler {
-    // EdfScheduler for weighted LB. The edf_ is only created when the original
-    // host weights of 2 or more hosts differ. When not present, the
-    // implementation of chooseHostOnce falls back to unweightedHostPick.
-    std::unique_ptr<EdfScheduler<const Host>> edf_;
+    // EdfScheduler, or InterleavedWrrScheduler if the derived class uses it, for weighted LB. The
+    // edf_ is only created when the original host weights of 2 or more hosts differ. When not
+    // present, the implementation of chooseHostOnce falls back to unweightedHostPick.
+    std::unique_ptr<Upstream::Scheduler<const Host>> edf_;
   };
 
   void initialize();
@@ -450,6 +452,9 @@ private:
                                                 const HostsSource& source) PURE;
   virtual HostConstSharedPtr unweightedHostPick(const HostVector& hosts_to_use,
                                                 const HostsSource& source) PURE;
+  // Whether weighted picks use an InterleavedWrrScheduler rather than an EdfScheduler while no
+  // hosts are in slow start. It ignores the changes of hostWeight() between refreshes.
+  virtual bool useInterleavedScheduler() const { return false; }
 
   // Scheduler for each valid HostsSource.
   absl::node_hash_map<HostsSource, Scheduler, HostsSourceHash> scheduler_;
@@ -467,8 +472,9 @@ protected:
 };
 
 /**
- * A round robin load balancer. When in weighted mode, EDF scheduling is used. When in not
- * weighted mode, simple RR index selection is used.
+ * A round robin load balancer. When in weighted mode, EDF scheduling is used, or interleaved
+ * weighted round robin scheduling if configured. When in not weighted mode, simple RR index
+ * selection is used.
  */
 class RoundRobinLoadBalancer : public EdfLoadBalancerBase {
 public:
@@ -485,7 +491,11 @@ public:
                 ? absl::optional<envoy::config::cluster::v3::Cluster::SlowStartConfig>(
                       round_robin_config.value().slow_start_config())
                 : absl::nullopt,
-            time_source) {
+            time_source),
+        interleaved_scheduler_(round_robin_config.has_value() &&
+                               round_robin_config.value().weighted_scheduler() ==
+                                   envoy::config::cluster::v3::Cluster::RoundRobinLbConfig::
+                                       INTERLEAVED) {
     initialize();
   }
 
@@ -505,6 +515,7 @@ private:
     }
     return host.weight();
   }
+  bool useInterleavedScheduler() const override { return interleaved_scheduler_; }
 
   HostConstSharedPtr unweightedHostPeek(const HostVector& hosts_to_use,
                                         const HostsSource& source) override {
@@ -527,6 +538,7 @@ private:
     return hosts_to_use[rr_indexes_[source]++ % hosts_to_use.size()];
   }
 
+  const bool interleaved_scheduler_;
   uint64_t peekahead_index_{};
   absl::node_hash_map<HostsSource, uint64_t, HostsSourceHash> rr_indexes_;
 };
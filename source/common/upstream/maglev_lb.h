@@ -1,5 +1,7 @@
 #pragma once
 
+#include <limits>
+
 #include "envoy/common/random_generator.h"
 #include "envoy/config/cluster/v3/cluster.pb.h"
 #include "envoy/stats/scope.h"
@@ -46,22 +48,28 @@ public:
 
 private:
   struct TableBuildEntry {
-    TableBuildEntry(const HostConstSharedPtr& host, uint64_t offset, uint64_t skip, double weight)
-        : host_(host), offset_(offset), skip_(skip), weight_(weight) {}
+    TableBuildEntry(uint64_t offset, uint64_t skip, double weight)
+        : skip_(skip), weight_(weight), permutation_(offset) {}
 
-    HostConstSharedPtr host_;
-    const uint64_t offset_;
     const uint64_t skip_;
     const double weight_;
     double target_weight_{};
-    uint64_t next_{};
+    // The current position in the host's permutation, (offset + skip * next) % table_size.
+    uint64_t permutation_;
     uint64_t count_{};
   };
 
-  uint64_t permutation(const TableBuildEntry& entry);
+  void nextPermutation(TableBuildEntry& entry) const;
+
+  // Marks a table entry that has not been claimed by a host yet.
+  static constexpr uint32_t EmptyEntry = std::numeric_limits<uint32_t>::max();
 
   const uint64_t table_size_;
-  std::vector<HostConstSharedPtr> table_;
+  // Hosts in the order of the normalized host weights the table was built from.
+  std::vector<HostConstSharedPtr> hosts_;
+  // Indexes into hosts_. Keeping indexes rather than host pointers makes the table 4 times smaller
+  // and saves two atomic reference count updates per entry on every build.
+  std::vector<uint32_t> table_;
   MaglevLoadBalancerStats& stats_;
 };
 
@@ -83,7 +91,7 @@ public:
 private:
   // ThreadAwareLoadBalancerBase
   HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
+  createLoadBalancer(uint32_t, const NormalizedHostWeightVector& normalized_host_weights,
                      double /* min_normalized_weight */, double max_normalized_weight) override {
     HashingLoadBalancerSharedPtr maglev_lb =
         std::make_shared<MaglevTable>(normalized_host_weights, max_normalized_weight, table_size_,
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
@@ -23,6 +24,19 @@ namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+namespace {
+
+// Clears a consecutive failure counter, which is shared by all workers. Most results are not
+// failures, so skipping the store when the counter is already clear keeps its cache line shared
+// between the workers instead of bouncing it on every request.
+void clearConsecutiveFailures(std::atomic<uint32_t>& counter) {
+  if (counter.load(std::memory_order_relaxed) != 0) {
+    counter = 0;
+  }
+}
+
+} // namespace
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::config::cluster::v3::Cluster& cluster_config,
     Event::Dispatcher& dispatcher, Runtime::Loader& runtime, EventLoggerSharedPtr event_logger,
@@ -38,7 +52,8 @@ DetectorSharedPtr DetectorImplFactory::createForCluster(
 
 DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector,
                                                  HostSharedPtr host)
-    : detector_(detector), host_(host),
+    : detector_(detector), host_(host), result_accumulator_(detector->resultAccumulator()),
+      result_slot_(result_accumulator_->allocate()),
       // add Success Rate monitors
       external_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE),
       local_origin_sr_monitor_(envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN) {
@@ -49,6 +64,8 @@ DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> d
                          : &DetectorHostMonitorImpl::putResultNoLocalExternalSplit;
 }
 
+DetectorHostMonitorImpl::~DetectorHostMonitorImpl() { result_accumulator_->release(result_slot_); }
+
 void DetectorHostMonitorImpl::eject(MonotonicTime ejection_time) {
   ASSERT(!host_.lock()->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
   host_.lock()->healthFlagSet(Host::HealthFlag::FAILED_OUTLIER_CHECK);
@@ -60,13 +77,9 @@ void DetectorHostMonitorImpl::uneject(MonotonicTime unejection_time) {
   last_unejection_time_ = (unejection_time);
 }
 
-void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
-  external_origin_sr_monitor_.updateCurrentSuccessRateBucket();
-  local_origin_sr_monitor_.updateCurrentSuccessRateBucket();
-}
-
 void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
-  external_origin_sr_monitor_.incTotalReqCounter();
+  HostResultCounters& counters = result_accumulator_->threadCounters(result_slot_);
+  counters.external_origin_total_.fetch_add(1, std::memory_order_relaxed);
   if (Http::CodeUtility::is5xx(response_code)) {
     std::shared_ptr<DetectorImpl> detector = detector_.lock();
     if (!detector) {
@@ -80,7 +93,7 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
         detector->onConsecutiveGatewayFailure(host_.lock());
       }
     } else {
-      consecutive_gateway_failure_ = 0;
+      clearConsecutiveFailures(consecutive_gateway_failure_);
     }
 
     if (++consecutive_5xx_ == detector->runtime().snapshot().getInteger(
@@ -88,9 +101,9 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
       detector->onConsecutive5xx(host_.lock());
     }
   } else {
-    external_origin_sr_monitor_.incSuccessReqCounter();
-    consecutive_5xx_ = 0;
-    consecutive_gateway_failure_ = 0;
+    counters.external_origin_success_.fetch_add(1, std::memory_order_relaxed);
+    clearConsecutiveFailures(consecutive_5xx_);
+    clearConsecutiveFailures(consecutive_gateway_failure_);
   }
 }
 
@@ -185,7 +198,8 @@ void DetectorHostMonitorImpl::localOriginFailure() {
     // It's possible for the cluster/detector to go away while we still have a host in use.
     return;
   }
-  local_origin_sr_monitor_.incTotalReqCounter();
+  result_accumulator_->threadCounters(result_slot_)
+      .local_origin_total_.fetch_add(1, std::memory_order_relaxed);
   if (++consecutive_local_origin_failure_ ==
       detector->runtime().snapshot().getInteger(
           ConsecutiveLocalOriginFailureRuntime,
@@ -201,10 +215,11 @@ void DetectorHostMonitorImpl::localOriginNoFailure() {
     return;
   }
 
-  local_origin_sr_monitor_.incTotalReqCounter();
-  local_origin_sr_monitor_.incSuccessReqCounter();
+  HostResultCounters& counters = result_accumulator_->threadCounters(result_slot_);
+  counters.local_origin_total_.fetch_add(1, std::memory_order_relaxed);
+  counters.local_origin_success_.fetch_add(1, std::memory_order_relaxed);
 
-  resetConsecutiveLocalOriginFailure();
+  clearConsecutiveFailures(consecutive_local_origin_failure_);
 }
 
 DetectorConfig::DetectorConfig(const envoy::config::cluster::v3::OutlierDetection& config)
@@ -267,7 +282,10 @@ DetectorImpl::DetectorImpl(const Cluster& cluster,
     : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
-      event_logger_(event_logger), random_generator_(random) {
+      event_logger_(event_logger), random_generator_(random),
+      result_accumulator_(std::make_shared<ResultAccumulator>(
+          std::min(std::max(1U, std::thread::hardware_concurrency()),
+                   ResultAccumulator::MaxShards))) {
   // Insert success rate initial numbers for each type of SR detector
   external_origin_sr_num_ = {-1, -1};
   local_origin_sr_num_ = {-1, -1};
@@ -590,9 +608,10 @@ void DetectorImpl::onConsecutiveErrorWorker(HostSharedPtr host,
   }
 }
 
-DetectorImpl::EjectionPair DetectorImpl::successRateEjectionThreshold(
-    double success_rate_sum, const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
-    double success_rate_stdev_factor) {
+DetectorImpl::EjectionPair
+DetectorImpl::successRateEjectionThreshold(double success_rate_sum,
+                                           const std::vector<double>& success_rates,
+                                           double success_rate_stdev_factor) {
   // This function is using mean and standard deviation as statistical measures for outlier
   // detection. First the mean is calculated by dividing the sum of success rate data over the
   // number of data points. Then variance is calculated by taking the mean of the
@@ -608,20 +627,23 @@ DetectorImpl::EjectionPair DetectorImpl::successRateEjectionThreshold(
   // variance = 400
   // stdev = 20
   // threshold returned = 52
-  double mean = success_rate_sum / valid_success_rate_hosts.size();
+  const size_t num_success_rates = success_rates.size();
+  const double* data = success_rates.data();
+  double mean = success_rate_sum / num_success_rates;
   double variance = 0;
-  std::for_each(valid_success_rate_hosts.begin(), valid_success_rate_hosts.end(),
-                [&variance, mean](HostSuccessRatePair v) {
-                  variance += std::pow(v.success_rate_ - mean, 2);
-                });
-  variance /= valid_success_rate_hosts.size();
+  for (size_t i = 0; i < num_success_rates; i++) {
+    variance += (data[i] - mean) * (data[i] - mean);
+  }
+  variance /= num_success_rates;
   double stdev = std::sqrt(variance);
 
   return {mean, (mean - (success_rate_stdev_factor * stdev))};
 }
 
 void DetectorImpl::processSuccessRateEjections(
-    DetectorHostMonitor::SuccessRateMonitorType monitor_type) {
+    DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+    const std::vector<std::pair<HostSharedPtr, DetectorHostMonitorImpl*>>& hosts,
+    const std::vector<uint64_t>& success_counts, const std::vector<uint64_t>& total_counts) {
   uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
       SuccessRateMinimumHostsRuntime, config_.successRateMinimumHosts());
   uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
@@ -631,81 +653,85 @@ void DetectorImpl::processSuccessRateEjections(
   uint64_t failure_percentage_request_volume = runtime_.snapshot().getInteger(
       FailurePercentageRequestVolumeRuntime, config_.failurePercentageRequestVolume());
 
-  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
-  std::vector<HostSuccessRatePair> valid_failure_percentage_hosts;
-  double success_rate_sum = 0;
-
   // Reset the Detector's success rate mean and stdev.
   getSRNums(monitor_type) = {-1, -1};
 
   // Exit early if there are not enough hosts.
-  if (host_monitors_.size() < success_rate_minimum_hosts &&
-      host_monitors_.size() < failure_percentage_minimum_hosts) {
+  if (hosts.size() < success_rate_minimum_hosts &&
+      hosts.size() < failure_percentage_minimum_hosts) {
     return;
   }
 
-  // reserve upper bound of vector size to avoid reallocation.
-  valid_success_rate_hosts.reserve(host_monitors_.size());
-  valid_failure_percentage_hosts.reserve(host_monitors_.size());
-
-  for (const auto& host : host_monitors_) {
+  // Gather the request counts of the hosts which are not ejected and saw requests during the last
+  // interval, so that the rates below are computed in branch free loops over contiguous arrays.
+  std::vector<uint32_t> candidates;
+  std::vector<double> successes;
+  std::vector<double> volumes;
+  candidates.reserve(hosts.size());
+  successes.reserve(hosts.size());
+  volumes.reserve(hosts.size());
+  for (uint32_t i = 0; i < hosts.size(); i++) {
     // Don't do work if the host is already ejected.
-    if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
-      absl::optional<std::pair<double, uint64_t>> host_success_rate_and_volume =
-          host.second->getSRMonitor(monitor_type)
-              .successRateAccumulator()
-              .getSuccessRateAndVolume();
-
-      if (!host_success_rate_and_volume) {
-        continue;
-      }
-      double success_rate = host_success_rate_and_volume.value().first;
-      double request_volume = host_success_rate_and_volume.value().second;
+    if (total_counts[i] != 0 &&
+        !hosts[i].first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      candidates.push_back(i);
+      successes.push_back(success_counts[i]);
+      volumes.push_back(total_counts[i]);
+    }
+  }
 
-      if (request_volume >=
-          std::min(success_rate_request_volume, failure_percentage_request_volume)) {
-        host.second->successRate(monitor_type, success_rate);
-      }
+  const size_t num_candidates = candidates.size();
+  std::vector<double> success_rates(num_candidates);
+  for (size_t i = 0; i < num_candidates; i++) {
+    success_rates[i] = successes[i] * 100.0 / volumes[i];
+  }
 
-      if (request_volume >= success_rate_request_volume) {
-        valid_success_rate_hosts.emplace_back(HostSuccessRatePair(host.first, success_rate));
-        success_rate_sum += success_rate;
-      }
-      if (request_volume >= failure_percentage_request_volume) {
-        valid_failure_percentage_hosts.emplace_back(HostSuccessRatePair(host.first, success_rate));
-      }
+  const double min_request_volume =
+      std::min(success_rate_request_volume, failure_percentage_request_volume);
+  std::vector<double> valid_success_rates;
+  valid_success_rates.reserve(num_candidates);
+  size_t num_valid_failure_percentage_hosts = 0;
+  double success_rate_sum = 0;
+  for (size_t i = 0; i < num_candidates; i++) {
+    if (volumes[i] >= min_request_volume) {
+      hosts[candidates[i]].second->successRate(monitor_type, success_rates[i]);
+    }
+    if (volumes[i] >= success_rate_request_volume) {
+      valid_success_rates.push_back(success_rates[i]);
+      success_rate_sum += success_rates[i];
     }
+    num_valid_failure_percentage_hosts += volumes[i] >= failure_percentage_request_volume;
   }
 
-  if (!valid_success_rate_hosts.empty() &&
-      valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
+  if (!valid_success_rates.empty() && valid_success_rates.size() >= success_rate_minimum_hosts) {
     const double success_rate_stdev_factor =
         runtime_.snapshot().getInteger(SuccessRateStdevFactorRuntime,
                                        config_.successRateStdevFactor()) /
         1000.0;
-    getSRNums(monitor_type) = successRateEjectionThreshold(
-        success_rate_sum, valid_success_rate_hosts, success_rate_stdev_factor);
+    getSRNums(monitor_type) = successRateEjectionThreshold(success_rate_sum, valid_success_rates,
+                                                           success_rate_stdev_factor);
     const double success_rate_ejection_threshold = getSRNums(monitor_type).ejection_threshold_;
-    for (const auto& host_success_rate_pair : valid_success_rate_hosts) {
-      if (host_success_rate_pair.success_rate_ < success_rate_ejection_threshold) {
+    for (size_t i = 0; i < num_candidates; i++) {
+      if (volumes[i] >= success_rate_request_volume &&
+          success_rates[i] < success_rate_ejection_threshold) {
+        const auto& host = hosts[candidates[i]];
         stats_.ejections_success_rate_.inc(); // Deprecated.
         const envoy::data::cluster::v3::OutlierEjectionType type =
-            host_monitors_[host_success_rate_pair.host_]
-                ->getSRMonitor(monitor_type)
-                .getEjectionType();
+            host.second->getSRMonitor(monitor_type).getEjectionType();
         updateDetectedEjectionStats(type);
-        ejectHost(host_success_rate_pair.host_, type);
+        ejectHost(host.first, type);
       }
     }
   }
 
-  if (!valid_failure_percentage_hosts.empty() &&
-      valid_failure_percentage_hosts.size() >= failure_percentage_minimum_hosts) {
+  if (num_valid_failure_percentage_hosts != 0 &&
+      num_valid_failure_percentage_hosts >= failure_percentage_minimum_hosts) {
     const double failure_percentage_threshold = runtime_.snapshot().getInteger(
         FailurePercentageThresholdRuntime, config_.failurePercentageThreshold());
 
-    for (const auto& host_success_rate_pair : valid_failure_percentage_hosts) {
-      if ((100.0 - host_success_rate_pair.success_rate_) >= failure_percentage_threshold) {
+    for (size_t i = 0; i < num_candidates; i++) {
+      if (volumes[i] >= failure_percentage_request_volume &&
+          (100.0 - success_rates[i]) >= failure_percentage_threshold) {
         // We should eject.
 
         // The ejection type returned by the SuccessRateMonitor's getEjectionType() will be a
@@ -715,7 +741,7 @@ void DetectorImpl::processSuccessRateEjections(
                 ? envoy::data::cluster::v3::FAILURE_PERCENTAGE
                 : envoy::data::cluster::v3::FAILURE_PERCENTAGE_LOCAL_ORIGIN;
         updateDetectedEjectionStats(type);
-        ejectHost(host_success_rate_pair.host_, type);
+        ejectHost(hosts[candidates[i]].first, type);
       }
     }
   }
@@ -724,19 +750,38 @@ void DetectorImpl::processSuccessRateEjections(
 void DetectorImpl::onIntervalTimer() {
   MonotonicTime now = time_source_.monotonicTime();
 
+  // Collect the request counts of all workers over the last interval, one array per counter.
+  std::vector<std::pair<HostSharedPtr, DetectorHostMonitorImpl*>> hosts;
+  std::vector<uint64_t> external_origin_success;
+  std::vector<uint64_t> external_origin_total;
+  std::vector<uint64_t> local_origin_success;
+  std::vector<uint64_t> local_origin_total;
+  hosts.reserve(host_monitors_.size());
+  external_origin_success.reserve(host_monitors_.size());
+  external_origin_total.reserve(host_monitors_.size());
+  local_origin_success.reserve(host_monitors_.size());
+  local_origin_total.reserve(host_monitors_.size());
+
   for (auto host : host_monitors_) {
     checkHostForUneject(host.first, host.second, now);
 
-    // Need to update the writer bucket to keep the data valid.
-    host.second->updateCurrentSuccessRateBucket();
+    const HostResults results = host.second->collectResults();
+    hosts.push_back(host);
+    external_origin_success.push_back(results.external_origin_success_);
+    external_origin_total.push_back(results.external_origin_total_);
+    local_origin_success.push_back(results.local_origin_success_);
+    local_origin_total.push_back(results.local_origin_total_);
+
     // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
     // will get updated in processSuccessRateEjections().
     host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin, -1);
     host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin, -1);
   }
 
-  processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin);
-  processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin);
+  processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin, hosts,
+                              external_origin_success, external_origin_total);
+  processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin, hosts,
+                              local_origin_success, local_origin_total);
 
   armIntervalTimer();
 }
@@ -818,25 +863,48 @@ void EventLoggerImpl::setCommonEventParams(envoy::data::cluster::v3::OutlierDete
   TimestampUtil::systemClockToTimestamp(time_source_.systemTime(), *event.mutable_timestamp());
 }
 
-SuccessRateAccumulatorBucket* SuccessRateAccumulator::updateCurrentWriter() {
-  // Right now current is being written to and backup is not. Flush the backup and swap.
-  backup_success_rate_bucket_->success_request_counter_ = 0;
-  backup_success_rate_bucket_->total_request_counter_ = 0;
-
-  current_success_rate_bucket_.swap(backup_success_rate_bucket_);
-
-  return current_success_rate_bucket_.get();
+ResultAccumulator::ResultAccumulator(uint32_t num_shards) : num_shards_(num_shards) {
+  ASSERT(num_shards_ > 0 && num_shards_ <= MaxShards);
 }
 
-absl::optional<std::pair<double, uint64_t>> SuccessRateAccumulator::getSuccessRateAndVolume() {
-  if (!backup_success_rate_bucket_->total_request_counter_) {
-    return absl::nullopt;
+ResultAccumulator::Slot ResultAccumulator::allocate() {
+  absl::MutexLock lock(&mutex_);
+  if (free_slots_.empty()) {
+    blocks_.emplace_back(new ShardRow[num_shards_]);
+    for (uint32_t i = HostsPerBlock; i > 0; i--) {
+      free_slots_.push_back({blocks_.back().get(), i - 1});
+    }
   }
+  Slot slot = free_slots_.back();
+  free_slots_.pop_back();
+  // Nothing writes to released counters, so stale counts of a previous host can be cleared here.
+  collect(slot);
+  return slot;
+}
+
+void ResultAccumulator::release(Slot slot) {
+  absl::MutexLock lock(&mutex_);
+  free_slots_.push_back(slot);
+}
+
+HostResults ResultAccumulator::collect(Slot slot) const {
+  HostResults results;
+  for (uint32_t shard = 0; shard < num_shards_; shard++) {
+    HostResultCounters& counters = slot.counters(shard);
+    results.external_origin_success_ += counters.external_origin_success_.exchange(0);
+    results.external_origin_total_ += counters.external_origin_total_.exchange(0);
+    results.local_origin_success_ += counters.local_origin_success_.exchange(0);
+    results.local_origin_total_ += counters.local_origin_total_.exchange(0);
+  }
+  return results;
+}
 
-  double success_rate = backup_success_rate_bucket_->success_request_counter_ * 100.0 /
-                        backup_success_rate_bucket_->total_request_counter_;
-
-  return {{success_rate, backup_success_rate_bucket_->total_request_counter_}};
+uint32_t ResultAccumulator::threadShard() const {
+  // Threads are numbered in the order they first report a result. Workers start together, so
+  // they end up in distinct shards as long as there are not more of them than shards.
+  static std::atomic<uint32_t> next_thread_index{0};
+  static thread_local const uint32_t thread_index = next_thread_index++;
+  return thread_index % num_shards_;
 }
 
 } // namespace Outlier
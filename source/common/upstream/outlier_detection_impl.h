@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -23,6 +25,7 @@
 #include "envoy/upstream/upstream.h"
 
 #include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -41,6 +44,7 @@ public:
   const absl::optional<MonotonicTime>& lastEjectionTime() override { return time_; }
   const absl::optional<MonotonicTime>& lastUnejectionTime() override { return time_; }
   double successRate(SuccessRateMonitorType) const override { return -1; }
+  uint32_t consecutiveFailures() const override { return 0; }
 
 private:
   const absl::optional<MonotonicTime> time_{};
@@ -58,75 +62,95 @@ public:
 };
 
 /**
- * Thin struct to facilitate calculations for success rate outlier detection.
+ * Request counters of a host, as counted by the threads sharing a shard of a ResultAccumulator.
  */
-struct HostSuccessRatePair {
-  HostSuccessRatePair(HostSharedPtr host, double success_rate)
-      : host_(host), success_rate_(success_rate) {}
-  HostSharedPtr host_;
-  double success_rate_;
+struct HostResultCounters {
+  std::atomic<uint32_t> external_origin_success_{0};
+  std::atomic<uint32_t> external_origin_total_{0};
+  std::atomic<uint32_t> local_origin_success_{0};
+  std::atomic<uint32_t> local_origin_total_{0};
 };
 
-struct SuccessRateAccumulatorBucket {
-  std::atomic<uint64_t> success_request_counter_;
-  std::atomic<uint64_t> total_request_counter_;
+/**
+ * Request counts of a host over the last interval, summed over all the shards.
+ */
+struct HostResults {
+  uint64_t external_origin_success_{};
+  uint64_t external_origin_total_{};
+  uint64_t local_origin_success_{};
+  uint64_t local_origin_total_{};
 };
 
 /**
- * The SuccessRateAccumulator uses the SuccessRateAccumulatorBucket to get per host success rate
- * stats. This implementation has a fixed window size of time, and thus only needs a
- * bucket to write to, and a bucket to accumulate/run stats over.
+ * The request counters of all the hosts of a detector, sharded by thread. Results are reported by
+ * every worker, so counters shared by all workers would bounce between their caches on every
+ * request. Instead each thread counts into the row of its own shard, and the main thread sums up
+ * and resets the counters of all shards once per interval.
+ *
+ * Counters are allocated in blocks of HostsPerBlock hosts. A block has one cache line aligned row
+ * per shard, so the counters of different shards never share a cache line. Blocks are only freed
+ * with the accumulator, which is shared by the detector and all its host monitors.
  */
-class SuccessRateAccumulator {
+class ResultAccumulator {
 public:
-  SuccessRateAccumulator()
-      : current_success_rate_bucket_(new SuccessRateAccumulatorBucket()),
-        backup_success_rate_bucket_(new SuccessRateAccumulatorBucket()) {}
+  static constexpr uint32_t HostsPerBlock = 64;
+  static constexpr uint32_t MaxShards = 16;
+
+  struct alignas(64) ShardRow {
+    std::array<HostResultCounters, HostsPerBlock> hosts_;
+  };
+
+  /**
+   * The counters of a single host in all the shards of a block.
+   */
+  struct Slot {
+    HostResultCounters& counters(uint32_t shard) { return rows_[shard].hosts_[index_]; }
+
+    ShardRow* rows_;
+    uint32_t index_;
+  };
+
+  explicit ResultAccumulator(uint32_t num_shards);
 
   /**
-   * This function updates the bucket to write data to.
-   * @return a pointer to the SuccessRateAccumulatorBucket.
+   * Allocates zeroed counters for a new host. Only called on the main thread.
    */
-  SuccessRateAccumulatorBucket* updateCurrentWriter();
+  Slot allocate();
   /**
-   * This function returns the success rate of a host over a window of time if the request volume is
-   * high enough. The underlying window of time could be dynamically adjusted. In the current
-   * implementation it is a fixed time window.
-   * @param success_rate_request_volume the threshold of requests an accumulator has to have in
-   *                                    order to be able to return a significant success rate value.
-   * @return a valid absl::optional<double> with the success rate. If there were not enough
-   * requests, an invalid absl::optional<double> is returned.
+   * Returns the counters of a host to the accumulator. May be called on any thread, but only once
+   * nothing can write to the counters any more.
    */
-  absl::optional<std::pair<double, uint64_t>> getSuccessRateAndVolume();
+  void release(Slot slot);
+  /**
+   * @return the counters of the calling thread for the host of the slot.
+   */
+  HostResultCounters& threadCounters(Slot slot) const { return slot.counters(threadShard()); }
+  /**
+   * Sums up and resets the counters of a host in all shards. Only called on the main thread.
+   */
+  HostResults collect(Slot slot) const;
 
 private:
-  std::unique_ptr<SuccessRateAccumulatorBucket> current_success_rate_bucket_;
-  std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
+  uint32_t threadShard() const;
+
+  const uint32_t num_shards_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<ShardRow[]>> blocks_ ABSL_GUARDED_BY(mutex_);
+  std::vector<Slot> free_slots_ ABSL_GUARDED_BY(mutex_);
 };
 
+using ResultAccumulatorSharedPtr = std::shared_ptr<ResultAccumulator>;
+
 class SuccessRateMonitor {
 public:
   SuccessRateMonitor(envoy::data::cluster::v3::OutlierEjectionType ejection_type)
-      : ejection_type_(ejection_type), success_rate_(-1) {
-    // Point the success_rate_accumulator_bucket_ pointer to a bucket.
-    updateCurrentSuccessRateBucket();
-  }
+      : ejection_type_(ejection_type), success_rate_(-1) {}
   double getSuccessRate() const { return success_rate_; }
-  SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
   void setSuccessRate(double new_success_rate) { success_rate_ = new_success_rate; }
-  void updateCurrentSuccessRateBucket() {
-    success_rate_accumulator_bucket_.store(success_rate_accumulator_.updateCurrentWriter());
-  }
-  void incTotalReqCounter() { success_rate_accumulator_bucket_.load()->total_request_counter_++; }
-  void incSuccessReqCounter() {
-    success_rate_accumulator_bucket_.load()->success_request_counter_++;
-  }
 
   envoy::data::cluster::v3::OutlierEjectionType getEjectionType() const { return ejection_type_; }
 
 private:
-  SuccessRateAccumulator success_rate_accumulator_;
-  std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
   envoy::data::cluster::v3::OutlierEjectionType ejection_type_;
   double success_rate_;
 };
@@ -139,6 +163,7 @@ class DetectorImpl;
 class DetectorHostMonitorImpl : public DetectorHostMonitor {
 public:
   DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector, HostSharedPtr host);
+  ~DetectorHostMonitorImpl() override;
 
   void eject(MonotonicTime ejection_time);
   void uneject(MonotonicTime ejection_time);
@@ -174,7 +199,12 @@ public:
   double successRate(SuccessRateMonitorType type) const override {
     return getSRMonitor(type).getSuccessRate();
   }
-  void updateCurrentSuccessRateBucket();
+  uint32_t consecutiveFailures() const override {
+    return std::max({consecutive_5xx_.load(), consecutive_gateway_failure_.load(),
+                     consecutive_local_origin_failure_.load()});
+  }
+  // Sums up and resets the request counters of all workers. Only called on the main thread.
+  HostResults collectResults() { return result_accumulator_->collect(result_slot_); }
   void successRate(SuccessRateMonitorType type, double new_success_rate) {
     getSRMonitor(type).setSuccessRate(new_success_rate);
   }
@@ -210,6 +240,10 @@ private:
   // jitter for outlier ejection time
   std::chrono::milliseconds jitter_;
 
+  // request counters of the success rate monitors, sharded by worker thread.
+  const ResultAccumulatorSharedPtr result_accumulator_;
+  const ResultAccumulator::Slot result_slot_;
+
   // success rate monitors:
   // - external_origin: for all events when external/local are not split
   //   and for external origin failures when external/local events are split
@@ -396,6 +430,7 @@ public:
   void onConsecutiveLocalOriginFailure(HostSharedPtr host);
   Runtime::Loader& runtime() { return runtime_; }
   DetectorConfig& config() { return config_; }
+  const ResultAccumulatorSharedPtr& resultAccumulator() { return result_accumulator_; }
 
   // Upstream::Outlier::Detector
   void addChangedStateCb(ChangeStateCb cb) override { callbacks_.push_back(cb); }
@@ -412,19 +447,17 @@ public:
    * This function returns pair of double values for success rate outlier detection. The pair
    * contains the average success rate of all valid hosts in the cluster and the ejection threshold.
    * If a host's success rate is under this threshold, the host is an outlier.
-   * @param success_rate_sum is the sum of the data in the success_rate_data vector.
-   * @param valid_success_rate_hosts is the vector containing the individual success rate data
-   *        points.
+   * @param success_rate_sum is the sum of the data in the success_rates vector.
+   * @param success_rates is the vector containing the individual success rate data points.
    * @return EjectionPair
    */
   struct EjectionPair {
     double success_rate_average_; // average success rate of all valid hosts in the cluster
     double ejection_threshold_;   // ejection threshold for the cluster
   };
-  static EjectionPair
-  successRateEjectionThreshold(double success_rate_sum,
-                               const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
-                               double success_rate_stdev_factor);
+  static EjectionPair successRateEjectionThreshold(double success_rate_sum,
+                                                   const std::vector<double>& success_rates,
+                                                   double success_rate_stdev_factor);
 
   const absl::node_hash_map<HostSharedPtr, DetectorHostMonitorImpl*>& getHostMonitors() {
     return host_monitors_;
@@ -450,7 +483,10 @@ private:
   bool enforceEjection(envoy::data::cluster::v3::OutlierEjectionType type);
   void updateEnforcedEjectionStats(envoy::data::cluster::v3::OutlierEjectionType type);
   void updateDetectedEjectionStats(envoy::data::cluster::v3::OutlierEjectionType type);
-  void processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType monitor_type);
+  void processSuccessRateEjections(
+      DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+      const std::vector<std::pair<HostSharedPtr, DetectorHostMonitorImpl*>>& hosts,
+      const std::vector<uint64_t>& success_counts, const std::vector<uint64_t>& total_counts);
 
   // The helper to double write value and gauge. The gauge could be null value since because any
   // stat might be deactivated.
@@ -481,6 +517,7 @@ private:
   EventLoggerSharedPtr event_logger_;
   Common::CallbackHandlePtr member_update_cb_;
   Random::RandomGenerator& random_generator_;
+  const ResultAccumulatorSharedPtr result_accumulator_;
 
   // EjectionPair for external and local origin events.
   // When external/local origin events are not split, external_origin_sr_num_ are used for
@@ -0,0 +1,98 @@
+#include "source/common/upstream/response_time_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+namespace Upstream {
+
+uint32_t ResponseTimeTrackerImpl::bucket(uint64_t response_time_us) {
+  if (response_time_us < LinearBuckets) {
+    return response_time_us;
+  }
+  // The buckets of a power of two are indexed by the bits after the most significant one.
+  const uint32_t msb = 63 - absl::countl_zero(response_time_us);
+  const uint32_t sub_bucket = (response_time_us >> (msb - SubBucketBits)) & 0x7;
+  const uint32_t index = LinearBuckets + ((msb - 4) << SubBucketBits) + sub_bucket;
+  return std::min(index, NumBuckets - 1);
+}
+
+uint64_t ResponseTimeTrackerImpl::bucketUpperBound(uint32_t bucket) {
+  if (bucket < LinearBuckets) {
+    return bucket;
+  }
+  const uint32_t msb = 4 + ((bucket - LinearBuckets) >> SubBucketBits);
+  const uint64_t sub_bucket = (bucket - LinearBuckets) & 0x7;
+  const uint64_t width = uint64_t(1) << (msb - SubBucketBits);
+  return (8 + sub_bucket) * width + width - 1;
+}
+
+void ResponseTimeTrackerImpl::recordResponseTime(std::chrono::microseconds response_time) {
+  buckets_[bucket(std::max<int64_t>(response_time.count(), 0))].fetch_add(
+      1, std::memory_order_relaxed);
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  // Exactly one of the requests crossing the end of the window sees it.
+  if (requests_since_decay_.fetch_add(1, std::memory_order_relaxed) + 1 == WindowSize) {
+    requests_since_decay_.fetch_sub(WindowSize, std::memory_order_relaxed);
+    decay();
+  }
+}
+
+void ResponseTimeTrackerImpl::decay() {
+  // Only the halvings subtract from the response time counts, so they can't underflow, and
+  // increments racing with a halving are kept. The hedges are also given back by cancelHedge(),
+  // which doesn't go below zero.
+  absl::MutexLock lock(&decay_lock_);
+  for (auto& count : buckets_) {
+    count.fetch_sub(count.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+  }
+  requests_.fetch_sub(requests_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+  hedges_.fetch_sub(hedges_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+}
+
+absl::optional<std::chrono::microseconds>
+ResponseTimeTrackerImpl::responseTimePercentile(double percentile) const {
+  uint64_t total = 0;
+  for (const auto& count : buckets_) {
+    total += count.load(std::memory_order_relaxed);
+  }
+  if (total < MinRequests) {
+    return absl::nullopt;
+  }
+
+  const uint64_t rank =
+      std::max<uint64_t>(1, std::ceil(total * std::clamp(percentile, 0.0, 100.0) / 100));
+  uint64_t below = 0;
+  for (uint32_t i = 0; i < NumBuckets; i++) {
+    below += buckets_[i].load(std::memory_order_relaxed);
+    if (below >= rank) {
+      return std::chrono::microseconds(bucketUpperBound(i));
+    }
+  }
+  // The buckets were incremented since they were summed up.
+  return std::chrono::microseconds(bucketUpperBound(NumBuckets - 1));
+}
+
+bool ResponseTimeTrackerImpl::tryHedge(double budget_percent) {
+  const double budget = requests_.load(std::memory_order_relaxed) * budget_percent / 100;
+  uint32_t hedges = hedges_.load(std::memory_order_relaxed);
+  do {
+    if (hedges + 1 > budget) {
+      return false;
+    }
+  } while (!hedges_.compare_exchange_weak(hedges, hedges + 1, std::memory_order_relaxed));
+  return true;
+}
+
+void ResponseTimeTrackerImpl::cancelHedge() {
+  // The hedge may already have been halved away.
+  uint32_t hedges = hedges_.load(std::memory_order_relaxed);
+  while (hedges > 0 &&
+         !hedges_.compare_exchange_weak(hedges, hedges - 1, std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
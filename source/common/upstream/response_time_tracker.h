@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/upstream/upstream.h"
+
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Implementation of ResponseTimeTracker as a histogram of the response times with log-linear
+ * buckets: one bucket per microsecond below 16us, then 8 buckets per power of two, so a percentile
+ * is off by at most 12.5%. Recording takes a few atomic increments. Every WindowSize recorded
+ * requests the counts are halved, so the recent requests weigh the most.
+ */
+class ResponseTimeTrackerImpl : public ResponseTimeTracker {
+public:
+  // The number of recorded requests between two halvings of the counts.
+  static constexpr uint32_t WindowSize = 1024;
+  // The number of requests below which there is no percentile.
+  static constexpr uint32_t MinRequests = 128;
+
+  // ResponseTimeTracker
+  void recordResponseTime(std::chrono::microseconds response_time) override;
+  absl::optional<std::chrono::microseconds>
+  responseTimePercentile(double percentile) const override;
+  bool tryHedge(double budget_percent) override;
+  void cancelHedge() override;
+
+private:
+  static constexpr uint32_t LinearBuckets = 16;
+  static constexpr uint32_t SubBucketBits = 3;
+  static constexpr uint32_t NumBuckets = 256;
+
+  static uint32_t bucket(uint64_t response_time_us);
+  static uint64_t bucketUpperBound(uint32_t bucket);
+  void decay();
+
+  std::array<std::atomic<uint32_t>, NumBuckets> buckets_{};
+  std::atomic<uint32_t> requests_{};
+  std::atomic<uint32_t> hedges_{};
+  std::atomic<uint32_t> requests_since_decay_{};
+  absl::Mutex decay_lock_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
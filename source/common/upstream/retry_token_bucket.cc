@@ -0,0 +1,58 @@
+#include "source/common/upstream/retry_token_bucket.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Upstream {
+
+RetryTokenBucketImpl::RetryTokenBucketImpl(uint32_t max_tokens, double token_ratio)
+    : max_tokens_(max_tokens * TokenScale),
+      tokens_per_success_(std::max<uint64_t>(1, std::llround(token_ratio * TokenScale))),
+      tokens_(max_tokens_) {}
+
+bool RetryTokenBucketImpl::tryTakeToken() {
+  uint64_t tokens = tokens_.load(std::memory_order_relaxed);
+  do {
+    if (tokens < TokenScale) {
+      return false;
+    }
+  } while (!tokens_.compare_exchange_weak(tokens, tokens - TokenScale, std::memory_order_relaxed));
+  return true;
+}
+
+bool RetryTokenBucketImpl::hasToken() const {
+  return tokens_.load(std::memory_order_relaxed) >= TokenScale;
+}
+
+void RetryTokenBucketImpl::onSuccess() {
+  uint64_t tokens = tokens_.load(std::memory_order_relaxed);
+  do {
+    // Most responses find the bucket full, which this doesn't write to.
+    if (tokens >= max_tokens_) {
+      return;
+    }
+  } while (!tokens_.compare_exchange_weak(
+      tokens, std::min(tokens + tokens_per_success_, max_tokens_), std::memory_order_relaxed));
+}
+
+RetryTokenBucketsImpl::RetryTokenBucketsImpl(
+    const envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket& config)
+    : token_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, token_ratio, DefaultTokenRatio)),
+      max_host_tokens_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_host_tokens, 0)),
+      host_failure_streak_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, host_failure_streak, 0)),
+      host_selection_max_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, host_selection_max_attempts, DefaultHostSelectionMaxAttempts)),
+      cluster_bucket_(config.max_tokens(), token_ratio_) {}
+
+RetryTokenBucketPtr RetryTokenBucketsImpl::createHostBucket() const {
+  if (max_host_tokens_ == 0) {
+    return nullptr;
+  }
+  return std::make_unique<RetryTokenBucketImpl>(max_host_tokens_, token_ratio_);
+}
+
+} // namespace Upstream
+} // namespace Envoy
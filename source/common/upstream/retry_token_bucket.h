@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "envoy/config/cluster/v3/circuit_breaker.pb.h"
+#include "envoy/upstream/resource_manager.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Implementation of RetryTokenBucket counting thousandths of a token in an atomic, so that the
+ * workers can take and put back tokens without a lock.
+ */
+class RetryTokenBucketImpl : public RetryTokenBucket {
+public:
+  RetryTokenBucketImpl(uint32_t max_tokens, double token_ratio);
+
+  // RetryTokenBucket
+  bool tryTakeToken() override;
+  bool hasToken() const override;
+  void onSuccess() override;
+
+private:
+  static constexpr uint64_t TokenScale = 1000;
+
+  const uint64_t max_tokens_;
+  const uint64_t tokens_per_success_;
+  std::atomic<uint64_t> tokens_;
+};
+
+/**
+ * Implementation of RetryTokenBuckets from the configuration of the cluster.
+ */
+class RetryTokenBucketsImpl : public RetryTokenBuckets {
+public:
+  static constexpr double DefaultTokenRatio = 0.1;
+  static constexpr uint32_t DefaultHostSelectionMaxAttempts = 3;
+
+  RetryTokenBucketsImpl(
+      const envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket& config);
+
+  // RetryTokenBuckets
+  RetryTokenBucket& clusterBucket() override { return cluster_bucket_; }
+  RetryTokenBucketPtr createHostBucket() const override;
+  uint32_t hostFailureStreak() const override { return host_failure_streak_; }
+  uint32_t hostSelectionMaxAttempts() const override { return host_selection_max_attempts_; }
+
+private:
+  const double token_ratio_;
+  const uint32_t max_host_tokens_;
+  const uint32_t host_failure_streak_;
+  const uint32_t host_selection_max_attempts_;
+  RetryTokenBucketImpl cluster_bucket_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
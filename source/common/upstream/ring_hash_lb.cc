@@ -1,7 +1,10 @@
 #include "source/common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -10,6 +13,7 @@
 #include "source/common/common/assert.h"
 #include "source/common/upstream/load_balancer_impl.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/strings/string_view.h"
 
@@ -45,6 +49,26 @@ RingHashLoadBalancer::RingHashLoadBalancer(
   }
 }
 
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createLoadBalancer(uint32_t priority,
+                                         const NormalizedHostWeightVector& normalized_host_weights,
+                                         double min_normalized_weight,
+                                         double /* max_normalized_weight */) {
+  if (rings_.size() <= priority) {
+    rings_.resize(priority + 1);
+  }
+  auto ring = std::make_shared<Ring>(normalized_host_weights, min_normalized_weight,
+                                     min_ring_size_, max_ring_size_, hash_function_,
+                                     use_hostname_for_hashing_, stats_, rings_[priority].get());
+  rings_[priority] = ring;
+  if (hash_balance_factor_ == 0) {
+    return ring;
+  }
+
+  return std::make_shared<BoundedLoadHashingLoadBalancer>(ring, normalized_host_weights,
+                                                          hash_balance_factor_);
+}
+
 RingHashLoadBalancerStats RingHashLoadBalancer::generateStats(Stats::Scope& scope) {
   return {ALL_RING_HASH_LOAD_BALANCER_STATS(POOL_GAUGE(scope))};
 }
@@ -102,7 +126,8 @@ using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::Hash
 RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_host_weights,
                                  double min_normalized_weight, uint64_t min_ring_size,
                                  uint64_t max_ring_size, HashFunction hash_function,
-                                 bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats)
+                                 bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats,
+                                 const Ring* previous)
     : stats_(stats) {
   ENVOY_LOG(trace, "ring hash: building ring");
 
@@ -141,28 +166,21 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
   // For stats reporting, keep track of the minimum and maximum actual number of hashes per host.
   // Users should hopefully pay attention to these numbers and alert if min_hashes_per_host is too
   // low, since that implies an inaccurate request distribution.
+  //
+  // When a previous ring is given, a host that kept its hash key still owns the hashes it had
+  // there, up to its new count, so only the hashes of new replicas are computed. Replicas beyond
+  // the new count are dropped, as are all entries of removed or re-keyed hosts. The copied entries
+  // are already sorted, so the new ones are sorted on their own and merged in.
 
   absl::InlinedVector<char, 196> hash_key_buffer;
-  double current_hashes = 0.0;
-  double target_hashes = 0.0;
-  uint64_t min_hashes_per_host = ring_size;
-  uint64_t max_hashes_per_host = 0;
-  for (const auto& entry : normalized_host_weights) {
-    const auto& host = entry.first;
-    const absl::string_view key_to_hash = hashKey(host, use_hostname_for_hashing);
-    ASSERT(!key_to_hash.empty());
-
+  const auto hash_replicas = [&](absl::string_view key_to_hash, uint64_t begin, uint64_t end,
+                                 const std::function<void(uint64_t)>& cb) {
     hash_key_buffer.assign(key_to_hash.begin(), key_to_hash.end());
     hash_key_buffer.emplace_back('_');
-    auto offset_start = hash_key_buffer.end();
-
-    // As noted above: maintain current_hashes and target_hashes as running sums across the entire
-    // host set. `i` is needed only to construct the hash key, and tally min/max hashes per host.
-    target_hashes += scale * entry.second;
-    uint64_t i = 0;
-    while (current_hashes < target_hashes) {
+    const size_t offset_start = hash_key_buffer.size();
+    for (uint64_t i = begin; i < end; ++i) {
       const std::string i_str = absl::StrCat("", i);
-      hash_key_buffer.insert(offset_start, i_str.begin(), i_str.end());
+      hash_key_buffer.insert(hash_key_buffer.end(), i_str.begin(), i_str.end());
 
       absl::string_view hash_key(static_cast<char*>(hash_key_buffer.data()),
                                  hash_key_buffer.size());
@@ -173,18 +191,68 @@ RingHashLoadBalancer::Ring::Ring(const NormalizedHostWeightVector& normalized_ho
               : HashUtil::xxHash64(hash_key);
 
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
-      ++i;
+      cb(hash);
+      hash_key_buffer.resize(offset_start);
+    }
+  };
+
+  double current_hashes = 0.0;
+  double target_hashes = 0.0;
+  uint64_t min_hashes_per_host = ring_size;
+  uint64_t max_hashes_per_host = 0;
+  std::vector<RingEntry> added_entries;
+  // Hosts whose entries in the previous ring are kept, except for the (host, hash) pairs dropped.
+  absl::flat_hash_set<const Host*> kept_hosts;
+  absl::flat_hash_set<std::pair<const Host*, uint64_t>> dropped_entries;
+  for (const auto& entry : normalized_host_weights) {
+    const auto& host = entry.first;
+    const absl::string_view key_to_hash = hashKey(host, use_hostname_for_hashing);
+    ASSERT(!key_to_hash.empty());
+
+    // As noted above: maintain current_hashes and target_hashes as running sums across the entire
+    // host set.
+    target_hashes += scale * entry.second;
+    uint64_t count = 0;
+    while (current_hashes < target_hashes) {
+      ++count;
       ++current_hashes;
-      hash_key_buffer.erase(offset_start, hash_key_buffer.end());
     }
-    min_hashes_per_host = std::min(i, min_hashes_per_host);
-    max_hashes_per_host = std::max(i, max_hashes_per_host);
+    min_hashes_per_host = std::min(count, min_hashes_per_host);
+    max_hashes_per_host = std::max(count, max_hashes_per_host);
+    if (count == 0) {
+      continue;
+    }
+    host_hashes_.emplace(host.get(), HostHashes{std::string(key_to_hash), count});
+
+    uint64_t reused = 0;
+    if (previous != nullptr) {
+      const auto it = previous->host_hashes_.find(host.get());
+      if (it != previous->host_hashes_.end() && it->second.key_ == key_to_hash) {
+        reused = std::min(count, it->second.count_);
+        kept_hosts.insert(host.get());
+        hash_replicas(key_to_hash, reused, it->second.count_, [&](uint64_t hash) {
+          dropped_entries.emplace(host.get(), hash);
+        });
+      }
+    }
+    hash_replicas(key_to_hash, reused, count,
+                  [&](uint64_t hash) { added_entries.push_back({hash, host}); });
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
+  const auto hash_less = [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
     return lhs.hash_ < rhs.hash_;
-  });
+  };
+  if (previous != nullptr) {
+    std::copy_if(previous->ring_.begin(), previous->ring_.end(), std::back_inserter(ring_),
+                 [&](const RingEntry& entry) {
+                   return kept_hosts.contains(entry.host_.get()) &&
+                          !dropped_entries.contains(std::make_pair(entry.host_.get(), entry.hash_));
+                 });
+  }
+  const size_t kept_size = ring_.size();
+  std::sort(added_entries.begin(), added_entries.end(), hash_less);
+  ring_.insert(ring_.end(), added_entries.begin(), added_entries.end());
+  std::inplace_merge(ring_.begin(), ring_.begin() + kept_size, ring_.end(), hash_less);
   if (ENVOY_LOG_CHECK_LEVEL(trace)) {
     for (const auto& entry : ring_) {
       const absl::string_view key_to_hash = hashKey(entry.host_, use_hostname_for_hashing);
@@ -10,6 +10,8 @@
 #include "source/common/common/logger.h"
 #include "source/common/upstream/thread_aware_lb_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -56,15 +58,27 @@ private:
     HostConstSharedPtr host_;
   };
 
+  // The hashes a host owns on a ring are those of "<key>_0" up to "<key>_<count - 1>".
+  struct HostHashes {
+    std::string key_;
+    uint64_t count_;
+  };
+
   struct Ring : public HashingLoadBalancer {
+    // If previous is set, entries of hosts that kept their hash key are copied from it and only
+    // the hashes of added, removed or reweighted hosts are computed. The result is the same ring
+    // a build from scratch would produce.
     Ring(const NormalizedHostWeightVector& normalized_host_weights, double min_normalized_weight,
          uint64_t min_ring_size, uint64_t max_ring_size, HashFunction hash_function,
-         bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats);
+         bool use_hostname_for_hashing, RingHashLoadBalancerStats& stats, const Ring* previous);
 
     // ThreadAwareLoadBalancerBase::HashingLoadBalancer
     HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
 
     std::vector<RingEntry> ring_;
+    // Hosts with at least one entry on the ring. The entries keep the hosts alive, so the
+    // pointers can't be reused by other hosts while the ring exists.
+    absl::flat_hash_map<const Host*, HostHashes> host_hashes_;
 
     RingHashLoadBalancerStats& stats_;
   };
@@ -72,18 +86,8 @@ private:
 
   // ThreadAwareLoadBalancerBase
   HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
-                     double min_normalized_weight, double /* max_normalized_weight */) override {
-    HashingLoadBalancerSharedPtr ring_hash_lb =
-        std::make_shared<Ring>(normalized_host_weights, min_normalized_weight, min_ring_size_,
-                               max_ring_size_, hash_function_, use_hostname_for_hashing_, stats_);
-    if (hash_balance_factor_ == 0) {
-      return ring_hash_lb;
-    }
-
-    return std::make_shared<BoundedLoadHashingLoadBalancer>(
-        ring_hash_lb, std::move(normalized_host_weights), hash_balance_factor_);
-  }
+  createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
+                     double min_normalized_weight, double max_normalized_weight) override;
 
   static RingHashLoadBalancerStats generateStats(Stats::Scope& scope);
 
@@ -97,6 +101,8 @@ private:
   const HashFunction hash_function_;
   const bool use_hostname_for_hashing_;
   const uint32_t hash_balance_factor_;
+  // The last ring built for each priority, the starting point of the next build.
+  std::vector<RingConstSharedPtr> rings_;
 };
 
 } // namespace Upstream
@@ -1,5 +1,6 @@
 #include "source/common/upstream/subset_lb.h"
 
+#include <limits>
 #include <memory>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
@@ -14,6 +15,7 @@
 #include "source/common/upstream/maglev_lb.h"
 #include "source/common/upstream/ring_hash_lb.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_set.h"
 
 namespace Envoy {
@@ -75,13 +77,13 @@ SubsetLoadBalancer::SubsetLoadBalancer(
   original_priority_set_callback_handle_ = priority_set.addPriorityUpdateCb(
       [this](uint32_t priority, const HostVector&, const HostVector&) {
         refreshSubsets(priority);
-        purgeEmptySubsets(subsets_);
+        purgeEmptySubsets();
       });
 }
 
 SubsetLoadBalancer::~SubsetLoadBalancer() {
   // Ensure gauges reflect correct values.
-  forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
+  forEachSubset([&](LbSubsetEntryPtr entry) {
     if (entry->active()) {
       stats_.lb_subsets_removed_.inc();
       stats_.lb_subsets_active_.dec();
@@ -348,43 +350,30 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   return entry->lb_subset_->chooseHost(context);
 }
 
-// Iterates over the given metadata match criteria (which must be lexically sorted by key) and find
-// a matching LbSubsetEntryPtr, if any.
+// Looks up the interned value of each of the given metadata match criteria (which must be lexically
+// sorted by key) and finds the matching LbSubsetEntryPtr, if any.
 SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::findSubset(
     const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& match_criteria) {
-  const LbSubsetMap* subsets = &subsets_;
-
   // Because the match_criteria and the host metadata used to populate subsets_ are sorted in the
-  // same order, we can iterate over the criteria and perform a lookup for each key and value,
-  // starting with the root LbSubsetMap and using the previous iteration's LbSubsetMap thereafter
-  // (tracked in subsets). If ever a criterion's key or value is not found, there is no subset for
-  // this criteria. If we reach the last criterion, we've found the LbSubsetEntry for the criteria,
-  // which may or may not have a subset attached to it.
-  for (uint32_t i = 0; i < match_criteria.size(); i++) {
-    const Router::MetadataMatchCriterion& match_criterion = *match_criteria[i];
-    const auto& subset_it = subsets->find(match_criterion.name());
-    if (subset_it == subsets->end()) {
-      // No subsets with this key (at this level in the hierarchy).
-      break;
+  // same order, the ids of the criteria values form the key of the matching subset. If a
+  // criterion's key or value was never seen in the metadata of a host, there is no subset for
+  // this criteria.
+  SubsetKey key;
+  key.reserve(match_criteria.size());
+  for (const auto& match_criterion : match_criteria) {
+    const auto key_it = value_ids_.find(match_criterion->name());
+    if (key_it == value_ids_.end()) {
+      return nullptr;
     }
-
-    const ValueSubsetMap& vs_map = subset_it->second;
-    const auto& vs_it = vs_map.find(match_criterion.value());
-    if (vs_it == vs_map.end()) {
-      // No subsets with this value.
-      break;
-    }
-
-    const LbSubsetEntryPtr& entry = vs_it->second;
-    if (i + 1 == match_criteria.size()) {
-      // We've reached the end of the criteria, and they all matched.
-      return entry;
+    const auto value_it = key_it->second.find(match_criterion->value());
+    if (value_it == key_it->second.end()) {
+      return nullptr;
     }
-
-    subsets = &entry->children_;
+    key.push_back(value_it->second);
   }
 
-  return nullptr;
+  const auto it = subsets_.find(key);
+  return it != subsets_.end() ? it->second : nullptr;
 }
 
 void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority, const HostVector& all_hosts) {
@@ -437,21 +426,35 @@ void SubsetLoadBalancer::initLbSubsetEntryOnce(LbSubsetEntryPtr& entry, bool sin
 
 // Iterates all the hosts of specified priority, looking up an LbSubsetEntryPtr for each and add
 // hosts to related entry. Because the metadata of host can be updated inlined, we must evaluate
-// every hosts for every update.
+// every hosts for every update. The subset keys of a metadata object are only extracted the first
+// time a host of the priority has it, so this is cheap for the hosts whose metadata didn't change.
 void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all_hosts) {
   absl::flat_hash_set<const LbSubsetEntry*> single_host_entries;
   uint64_t collision_count_of_single_host_entries{};
 
+  if (host_subset_keys_.size() <= priority) {
+    host_subset_keys_.resize(priority + 1);
+  }
+  HostSubsetKeysMap& previous_host_subset_keys = host_subset_keys_[priority];
+  HostSubsetKeysMap host_subset_keys;
+  host_subset_keys.reserve(previous_host_subset_keys.size());
+
   for (const auto& host : all_hosts) {
-    for (const auto& subset_selector : subset_selectors_) {
-      const auto& keys = subset_selector->selectorKeys();
-      // For each host, for each subset key, attempt to extract the metadata corresponding to the
-      // key from the host.
-      std::vector<SubsetMetadata> all_kvs = extractSubsetMetadata(keys, *host);
-      for (const auto& kvs : all_kvs) {
+    const MetadataConstSharedPtr metadata = host->metadata();
+    auto [keys_it, inserted] = host_subset_keys.try_emplace(metadata.get());
+    if (inserted) {
+      const auto previous_it = previous_host_subset_keys.find(metadata.get());
+      keys_it->second = previous_it != previous_host_subset_keys.end()
+                            ? std::move(previous_it->second)
+                            : extractSubsetKeys(*host);
+    }
+
+    const auto& selector_keys = keys_it->second.selector_keys_;
+    for (uint32_t i = 0; i < subset_selectors_.size(); i++) {
+      for (const SubsetKey& key : selector_keys[i]) {
         // The host has metadata for each key, find or create its subset.
-        auto entry = findOrCreateLbSubsetEntry(subsets_, kvs, 0);
-        initLbSubsetEntryOnce(entry, subset_selector->singleHostPerSubset());
+        auto entry = findOrCreateLbSubsetEntry(key);
+        initLbSubsetEntryOnce(entry, subset_selectors_[i]->singleHostPerSubset());
 
         if (entry->single_host_subset_) {
           if (single_host_entries.contains(entry.get())) {
@@ -465,6 +468,7 @@ void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all
       }
     }
   }
+  previous_host_subset_keys = std::move(host_subset_keys);
 
   // This stat isn't added to `ClusterTrafficStats` because it wouldn't be used for nearly all
   // clusters, and is only set during configuration updates, not in the data path, so performance of
@@ -479,7 +483,7 @@ void SubsetLoadBalancer::processSubsets(uint32_t priority, const HostVector& all
   single_duplicate_stat_->set(collision_count_of_single_host_entries);
 
   // Finalize updates after all the hosts are evaluated.
-  forEachSubset(subsets_, [priority](LbSubsetEntryPtr entry) {
+  forEachSubset([priority](LbSubsetEntryPtr entry) {
     if (entry->initialized()) {
       entry->lb_subset_->finalize(priority);
     }
@@ -498,6 +502,43 @@ bool SubsetLoadBalancer::hostMatches(const SubsetMetadata& kvs, const Host& host
       kvs, host.metadata().get(), Config::MetadataFilters::get().ENVOY_LB, list_as_any_);
 }
 
+// Extracts the subset keys of the metadata of the given host for each subset selector, interning
+// the values of the key-value pairs.
+SubsetLoadBalancer::HostSubsetKeys SubsetLoadBalancer::extractSubsetKeys(const Host& host) {
+  HostSubsetKeys host_subset_keys;
+  host_subset_keys.metadata_ = host.metadata();
+  host_subset_keys.selector_keys_.reserve(subset_selectors_.size());
+  for (const auto& subset_selector : subset_selectors_) {
+    auto& keys = host_subset_keys.selector_keys_.emplace_back();
+    for (const auto& kvs : extractSubsetMetadata(subset_selector->selectorKeys(), host)) {
+      SubsetKey& key = keys.emplace_back();
+      for (const auto& [name, value] : kvs) {
+        key.push_back(internValue(name, value));
+      }
+    }
+  }
+  return host_subset_keys;
+}
+
+// Returns the id of the given value of the given key, assigning an id to values seen for the first
+// time. The ids of purged values are reused first, so that the ids stay bounded by the largest
+// number of values interned at once.
+uint32_t SubsetLoadBalancer::internValue(const std::string& key, const ProtobufWkt::Value& value) {
+  const auto [it, inserted] = value_ids_[key].try_emplace(HashedValue(value));
+  if (inserted) {
+    if (!free_value_ids_.empty()) {
+      it->second = free_value_ids_.back();
+      free_value_ids_.pop_back();
+    } else {
+      RELEASE_ASSERT(next_value_id_ < std::numeric_limits<uint32_t>::max(),
+                     "too many subset metadata values");
+      it->second = next_value_id_++;
+    }
+    num_values_++;
+  }
+  return it->second;
+}
+
 // Iterates over subset_keys looking up values from the given host's metadata. Each key-value pair
 // is appended to kvs. Returns a non-empty value if the host has a value for each key.
 std::vector<SubsetLoadBalancer::SubsetMetadata>
@@ -582,93 +623,75 @@ std::string SubsetLoadBalancer::describeMetadata(const SubsetLoadBalancer::Subse
   return buf.str();
 }
 
-// Given a vector of key-values (from extractSubsetMetadata), recursively finds the matching
-// LbSubsetEntryPtr.
+// Finds the LbSubsetEntryPtr of the given subset key, creating an uninitialized one if needed.
 SubsetLoadBalancer::LbSubsetEntryPtr
-SubsetLoadBalancer::findOrCreateLbSubsetEntry(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                              uint32_t idx) {
-  ASSERT(idx < kvs.size());
-
-  const std::string& name = kvs[idx].first;
-  const ProtobufWkt::Value& pb_value = kvs[idx].second;
-  const HashedValue value(pb_value);
-
-  LbSubsetEntryPtr entry;
-
-  const auto kv_it = subsets.find(name);
-
-  if (kv_it != subsets.end()) {
-    ValueSubsetMap& value_subset_map = kv_it->second;
-    const auto vs_it = value_subset_map.find(value);
-    if (vs_it != value_subset_map.end()) {
-      entry = vs_it->second;
-    }
-  }
-
+SubsetLoadBalancer::findOrCreateLbSubsetEntry(const SubsetKey& key) {
+  LbSubsetEntryPtr& entry = subsets_[key];
   if (!entry) {
-    // Not found. Create an uninitialized entry.
     entry = std::make_shared<LbSubsetEntry>();
-    if (kv_it != subsets.end()) {
-      ValueSubsetMap& value_subset_map = kv_it->second;
-      value_subset_map.emplace(value, entry);
-    } else {
-      ValueSubsetMap value_subset_map = {{value, entry}};
-      subsets.emplace(name, value_subset_map);
-    }
-  }
-
-  idx++;
-  if (idx == kvs.size()) {
-    // We've matched all the key-values, return the entry.
-    return entry;
   }
-
-  return findOrCreateLbSubsetEntry(entry->children_, kvs, idx);
+  return entry;
 }
 
-// Invokes cb for each LbSubsetEntryPtr in subsets.
-void SubsetLoadBalancer::forEachSubset(LbSubsetMap& subsets,
-                                       std::function<void(LbSubsetEntryPtr&)> cb) {
-  for (auto& vsm : subsets) {
-    for (auto& em : vsm.second) {
-      LbSubsetEntryPtr entry = em.second;
-      cb(entry);
-      forEachSubset(entry->children_, cb);
-    }
+// Invokes cb for each LbSubsetEntryPtr in subsets_.
+void SubsetLoadBalancer::forEachSubset(std::function<void(LbSubsetEntryPtr&)> cb) {
+  for (auto& [key, entry] : subsets_) {
+    cb(entry);
   }
 }
 
-void SubsetLoadBalancer::purgeEmptySubsets(LbSubsetMap& subsets) {
-  for (auto subset_it = subsets.begin(); subset_it != subsets.end();) {
-    for (auto it = subset_it->second.begin(); it != subset_it->second.end();) {
-      LbSubsetEntryPtr entry = it->second;
+void SubsetLoadBalancer::purgeEmptySubsets() {
+  absl::erase_if(subsets_, [this](const auto& key_entry) {
+    const LbSubsetEntryPtr& entry = key_entry.second;
+    if (entry->active()) {
+      return false;
+    }
 
-      purgeEmptySubsets(entry->children_);
+    // If it wasn't initialized, it wasn't accounted for.
+    if (entry->initialized()) {
+      stats_.lb_subsets_active_.dec();
+      stats_.lb_subsets_removed_.inc();
+    }
+    return true;
+  });
 
-      if (entry->active() || entry->hasChildren()) {
-        it++;
-        continue;
-      }
+  // The values are only purged once their number doubled, so that the cost of walking all the
+  // subset keys is amortized over the updates which interned the values.
+  if (num_values_ > 2 * num_values_after_purge_) {
+    purgeUnusedValues();
+  }
+}
 
-      // If it wasn't initialized, it wasn't accounted for.
-      if (entry->initialized()) {
-        stats_.lb_subsets_active_.dec();
-        stats_.lb_subsets_removed_.inc();
+// Forgets the values which are neither in the key of a subset nor in the metadata of a host. Their
+// ids are in no subset key anymore, so they can be given to new values.
+void SubsetLoadBalancer::purgeUnusedValues() {
+  absl::flat_hash_set<uint32_t> used_ids;
+  for (const auto& [key, entry] : subsets_) {
+    used_ids.insert(key.begin(), key.end());
+  }
+  for (const auto& host_subset_keys : host_subset_keys_) {
+    for (const auto& [metadata, keys] : host_subset_keys) {
+      for (const auto& selector_keys : keys.selector_keys_) {
+        for (const SubsetKey& key : selector_keys) {
+          used_ids.insert(key.begin(), key.end());
+        }
       }
-
-      auto next_it = std::next(it);
-      subset_it->second.erase(it);
-      it = next_it;
     }
+  }
 
-    if (subset_it->second.empty()) {
-      auto next_subset_it = std::next(subset_it);
-      subsets.erase(subset_it);
-      subset_it = next_subset_it;
-    } else {
-      subset_it++;
-    }
+  num_values_ = 0;
+  for (auto& [key, ids] : value_ids_) {
+    absl::erase_if(ids, [this, &used_ids](const auto& value_id) {
+      if (used_ids.contains(value_id.second)) {
+        return false;
+      }
+      free_value_ids_.push_back(value_id.second);
+      return true;
+    });
+    num_values_ += ids.size();
   }
+  absl::erase_if(value_ids_, [](const auto& key_ids) { return key_ids.second.empty(); });
+  num_values_after_purge_ = num_values_;
 }
 
 // Initialize a new HostSubsetImpl and LoadBalancer from the SubsetLoadBalancer, filtering hosts
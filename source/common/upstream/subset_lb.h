@@ -18,6 +18,8 @@
 #include "source/common/upstream/load_balancer_impl.h"
 #include "source/common/upstream/upstream_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/types/optional.h"
 
@@ -58,6 +60,7 @@ public:
   OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
     return {};
   }
+  OptRef<ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
 private:
   struct SubsetSelectorFallbackParams;
@@ -144,8 +147,10 @@ private:
 
   using LbSubsetEntryPtr = std::shared_ptr<LbSubsetEntry>;
   using SubsetSelectorMapPtr = std::shared_ptr<SubsetSelectorMap>;
-  using ValueSubsetMap = absl::node_hash_map<HashedValue, LbSubsetEntryPtr>;
-  using LbSubsetMap = absl::node_hash_map<std::string, ValueSubsetMap>;
+  // Identifies a subset by the ids of its interned key-value pairs, in the lexical order of the
+  // keys. See internValue().
+  using SubsetKey = absl::InlinedVector<uint32_t, 4>;
+  using LbSubsetMap = absl::flat_hash_map<SubsetKey, LbSubsetEntryPtr>;
   using SubsetSelectorFallbackParamsRef = std::reference_wrapper<SubsetSelectorFallbackParams>;
   using MetadataFallbacks = ProtobufWkt::RepeatedPtrField<ProtobufWkt::Value>;
 
@@ -302,24 +307,29 @@ private:
     HostConstSharedPtr subset_;
   };
 
-  // Entry in the subset hierarchy.
+  // Entry in the subset index.
   class LbSubsetEntry {
   public:
     LbSubsetEntry() = default;
 
     bool initialized() const { return lb_subset_ != nullptr; }
     bool active() const { return initialized() && lb_subset_->active(); }
-    bool hasChildren() const { return !children_.empty(); }
 
-    LbSubsetMap children_;
-
-    // Only initialized if a match exists at this level.
     LbSubsetPtr lb_subset_;
 
     // Used to quick check if entry is single host subset entry or not.
     bool single_host_subset_{};
   };
 
+  // The subset keys of the hosts sharing a metadata object, for each subset selector. There may be
+  // several keys for a selector when list_as_any is set.
+  struct HostSubsetKeys {
+    MetadataConstSharedPtr metadata_;
+    std::vector<std::vector<SubsetKey>> selector_keys_;
+  };
+  using HostSubsetKeysMap =
+      absl::flat_hash_map<const envoy::config::core::v3::Metadata*, HostSubsetKeys>;
+
   void initLbSubsetEntryOnce(LbSubsetEntryPtr& entry, bool single_host_subset);
 
   // Create filtered default subset (if necessary) and other subsets based on current hosts.
@@ -345,11 +355,13 @@ private:
   LbSubsetEntryPtr
   findSubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& matches);
 
-  LbSubsetEntryPtr findOrCreateLbSubsetEntry(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                             uint32_t idx);
-  void forEachSubset(LbSubsetMap& subsets, std::function<void(LbSubsetEntryPtr&)> cb);
-  void purgeEmptySubsets(LbSubsetMap& subsets);
+  LbSubsetEntryPtr findOrCreateLbSubsetEntry(const SubsetKey& key);
+  void forEachSubset(std::function<void(LbSubsetEntryPtr&)> cb);
+  void purgeEmptySubsets();
+  void purgeUnusedValues();
 
+  HostSubsetKeys extractSubsetKeys(const Host& host);
+  uint32_t internValue(const std::string& key, const ProtobufWkt::Value& value);
   std::vector<SubsetMetadata> extractSubsetMetadata(const std::set<std::string>& subset_keys,
                                                     const Host& host);
   std::string describeMetadata(const SubsetMetadata& kvs);
@@ -388,8 +400,20 @@ private:
   LbSubsetEntryPtr fallback_subset_;
   LbSubsetEntryPtr panic_mode_subset_;
 
-  // Forms a trie-like structure. Requires lexically sorted Host and Route metadata.
+  // The subsets of the subset selectors, indexed by their interned key-value pairs. Requires
+  // lexically sorted Host and Route metadata.
   LbSubsetMap subsets_;
+  // The ids of the interned values of every key of the subset selectors.
+  absl::flat_hash_map<std::string, absl::flat_hash_map<HashedValue, uint32_t>> value_ids_;
+  // The ids of the purged values, which are in no subset key, to be reused by new values.
+  std::vector<uint32_t> free_value_ids_;
+  uint32_t next_value_id_{};
+  uint64_t num_values_{};
+  // The number of interned values after the last purge of the unused ones.
+  uint64_t num_values_after_purge_{};
+  // The subset keys of the hosts of every priority, by metadata object, as of the last update of
+  // the priority. Only the hosts whose metadata changed are extracted again.
+  std::vector<HostSubsetKeysMap> host_subset_keys_;
   // Forms a trie-like structure of lexically sorted keys+fallback policy from subset
   // selectors configuration
   SubsetSelectorMapPtr selectors_;
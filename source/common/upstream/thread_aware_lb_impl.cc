@@ -1,8 +1,11 @@
 #include "source/common/upstream/thread_aware_lb_impl.h"
 
 #include <memory>
+#include <numeric>
 #include <random>
 
+#include "source/common/runtime/runtime_features.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -95,12 +98,14 @@ void ThreadAwareLoadBalancerBase::initialize() {
   // complicated initialization as the load balancer would need its own initialized callback. I
   // think the synchronous/asynchronous split is probably the best option.
   priority_update_cb_ = priority_set_.addPriorityUpdateCb(
-      [this](uint32_t, const HostVector&, const HostVector&) -> void { refresh(); });
+      [this](uint32_t priority, const HostVector&, const HostVector&) -> void {
+        refresh(priority);
+      });
 
-  refresh();
+  refresh(absl::nullopt);
 }
 
-void ThreadAwareLoadBalancerBase::refresh() {
+void ThreadAwareLoadBalancerBase::refresh(absl::optional<uint32_t> updated_priority) {
   auto per_priority_state_vector = std::make_shared<std::vector<PerPriorityStatePtr>>(
       priority_set_.hostSetsPerPriority().size());
   auto healthy_per_priority_load =
@@ -116,15 +121,26 @@ void ThreadAwareLoadBalancerBase::refresh() {
     // in hosts set or hosts' health.
     per_priority_state->global_panic_ = per_priority_panic_[priority];
 
+    // An update of one priority can change the panic state of the others, but leaves their hosts
+    // alone. Unless that happened, keep sharing the immutable load balancer built last time.
+    if (per_priority_state_ != nullptr && priority < per_priority_state_->size() &&
+        updated_priority != priority &&
+        (*per_priority_state_)[priority]->global_panic_ == per_priority_state->global_panic_) {
+      per_priority_state->current_lb_ = (*per_priority_state_)[priority]->current_lb_;
+      continue;
+    }
+
     // Normalize host and locality weights such that the sum of all normalized weights is 1.
     NormalizedHostWeightVector normalized_host_weights;
     double min_normalized_weight = 1.0;
     double max_normalized_weight = 0.0;
     normalizeWeights(*host_set, per_priority_state->global_panic_, normalized_host_weights,
                      min_normalized_weight, max_normalized_weight);
-    per_priority_state->current_lb_ = createLoadBalancer(
-        std::move(normalized_host_weights), min_normalized_weight, max_normalized_weight);
+    per_priority_state->current_lb_ =
+        createLoadBalancer(priority, std::move(normalized_host_weights), min_normalized_weight,
+                           max_normalized_weight);
   }
+  per_priority_state_ = per_priority_state_vector;
 
   {
     absl::WriterMutexLock lock(&factory_->mutex_);
@@ -185,26 +201,55 @@ LoadBalancerPtr ThreadAwareLoadBalancerBase::LoadBalancerFactoryImpl::create() {
   return lb;
 }
 
-double ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::hostOverloadFactor(
-    const Host& host, double weight) const {
+ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::BoundedLoadHashingLoadBalancer(
+    HashingLoadBalancerSharedPtr hashing_lb_ptr, NormalizedHostWeightVector normalized_host_weights,
+    uint32_t hash_balance_factor)
+    : hashing_lb_ptr_(std::move(hashing_lb_ptr)),
+      normalized_host_weights_(std::move(normalized_host_weights)),
+      hash_balance_factor_(hash_balance_factor),
+      use_probe_steps_(Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.bounded_load_hash_probe_steps")) {
+  ASSERT(hashing_lb_ptr_ != nullptr);
+  ASSERT(hash_balance_factor > 0);
+  const uint32_t num_hosts = normalized_host_weights_.size();
+  host_indices_.reserve(num_hosts);
+  for (uint32_t i = 0; i < num_hosts; i++) {
+    host_indices_[normalized_host_weights_[i].first.get()] = i;
+  }
+  if (use_probe_steps_) {
+    for (uint32_t step = 1; step < num_hosts; step++) {
+      if (std::gcd(step, num_hosts) == 1) {
+        probe_steps_.push_back(step);
+      }
+    }
+  }
+}
+
+uint32_t
+ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::totalSlots(const Host& host) const {
   // TODO(scheler): This will not work if rq_active cluster stat is disabled, need to detect
   // and alert the user if that's the case.
 
+  // All the hosts belong to the same cluster. Its active requests are only read once per
+  // chooseHost() call, however many hosts are probed.
   const uint32_t overall_active = host.cluster().trafficStats()->upstream_rq_active_.value();
-  const uint32_t host_active = host.stats().rq_active_.value();
+  return ((overall_active + 1) * hash_balance_factor_ + 99) / 100;
+}
 
-  const uint32_t total_slots = ((overall_active + 1) * hash_balance_factor_ + 99) / 100;
+double ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::hostOverloadFactor(
+    const Host& host, double weight, uint32_t total_slots) const {
+  const uint32_t host_active = host.stats().rq_active_.value();
   const uint32_t slots =
       std::max(static_cast<uint32_t>(std::ceil(total_slots * weight)), static_cast<uint32_t>(1));
 
-  if (host.stats().rq_active_.value() > slots) {
+  if (host_active > slots) {
     ENVOY_LOG_MISC(
         debug,
         "ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost: "
-        "host {} overloaded; overall_active {}, host_weight {}, host_active {} > slots {}",
-        host.address()->asString(), overall_active, weight, host_active, slots);
+        "host {} overloaded; total_slots {}, host_weight {}, host_active {} > slots {}",
+        host.address()->asString(), total_slots, weight, host_active, slots);
   }
-  return static_cast<double>(host.stats().rq_active_.value()) / slots;
+  return static_cast<double>(host_active) / slots;
 }
 
 HostConstSharedPtr
@@ -222,8 +267,9 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
   //
   // If weights are specified on the hosts, they are respected.
   //
-  // This is an O(N) algorithm, unlike other load balancers. Using a lower `hash_balance_factor`
-  // results in more hosts being probed, so use a higher value if you require better performance.
+  // At most `100/hash_balance_factor` of the hosts can be overloaded at any time, so the expected
+  // number of hosts probed is constant. Using a lower `hash_balance_factor` results in more hosts
+  // being probed, so use a higher value if you require better performance.
 
   if (normalized_host_weights_.empty()) {
     return nullptr;
@@ -233,8 +279,11 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
   if (host == nullptr) {
     return nullptr;
   }
-  const double weight = normalized_host_weights_map_.at(host);
-  double overload_factor = hostOverloadFactor(*host, weight);
+  const auto it = host_indices_.find(host.get());
+  ASSERT(it != host_indices_.end());
+  const uint32_t total_slots = totalSlots(*host);
+  const double overload_factor =
+      hostOverloadFactor(*host, normalized_host_weights_[it->second].second, total_slots);
   if (overload_factor <= 1.0) {
     ENVOY_LOG_MISC(debug,
                    "ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost: "
@@ -243,6 +292,55 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
     return host;
   }
 
+  if (use_probe_steps_) {
+    return chooseHostByProbing(hash, it->second, overload_factor, total_slots);
+  }
+  return chooseHostByShuffling(hash, host, overload_factor, total_slots);
+}
+
+HostConstSharedPtr ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHostByProbing(
+    uint64_t hash, uint32_t host_index, double overload_factor, uint32_t total_slots) const {
+  // The hosts are probed from the overloaded one, by a step picked by the hash among the steps
+  // which visit every host once. The same input gets the same sequence of hosts all the time, and
+  // the inputs overflowing from the same host are spread over different sequences. The hash
+  // chose the overloaded host, so it is mixed before picking the step to decorrelate the two.
+  const uint32_t num_hosts = normalized_host_weights_.size();
+  uint32_t least_overloaded_index = host_index;
+  double least_overload_factor = overload_factor;
+  if (!probe_steps_.empty()) {
+    uint64_t mixed = hash;
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdULL;
+    mixed ^= mixed >> 33;
+    const uint64_t step = probe_steps_[mixed % probe_steps_.size()];
+    uint32_t index = host_index;
+    for (uint32_t i = 1; i < num_hosts; i++) {
+      index = (index + step) % num_hosts;
+      const auto& [alt_host, alt_host_weight] = normalized_host_weights_[index];
+      overload_factor = hostOverloadFactor(*alt_host, alt_host_weight, total_slots);
+
+      if (overload_factor <= 1.0) {
+        ENVOY_LOG_MISC(debug,
+                       "ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost: "
+                       "selected host #{}:{} (attempt:{})",
+                       index, alt_host->address()->asString(), i + 1);
+        return alt_host;
+      }
+
+      if (least_overload_factor > overload_factor) {
+        least_overloaded_index = index;
+        least_overload_factor = overload_factor;
+      }
+    }
+  }
+
+  return normalized_host_weights_[least_overloaded_index].first;
+}
+
+HostConstSharedPtr
+ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHostByShuffling(
+    uint64_t hash, const HostConstSharedPtr& host, double overload_factor,
+    uint32_t total_slots) const {
   // When a host is overloaded, we choose the next host in a random manner rather than picking the
   // next one in the ring. The random sequence is seeded by the hash, so the same input gets the
   // same sequence of hosts all the time.
@@ -282,7 +380,7 @@ ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost(uint64_t
     }
 
     const double alt_host_weight = normalized_host_weights_[k].second;
-    overload_factor = hostOverloadFactor(*alt_host, alt_host_weight);
+    overload_factor = hostOverloadFactor(*alt_host, alt_host_weight, total_slots);
 
     if (overload_factor <= 1.0) {
       ENVOY_LOG_MISC(debug,
@@ -10,14 +10,15 @@
 #include "source/common/config/well_known_names.h"
 #include "source/common/upstream/load_balancer_impl.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Upstream {
 
 using NormalizedHostWeightVector = std::vector<std::pair<HostConstSharedPtr, double>>;
-using NormalizedHostWeightMap = std::map<HostConstSharedPtr, double>;
 
 class ThreadAwareLoadBalancerBase : public LoadBalancerBase, public ThreadAwareLoadBalancer {
 public:
@@ -58,32 +59,38 @@ public:
   public:
     BoundedLoadHashingLoadBalancer(HashingLoadBalancerSharedPtr hashing_lb_ptr,
                                    NormalizedHostWeightVector normalized_host_weights,
-                                   uint32_t hash_balance_factor)
-        : normalized_host_weights_map_(initNormalizedHostWeightMap(normalized_host_weights)),
-          hashing_lb_ptr_(std::move(hashing_lb_ptr)),
-          normalized_host_weights_(std::move(normalized_host_weights)),
-          hash_balance_factor_(hash_balance_factor) {
-      ASSERT(hashing_lb_ptr_ != nullptr);
-      ASSERT(hash_balance_factor > 0);
-    }
+                                   uint32_t hash_balance_factor);
     HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
 
   protected:
-    virtual double hostOverloadFactor(const Host& host, double weight) const;
-    const NormalizedHostWeightMap normalized_host_weights_map_;
+    /**
+     * @param host the host to compute the overload factor of.
+     * @param weight the normalized weight of the host.
+     * @param total_slots the number of active requests all the hosts may serve, taken once per
+     *        chooseHost() call from the active requests of the cluster.
+     * @return the number of active requests of the host divided by the slots of its weight. The
+     *         host is overloaded when the factor is above 1.
+     */
+    virtual double hostOverloadFactor(const Host& host, double weight, uint32_t total_slots) const;
 
   private:
-    const NormalizedHostWeightMap
-    initNormalizedHostWeightMap(const NormalizedHostWeightVector& normalized_host_weights) {
-      NormalizedHostWeightMap normalized_host_weights_map;
-      for (auto const& item : normalized_host_weights) {
-        normalized_host_weights_map[item.first] = item.second;
-      }
-      return normalized_host_weights_map;
-    }
+    uint32_t totalSlots(const Host& host) const;
+    HostConstSharedPtr chooseHostByProbing(uint64_t hash, uint32_t host_index,
+                                           double overload_factor, uint32_t total_slots) const;
+    HostConstSharedPtr chooseHostByShuffling(uint64_t hash, const HostConstSharedPtr& host,
+                                             double overload_factor, uint32_t total_slots) const;
+
     const HashingLoadBalancerSharedPtr hashing_lb_ptr_;
     const NormalizedHostWeightVector normalized_host_weights_;
     const uint32_t hash_balance_factor_;
+    // Index of every host in normalized_host_weights_.
+    absl::flat_hash_map<const Host*, uint32_t> host_indices_;
+    // The steps below the number of hosts which are coprime with it. Walking the hosts from any
+    // index by one of these steps visits every host exactly once.
+    std::vector<uint32_t> probe_steps_;
+    // Whether overloaded hosts are replaced by probing with probe_steps_, rather than by the
+    // shuffle of all the hosts seeded by the hash.
+    const bool use_probe_steps_;
   };
   // Upstream::ThreadAwareLoadBalancer
   LoadBalancerFactorySharedPtr factory() override { return factory_; }
@@ -104,6 +111,7 @@ public:
   OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
     return {};
   }
+  OptRef<ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
 protected:
   ThreadAwareLoadBalancerBase(
@@ -137,6 +145,7 @@ private:
     OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
       return {};
     }
+    OptRef<ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
     ClusterLbStats& stats_;
     Random::RandomGenerator& random_;
@@ -163,12 +172,23 @@ private:
     std::shared_ptr<DegradedLoad> degraded_per_priority_load_ ABSL_GUARDED_BY(mutex_);
   };
 
+  /**
+   * Builds the hashing load balancer of a priority. It is only called for priorities whose hosts
+   * or panic state changed since the last build, the load balancers of other priorities are
+   * shared with the previous refresh.
+   * @param priority the priority the load balancer is built for.
+   * @param normalized_host_weights the hosts of the priority with weights summing to 1.
+   * @param min_normalized_weight the smallest weight in normalized_host_weights.
+   * @param max_normalized_weight the largest weight in normalized_host_weights.
+   */
   virtual HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
+  createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
                      double min_normalized_weight, double max_normalized_weight) PURE;
-  void refresh();
+  void refresh(absl::optional<uint32_t> updated_priority);
 
   std::shared_ptr<LoadBalancerFactoryImpl> factory_;
+  // The state last handed to the factory. Only accessed on the main thread.
+  std::shared_ptr<std::vector<PerPriorityStatePtr>> per_priority_state_;
   Common::CallbackHandlePtr priority_update_cb_;
 };
 
@@ -430,6 +430,9 @@ HostDescriptionImpl::HostDescriptionImpl(
                   .bool_value()),
       metadata_(metadata), locality_(locality),
       locality_zone_stat_name_(locality.zone(), cluster->statsScope().symbolTable()),
+      retry_token_bucket_(cluster->retryTokenBuckets().has_value()
+                              ? cluster->retryTokenBuckets()->get().createHostBucket()
+                              : nullptr),
       priority_(priority),
       socket_factory_(resolveTransportSocketFactory(dest_address, metadata_.get())),
       creation_time_(time_source.monotonicTime()) {
@@ -1011,6 +1014,10 @@ ClusterInfoImpl::ClusterInfoImpl(
           config, *http_protocol_options_)),
       resource_managers_(config, runtime, name_, *stats_scope_,
                          factory_context.clusterManager().clusterCircuitBreakersStatNames()),
+      retry_token_buckets_(config.circuit_breakers().has_retry_token_bucket()
+                               ? std::make_unique<RetryTokenBucketsImpl>(
+                                     config.circuit_breakers().retry_token_bucket())
+                               : nullptr),
       maintenance_mode_runtime_key_(absl::StrCat("upstream.maintenance_mode.", name_)),
       upstream_local_address_selector_(
           std::make_shared<UpstreamLocalAddressSelectorImpl>(config, bind_config)),
@@ -1030,6 +1037,7 @@ ClusterInfoImpl::ClusterInfoImpl(
       drain_connections_on_host_removal_(config.ignore_health_on_host_removal()),
       connection_pool_per_downstream_connection_(
           config.connection_pool_per_downstream_connection()),
+      share_http2_connections_across_workers_(config.share_http2_connections_across_workers()),
       warm_hosts_(!config.health_checks().empty() &&
                   common_lb_config_.ignore_new_hosts_until_first_hc()),
       set_local_interface_name_on_upstream_connections_(
@@ -1055,6 +1063,11 @@ ClusterInfoImpl::ClusterInfoImpl(
                          "HttpProtocolOptions can be specified");
   }
 
+  if (share_http2_connections_across_workers_ && connection_pool_per_downstream_connection_) {
+    throw EnvoyException("share_http2_connections_across_workers cannot be combined with "
+                         "connection_pool_per_downstream_connection");
+  }
+
   // If load_balancing_policy is set we will use it directly, ignoring lb_policy.
   if (config.has_load_balancing_policy()) {
     configureLbPolicies(config, server_context);
@@ -1128,6 +1141,11 @@ ClusterInfoImpl::ClusterInfoImpl(
     max_connection_duration_ = absl::nullopt;
   }
 
+  if (config.preconnect_policy().has_adaptive_preconnect()) {
+    adaptive_preconnect_window_ = std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(
+        config.preconnect_policy().adaptive_preconnect(), arrival_rate_window, 1000));
+  }
+
   if (config.has_eds_cluster_config()) {
     if (config.type() != envoy::config::cluster::v3::Cluster::EDS) {
       throw EnvoyException("eds_cluster_config set in a non-EDS cluster");
@@ -1581,7 +1599,10 @@ ClusterInfoImpl::OptionalClusterStats::OptionalClusterStats(
           (config.track_cluster_stats().request_response_sizes()
                ? std::make_unique<ClusterRequestResponseSizeStats>(generateRequestResponseSizeStats(
                      stats_scope, manager.clusterRequestResponseSizeStatNames()))
-               : nullptr)) {}
+               : nullptr)),
+      response_time_tracker_(config.track_cluster_stats().response_time_percentiles()
+                                 ? std::make_unique<ResponseTimeTrackerImpl>()
+                                 : nullptr) {}
 
 ClusterInfoImpl::ResourceManagers::ResourceManagers(
     const envoy::config::cluster::v3::Cluster& config, Runtime::Loader& runtime,
@@ -1954,13 +1975,14 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(
       hosts_changed |=
           updateHealthFlag(*host, *existing_host->second, Host::HealthFlag::DEGRADED_EDS_HEALTH);
 
-      // Did metadata change?
+      // Did metadata change? Equal metadata is usually shared through the metadata pool of the
+      // cluster, in which case there is no need to compare it. This includes no metadata.
       bool metadata_changed = true;
-      if (host->metadata() && existing_host->second->metadata()) {
+      if (host->metadata() == existing_host->second->metadata()) {
+        metadata_changed = false;
+      } else if (host->metadata() && existing_host->second->metadata()) {
         metadata_changed = !Protobuf::util::MessageDifferencer::Equivalent(
             *host->metadata(), *existing_host->second->metadata());
-      } else if (!host->metadata() && !existing_host->second->metadata()) {
-        metadata_changed = false;
       }
 
       if (metadata_changed) {
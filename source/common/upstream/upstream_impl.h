@@ -54,6 +54,8 @@
 #include "source/common/upstream/load_balancer_impl.h"
 #include "source/common/upstream/outlier_detection_impl.h"
 #include "source/common/upstream/resource_manager_impl.h"
+#include "source/common/upstream/response_time_tracker.h"
+#include "source/common/upstream/retry_token_bucket.h"
 #include "source/common/upstream/transport_socket_match_impl.h"
 #include "source/common/upstream/upstream_http_factory_context_impl.h"
 #include "source/extensions/upstreams/http/config.h"
@@ -190,6 +192,12 @@ public:
         new Outlier::DetectorHostMonitorNullImpl();
     return *null_outlier_detector;
   }
+  RetryTokenBucketOptRef retryTokenBucket() const override {
+    if (retry_token_bucket_ == nullptr) {
+      return absl::nullopt;
+    }
+    return std::ref(*retry_token_bucket_);
+  }
   HostStats& stats() const override { return stats_; }
   LoadMetricStats& loadMetricStats() const override { return load_metric_stats_; }
   const std::string& hostnameForHealthChecks() const override { return health_checks_hostname_; }
@@ -250,6 +258,7 @@ private:
   mutable HostStats stats_;
   mutable LoadMetricStatsImpl load_metric_stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
+  const RetryTokenBucketPtr retry_token_bucket_;
   HealthCheckHostMonitorPtr health_checker_;
   std::atomic<uint32_t> priority_;
   std::reference_wrapper<Network::UpstreamTransportSocketFactory>
@@ -738,6 +747,9 @@ public:
   }
   float perUpstreamPreconnectRatio() const override { return per_upstream_preconnect_ratio_; }
   float peekaheadRatio() const override { return peekahead_ratio_; }
+  const absl::optional<std::chrono::milliseconds> adaptivePreconnectWindow() const override {
+    return adaptive_preconnect_window_;
+  }
   uint32_t perConnectionBufferLimitBytes() const override {
     return per_connection_buffer_limit_bytes_;
   }
@@ -794,6 +806,12 @@ public:
   const std::string& name() const override { return name_; }
   const std::string& observabilityName() const override { return observability_name_; }
   ResourceManager& resourceManager(ResourcePriority priority) const override;
+  RetryTokenBucketsOptRef retryTokenBuckets() const override {
+    if (retry_token_buckets_ == nullptr) {
+      return absl::nullopt;
+    }
+    return std::ref(*retry_token_buckets_);
+  }
   TransportSocketMatcher& transportSocketMatcher() const override { return *socket_matcher_; }
   LazyClusterTrafficStats& trafficStats() const override { return traffic_stats_; }
   ClusterConfigUpdateStats& configUpdateStats() const override { return config_update_stats_; }
@@ -821,6 +839,15 @@ public:
     return std::ref(*(optional_cluster_stats_->timeout_budget_stats_));
   }
 
+  ResponseTimeTrackerOptRef responseTimeTracker() const override {
+    if (optional_cluster_stats_ == nullptr ||
+        optional_cluster_stats_->response_time_tracker_ == nullptr) {
+      return absl::nullopt;
+    }
+
+    return std::ref(*(optional_cluster_stats_->response_time_tracker_));
+  }
+
   std::shared_ptr<UpstreamLocalAddressSelector> getUpstreamLocalAddressSelector() const override {
     return upstream_local_address_selector_;
   }
@@ -832,6 +859,9 @@ public:
   bool connectionPoolPerDownstreamConnection() const override {
     return connection_pool_per_downstream_connection_;
   }
+  bool shareHttp2ConnectionsAcrossWorkers() const override {
+    return share_http2_connections_across_workers_;
+  }
   bool warmHosts() const override { return warm_hosts_; }
   bool setLocalInterfaceNameOnUpstreamConnections() const override {
     return set_local_interface_name_on_upstream_connections_;
@@ -898,6 +928,7 @@ private:
                          Stats::Scope& stats_scope, const ClusterManager& manager);
     const ClusterTimeoutBudgetStatsPtr timeout_budget_stats_;
     const ClusterRequestResponseSizeStatsPtr request_response_size_stats_;
+    const ResponseTimeTrackerPtr response_time_tracker_;
   };
 
   Runtime::Loader& runtime_;
@@ -916,6 +947,7 @@ private:
   absl::optional<std::chrono::milliseconds> max_connection_duration_;
   const float per_upstream_preconnect_ratio_;
   const float peekahead_ratio_;
+  absl::optional<std::chrono::milliseconds> adaptive_preconnect_window_;
   const uint32_t per_connection_buffer_limit_bytes_;
   TransportSocketMatcherPtr socket_matcher_;
   Stats::ScopeSharedPtr stats_scope_;
@@ -928,6 +960,7 @@ private:
   const std::unique_ptr<OptionalClusterStats> optional_cluster_stats_;
   const uint64_t features_;
   mutable ResourceManagers resource_managers_;
+  const RetryTokenBucketsPtr retry_token_buckets_;
   const std::string maintenance_mode_runtime_key_;
   std::shared_ptr<UpstreamLocalAddressSelector> upstream_local_address_selector_;
   LoadBalancerType lb_type_;
@@ -947,6 +980,7 @@ private:
   const envoy::config::cluster::v3::Cluster::CommonLbConfig common_lb_config_;
   const bool drain_connections_on_host_removal_;
   const bool connection_pool_per_downstream_connection_;
+  const bool share_http2_connections_across_workers_;
   const bool warm_hosts_;
   const bool set_local_interface_name_on_upstream_connections_;
   const absl::optional<envoy::config::core::v3::UpstreamHttpProtocolOptions>
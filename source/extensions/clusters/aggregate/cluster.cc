@@ -117,12 +117,13 @@ void AggregateClusterLoadBalancer::refresh(OptRef<const std::string> excluded_cl
   priority_context_ = std::move(priority_context);
 }
 
-void AggregateClusterLoadBalancer::onClusterAddOrUpdate(Upstream::ThreadLocalCluster& cluster) {
-  if (std::find(clusters_->begin(), clusters_->end(), cluster.info()->name()) != clusters_->end()) {
-    ENVOY_LOG(debug, "adding or updating cluster '{}' for aggregate cluster '{}'",
-              cluster.info()->name(), parent_info_->name());
+void AggregateClusterLoadBalancer::onClusterAddOrUpdate(
+    absl::string_view cluster_name, Upstream::ThreadLocalClusterCommand& get_cluster) {
+  if (std::find(clusters_->begin(), clusters_->end(), cluster_name) != clusters_->end()) {
+    ENVOY_LOG(debug, "adding or updating cluster '{}' for aggregate cluster '{}'", cluster_name,
+              parent_info_->name());
     refresh();
-    addMemberUpdateCallbackForCluster(cluster);
+    addMemberUpdateCallbackForCluster(get_cluster());
   }
 }
 
@@ -137,6 +138,10 @@ void AggregateClusterLoadBalancer::onClusterRemoval(const std::string& cluster_n
   }
 }
 
+bool AggregateClusterLoadBalancer::tracksCluster(absl::string_view cluster_name) const {
+  return std::find(clusters_->begin(), clusters_->end(), cluster_name) != clusters_->end();
+}
+
 absl::optional<uint32_t> AggregateClusterLoadBalancer::LoadBalancerImpl::hostToLinearizedPriority(
     const Upstream::HostDescription& host) const {
   auto it = priority_context_.cluster_and_priority_to_linearized_priority_.find(
@@ -208,6 +213,13 @@ AggregateClusterLoadBalancer::lifetimeCallbacks() {
   return {};
 }
 
+OptRef<Upstream::ResponseTimeCallbacks> AggregateClusterLoadBalancer::responseTimeCallbacks() {
+  if (load_balancer_) {
+    return load_balancer_->responseTimeCallbacks();
+  }
+  return {};
+}
+
 std::pair<Upstream::ClusterImplBaseSharedPtr, Upstream::ThreadAwareLoadBalancerPtr>
 ClusterFactory::createClusterWithConfig(
     Server::Configuration::ServerFactoryContext& server_context,
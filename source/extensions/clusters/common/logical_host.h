@@ -99,6 +99,9 @@ public:
   Outlier::DetectorHostMonitor& outlierDetector() const override {
     return logical_host_->outlierDetector();
   }
+  RetryTokenBucketOptRef retryTokenBucket() const override {
+    return logical_host_->retryTokenBucket();
+  }
   HostStats& stats() const override { return logical_host_->stats(); }
   LoadMetricStats& loadMetricStats() const override { return logical_host_->loadMetricStats(); }
   const std::string& hostnameForHealthChecks() const override {
@@ -73,6 +73,7 @@ private:
     selectExistingConnection(Upstream::LoadBalancerContext* context, const Upstream::Host& host,
                              std::vector<uint8_t>& hash_key) override;
     OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override;
+    OptRef<Upstream::ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
     // Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks
     void onConnectionOpen(Envoy::Http::ConnectionPool::Instance& pool,
@@ -10,6 +10,8 @@
 #include "source/common/config/api_version.h"
 #include "source/common/config/decoded_resource_impl.h"
 
+#include "absl/strings/str_cat.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -52,6 +54,11 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
     parent_.validateEndpointsForZoneAwareRouting(locality_lb_endpoint);
 
     priority_state_manager.initializePriorityFor(locality_lb_endpoint);
+    // The key of the endpoints of the locality starts with its priority and its serialization,
+    // prefixed by its length so that the serialization of the endpoint can follow it.
+    const std::string locality = locality_lb_endpoint.locality().SerializeAsString();
+    const std::string locality_key =
+        absl::StrCat(locality_lb_endpoint.priority(), ":", locality.size(), ":", locality);
 
     if (locality_lb_endpoint.has_leds_cluster_locality_config()) {
       // The locality uses LEDS, fetch its dynamic data, which must be ready, or otherwise
@@ -64,13 +71,13 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
              parent_.leds_localities_[leds_config]->isUpdated());
       for (const auto& [_, lb_endpoint] :
            parent_.leds_localities_[leds_config]->getEndpointsMap()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_key,
+                                priority_state_manager, all_new_hosts);
       }
     } else {
       for (const auto& lb_endpoint : locality_lb_endpoint.lb_endpoints()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_key,
+                                priority_state_manager, all_new_hosts);
       }
     }
   }
@@ -123,6 +130,8 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
     parent_.info_->configUpdateStats().update_no_rebuild_.inc();
   }
 
+  updateEndpointHosts();
+
   // If we didn't setup to initialize when our first round of health checking is complete, just
   // do it now.
   parent_.onPreInitComplete();
@@ -131,7 +140,26 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
 void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
     const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
     const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
-    PriorityStateManager& priority_state_manager, absl::flat_hash_set<std::string>& all_new_hosts) {
+    absl::string_view locality_key, PriorityStateManager& priority_state_manager,
+    absl::flat_hash_set<std::string>& all_new_hosts) {
+  // The endpoints are keyed by their serialization rather than a hash of it, so that two different
+  // endpoints never share a host. The serialization of messages with map fields, e.g. metadata, is
+  // not deterministic. At worst, this builds a new host for an endpoint that did not change.
+  std::string endpoint_key = absl::StrCat(locality_key, lb_endpoint.SerializeAsString());
+  const auto endpoint_host = parent_.endpoint_hosts_.find(endpoint_key);
+  if (endpoint_host != parent_.endpoint_hosts_.end()) {
+    const HostSharedPtr& host = endpoint_host->second;
+    const auto& address_as_string = host->address()->asString();
+    if (all_new_hosts.count(address_as_string) > 0) {
+      return;
+    }
+
+    priority_state_manager.registerHostForPriority(host, locality_lb_endpoint);
+    all_new_hosts.emplace(address_as_string);
+    reused_endpoint_hosts_.emplace_back(std::move(endpoint_key), host);
+    return;
+  }
+
   const auto address = parent_.resolveProtoAddress(lb_endpoint.endpoint().address());
   // When the configuration contains duplicate hosts, only the first one will be retained.
   const auto address_as_string = address->asString();
@@ -143,6 +171,26 @@ void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
                                                  locality_lb_endpoint, lb_endpoint,
                                                  parent_.time_source_);
   all_new_hosts.emplace(address_as_string);
+  new_endpoint_hosts_.emplace_back(std::move(endpoint_key), address_as_string);
+}
+
+void EdsClusterImpl::BatchUpdateHelper::updateEndpointHosts() {
+  absl::flat_hash_map<std::string, HostSharedPtr> endpoint_hosts;
+  endpoint_hosts.reserve(reused_endpoint_hosts_.size() + new_endpoint_hosts_.size());
+  for (auto& [endpoint_key, host] : reused_endpoint_hosts_) {
+    endpoint_hosts.emplace(std::move(endpoint_key), std::move(host));
+  }
+
+  // The host built for an endpoint is dropped if an existing host with the same address is updated
+  // in place instead, so use whichever host the priority set now has for the address.
+  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
+  for (auto& [endpoint_key, address] : new_endpoint_hosts_) {
+    const auto host = all_hosts->find(address);
+    if (host != all_hosts->end()) {
+      endpoint_hosts.emplace(std::move(endpoint_key), host->second);
+    }
+  }
+  parent_.endpoint_hosts_ = std::move(endpoint_hosts);
 }
 
 void EdsClusterImpl::onConfigUpdate(const std::vector<Config::DecodedResourceRef>& resources,
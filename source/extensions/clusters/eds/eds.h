@@ -79,14 +79,25 @@ private:
     void updateLocalityEndpoints(
         const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
         const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
-        PriorityStateManager& priority_state_manager,
+        absl::string_view locality_key, PriorityStateManager& priority_state_manager,
         absl::flat_hash_set<std::string>& all_new_hosts);
+    // Replaces the endpoint hosts of the cluster with the ones of this update.
+    void updateEndpointHosts();
 
     EdsClusterImpl& parent_;
     const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment_;
+    // The keys of the endpoints of this update, with the hosts that were reused for them.
+    std::vector<std::pair<std::string, HostSharedPtr>> reused_endpoint_hosts_;
+    // The keys of the endpoints of this update that new hosts were built for, with their
+    // addresses.
+    std::vector<std::pair<std::string, std::string>> new_endpoint_hosts_;
   };
 
   Config::SubscriptionPtr subscription_;
+  // The hosts of the endpoints of the last update, keyed by the serialization of the endpoint, its
+  // locality and its priority. Endpoints that did not change since reuse these hosts, rather than
+  // building new hosts that would only be matched with them by address and then dropped.
+  absl::flat_hash_map<std::string, HostSharedPtr> endpoint_hosts_;
   Server::Configuration::TransportSocketFactoryContextImpl factory_context_;
   const LocalInfo::LocalInfo& local_info_;
   const std::string cluster_name_;
@@ -215,6 +215,7 @@ private:
     OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
       return {};
     }
+    OptRef<Upstream::ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
 
   private:
     const SlotArraySharedPtr slot_array_;
@@ -292,6 +292,12 @@ EXTENSIONS = {
     "envoy.io_socket.user_space":                       "//source/extensions/io_socket/user_space:config",
     "envoy.bootstrap.internal_listener":                "//source/extensions/bootstrap/internal_listener:config",
 
+    #
+    # Socket interface
+    #
+
+    "envoy.extensions.network.socket_interface.io_uring": "//source/extensions/network/socket_interface/io_uring:config",
+
     #
     # TLS peer certification validators
     #
@@ -339,6 +345,13 @@ EXTENSIONS = {
     "envoy.udp_packet_writer.default":                  "//source/extensions/udp_packet_writer/default:config",
     "envoy.udp_packet_writer.gso":                      "//source/extensions/udp_packet_writer/gso:config",
 
+    #
+    # Load balancing policies
+    #
+
+    "envoy.load_balancing_policies.anchor_hash":        "//source/extensions/load_balancing_policies/anchor_hash:config",
+    "envoy.load_balancing_policies.peak_ewma":          "//source/extensions/load_balancing_policies/peak_ewma:config",
+
     #
     # Formatter
     #
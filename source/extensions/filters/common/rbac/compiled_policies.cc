@@ -0,0 +1,348 @@
+#include "source/extensions/filters/common/rbac/compiled_policies.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "source/common/common/assert.h"
+
+#include "absl/container/fixed_array.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+namespace {
+
+enum AddressIndex : uint32_t { SourceIp = 0, DirectRemoteIp, RemoteIp };
+
+// Results of shared matchers cached while evaluating a request.
+enum MemoState : uint8_t { Unknown = 0, NoMatch, Match };
+
+} // namespace
+
+struct CompiledPolicies::EvaluationContext {
+  const Network::Connection& connection_;
+  const Envoy::Http::RequestHeaderMap& headers_;
+  const StreamInfo::StreamInfo& info_;
+  absl::FixedArray<uint8_t, 32> memo_;
+};
+
+CompiledPolicies::CompiledPolicies(const envoy::config::rbac::v3::RBAC& rules,
+                                   Expr::Builder* builder,
+                                   ProtobufMessage::ValidationVisitor& validation_visitor) {
+  std::vector<const std::string*> names;
+  names.reserve(rules.policies().size());
+  for (const auto& policy : rules.policies()) {
+    names.push_back(&policy.first);
+  }
+  std::sort(names.begin(), names.end(),
+            [](const std::string* lhs, const std::string* rhs) { return *lhs < *rhs; });
+
+  // The policies are not moved once compiled, as their expressions refer to their conditions.
+  policies_.reserve(names.size());
+  std::array<std::vector<std::pair<uint32_t, std::vector<Network::Address::CidrRange>>>,
+             IndexedAddressTypes>
+      address_data;
+  for (const std::string* name : names) {
+    const envoy::config::rbac::v3::Policy& config = rules.policies().at(*name);
+    const uint32_t index = policies_.size();
+    Policy& policy = policies_.emplace_back();
+    policy.name_ = *name;
+    policy.permissions_ =
+        compileComposite(Node::Type::Or, config.permissions(), &validation_visitor);
+
+    std::array<std::vector<Network::Address::CidrRange>, IndexedAddressTypes> ranges;
+    for (const auto& principal : config.principals()) {
+      compilePrincipal(principal, index, ranges);
+    }
+    for (size_t type = 0; type < IndexedAddressTypes; ++type) {
+      if (!ranges[type].empty()) {
+        address_data[type].emplace_back(index, std::move(ranges[type]));
+      }
+    }
+    if (policy.any_principal_ || !policy.principals_.empty()) {
+      unindexed_policies_.push_back(index);
+    }
+
+    if (config.has_condition()) {
+      policy.condition_ = config.condition();
+      policy.expr_ = Expr::createExpression(*builder, policy.condition_);
+    }
+  }
+
+  for (size_t type = 0; type < IndexedAddressTypes; ++type) {
+    if (!address_data[type].empty()) {
+      address_indexes_[type] =
+          std::make_unique<Network::LcTrie::LcTrie<uint32_t>>(address_data[type]);
+    }
+  }
+  shared_leaves_.clear();
+}
+
+void CompiledPolicies::compilePrincipal(
+    const envoy::config::rbac::v3::Principal& principal, uint32_t policy,
+    std::array<std::vector<Network::Address::CidrRange>, IndexedAddressTypes>& ranges) {
+  switch (principal.identifier_case()) {
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kAny:
+    policies_[policy].any_principal_ = true;
+    return;
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kOrIds:
+    // The principals of a policy are or'ed already.
+    for (const auto& id : principal.or_ids().ids()) {
+      compilePrincipal(id, policy, ranges);
+    }
+    return;
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kSourceIp:
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kDirectRemoteIp:
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kRemoteIp: {
+    const bool source_ip = principal.has_source_ip();
+    const bool direct_remote_ip = principal.has_direct_remote_ip();
+    const auto range = Network::Address::CidrRange::create(
+        source_ip ? principal.source_ip()
+                  : (direct_remote_ip ? principal.direct_remote_ip() : principal.remote_ip()));
+    if (range.isValid()) {
+      ranges[source_ip ? SourceIp : (direct_remote_ip ? DirectRemoteIp : RemoteIp)].push_back(
+          range);
+      return;
+    }
+    break;
+  }
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kAuthenticated: {
+    const auto& authenticated = principal.authenticated();
+    if (authenticated.has_principal_name() &&
+        authenticated.principal_name().match_pattern_case() ==
+            envoy::type::matcher::v3::StringMatcher::MatchPatternCase::kExact &&
+        !authenticated.principal_name().ignore_case()) {
+      auto& policies = principal_name_index_[authenticated.principal_name().exact()];
+      if (policies.empty() || policies.back() != policy) {
+        policies.push_back(policy);
+      }
+      return;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  policies_[policy].principals_.push_back(compile(principal));
+}
+
+uint32_t CompiledPolicies::compile(const envoy::config::rbac::v3::Permission& permission,
+                                   ProtobufMessage::ValidationVisitor& validation_visitor) {
+  switch (permission.rule_case()) {
+  case envoy::config::rbac::v3::Permission::RuleCase::kAny:
+    return addNode(Node::Type::Any, 0);
+  case envoy::config::rbac::v3::Permission::RuleCase::kAndRules:
+    return compileComposite(Node::Type::And, permission.and_rules().rules(), &validation_visitor);
+  case envoy::config::rbac::v3::Permission::RuleCase::kOrRules:
+    return compileComposite(Node::Type::Or, permission.or_rules().rules(), &validation_visitor);
+  case envoy::config::rbac::v3::Permission::RuleCase::kNotRule:
+    return addNode(Node::Type::Not, compile(permission.not_rule(), validation_visitor));
+  case envoy::config::rbac::v3::Permission::RuleCase::kHeader:
+    return addSharedLeaf(absl::StrCat("header:", permission.header().SerializeAsString()),
+                         [&permission]() -> MatcherConstSharedPtr {
+                           return std::make_shared<const HeaderMatcher>(permission.header());
+                         });
+  case envoy::config::rbac::v3::Permission::RuleCase::kUrlPath:
+    return addSharedLeaf(absl::StrCat("path:", permission.url_path().SerializeAsString()),
+                         [&permission]() -> MatcherConstSharedPtr {
+                           return std::make_shared<const PathMatcher>(permission.url_path());
+                         });
+  default:
+    return addLeaf(Matcher::create(permission, validation_visitor));
+  }
+}
+
+uint32_t CompiledPolicies::compile(const envoy::config::rbac::v3::Principal& principal) {
+  switch (principal.identifier_case()) {
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kAny:
+    return addNode(Node::Type::Any, 0);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kAndIds:
+    return compileComposite(Node::Type::And, principal.and_ids().ids(), nullptr);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kOrIds:
+    return compileComposite(Node::Type::Or, principal.or_ids().ids(), nullptr);
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kNotId:
+    return addNode(Node::Type::Not, compile(principal.not_id()));
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kHeader:
+    return addSharedLeaf(absl::StrCat("header:", principal.header().SerializeAsString()),
+                         [&principal]() -> MatcherConstSharedPtr {
+                           return std::make_shared<const HeaderMatcher>(principal.header());
+                         });
+  case envoy::config::rbac::v3::Principal::IdentifierCase::kUrlPath:
+    return addSharedLeaf(absl::StrCat("path:", principal.url_path().SerializeAsString()),
+                         [&principal]() -> MatcherConstSharedPtr {
+                           return std::make_shared<const PathMatcher>(principal.url_path());
+                         });
+  default:
+    return addLeaf(Matcher::create(principal));
+  }
+}
+
+template <class Rule>
+uint32_t
+CompiledPolicies::compileComposite(Node::Type type, const Protobuf::RepeatedPtrField<Rule>& rules,
+                                   ProtobufMessage::ValidationVisitor* validation_visitor) {
+  // The children are compiled before being laid out, as compiling them appends to children_ too.
+  std::vector<uint32_t> children;
+  children.reserve(rules.size());
+  for (const auto& rule : rules) {
+    if constexpr (std::is_same_v<Rule, envoy::config::rbac::v3::Permission>) {
+      children.push_back(compile(rule, *validation_visitor));
+    } else {
+      children.push_back(compile(rule));
+    }
+  }
+  const uint32_t first = children_.size();
+  children_.insert(children_.end(), children.begin(), children.end());
+  return addNode(type, first, children.size());
+}
+
+uint32_t CompiledPolicies::addNode(Node::Type type, uint32_t index, uint32_t count) {
+  nodes_.push_back({type, index, count});
+  return nodes_.size() - 1;
+}
+
+uint32_t CompiledPolicies::addLeaf(MatcherConstSharedPtr matcher) {
+  leaves_.push_back({std::move(matcher), NoMemoSlot});
+  return addNode(Node::Type::Leaf, leaves_.size() - 1);
+}
+
+uint32_t
+CompiledPolicies::addSharedLeaf(const std::string& key,
+                                const std::function<MatcherConstSharedPtr()>& create_matcher) {
+  // Header and path matchers have no map fields, so their serialization is canonical.
+  auto it = shared_leaves_.find(key);
+  if (it == shared_leaves_.end()) {
+    const uint32_t node = addLeaf(create_matcher());
+    shared_leaves_.emplace(key, node);
+    return node;
+  }
+  Leaf& leaf = leaves_[nodes_[it->second].index_];
+  if (leaf.memo_slot_ == NoMemoSlot) {
+    leaf.memo_slot_ = shared_matcher_count_++;
+  }
+  return it->second;
+}
+
+bool CompiledPolicies::evaluate(uint32_t index, EvaluationContext& context) const {
+  const Node& node = nodes_[index];
+  switch (node.type_) {
+  case Node::Type::Any:
+    return true;
+  case Node::Type::Leaf: {
+    const Leaf& leaf = leaves_[node.index_];
+    if (leaf.memo_slot_ == NoMemoSlot) {
+      return leaf.matcher_->matches(context.connection_, context.headers_, context.info_);
+    }
+    uint8_t& memo = context.memo_[leaf.memo_slot_];
+    if (memo == Unknown) {
+      memo = leaf.matcher_->matches(context.connection_, context.headers_, context.info_)
+                 ? Match
+                 : NoMatch;
+    }
+    return memo == Match;
+  }
+  case Node::Type::And:
+    for (uint32_t i = node.index_; i < node.index_ + node.count_; ++i) {
+      if (!evaluate(children_[i], context)) {
+        return false;
+      }
+    }
+    return true;
+  case Node::Type::Or:
+    for (uint32_t i = node.index_; i < node.index_ + node.count_; ++i) {
+      if (evaluate(children_[i], context)) {
+        return true;
+      }
+    }
+    return false;
+  case Node::Type::Not:
+    return !evaluate(node.index_, context);
+  }
+  PANIC_DUE_TO_CORRUPT_ENUM;
+}
+
+bool CompiledPolicies::policyMatches(const Policy& policy, bool principal_indexed,
+                                     EvaluationContext& context) const {
+  if (!evaluate(policy.permissions_, context)) {
+    return false;
+  }
+  if (!principal_indexed && !policy.any_principal_ &&
+      std::none_of(policy.principals_.begin(), policy.principals_.end(),
+                   [&](uint32_t principal) { return evaluate(principal, context); })) {
+    return false;
+  }
+  return policy.expr_ == nullptr || Expr::matches(*policy.expr_, context.info_, context.headers_);
+}
+
+const std::string* CompiledPolicies::firstMatch(const Network::Connection& connection,
+                                                const Envoy::Http::RequestHeaderMap& headers,
+                                                const StreamInfo::StreamInfo& info) const {
+  // Collect the policies with a principal matched through the indexes.
+  absl::InlinedVector<uint32_t, 8> indexed;
+  const std::array<const Network::Address::InstanceConstSharedPtr*, IndexedAddressTypes>
+      addresses = {&connection.connectionInfoProvider().remoteAddress(),
+                   &info.downstreamAddressProvider().directRemoteAddress(),
+                   &info.downstreamAddressProvider().remoteAddress()};
+  for (size_t type = 0; type < IndexedAddressTypes; ++type) {
+    const Network::Address::InstanceConstSharedPtr& address = *addresses[type];
+    if (address_indexes_[type] != nullptr && address != nullptr && address->ip() != nullptr) {
+      for (const uint32_t policy : address_indexes_[type]->getData(address)) {
+        indexed.push_back(policy);
+      }
+    }
+  }
+  const auto& ssl = connection.ssl();
+  if (!principal_name_index_.empty() && ssl != nullptr) {
+    // As for AuthenticatedMatcher, the URI SANs, the DNS SANs and the subject are all candidates.
+    const auto add_name = [this, &indexed](const std::string& name) {
+      const auto it = principal_name_index_.find(name);
+      if (it != principal_name_index_.end()) {
+        indexed.insert(indexed.end(), it->second.begin(), it->second.end());
+      }
+    };
+    for (const std::string& uri : ssl->uriSanPeerCertificate()) {
+      add_name(uri);
+    }
+    for (const std::string& dns : ssl->dnsSansPeerCertificate()) {
+      add_name(dns);
+    }
+    add_name(ssl->subjectPeerCertificate());
+  }
+  std::sort(indexed.begin(), indexed.end());
+  indexed.erase(std::unique(indexed.begin(), indexed.end()), indexed.end());
+
+  // Walk the indexed and unindexed candidates together in name order.
+  EvaluationContext context{connection, headers, info,
+                            absl::FixedArray<uint8_t, 32>(shared_matcher_count_, Unknown)};
+  auto indexed_it = indexed.begin();
+  auto unindexed_it = unindexed_policies_.begin();
+  while (indexed_it != indexed.end() || unindexed_it != unindexed_policies_.end()) {
+    uint32_t policy;
+    bool principal_indexed = false;
+    if (unindexed_it == unindexed_policies_.end() ||
+        (indexed_it != indexed.end() && *indexed_it <= *unindexed_it)) {
+      policy = *indexed_it++;
+      principal_indexed = true;
+      if (unindexed_it != unindexed_policies_.end() && *unindexed_it == policy) {
+        ++unindexed_it;
+      }
+    } else {
+      policy = *unindexed_it++;
+    }
+    if (policyMatches(policies_[policy], principal_indexed, context)) {
+      return &policies_[policy].name_;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/network/connection.h"
+#include "envoy/stream_info/stream_info.h"
+
+#include "source/common/network/lc_trie.h"
+#include "source/extensions/filters/common/expr/evaluator.h"
+#include "source/extensions/filters/common/rbac/matchers.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+/**
+ * The policies of an RBAC config flattened ahead of time, so that a request is evaluated against
+ * as few matchers as possible while yielding the same first matching policy as evaluating each
+ * PolicyMatcher in name order.
+ *
+ * - Permission and principal trees are flattened into a single node array. Identical header and
+ *   path matchers are shared across all policies, and are evaluated at most once per request.
+ * - Top level source_ip, direct_remote_ip and remote_ip principals are indexed by address through
+ *   an LC trie per address type, and top level authenticated principals with an exact (case
+ *   sensitive) principal name are indexed through a hash map. Policies only reachable through these
+ *   principals are skipped unless the request hits the index.
+ * - Evaluation stops at the first matching policy.
+ */
+class CompiledPolicies : NonCopyable {
+public:
+  CompiledPolicies(const envoy::config::rbac::v3::RBAC& rules, Expr::Builder* builder,
+                   ProtobufMessage::ValidationVisitor& validation_visitor);
+
+  /**
+   * @return the name of the first policy, in name order, matching the request or nullptr if none
+   *         matches.
+   */
+  const std::string* firstMatch(const Network::Connection& connection,
+                                const Envoy::Http::RequestHeaderMap& headers,
+                                const StreamInfo::StreamInfo& info) const;
+
+  /**
+   * @return the number of header and path matchers shared by more than one rule.
+   */
+  size_t sharedMatcherCount() const { return shared_matcher_count_; }
+
+private:
+  struct Node {
+    enum class Type : uint8_t { Any, Leaf, And, Or, Not };
+
+    Type type_;
+    // The leaf for Leaf, the first entry in children_ for And and Or, the child node for Not.
+    uint32_t index_;
+    // The number of children of And and Or.
+    uint32_t count_;
+  };
+
+  struct Leaf {
+    MatcherConstSharedPtr matcher_;
+    // Slot caching the result of a shared matcher for the duration of a request.
+    uint32_t memo_slot_;
+  };
+
+  struct Policy {
+    std::string name_;
+    uint32_t permissions_;
+    bool any_principal_{};
+    // Principals not covered by the address and principal name indexes.
+    std::vector<uint32_t> principals_;
+    google::api::expr::v1alpha1::Expr condition_;
+    Expr::ExpressionPtr expr_;
+  };
+
+  struct EvaluationContext;
+
+  // The address types source_ip, direct_remote_ip and remote_ip principals are matched against.
+  static constexpr size_t IndexedAddressTypes = 3;
+  static constexpr uint32_t NoMemoSlot = UINT32_MAX;
+
+  uint32_t compile(const envoy::config::rbac::v3::Permission& permission,
+                   ProtobufMessage::ValidationVisitor& validation_visitor);
+  uint32_t compile(const envoy::config::rbac::v3::Principal& principal);
+  void compilePrincipal(const envoy::config::rbac::v3::Principal& principal, uint32_t policy,
+                        std::array<std::vector<Network::Address::CidrRange>,
+                                   IndexedAddressTypes>& ranges);
+  template <class Rule>
+  uint32_t compileComposite(Node::Type type, const Protobuf::RepeatedPtrField<Rule>& rules,
+                            ProtobufMessage::ValidationVisitor* validation_visitor);
+  uint32_t addNode(Node::Type type, uint32_t index, uint32_t count = 0);
+  uint32_t addLeaf(MatcherConstSharedPtr matcher);
+  uint32_t addSharedLeaf(const std::string& key,
+                         const std::function<MatcherConstSharedPtr()>& create_matcher);
+
+  bool evaluate(uint32_t node, EvaluationContext& context) const;
+  bool policyMatches(const Policy& policy, bool principal_indexed,
+                     EvaluationContext& context) const;
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> children_;
+  std::vector<Leaf> leaves_;
+  std::vector<Policy> policies_;
+  // Policies, in name order, that have principals outside of the indexes.
+  std::vector<uint32_t> unindexed_policies_;
+  std::array<std::unique_ptr<Network::LcTrie::LcTrie<uint32_t>>, IndexedAddressTypes>
+      address_indexes_;
+  absl::flat_hash_map<std::string, std::vector<uint32_t>> principal_name_index_;
+  absl::flat_hash_map<std::string, uint32_t> shared_leaves_;
+  size_t shared_matcher_count_{};
+};
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -4,6 +4,7 @@
 #include "envoy/config/rbac/v3/rbac.pb.validate.h"
 
 #include "source/common/http/header_map_impl.h"
+#include "source/common/runtime/runtime_features.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -52,6 +53,12 @@ RoleBasedAccessControlEngineImpl::RoleBasedAccessControlEngineImpl(
     }
   }
 
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.rbac_compile_policies")) {
+    compiled_policies_ =
+        std::make_unique<CompiledPolicies>(rules, builder_.get(), validation_visitor);
+    return;
+  }
+
   for (const auto& policy : rules.policies()) {
     policies_.emplace(policy.first, std::make_unique<PolicyMatcher>(policy.second, builder_.get(),
                                                                     validation_visitor));
@@ -89,6 +96,14 @@ bool RoleBasedAccessControlEngineImpl::handleAction(const Network::Connection& c
 bool RoleBasedAccessControlEngineImpl::checkPolicyMatch(
     const Network::Connection& connection, const StreamInfo::StreamInfo& info,
     const Envoy::Http::RequestHeaderMap& headers, std::string* effective_policy_id) const {
+  if (compiled_policies_ != nullptr) {
+    const std::string* policy_id = compiled_policies_->firstMatch(connection, headers, info);
+    if (policy_id != nullptr && effective_policy_id != nullptr) {
+      *effective_policy_id = *policy_id;
+    }
+    return policy_id != nullptr;
+  }
+
   bool matched = false;
 
   for (const auto& policy : policies_) {
@@ -4,6 +4,7 @@
 
 #include "source/common/http/matching/data_impl.h"
 #include "source/common/matcher/matcher.h"
+#include "source/extensions/filters/common/rbac/compiled_policies.h"
 #include "source/extensions/filters/common/rbac/engine.h"
 #include "source/extensions/filters/common/rbac/matchers.h"
 
@@ -84,6 +85,8 @@ private:
   const EnforcementMode mode_;
 
   std::map<std::string, std::unique_ptr<PolicyMatcher>> policies_;
+  // Replaces policies_ unless the rbac_compile_policies runtime guard is disabled.
+  std::unique_ptr<CompiledPolicies> compiled_policies_;
 
   Protobuf::Arena constant_arena_;
   Expr::BuilderPtr builder_;
@@ -1,7 +1,10 @@
 #include "source/extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
 
+#include <algorithm>
+
 #include "envoy/network/listener.h"
 
+#include "source/common/config/utility.h"
 #include "source/common/network/socket_option_factory.h"
 
 namespace Envoy {
@@ -9,6 +12,23 @@ namespace Extensions {
 namespace UdpFilters {
 namespace UdpProxy {
 
+Network::UdpPacketWriterFactoryPtr UdpProxyFilterConfig::createUpstreamWriterFactory(
+    const envoy::extensions::filters::udp::udp_proxy::v3::UdpProxyConfig& config) {
+  Network::UdpPacketWriterFactoryPtr writer_factory;
+  if (config.has_upstream_packet_writer_config()) {
+    auto& factory_factory =
+        Config::Utility::getAndCheckFactory<Network::UdpPacketWriterFactoryFactory>(
+            config.upstream_packet_writer_config());
+    writer_factory =
+        factory_factory.createUdpPacketWriterFactory(config.upstream_packet_writer_config());
+  }
+  if (writer_factory == nullptr) {
+    // The GSO writer factory is empty when QUICHE is not compiled in, fall back to sendmsg.
+    writer_factory = std::make_unique<Network::UdpDefaultWriterFactory>();
+  }
+  return writer_factory;
+}
+
 UdpProxyFilter::UdpProxyFilter(Network::UdpReadFilterCallbacks& callbacks,
                                const UdpProxyFilterConfigSharedPtr& config)
     : UdpListenerReadFilter(callbacks), config_(config),
@@ -17,7 +37,10 @@ UdpProxyFilter::UdpProxyFilter(Network::UdpReadFilterCallbacks& callbacks,
   for (const auto& entry : config_->allClusterNames()) {
     Upstream::ThreadLocalCluster* cluster = config->clusterManager().getThreadLocalCluster(entry);
     if (cluster != nullptr) {
-      onClusterAddOrUpdate(*cluster);
+      Upstream::ThreadLocalClusterCommand command = [cluster]() -> Upstream::ThreadLocalCluster& {
+        return *cluster;
+      };
+      onClusterAddOrUpdate(entry, command);
     }
   }
 
@@ -35,18 +58,26 @@ UdpProxyFilter::~UdpProxyFilter() {
   }
 }
 
-void UdpProxyFilter::onClusterAddOrUpdate(Upstream::ThreadLocalCluster& cluster) {
-  auto cluster_name = cluster.info()->name();
+void UdpProxyFilter::onClusterAddOrUpdate(absl::string_view cluster_name,
+                                          Upstream::ThreadLocalClusterCommand& get_cluster) {
+  const auto& cluster_names = config_->allClusterNames();
+  if (std::find(cluster_names.begin(), cluster_names.end(), cluster_name) == cluster_names.end()) {
+    return;
+  }
+
   ENVOY_LOG(debug, "udp proxy: attaching to cluster {}", cluster_name);
+  Upstream::ThreadLocalCluster& cluster = get_cluster();
   ASSERT((!cluster_infos_.contains(cluster_name)) ||
          &cluster_infos_[cluster_name]->cluster_ != &cluster);
 
+  // An update replaces the cluster info of the previous ThreadLocalCluster.
   if (config_->usingPerPacketLoadBalancing()) {
-    cluster_infos_.emplace(cluster_name,
-                           std::make_unique<PerPacketLoadBalancingClusterInfo>(*this, cluster));
+    cluster_infos_.insert_or_assign(
+        std::string(cluster_name),
+        std::make_unique<PerPacketLoadBalancingClusterInfo>(*this, cluster));
   } else {
-    cluster_infos_.emplace(cluster_name,
-                           std::make_unique<StickySessionClusterInfo>(*this, cluster));
+    cluster_infos_.insert_or_assign(std::string(cluster_name),
+                                    std::make_unique<StickySessionClusterInfo>(*this, cluster));
   }
 }
 
@@ -75,6 +106,27 @@ Network::FilterStatus UdpProxyFilter::onReceiveError(Api::IoError::IoErrorCode)
   return Network::FilterStatus::StopIteration;
 }
 
+void UdpProxyFilter::scheduleUpstreamFlush(ActiveSession& session) {
+  if (!sessions_pending_flush_.insert(&session).second || sessions_pending_flush_.size() > 1) {
+    // Either this session or another one already scheduled the flush.
+    return;
+  }
+  if (upstream_flush_cb_ == nullptr) {
+    upstream_flush_cb_ = read_callbacks_->udpListener().dispatcher().createSchedulableCallback(
+        [this]() { flushUpstreamWrites(); });
+  }
+  // The listener reads a batch of downstream datagrams in a single file event, so the callback
+  // runs once all of them have been handed to their sessions.
+  upstream_flush_cb_->scheduleCallbackCurrentIteration();
+}
+
+void UdpProxyFilter::flushUpstreamWrites() {
+  for (ActiveSession* session : sessions_pending_flush_) {
+    session->flushWrites();
+  }
+  sessions_pending_flush_.clear();
+}
+
 UdpProxyFilter::ClusterInfo::ClusterInfo(UdpProxyFilter& filter,
                                          Upstream::ThreadLocalCluster& cluster,
                                          SessionStorageType&& sessions)
@@ -246,7 +298,9 @@ UdpProxyFilter::ActiveSession::ActiveSession(ClusterInfo& cluster,
           [this] { onIdleTimer(); })),
       // NOTE: The socket call can only fail due to memory/fd exhaustion. No local ephemeral port
       //       is bound until the first packet is sent to the upstream host.
-      socket_(cluster.filter_.createSocket(host)) {
+      socket_(cluster.filter_.createSocket(host)),
+      writer_(cluster.filter_.createUdpPacketWriter(socket_->ioHandle(),
+                                                    cluster.cluster_.info()->statsScope())) {
   if (!cluster_.filter_.config_->sessionAccessLogs().empty()) {
     udp_session_stats_.emplace(
         StreamInfo::StreamInfoImpl(cluster_.filter_.config_->timeSource(), nullptr));
@@ -254,8 +308,15 @@ UdpProxyFilter::ActiveSession::ActiveSession(ClusterInfo& cluster,
 
   socket_->ioHandle().initializeFileEvent(
       cluster.filter_.read_callbacks_->udpListener().dispatcher(),
-      [this](uint32_t) { onReadReady(); }, Event::PlatformDefaultTriggerType,
-      Event::FileReadyType::Read);
+      [this](uint32_t events) {
+        if (events & Event::FileReadyType::Write) {
+          onWriteReady();
+        }
+        if (events & Event::FileReadyType::Read) {
+          onReadReady();
+        }
+      },
+      Event::PlatformDefaultTriggerType, Event::FileReadyType::Read);
   ENVOY_LOG(debug, "creating new session: downstream={} local={} upstream={}",
             addresses_.peer_->asStringView(), addresses_.local_->asStringView(),
             host->address()->asStringView());
@@ -277,6 +338,17 @@ UdpProxyFilter::ActiveSession::ActiveSession(ClusterInfo& cluster,
               addresses_.peer_->asStringView());
   }
 
+  if (cluster_.filter_.config_->upstreamSocketConfig().prefer_gro_ &&
+      Api::OsSysCallsSingleton::get().supportsUdpGro()) {
+    // Without UDP_GRO the kernel hands out one datagram per recvmsg() call even though the read
+    // path sizes its buffers for coalesced datagrams.
+    if (!Network::Socket::applyOptions(Network::SocketOptionFactory::buildUdpGroOptions(),
+                                       *socket_,
+                                       envoy::config::core::v3::SocketOption::STATE_BOUND)) {
+      ENVOY_LOG(debug, "cannot enable UDP_GRO on the upstream socket");
+    }
+  }
+
   // TODO(mattklein123): Enable dropped packets socket option. In general the Socket abstraction
   // does not work well right now for client sockets. It's too heavy weight and is aimed at listener
   // sockets. We need to figure out how to either refactor Socket into something that works better
@@ -288,6 +360,15 @@ UdpProxyFilter::ActiveSession::~ActiveSession() {
   ENVOY_LOG(debug, "deleting the session: downstream={} local={} upstream={}",
             addresses_.peer_->asStringView(), addresses_.local_->asStringView(),
             host_->address()->asStringView());
+  if (cluster_.filter_.sessions_pending_flush_.erase(this) > 0 || flush_blocked_) {
+    // This is the last chance to send the buffered datagrams, which are dropped if the socket
+    // still cannot take them.
+    writer_->setWritable();
+    const Api::IoCallUint64Result rc = writer_->flush();
+    if (!rc.ok()) {
+      cluster_.cluster_stats_.sess_tx_errors_.inc();
+    }
+  }
   cluster_.filter_.config_->stats().downstream_sess_active_.dec();
   cluster_.cluster_.info()
       ->resourceManager(Upstream::ResourcePriority::Default)
@@ -359,12 +440,10 @@ void UdpProxyFilter::ActiveSession::onReadReady() {
       cluster_.filter_.config_->upstreamSocketConfig().prefer_gro_, packets_dropped);
   if (result == nullptr) {
     socket_->ioHandle().activateFileEvents(Event::FileReadyType::Read);
-    return;
-  }
-  if (result->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+  } else if (result->getErrorCode() != Api::IoError::IoErrorCode::Again) {
     cluster_.cluster_stats_.sess_rx_errors_.inc();
   }
-  // Flush out buffered data at the end of IO event.
+  // Flush out buffered data at the end of IO event, including when the read budget ran out.
   cluster_.filter_.read_callbacks_->udpListener().flush();
 }
 
@@ -401,14 +480,52 @@ void UdpProxyFilter::ActiveSession::write(const Buffer::Instance& buffer) {
 
     skip_connect_ = true;
   }
-  Api::IoCallUint64Result rc =
-      Network::Utility::writeToSocket(socket_->ioHandle(), buffer, local_ip, *host_->address());
+  if (writer_->isWriteBlocked()) {
+    // Upstream sockets are only polled for writability while a flushed batch is blocked. Like a
+    // plain sendmsg, retry on every datagram and let the kernel report whether the socket is
+    // still full.
+    writer_->setWritable();
+  }
+  Api::IoCallUint64Result rc = writer_->writePacket(buffer, local_ip, *host_->address());
   if (!rc.ok()) {
     cluster_.cluster_stats_.sess_tx_errors_.inc();
   } else {
     cluster_.cluster_stats_.sess_tx_datagrams_.inc();
     cluster_.cluster_.info()->trafficStats()->upstream_cx_tx_bytes_total_.add(buffer_length);
   }
+  if (writer_->isBatchMode()) {
+    cluster_.filter_.scheduleUpstreamFlush(*this);
+  }
+}
+
+void UdpProxyFilter::ActiveSession::flushWrites() {
+  const Api::IoCallUint64Result rc = writer_->flush();
+  if (rc.ok()) {
+    return;
+  }
+  if (rc.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+    // The writer keeps the batch, which is flushed again when the socket becomes writable.
+    ENVOY_LOG(trace, "upstream flush blocked: downstream={} upstream={}",
+              addresses_.peer_->asStringView(), host_->address()->asStringView());
+    if (!flush_blocked_) {
+      flush_blocked_ = true;
+      socket_->ioHandle().enableFileEvents(Event::FileReadyType::Read |
+                                           Event::FileReadyType::Write);
+    }
+    return;
+  }
+  ENVOY_LOG(debug, "cannot flush datagrams upstream: {}", rc.err_->getErrorDetails());
+  cluster_.cluster_stats_.sess_tx_errors_.inc();
+}
+
+void UdpProxyFilter::ActiveSession::onWriteReady() {
+  if (!flush_blocked_) {
+    return;
+  }
+  flush_blocked_ = false;
+  socket_->ioHandle().enableFileEvents(Event::FileReadyType::Read);
+  writer_->setWritable();
+  flushWrites();
 }
 
 void UdpProxyFilter::ActiveSession::processPacket(Network::Address::InstanceConstSharedPtr,
@@ -3,9 +3,11 @@
 #include "envoy/access_log/access_log.h"
 #include "envoy/config/accesslog/v3/accesslog.pb.h"
 #include "envoy/event/file_event.h"
+#include "envoy/event/schedulable_cb.h"
 #include "envoy/event/timer.h"
 #include "envoy/extensions/filters/udp/udp_proxy/v3/udp_proxy.pb.h"
 #include "envoy/network/filter.h"
+#include "envoy/network/udp_packet_writer_handler.h"
 #include "envoy/stream_info/stream_info.h"
 #include "envoy/upstream/cluster_manager.h"
 
@@ -15,6 +17,7 @@
 #include "source/common/common/random_generator.h"
 #include "source/common/network/socket_impl.h"
 #include "source/common/network/socket_interface.h"
+#include "source/common/network/udp_packet_writer_handler_impl.h"
 #include "source/common/network/utility.h"
 #include "source/common/protobuf/utility.h"
 #include "source/common/stream_info/stream_info_impl.h"
@@ -81,6 +84,7 @@ public:
         stats_(generateStats(config.stat_prefix(), context.scope())),
         // Default prefer_gro to true for upstream client traffic.
         upstream_socket_config_(config.upstream_socket_config(), true),
+        upstream_writer_factory_(createUpstreamWriterFactory(config)),
         random_(context.api().randomGenerator()) {
     if (use_original_src_ip_ && !Api::OsSysCallsSingleton::get().supportsIpTransparent()) {
       ExceptionUtil::throwEnvoyException(
@@ -120,6 +124,9 @@ public:
   const Network::ResolvedUdpSocketConfig& upstreamSocketConfig() const {
     return upstream_socket_config_;
   }
+  Network::UdpPacketWriterFactory& upstreamWriterFactory() const {
+    return *upstream_writer_factory_;
+  }
   const std::vector<AccessLog::InstanceSharedPtr>& sessionAccessLogs() const {
     return session_access_logs_;
   }
@@ -134,6 +141,8 @@ private:
     return {ALL_UDP_PROXY_DOWNSTREAM_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
                                            POOL_GAUGE_PREFIX(scope, final_prefix))};
   }
+  static Network::UdpPacketWriterFactoryPtr createUpstreamWriterFactory(
+      const envoy::extensions::filters::udp::udp_proxy::v3::UdpProxyConfig& config);
 
   Upstream::ClusterManager& cluster_manager_;
   TimeSource& time_source_;
@@ -144,6 +153,7 @@ private:
   std::unique_ptr<const HashPolicyImpl> hash_policy_;
   mutable UdpProxyDownstreamStats stats_;
   const Network::ResolvedUdpSocketConfig upstream_socket_config_;
+  const Network::UdpPacketWriterFactoryPtr upstream_writer_factory_;
   std::vector<AccessLog::InstanceSharedPtr> session_access_logs_;
   std::vector<AccessLog::InstanceSharedPtr> proxy_access_logs_;
   Random::RandomGenerator& random_;
@@ -200,10 +210,13 @@ private:
     const Network::UdpRecvData::LocalPeerAddresses& addresses() const { return addresses_; }
     const Upstream::Host& host() const { return *host_; }
     void write(const Buffer::Instance& buffer);
+    // Sends the datagrams buffered by a batching upstream writer.
+    void flushWrites();
 
   private:
     void onIdleTimer();
     void onReadReady();
+    void onWriteReady();
     void fillSessionStreamInfo();
 
     // Network::UdpPacketProcessor
@@ -247,6 +260,12 @@ private:
     // packets from the upstream host. Note that a a local ephemeral port is bound on the first
     // write to the upstream host.
     const Network::SocketPtr socket_;
+    // Writes datagrams to the upstream host through socket_. In batch mode, datagrams are buffered
+    // until the filter flushes the session at the end of the event loop iteration.
+    const Network::UdpPacketWriterPtr writer_;
+    // Set when the socket could not take a flushed batch. The batch stays buffered in writer_ and
+    // is flushed again once the socket is writable.
+    bool flush_blocked_{};
     // The socket should be connected to avoid port exhaustion unless runtime guard
     // envoy.reloadable_features.udp_proxy_connect is unset or use_original_src_ip_ is set. If it
     // is true, there will be no calling `connect()` on the socket.
@@ -391,14 +410,31 @@ private:
                                                  nullptr, Network::SocketCreationOptions{});
   }
 
+  virtual Network::UdpPacketWriterPtr createUdpPacketWriter(Network::IoHandle& io_handle,
+                                                            Stats::Scope& scope) {
+    // Virtual so this can be overridden in unit tests.
+    return config_->upstreamWriterFactory().createUdpPacketWriter(io_handle, scope);
+  }
+
   void fillProxyStreamInfo();
+  // Registers a session whose writer buffered datagrams. All registered sessions are flushed once
+  // the current event loop iteration is done reading downstream datagrams.
+  void scheduleUpstreamFlush(ActiveSession& session);
+  void flushUpstreamWrites();
 
   // Upstream::ClusterUpdateCallbacks
-  void onClusterAddOrUpdate(Upstream::ThreadLocalCluster& cluster) final;
+  void onClusterAddOrUpdate(absl::string_view cluster_name,
+                            Upstream::ThreadLocalClusterCommand& get_cluster) final;
   void onClusterRemoval(const std::string& cluster_name) override;
+  bool tracksCluster(absl::string_view cluster_name) const override {
+    return cluster_infos_.contains(cluster_name);
+  }
 
   const UdpProxyFilterConfigSharedPtr config_;
   const Upstream::ClusterUpdateCallbacksHandlePtr cluster_update_callbacks_;
+  // Declared before cluster_infos_ so that sessions destroyed with their cluster can still flush.
+  absl::flat_hash_set<ActiveSession*> sessions_pending_flush_;
+  Event::SchedulableCallbackPtr upstream_flush_cb_;
   // Map for looking up cluster info with its name.
   absl::flat_hash_map<std::string, ClusterInfoPtr> cluster_infos_;
 
@@ -1,5 +1,7 @@
 #include "source/extensions/http/cache/simple_http_cache/simple_http_cache.h"
 
+#include <limits>
+
 #include "envoy/extensions/http/cache/simple_http_cache/v3/config.pb.h"
 #include "envoy/registry/registry.h"
 
@@ -41,14 +43,14 @@ public:
     body_ = std::move(entry.body_);
     trailers_ = std::move(entry.trailers_);
     cb(entry.response_headers_ ? request_.makeLookupResult(std::move(entry.response_headers_),
-                                                           std::move(entry.metadata_), body_.size(),
-                                                           trailers_ != nullptr)
+                                                           std::move(entry.metadata_),
+                                                           body_->size(), trailers_ != nullptr)
                                : LookupResult{});
   }
 
   void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
-    ASSERT(range.end() <= body_.length(), "Attempt to read past end of body.");
-    cb(std::make_unique<Buffer::OwnedImpl>(&body_[range.begin()], range.length()));
+    ASSERT(body_ != nullptr && range.end() <= body_->length(), "Attempt to read past end of body.");
+    cb(std::make_unique<Buffer::OwnedImpl>(&(*body_)[range.begin()], range.length()));
   }
 
   // The cache must call cb with the cached trailers.
@@ -63,7 +65,7 @@ public:
 private:
   SimpleHttpCache& cache_;
   const LookupRequest request_;
-  std::string body_;
+  std::shared_ptr<const std::string> body_;
   Http::ResponseTrailerMapPtr trailers_;
 };
 
@@ -137,6 +139,23 @@ private:
 };
 } // namespace
 
+// Default number of shards, enough to keep contention low with one worker per core on most hosts.
+constexpr uint32_t DefaultShards = 16;
+
+SimpleHttpCache::SimpleHttpCache(const SimpleHttpCacheConfig& config, Stats::Scope& scope)
+    : config_(config),
+      stats_({ALL_SIMPLE_HTTP_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "simple_http_cache."),
+                                          POOL_GAUGE_PREFIX(scope, "simple_http_cache."))}) {
+  const uint32_t num_shards = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, shards, DefaultShards);
+  if (config.has_max_cache_size_bytes()) {
+    max_shard_size_bytes_ = config.max_cache_size_bytes().value() / num_shards;
+  }
+  shards_.reserve(num_shards);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
 LookupContextPtr SimpleHttpCache::makeLookupContext(LookupRequest&& request,
                                                     Http::StreamDecoderFilterCallbacks&) {
   return std::make_unique<SimpleLookupContext>(*this, std::move(request));
@@ -147,88 +166,53 @@ void SimpleHttpCache::updateHeaders(const LookupContext& lookup_context,
                                     const ResponseMetadata& metadata,
                                     std::function<void(bool)> on_complete) {
   const auto& simple_lookup_context = static_cast<const SimpleLookupContext&>(lookup_context);
-  const Key& key = simple_lookup_context.request().key();
-  absl::WriterMutexLock lock(&mutex_);
-  auto iter = map_.find(key);
-  if (iter == map_.end() || !iter->second.response_headers_) {
-    on_complete(false);
-    return;
-  }
-  if (VaryHeaderUtils::hasVary(*iter->second.response_headers_)) {
-    absl::optional<Key> varied_key =
-        variedRequestKey(simple_lookup_context.request(), *iter->second.response_headers_);
-    if (!varied_key.has_value()) {
-      on_complete(false);
-      return;
-    }
-    iter = map_.find(varied_key.value());
-    if (iter == map_.end() || !iter->second.response_headers_) {
-      on_complete(false);
+  const LookupRequest& request = simple_lookup_context.request();
+  const auto apply_update = [&response_headers, &metadata](Entry& entry) {
+    applyHeaderUpdate(response_headers, *entry.response_headers_);
+    entry.metadata_ = metadata;
+  };
+
+  bool varies = false;
+  absl::optional<Key> varied_key;
+  bool updated = updateEntry(request.key(), [&](Entry& entry) {
+    if (VaryHeaderUtils::hasVary(*entry.response_headers_)) {
+      // The varied response may live in another shard, so it is updated once this one is
+      // unlocked.
+      varies = true;
+      varied_key = variedRequestKey(request, *entry.response_headers_);
       return;
     }
+    apply_update(entry);
+  });
+  if (updated && varies) {
+    updated = varied_key.has_value() && updateEntry(varied_key.value(), apply_update);
   }
-  Entry& entry = iter->second;
-
-  applyHeaderUpdate(response_headers, *entry.response_headers_);
-  entry.metadata_ = metadata;
-  on_complete(true);
+  on_complete(updated);
 }
 
 SimpleHttpCache::Entry SimpleHttpCache::lookup(const LookupRequest& request) {
-  absl::ReaderMutexLock lock(&mutex_);
-  auto iter = map_.find(request.key());
-  if (iter == map_.end()) {
-    return Entry{};
+  absl::optional<Entry> entry = findEntry(request.key());
+  if (entry.has_value() && VaryHeaderUtils::hasVary(*entry->response_headers_)) {
+    const absl::optional<Key> varied_key = variedRequestKey(request, *entry->response_headers_);
+    entry = varied_key.has_value() ? findEntry(varied_key.value()) : absl::nullopt;
   }
-  ASSERT(iter->second.response_headers_);
-
-  if (VaryHeaderUtils::hasVary(*iter->second.response_headers_)) {
-    return varyLookup(request, iter->second.response_headers_);
-  } else {
-    Http::ResponseTrailerMapPtr trailers_map;
-    if (iter->second.trailers_) {
-      trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*iter->second.trailers_);
-    }
-    return SimpleHttpCache::Entry{
-        Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*iter->second.response_headers_),
-        iter->second.metadata_, iter->second.body_, std::move(trailers_map)};
+
+  if (!entry.has_value()) {
+    stats_.lookup_miss_.inc();
+    return Entry{};
   }
+  stats_.lookup_hit_.inc();
+  return std::move(entry.value());
 }
 
 bool SimpleHttpCache::insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
                              ResponseMetadata&& metadata, std::string&& body,
                              Http::ResponseTrailerMapPtr&& trailers) {
-  absl::WriterMutexLock lock(&mutex_);
-  map_[key] = SimpleHttpCache::Entry{std::move(response_headers), std::move(metadata),
-                                     std::move(body), std::move(trailers)};
-  return true;
-}
-
-SimpleHttpCache::Entry
-SimpleHttpCache::varyLookup(const LookupRequest& request,
-                            const Http::ResponseHeaderMapPtr& response_headers) {
-  // This method should be called from lookup, which holds the mutex for reading.
-  mutex_.AssertReaderHeld();
-
-  absl::optional<Key> varied_key = variedRequestKey(request, *response_headers);
-  if (!varied_key.has_value()) {
-    return SimpleHttpCache::Entry{};
-  }
-  Key& varied_request_key = varied_key.value();
-
-  auto iter = map_.find(varied_request_key);
-  if (iter == map_.end()) {
-    return SimpleHttpCache::Entry{};
-  }
-  ASSERT(iter->second.response_headers_);
-  Http::ResponseTrailerMapPtr trailers_map;
-  if (iter->second.trailers_) {
-    trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*iter->second.trailers_);
-  }
-
-  return SimpleHttpCache::Entry{
-      Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*iter->second.response_headers_),
-      iter->second.metadata_, iter->second.body_, std::move(trailers_map)};
+  return storeEntry(key,
+                    Entry{std::move(response_headers), std::move(metadata),
+                          std::make_shared<const std::string>(std::move(body)),
+                          std::move(trailers)},
+                    true);
 }
 
 bool SimpleHttpCache::varyInsert(const Key& request_key,
@@ -237,8 +221,6 @@ bool SimpleHttpCache::varyInsert(const Key& request_key,
                                  const Http::RequestHeaderMap& request_headers,
                                  const VaryAllowList& vary_allow_list,
                                  Http::ResponseTrailerMapPtr&& trailers) {
-  absl::WriterMutexLock lock(&mutex_);
-
   absl::btree_set<absl::string_view> vary_header_values =
       VaryHeaderUtils::getVaryValues(*response_headers);
   ASSERT(!vary_header_values.empty());
@@ -253,27 +235,119 @@ bool SimpleHttpCache::varyInsert(const Key& request_key,
   }
 
   varied_request_key.add_custom_fields(vary_identifier.value());
-  map_[varied_request_key] = SimpleHttpCache::Entry{
-      std::move(response_headers), std::move(metadata), std::move(body), std::move(trailers)};
-
-  // Add a special entry to flag that this request generates varied responses.
-  auto iter = map_.find(request_key);
-  if (iter == map_.end()) {
-    Envoy::Http::ResponseHeaderMapPtr vary_only_map =
-        Envoy::Http::createHeaderMap<Envoy::Http::ResponseHeaderMapImpl>({});
-    vary_only_map->setCopy(Envoy::Http::CustomHeaders::get().Vary,
-                           absl::StrJoin(vary_header_values, ","));
-    // TODO(cbdm): In a cache that evicts entries, we could maintain a list of the "varykey"s that
-    // we have inserted as the body for this first lookup. This way, we would know which keys we
-    // have inserted for that resource. For the first entry simply use vary_identifier as the
-    // entry_list; for future entries append vary_identifier to existing list.
-    std::string entry_list;
-    map_[request_key] =
-        SimpleHttpCache::Entry{std::move(vary_only_map), {}, std::move(entry_list), {}};
+  // The vary header values reference the response headers, so build the marker entry first.
+  Envoy::Http::ResponseHeaderMapPtr vary_only_map =
+      Envoy::Http::createHeaderMap<Envoy::Http::ResponseHeaderMapImpl>({});
+  vary_only_map->setCopy(Envoy::Http::CustomHeaders::get().Vary,
+                         absl::StrJoin(vary_header_values, ","));
+  if (!storeEntry(varied_request_key,
+                  Entry{std::move(response_headers), std::move(metadata),
+                        std::make_shared<const std::string>(std::move(body)),
+                        std::move(trailers)},
+                  true)) {
+    return false;
   }
+
+  // Add a special entry to flag that this request generates varied responses, unless there is
+  // one already. If the marker is evicted, lookups miss until the next varied insert.
+  // TODO(cbdm): We could maintain a list of the "varykey"s that we have inserted as the body for
+  // this first lookup. This way, we would know which keys we have inserted for that resource, and
+  // could evict them together with the marker.
+  storeEntry(request_key,
+             Entry{std::move(vary_only_map), {}, std::make_shared<const std::string>(), {}}, false);
   return true;
 }
 
+SimpleHttpCache::Shard& SimpleHttpCache::shardFor(const Key& key) {
+  if (shards_.size() == 1) {
+    return *shards_[0];
+  }
+  return *shards_[stableHashKey(key) % shards_.size()];
+}
+
+absl::optional<SimpleHttpCache::Entry> SimpleHttpCache::findEntry(const Key& key) {
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+  auto iter = shard.map_.find(key);
+  if (iter == shard.map_.end()) {
+    return absl::nullopt;
+  }
+  shard.entries_.splice(shard.entries_.begin(), shard.entries_, iter->second);
+
+  const Entry& entry = iter->second->entry_;
+  ASSERT(entry.response_headers_);
+  Http::ResponseTrailerMapPtr trailers_map;
+  if (entry.trailers_) {
+    trailers_map = Http::createHeaderMap<Http::ResponseTrailerMapImpl>(*entry.trailers_);
+  }
+  return Entry{Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*entry.response_headers_),
+               entry.metadata_, entry.body_, std::move(trailers_map)};
+}
+
+bool SimpleHttpCache::storeEntry(const Key& key, Entry&& entry, bool replace) {
+  const uint64_t size_bytes = entrySize(key, entry);
+  if (size_bytes > max_shard_size_bytes_) {
+    stats_.insert_rejected_.inc();
+    return false;
+  }
+
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+  auto iter = shard.map_.find(key);
+  if (iter != shard.map_.end()) {
+    if (!replace) {
+      return true;
+    }
+    removeEntry(shard, iter->second);
+  }
+
+  while (!shard.entries_.empty() && shard.size_bytes_ + size_bytes > max_shard_size_bytes_) {
+    removeEntry(shard, std::prev(shard.entries_.end()));
+    stats_.eviction_.inc();
+  }
+
+  shard.entries_.push_front(StoredEntry{key, std::move(entry), size_bytes});
+  shard.map_[key] = shard.entries_.begin();
+  shard.size_bytes_ += size_bytes;
+  stats_.insert_.inc();
+  stats_.size_bytes_.add(size_bytes);
+  stats_.size_count_.inc();
+  return true;
+}
+
+bool SimpleHttpCache::updateEntry(const Key& key, const std::function<void(Entry&)>& update) {
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+  auto iter = shard.map_.find(key);
+  if (iter == shard.map_.end()) {
+    return false;
+  }
+  StoredEntry& stored = *iter->second;
+  update(stored.entry_);
+
+  // Header updates may change the size of the entry. The shard may exceed its share until the
+  // next insert.
+  const uint64_t size_bytes = entrySize(key, stored.entry_);
+  shard.size_bytes_ = shard.size_bytes_ - stored.size_bytes_ + size_bytes;
+  stats_.size_bytes_.sub(stored.size_bytes_);
+  stats_.size_bytes_.add(size_bytes);
+  stored.size_bytes_ = size_bytes;
+  return true;
+}
+
+void SimpleHttpCache::removeEntry(Shard& shard, StoredEntryList::iterator it) {
+  shard.size_bytes_ -= it->size_bytes_;
+  stats_.size_bytes_.sub(it->size_bytes_);
+  stats_.size_count_.dec();
+  shard.map_.erase(it->key_);
+  shard.entries_.erase(it);
+}
+
+uint64_t SimpleHttpCache::entrySize(const Key& key, const Entry& entry) {
+  return key.ByteSizeLong() + entry.response_headers_->byteSize() + entry.body_->size() +
+         (entry.trailers_ != nullptr ? entry.trailers_->byteSize() : 0);
+}
+
 InsertContextPtr SimpleHttpCache::makeInsertContext(LookupContextPtr&& lookup_context,
                                                     Http::StreamEncoderFilterCallbacks&) {
   ASSERT(lookup_context != nullptr);
@@ -301,15 +375,20 @@ public:
   }
   // From HttpCacheFactory
   std::shared_ptr<HttpCache>
-  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig&,
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& filter_config,
            Server::Configuration::FactoryContext& context) override {
-    return context.singletonManager().getTyped<SimpleHttpCache>(
-        SINGLETON_MANAGER_REGISTERED_NAME(simple_http_cache_singleton), &createCache);
-  }
-
-private:
-  static std::shared_ptr<Singleton::Instance> createCache() {
-    return std::make_shared<SimpleHttpCache>();
+    SimpleHttpCacheConfig config;
+    MessageUtil::unpackTo(filter_config.typed_config(), config);
+    // The cache is shared by all filters, so its stats live in the server scope.
+    std::shared_ptr<SimpleHttpCache> cache = context.singletonManager().getTyped<SimpleHttpCache>(
+        SINGLETON_MANAGER_REGISTERED_NAME(simple_http_cache_singleton), [&config, &context] {
+          return std::make_shared<SimpleHttpCache>(config, context.serverScope());
+        });
+    if (!Protobuf::util::MessageDifferencer::Equals(cache->config(), config)) {
+      throw EnvoyException(fmt::format("mismatched SimpleHttpCacheConfig\n{}\nvs.\n{}",
+                                       cache->config().DebugString(), config.DebugString()));
+    }
+    return cache;
   }
 };
 
@@ -1,5 +1,14 @@
 #pragma once
 
+#include <limits>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "envoy/extensions/http/cache/simple_http_cache/v3/config.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
 #include "source/common/protobuf/utility.h"
 #include "source/extensions/filters/http/cache/http_cache.h"
 
@@ -12,19 +21,73 @@ namespace Extensions {
 namespace HttpFilters {
 namespace Cache {
 
-// Example cache backend that never evicts. Not suitable for production use.
+using SimpleHttpCacheConfig =
+    envoy::extensions::http::cache::simple_http_cache::v3::SimpleHttpCacheConfig;
+
+/**
+ * All simple http cache stats. @see stats_macros.h
+ */
+#define ALL_SIMPLE_HTTP_CACHE_STATS(COUNTER, GAUGE)                                                \
+  COUNTER(eviction)                                                                                \
+  COUNTER(insert)                                                                                  \
+  COUNTER(insert_rejected)                                                                         \
+  COUNTER(lookup_hit)                                                                              \
+  COUNTER(lookup_miss)                                                                             \
+  GAUGE(size_bytes, NeverImport)                                                                   \
+  GAUGE(size_count, NeverImport)
+
+/**
+ * Struct definition for all simple http cache stats. @see stats_macros.h
+ */
+struct SimpleHttpCacheStats {
+  ALL_SIMPLE_HTTP_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+// In-memory cache backend. Entries are spread over independently locked shards, each of which
+// evicts its least recently used entries once it exceeds its share of the configured byte budget.
 class SimpleHttpCache : public HttpCache, public Singleton::Instance {
 private:
   struct Entry {
     Http::ResponseHeaderMapPtr response_headers_;
     ResponseMetadata metadata_;
-    std::string body_;
+    // Shared between the cache and lookups, so that bodies aren't copied while a shard is locked.
+    std::shared_ptr<const std::string> body_;
     Http::ResponseTrailerMapPtr trailers_;
   };
 
-  // Looks for a response that has been varied. Only called from lookup.
-  Entry varyLookup(const LookupRequest& request,
-                   const Http::ResponseHeaderMapPtr& response_headers);
+  struct StoredEntry {
+    Key key_;
+    Entry entry_;
+    uint64_t size_bytes_;
+  };
+  using StoredEntryList = std::list<StoredEntry>;
+
+  struct Shard {
+    absl::Mutex mutex_;
+    // Most recently used entries are at the front.
+    StoredEntryList entries_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_map<Key, StoredEntryList::iterator, MessageUtil, MessageUtil>
+        map_ ABSL_GUARDED_BY(mutex_);
+    uint64_t size_bytes_ ABSL_GUARDED_BY(mutex_){0};
+  };
+
+  Shard& shardFor(const Key& key);
+
+  // Returns a copy of the entry stored for `key` and marks it as most recently used.
+  absl::optional<Entry> findEntry(const Key& key);
+
+  // Stores `entry` for `key`, evicting least recently used entries of the shard as needed.
+  // If `replace` is false an existing entry for `key` is kept.
+  bool storeEntry(const Key& key, Entry&& entry, bool replace);
+
+  // Applies `update` to the entry stored for `key`. Returns false if there is no such entry.
+  bool updateEntry(const Key& key, const std::function<void(Entry&)>& update);
+
+  // Removes `it` from `shard`, updating the size accounting.
+  void removeEntry(Shard& shard, StoredEntryList::iterator it)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mutex_);
+
+  static uint64_t entrySize(const Key& key, const Entry& entry);
 
   // A list of headers that we do not want to update upon validation
   // We skip these headers because either it's updated by other application logic
@@ -33,6 +96,8 @@ private:
   static const absl::flat_hash_set<Http::LowerCaseString> headersNotToUpdate();
 
 public:
+  SimpleHttpCache(const SimpleHttpCacheConfig& config, Stats::Scope& scope);
+
   // HttpCache
   LookupContextPtr makeLookupContext(LookupRequest&& request,
                                      Http::StreamDecoderFilterCallbacks& callbacks) override;
@@ -44,6 +109,9 @@ public:
                      std::function<void(bool)> on_complete) override;
   CacheInfo cacheInfo() const override;
 
+  const SimpleHttpCacheConfig& config() const { return config_; }
+  const SimpleHttpCacheStats& stats() const { return stats_; }
+
   Entry lookup(const LookupRequest& request);
   bool insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
               ResponseMetadata&& metadata, std::string&& body,
@@ -55,8 +123,11 @@ public:
                   const Http::RequestHeaderMap& request_headers,
                   const VaryAllowList& vary_allow_list, Http::ResponseTrailerMapPtr&& trailers);
 
-  absl::Mutex mutex_;
-  absl::flat_hash_map<Key, Entry, MessageUtil, MessageUtil> map_ ABSL_GUARDED_BY(mutex_);
+private:
+  const SimpleHttpCacheConfig config_;
+  SimpleHttpCacheStats stats_;
+  uint64_t max_shard_size_bytes_{std::numeric_limits<uint64_t>::max()};
+  std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 } // namespace Cache
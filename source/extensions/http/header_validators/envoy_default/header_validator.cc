@@ -4,6 +4,7 @@
 
 #include "envoy/http/header_validator_errors.h"
 
+#include "source/common/http/header_char_utility.h"
 #include "source/extensions/http/header_validators/envoy_default/character_tables.h"
 
 #include "absl/container/node_hash_set.h"
@@ -16,6 +17,7 @@ namespace HeaderValidators {
 namespace EnvoyDefault {
 
 using ::envoy::extensions::http::header_validators::envoy_default::v3::HeaderValidatorConfig;
+using ::Envoy::Http::HeaderCharUtility;
 using ::Envoy::Http::HeaderString;
 using ::Envoy::Http::Protocol;
 using ::Envoy::Http::UhvResponseCodeDetail;
@@ -176,26 +178,16 @@ HeaderValidator::validateGenericHeaderName(const HeaderString& name) {
             UhvResponseCodeDetail::get().EmptyHeaderName};
   }
 
-  bool is_valid = true;
-  bool has_underscore = false;
-  char c = '\0';
   const auto& underscore_action = config_.headers_with_underscores_action();
 
-  for (auto iter = key_string_view.begin(); iter != key_string_view.end() && is_valid; ++iter) {
-    c = *iter;
-    if (c != '_') {
-      is_valid &= testChar(kGenericHeaderNameCharTable, c);
-    } else {
-      has_underscore = true;
-    }
-  }
-
-  if (!is_valid) {
+  // The underscore is a token character, so it is looked for separately once the name is known to
+  // be valid.
+  if (!HeaderCharUtility::isToken(key_string_view)) {
     return {HeaderEntryValidationResult::Action::Reject,
             UhvResponseCodeDetail::get().InvalidNameCharacters};
   }
 
-  if (has_underscore) {
+  if (key_string_view.find('_') != absl::string_view::npos) {
     if (underscore_action == HeaderValidatorConfig::REJECT_REQUEST) {
       stats_.incRequestsRejectedWithUnderscoresInHeaders();
       return {HeaderEntryValidationResult::Action::Reject,
@@ -225,14 +217,7 @@ HeaderValidator::validateGenericHeaderValue(const HeaderString& value) {
   //
   // VCHAR          =  %x21-7E
   //                   ; visible (printing) characters
-  const auto& value_string_view = value.getStringView();
-  bool is_valid = true;
-
-  for (auto iter = value_string_view.begin(); iter != value_string_view.end() && is_valid; ++iter) {
-    is_valid &= testChar(kGenericHeaderValueCharTable, *iter);
-  }
-
-  if (!is_valid) {
+  if (!HeaderCharUtility::isValidHeaderValue(value.getStringView())) {
     return {HeaderValueValidationResult::Action::Reject,
             UhvResponseCodeDetail::get().InvalidValueCharacters};
   }
@@ -541,7 +541,8 @@ void ListenerImpl::buildInternalListener() {
                                        name_));
     }
     if ((config_.has_connection_balance_config() &&
-         config_.connection_balance_config().has_exact_balance()) ||
+         (config_.connection_balance_config().has_exact_balance() ||
+          config_.connection_balance_config().has_least_loaded_balance())) ||
         config_.enable_mptcp() ||
         config_.has_enable_reuse_port() // internal listener doesn't use physical l4 port.
         || (config_.has_freebind() && config_.freebind().value()) ||
@@ -776,6 +777,12 @@ void ListenerImpl::buildConnectionBalancer(const Network::Address::Instance& add
         connection_balancers_.emplace(address.asString(),
                                       std::make_shared<Network::ExactConnectionBalancerImpl>());
         break;
+      case envoy::config::listener::v3::Listener_ConnectionBalanceConfig::kLeastLoadedBalance:
+        connection_balancers_.emplace(
+            address.asString(),
+            std::make_shared<Network::LeastLoadedConnectionBalancerImpl>(
+                config_.connection_balance_config().least_loaded_balance().max_imbalance()));
+        break;
       case envoy::config::listener::v3::Listener_ConnectionBalanceConfig::kExtendBalance: {
         const std::string connection_balance_library_type{TypeUtil::typeUrlToDescriptorFullName(
             config_.connection_balance_config().extend_balance().typed_config().type_url())};
@@ -0,0 +1,268 @@
+#include "source/extensions/load_balancing_policies/anchor_hash/anchor_hash_lb.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "source/common/common/assert.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace AnchorHash {
+
+namespace {
+
+// The hash of a key among the buckets that were working when the given bucket was removed. The
+// bucket is mixed into the hash of the key with the finalizer of MurmurHash3, so that keys of the
+// same removed bucket are spread independently of where they landed before.
+uint64_t rehash(uint64_t hash, uint32_t bucket) {
+  uint64_t mixed = hash ^ ((static_cast<uint64_t>(bucket) + 1) * 0x9e3779b97f4a7c15ULL);
+  mixed ^= mixed >> 33;
+  mixed *= 0xff51afd7ed558ccdULL;
+  mixed ^= mixed >> 33;
+  mixed *= 0xc4ceb9fe1a85ec53ULL;
+  mixed ^= mixed >> 33;
+  return mixed;
+}
+
+} // namespace
+
+AnchorHashTable::AnchorHashTable(
+    const Upstream::NormalizedHostWeightVector& normalized_host_weights, uint32_t min_capacity,
+    bool use_hostname_for_hashing, AnchorHashLoadBalancerStats& stats,
+    const AnchorHashTable* previous)
+    : stats_(stats) {
+  // We can't do anything sensible with no hosts.
+  if (normalized_host_weights.empty()) {
+    ENVOY_LOG(debug, "anchor hash: normalized hosts weights is empty, skipping building table");
+    stats_.capacity_.set(0);
+    return;
+  }
+
+  if (previous != nullptr && update(normalized_host_weights, use_hostname_for_hashing, *previous)) {
+    stats_.table_updated_.inc();
+  } else {
+    ASSERT(normalized_host_weights.size() <= std::numeric_limits<uint32_t>::max() / 2);
+    const uint32_t capacity =
+        std::max(min_capacity, static_cast<uint32_t>(normalized_host_weights.size() * 2));
+    build(normalized_host_weights, capacity, use_hostname_for_hashing);
+    stats_.table_rebuilt_.inc();
+  }
+  ENVOY_LOG(debug, "anchor hash: {} hosts in {} buckets", num_working_, capacity());
+  stats_.capacity_.set(capacity());
+}
+
+void AnchorHashTable::build(const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+                            uint32_t capacity, bool use_hostname_for_hashing) {
+  // Buckets are handed out in the order of the hash keys, so a table built from scratch only
+  // depends on the keys of the hosts, not on their order. Of hosts sharing a key, only the first
+  // one gets a bucket.
+  std::vector<std::pair<absl::string_view, const Upstream::HostConstSharedPtr*>> keyed_hosts;
+  keyed_hosts.reserve(normalized_host_weights.size());
+  for (const auto& host_weight : normalized_host_weights) {
+    const absl::string_view key_to_hash = hashKey(host_weight.first, use_hostname_for_hashing);
+    ASSERT(!key_to_hash.empty());
+    keyed_hosts.emplace_back(key_to_hash, &host_weight.first);
+  }
+  std::stable_sort(keyed_hosts.begin(), keyed_hosts.end(),
+                   [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  keyed_hosts.erase(std::unique(keyed_hosts.begin(), keyed_hosts.end(),
+                                [](const auto& lhs, const auto& rhs) {
+                                  return lhs.first == rhs.first;
+                                }),
+                    keyed_hosts.end());
+
+  // Implementation of INITANCHOR in the paper: the first buckets are working, the others are
+  // removed in decreasing order.
+  num_working_ = keyed_hosts.size();
+  removed_at_.assign(capacity, 0);
+  successor_.resize(capacity);
+  std::iota(successor_.begin(), successor_.end(), 0);
+  working_ = successor_;
+  location_ = successor_;
+  hosts_.resize(capacity);
+  buckets_.reserve(num_working_);
+  for (uint32_t bucket = 0; bucket < num_working_; bucket++) {
+    hosts_[bucket] = *keyed_hosts[bucket].second;
+    buckets_.emplace(std::string(keyed_hosts[bucket].first), bucket);
+  }
+  removed_.reserve(capacity - num_working_);
+  for (uint32_t bucket = capacity; bucket > num_working_; bucket--) {
+    removed_.push_back(bucket - 1);
+    removed_at_[bucket - 1] = bucket - 1;
+  }
+}
+
+bool AnchorHashTable::update(const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+                             bool use_hostname_for_hashing, const AnchorHashTable& previous) {
+  if (previous.num_working_ == 0) {
+    return false;
+  }
+
+  absl::flat_hash_map<absl::string_view, const Upstream::HostConstSharedPtr*> keyed_hosts;
+  keyed_hosts.reserve(normalized_host_weights.size());
+  for (const auto& host_weight : normalized_host_weights) {
+    const absl::string_view key_to_hash = hashKey(host_weight.first, use_hostname_for_hashing);
+    ASSERT(!key_to_hash.empty());
+    keyed_hosts.emplace(key_to_hash, &host_weight.first);
+  }
+  if (keyed_hosts.size() > previous.capacity()) {
+    return false;
+  }
+
+  std::vector<uint32_t> removed_buckets;
+  for (const auto& [key, bucket] : previous.buckets_) {
+    if (!keyed_hosts.contains(key)) {
+      removed_buckets.push_back(bucket);
+    }
+  }
+  // Every key would move anyway, and removing all the buckets would leave none to rehash into.
+  if (removed_buckets.size() == previous.buckets_.size()) {
+    return false;
+  }
+  std::vector<std::pair<absl::string_view, const Upstream::HostConstSharedPtr*>> added_hosts;
+  for (const auto& keyed_host : keyed_hosts) {
+    if (!previous.buckets_.contains(keyed_host.first)) {
+      added_hosts.push_back(keyed_host);
+    }
+  }
+
+  removed_at_ = previous.removed_at_;
+  successor_ = previous.successor_;
+  working_ = previous.working_;
+  location_ = previous.location_;
+  removed_ = previous.removed_;
+  num_working_ = previous.num_working_;
+  hosts_ = previous.hosts_;
+
+  // Buckets are removed in bucket order and added in key order, so the table doesn't depend on
+  // the iteration order of the maps. Removing first lets the added hosts take over the keys of the
+  // removed ones, the last removed bucket being the first added back.
+  std::sort(removed_buckets.begin(), removed_buckets.end());
+  for (const uint32_t bucket : removed_buckets) {
+    removeBucket(bucket);
+    hosts_[bucket] = nullptr;
+  }
+  buckets_.reserve(keyed_hosts.size());
+  for (const auto& [key, host] : keyed_hosts) {
+    const auto it = previous.buckets_.find(key);
+    if (it != previous.buckets_.end()) {
+      // The host may be a new object with the same key.
+      hosts_[it->second] = *host;
+      buckets_.emplace(std::string(key), it->second);
+    }
+  }
+  std::sort(added_hosts.begin(), added_hosts.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+  for (const auto& [key, host] : added_hosts) {
+    const uint32_t bucket = addBucket();
+    hosts_[bucket] = *host;
+    buckets_.emplace(std::string(key), bucket);
+  }
+  ENVOY_LOG(debug, "anchor hash: removed {} buckets, added {} buckets", removed_buckets.size(),
+            added_hosts.size());
+  return true;
+}
+
+Upstream::HostConstSharedPtr AnchorHashTable::chooseHost(uint64_t hash, uint32_t attempt) const {
+  if (num_working_ == 0) {
+    return nullptr;
+  }
+
+  if (attempt > 0) {
+    // If a retry host predicate is being applied, mutate the hash to choose an alternate host.
+    // By using value with most bits set for the retry attempts, we achieve a larger change in
+    // the hash, thereby reducing the likelihood that all retries are directed to a single host.
+    hash ^= ~0ULL - attempt + 1;
+  }
+
+  return hosts_[chooseBucket(hash)];
+}
+
+uint32_t AnchorHashTable::chooseBucket(uint64_t hash) const {
+  // Implementation of GETBUCKET in the paper. A key hashing to a removed bucket is rehashed among
+  // the buckets below the number of buckets that were working when it was removed. Those removed
+  // before it are replaced by their successors, until a bucket that was working at the time is
+  // reached. If that bucket was removed since, the same happens again from it.
+  uint32_t bucket = hash % capacity();
+  while (removed_at_[bucket] > 0) {
+    uint32_t candidate = rehash(hash, bucket) % removed_at_[bucket];
+    while (removed_at_[candidate] >= removed_at_[bucket]) {
+      candidate = successor_[candidate];
+    }
+    bucket = candidate;
+  }
+  return bucket;
+}
+
+void AnchorHashTable::removeBucket(uint32_t bucket) {
+  // Implementation of REMOVEBUCKET in the paper: the last working bucket takes the place of the
+  // removed one in working_.
+  ASSERT(removed_at_[bucket] == 0 && num_working_ > 1);
+  removed_.push_back(bucket);
+  num_working_--;
+  removed_at_[bucket] = num_working_;
+  working_[location_[bucket]] = working_[num_working_];
+  location_[working_[num_working_]] = location_[bucket];
+  successor_[bucket] = working_[num_working_];
+}
+
+uint32_t AnchorHashTable::addBucket() {
+  // Implementation of ADDBUCKET in the paper, which undoes the last removal.
+  ASSERT(!removed_.empty());
+  const uint32_t bucket = removed_.back();
+  removed_.pop_back();
+  removed_at_[bucket] = 0;
+  location_[working_[num_working_]] = num_working_;
+  working_[location_[bucket]] = bucket;
+  successor_[bucket] = bucket;
+  num_working_++;
+  return bucket;
+}
+
+AnchorHashLoadBalancer::AnchorHashLoadBalancer(
+    const Upstream::PrioritySet& priority_set, Upstream::ClusterLbStats& stats,
+    Stats::Scope& scope, Runtime::Loader& runtime, Random::RandomGenerator& random,
+    uint32_t min_capacity, bool use_hostname_for_hashing, uint32_t hash_balance_factor,
+    const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
+    : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
+      scope_(scope.createScope("anchor_hash_lb.")), stats_(generateStats(*scope_)),
+      min_capacity_(min_capacity), use_hostname_for_hashing_(use_hostname_for_hashing),
+      hash_balance_factor_(hash_balance_factor) {}
+
+Upstream::ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+AnchorHashLoadBalancer::createLoadBalancer(
+    uint32_t priority, const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+    double /* min_normalized_weight */, double /* max_normalized_weight */) {
+  if (tables_.size() <= priority) {
+    tables_.resize(priority + 1);
+  }
+  auto table = std::make_shared<AnchorHashTable>(normalized_host_weights, min_capacity_,
+                                                 use_hostname_for_hashing_, stats_,
+                                                 tables_[priority].get());
+  tables_[priority] = table;
+  if (hash_balance_factor_ == 0) {
+    return table;
+  }
+
+  // The table gives every host the same share of the keys, so the load bound does too.
+  Upstream::NormalizedHostWeightVector equal_host_weights;
+  equal_host_weights.reserve(normalized_host_weights.size());
+  for (const auto& host_weight : normalized_host_weights) {
+    equal_host_weights.emplace_back(host_weight.first, 1.0 / normalized_host_weights.size());
+  }
+  return std::make_shared<BoundedLoadHashingLoadBalancer>(table, std::move(equal_host_weights),
+                                                          hash_balance_factor_);
+}
+
+AnchorHashLoadBalancerStats AnchorHashLoadBalancer::generateStats(Stats::Scope& scope) {
+  return {ALL_ANCHOR_HASH_LOAD_BALANCER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope))};
+}
+
+} // namespace AnchorHash
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
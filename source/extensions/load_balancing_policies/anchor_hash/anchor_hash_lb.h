@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/config/cluster/v3/cluster.pb.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/upstream/thread_aware_lb_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace AnchorHash {
+
+/**
+ * All anchor hash load balancer stats. @see stats_macros.h
+ */
+#define ALL_ANCHOR_HASH_LOAD_BALANCER_STATS(COUNTER, GAUGE)                                        \
+  COUNTER(table_rebuilt)                                                                           \
+  COUNTER(table_updated)                                                                           \
+  GAUGE(capacity, Accumulate)
+
+/**
+ * Struct definition for all anchor hash load balancer stats. @see stats_macros.h
+ */
+struct AnchorHashLoadBalancerStats {
+  ALL_ANCHOR_HASH_LOAD_BALANCER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * This is an implementation of AnchorHash as described in https://arxiv.org/abs/2001.09092,
+ * algorithm 3. Every host owns one of capacity() buckets, the other buckets are removed. A key
+ * hashing to a removed bucket is rehashed into the buckets that were working when it was removed,
+ * so a lookup takes 1 + ln(capacity() / hosts) hashes in expectation, and removing or adding a
+ * bucket only moves the keys of that bucket.
+ *
+ * Host weights are ignored, every host owns the same share of the keys.
+ */
+class AnchorHashTable : public Upstream::ThreadAwareLoadBalancerBase::HashingLoadBalancer,
+                        Logger::Loggable<Logger::Id::upstream> {
+public:
+  /**
+   * @param normalized_host_weights the hosts of the table.
+   * @param min_capacity the lowest number of buckets a table built from scratch has. Tables built
+   *        from scratch have at least twice as many buckets as hosts.
+   * @param use_hostname_for_hashing whether the host name is the key of a host without a hash key
+   *        in its metadata, rather than its address.
+   * @param previous the table the hosts are updated from, if any. The buckets of the hosts whose
+   *        key is gone are removed and buckets are added for new keys, in a constant time per host
+   *        changed. The table is built from scratch when there is no previous table, no host kept
+   *        its key, or the hosts don't fit in the buckets of the previous table.
+   */
+  AnchorHashTable(const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+                  uint32_t min_capacity, bool use_hostname_for_hashing,
+                  AnchorHashLoadBalancerStats& stats, const AnchorHashTable* previous);
+
+  // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+  Upstream::HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
+
+  uint32_t capacity() const { return hosts_.size(); }
+
+private:
+  void build(const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+             uint32_t capacity, bool use_hostname_for_hashing);
+  bool update(const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+              bool use_hostname_for_hashing, const AnchorHashTable& previous);
+  uint32_t chooseBucket(uint64_t hash) const;
+  void removeBucket(uint32_t bucket);
+  uint32_t addBucket();
+
+  // The arrays of the paper, indexed by bucket except for working_ and removed_.
+  // A: the number of working buckets left when the bucket was removed, 0 for working buckets.
+  std::vector<uint32_t> removed_at_;
+  // K: the bucket that took the place of the bucket in working_ when it was removed.
+  std::vector<uint32_t> successor_;
+  // W: the working buckets in the first num_working_ entries.
+  std::vector<uint32_t> working_;
+  // L: the index of the bucket in working_.
+  std::vector<uint32_t> location_;
+  // R: the removed buckets, the last one removed at the back.
+  std::vector<uint32_t> removed_;
+  uint32_t num_working_{};
+  // The host of every working bucket.
+  std::vector<Upstream::HostConstSharedPtr> hosts_;
+  // The bucket of every host, by hash key.
+  absl::flat_hash_map<std::string, uint32_t> buckets_;
+  AnchorHashLoadBalancerStats& stats_;
+};
+
+/**
+ * Thread aware load balancer implementation for AnchorHash. The table of a priority is updated
+ * from the previous table of the priority when its hosts change.
+ */
+class AnchorHashLoadBalancer : public Upstream::ThreadAwareLoadBalancerBase,
+                               Logger::Loggable<Logger::Id::upstream> {
+public:
+  AnchorHashLoadBalancer(const Upstream::PrioritySet& priority_set,
+                         Upstream::ClusterLbStats& stats, Stats::Scope& scope,
+                         Runtime::Loader& runtime, Random::RandomGenerator& random,
+                         uint32_t min_capacity, bool use_hostname_for_hashing,
+                         uint32_t hash_balance_factor,
+                         const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config);
+
+  const AnchorHashLoadBalancerStats& stats() const { return stats_; }
+
+private:
+  using AnchorHashTableConstSharedPtr = std::shared_ptr<const AnchorHashTable>;
+
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerSharedPtr
+  createLoadBalancer(uint32_t priority,
+                     const Upstream::NormalizedHostWeightVector& normalized_host_weights,
+                     double min_normalized_weight, double max_normalized_weight) override;
+
+  static AnchorHashLoadBalancerStats generateStats(Stats::Scope& scope);
+
+  Stats::ScopeSharedPtr scope_;
+  AnchorHashLoadBalancerStats stats_;
+  const uint32_t min_capacity_;
+  const bool use_hostname_for_hashing_;
+  const uint32_t hash_balance_factor_;
+  // The last table built for each priority, the starting point of the next build.
+  std::vector<AnchorHashTableConstSharedPtr> tables_;
+};
+
+} // namespace AnchorHash
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
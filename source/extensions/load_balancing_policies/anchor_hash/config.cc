@@ -0,0 +1,33 @@
+#include "source/extensions/load_balancing_policies/anchor_hash/config.h"
+
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/load_balancing_policies/anchor_hash/anchor_hash_lb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace AnchorHash {
+
+Upstream::ThreadAwareLoadBalancerPtr
+AnchorHashLbFactory::create(const Upstream::ClusterInfo& cluster_info,
+                            const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+                            Random::RandomGenerator& random, TimeSource&) {
+  ASSERT(cluster_info.loadBalancingPolicy() != nullptr);
+  const auto& config =
+      dynamic_cast<const envoy::extensions::load_balancing_policies::anchor_hash::v3::AnchorHash&>(
+          *cluster_info.loadBalancingPolicy());
+  return std::make_unique<AnchorHashLoadBalancer>(
+      priority_set, cluster_info.lbStats(), cluster_info.statsScope(), runtime, random,
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, capacity, 0),
+      config.consistent_hashing_lb_config().use_hostname_for_hashing(),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.consistent_hashing_lb_config(), hash_balance_factor,
+                                      0),
+      cluster_info.lbConfig());
+}
+
+REGISTER_FACTORY(AnchorHashLbFactory, Upstream::TypedLoadBalancerFactory);
+
+} // namespace AnchorHash
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
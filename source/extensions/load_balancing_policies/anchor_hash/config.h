@@ -0,0 +1,36 @@
+#pragma once
+
+#include "envoy/extensions/load_balancing_policies/anchor_hash/v3/anchor_hash.pb.h"
+#include "envoy/registry/registry.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "source/common/upstream/load_balancer_factory_base.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace AnchorHash {
+
+class AnchorHashLbFactory : public Upstream::TypedLoadBalancerFactoryBase {
+public:
+  AnchorHashLbFactory()
+      : TypedLoadBalancerFactoryBase("envoy.load_balancing_policies.anchor_hash") {}
+
+  // Upstream::TypedLoadBalancerFactory
+  Upstream::ThreadAwareLoadBalancerPtr create(const Upstream::ClusterInfo& cluster_info,
+                                              const Upstream::PrioritySet& priority_set,
+                                              Runtime::Loader& runtime,
+                                              Random::RandomGenerator& random,
+                                              TimeSource& time_source) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<
+        envoy::extensions::load_balancing_policies::anchor_hash::v3::AnchorHash>();
+  }
+};
+
+DECLARE_FACTORY(AnchorHashLbFactory);
+
+} // namespace AnchorHash
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#include "source/extensions/load_balancing_policies/peak_ewma/config.h"
+
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace PeakEwma {
+
+Upstream::ThreadAwareLoadBalancerPtr
+PeakEwmaLbFactory::create(const Upstream::ClusterInfo& cluster_info,
+                          const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+                          Random::RandomGenerator& random, TimeSource& time_source) {
+  ASSERT(cluster_info.loadBalancingPolicy() != nullptr);
+  const auto& config =
+      dynamic_cast<const envoy::extensions::load_balancing_policies::peak_ewma::v3::PeakEwma&>(
+          *cluster_info.loadBalancingPolicy());
+  const std::chrono::milliseconds decay_time(
+      PROTOBUF_GET_MS_OR_DEFAULT(config, decay_time, 10000));
+  const std::chrono::milliseconds default_response_time(
+      PROTOBUF_GET_MS_OR_DEFAULT(config, default_response_time, 10));
+  const std::chrono::milliseconds failure_penalty(
+      PROTOBUF_GET_MS_OR_DEFAULT(config, failure_penalty, 1000));
+  return std::make_unique<PeakEwmaThreadAwareLoadBalancer>(
+      std::make_shared<PeakEwmaLoadBalancerFactory>(cluster_info, priority_set, runtime, random,
+                                                    time_source, decay_time,
+                                                    default_response_time, failure_penalty));
+}
+
+REGISTER_FACTORY(PeakEwmaLbFactory, Upstream::TypedLoadBalancerFactory);
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
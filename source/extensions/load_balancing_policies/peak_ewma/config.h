@@ -0,0 +1,34 @@
+#pragma once
+
+#include "envoy/extensions/load_balancing_policies/peak_ewma/v3/peak_ewma.pb.h"
+#include "envoy/registry/registry.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "source/common/upstream/load_balancer_factory_base.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace PeakEwma {
+
+class PeakEwmaLbFactory : public Upstream::TypedLoadBalancerFactoryBase {
+public:
+  PeakEwmaLbFactory() : TypedLoadBalancerFactoryBase("envoy.load_balancing_policies.peak_ewma") {}
+
+  // Upstream::TypedLoadBalancerFactory
+  Upstream::ThreadAwareLoadBalancerPtr create(const Upstream::ClusterInfo& cluster_info,
+                                              const Upstream::PrioritySet& priority_set,
+                                              Runtime::Loader& runtime,
+                                              Random::RandomGenerator& random,
+                                              TimeSource& time_source) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<envoy::extensions::load_balancing_policies::peak_ewma::v3::PeakEwma>();
+  }
+};
+
+DECLARE_FACTORY(PeakEwmaLbFactory);
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,131 @@
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace PeakEwma {
+
+PeakEwmaLoadBalancer::PeakEwmaLoadBalancer(
+    const Upstream::PrioritySet& priority_set, const Upstream::PrioritySet* local_priority_set,
+    Upstream::ClusterLbStats& stats, Runtime::Loader& runtime, Random::RandomGenerator& random,
+    const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config,
+    std::chrono::microseconds decay_time, std::chrono::microseconds default_response_time,
+    std::chrono::microseconds failure_penalty, TimeSource& time_source)
+    : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                common_config),
+      decay_time_us_(decay_time.count()), default_response_time_us_(default_response_time.count()),
+      failure_penalty_(failure_penalty), time_source_(time_source) {
+  for (const auto& host_set : priority_set.hostSetsPerPriority()) {
+    addHosts(host_set->hosts());
+  }
+  member_update_cb_ = priority_set.addMemberUpdateCb(
+      [this](const Upstream::HostVector& hosts_added, const Upstream::HostVector& hosts_removed) {
+        for (const auto& host : hosts_removed) {
+          estimates_.erase(host.get());
+        }
+        addHosts(hosts_added);
+      });
+}
+
+void PeakEwmaLoadBalancer::addHosts(const Upstream::HostVector& hosts) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  for (const auto& host : hosts) {
+    estimates_.try_emplace(host.get(), ResponseTimeEstimate{default_response_time_us_, now});
+  }
+}
+
+double PeakEwmaLoadBalancer::decayFactor(MonotonicTime last_update, MonotonicTime now) const {
+  const double elapsed_us = std::max<double>(
+      0, std::chrono::duration_cast<std::chrono::microseconds>(now - last_update).count());
+  return std::exp(-elapsed_us / decay_time_us_);
+}
+
+void PeakEwmaLoadBalancer::onHostResponseTime(const Upstream::HostDescription& host,
+                                              std::chrono::microseconds response_time) {
+  // Responses of hosts that were removed while the request was in flight are dropped.
+  auto it = estimates_.find(&host);
+  if (it == estimates_.end()) {
+    return;
+  }
+
+  ResponseTimeEstimate& estimate = it->second;
+  const MonotonicTime now = time_source_.monotonicTime();
+  const double response_time_us = response_time.count();
+  if (response_time_us > estimate.response_time_us_) {
+    // The peak: a slower response is taken as is, so a host that slows down is avoided at once.
+    estimate.response_time_us_ = response_time_us;
+  } else {
+    const double decay = decayFactor(estimate.last_update_, now);
+    estimate.response_time_us_ =
+        estimate.response_time_us_ * decay + response_time_us * (1.0 - decay);
+  }
+  estimate.last_update_ = now;
+}
+
+void PeakEwmaLoadBalancer::onHostFailure(const Upstream::HostDescription& host,
+                                         std::chrono::microseconds elapsed) {
+  // A host that resets or hangs must not keep the estimate of its last good responses, so the
+  // failure is recorded like a response that took at least the penalty.
+  onHostResponseTime(host, std::max(elapsed, failure_penalty_));
+}
+
+double PeakEwmaLoadBalancer::hostCost(const Upstream::Host& host, MonotonicTime now) const {
+  double response_time_us = default_response_time_us_;
+  const auto it = estimates_.find(&host);
+  if (it != estimates_.end()) {
+    // Decay towards zero while the host is not chosen, so that a host that was slow once is tried
+    // again eventually.
+    response_time_us =
+        it->second.response_time_us_ * decayFactor(it->second.last_update_, now);
+  }
+  return response_time_us * (host.stats().rq_active_.value() + 1);
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::peekAnotherHost(Upstream::LoadBalancerContext* context) {
+  // Only allow as many preconnected connections as there are healthy hosts.
+  if (stashed_random_.size() >= total_healthy_hosts_) {
+    return nullptr;
+  }
+  return peekOrChoose(context, true);
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::chooseHostOnce(Upstream::LoadBalancerContext* context) {
+  return peekOrChoose(context, false);
+}
+
+Upstream::HostConstSharedPtr
+PeakEwmaLoadBalancer::peekOrChoose(Upstream::LoadBalancerContext* context, bool peek) {
+  const uint64_t random_hash = random(peek);
+  const absl::optional<HostsSource> hosts_source = hostSourceToUse(context, random_hash);
+  if (!hosts_source) {
+    return nullptr;
+  }
+
+  const Upstream::HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+  if (hosts_to_use.size() == 1) {
+    return hosts_to_use[0];
+  }
+
+  // Both choices come from the same random value so that a peek predicts the next pick. The
+  // second choice is offset from the first one so that the two are always distinct.
+  const size_t first = random_hash % hosts_to_use.size();
+  const size_t second =
+      (first + 1 + (random_hash >> 32) % (hosts_to_use.size() - 1)) % hosts_to_use.size();
+  const MonotonicTime now = time_source_.monotonicTime();
+  return hostCost(*hosts_to_use[second], now) < hostCost(*hosts_to_use[first], now)
+             ? hosts_to_use[second]
+             : hosts_to_use[first];
+}
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
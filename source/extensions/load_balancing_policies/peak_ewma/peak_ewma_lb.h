@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+
+#include "envoy/common/time.h"
+#include "envoy/upstream/load_balancer.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/common/logger.h"
+#include "source/common/upstream/load_balancer_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace PeakEwma {
+
+/**
+ * Worker local load balancer that picks the cheaper of two random hosts. The cost of a host is
+ * the peak EWMA of its response times times its active requests plus one. The response times are
+ * reported by the router through Upstream::ResponseTimeCallbacks on the worker that chose the
+ * host, so the estimates are never shared with other workers. A request that is reset or times out
+ * counts as a response of at least the failure penalty.
+ *
+ * The estimates outlive host updates: the load balancer follows the member updates of the worker
+ * local priority set instead of being recreated by its factory.
+ */
+class PeakEwmaLoadBalancer : public Upstream::ZoneAwareLoadBalancerBase,
+                             public Upstream::ResponseTimeCallbacks,
+                             Logger::Loggable<Logger::Id::upstream> {
+public:
+  PeakEwmaLoadBalancer(const Upstream::PrioritySet& priority_set,
+                       const Upstream::PrioritySet* local_priority_set,
+                       Upstream::ClusterLbStats& stats, Runtime::Loader& runtime,
+                       Random::RandomGenerator& random,
+                       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config,
+                       std::chrono::microseconds decay_time,
+                       std::chrono::microseconds default_response_time,
+                       std::chrono::microseconds failure_penalty, TimeSource& time_source);
+
+  // Upstream::ZoneAwareLoadBalancerBase
+  Upstream::HostConstSharedPtr chooseHostOnce(Upstream::LoadBalancerContext* context) override;
+  Upstream::HostConstSharedPtr peekAnotherHost(Upstream::LoadBalancerContext* context) override;
+  OptRef<Upstream::ResponseTimeCallbacks> responseTimeCallbacks() override { return *this; }
+
+  // Upstream::ResponseTimeCallbacks
+  void onHostResponseTime(const Upstream::HostDescription& host,
+                          std::chrono::microseconds response_time) override;
+  void onHostFailure(const Upstream::HostDescription& host,
+                     std::chrono::microseconds elapsed) override;
+
+  /**
+   * @return the cost of sending a request to the host at the given time.
+   */
+  double hostCost(const Upstream::Host& host, MonotonicTime now) const;
+
+private:
+  struct ResponseTimeEstimate {
+    // The peak EWMA of the response times of the host, in microseconds.
+    double response_time_us_;
+    MonotonicTime last_update_;
+  };
+
+  // The weight of an estimate last updated at last_update, between 0 and 1.
+  double decayFactor(MonotonicTime last_update, MonotonicTime now) const;
+  Upstream::HostConstSharedPtr peekOrChoose(Upstream::LoadBalancerContext* context, bool peek);
+  void addHosts(const Upstream::HostVector& hosts);
+
+  const double decay_time_us_;
+  const double default_response_time_us_;
+  const std::chrono::microseconds failure_penalty_;
+  TimeSource& time_source_;
+  // Holds an estimate for each host of the priority set. Entries are erased as soon as their host
+  // is removed, so the address of a destroyed host never matches a live entry.
+  absl::flat_hash_map<const Upstream::HostDescription*, ResponseTimeEstimate> estimates_;
+  Common::CallbackHandlePtr member_update_cb_;
+};
+
+/**
+ * Shared by all workers to create their PeakEwmaLoadBalancer. Only holds immutable configuration.
+ */
+class PeakEwmaLoadBalancerFactory : public Upstream::LoadBalancerFactory {
+public:
+  PeakEwmaLoadBalancerFactory(const Upstream::ClusterInfo& cluster_info,
+                              const Upstream::PrioritySet& priority_set, Runtime::Loader& runtime,
+                              Random::RandomGenerator& random, TimeSource& time_source,
+                              std::chrono::microseconds decay_time,
+                              std::chrono::microseconds default_response_time,
+                              std::chrono::microseconds failure_penalty)
+      : cluster_info_(cluster_info), priority_set_(priority_set), runtime_(runtime),
+        random_(random), time_source_(time_source), decay_time_(decay_time),
+        default_response_time_(default_response_time), failure_penalty_(failure_penalty) {}
+
+  // Upstream::LoadBalancerFactory
+  // Without worker local parameters, the load balancer uses the priority set of the cluster.
+  Upstream::LoadBalancerPtr create() override { return create({priority_set_, nullptr}); }
+  Upstream::LoadBalancerPtr create(Upstream::LoadBalancerParams params) override {
+    return std::make_unique<PeakEwmaLoadBalancer>(
+        params.priority_set, params.local_priority_set, cluster_info_.lbStats(), runtime_,
+        random_, cluster_info_.lbConfig(), decay_time_, default_response_time_, failure_penalty_,
+        time_source_);
+  }
+  // The response time estimates must survive host updates.
+  bool recreateOnHostChange() const override { return false; }
+
+private:
+  const Upstream::ClusterInfo& cluster_info_;
+  const Upstream::PrioritySet& priority_set_;
+  Runtime::Loader& runtime_;
+  Random::RandomGenerator& random_;
+  TimeSource& time_source_;
+  const std::chrono::microseconds decay_time_;
+  const std::chrono::microseconds default_response_time_;
+  const std::chrono::microseconds failure_penalty_;
+};
+
+/**
+ * The main thread side of the peak EWMA load balancer. All state is per worker, so there is
+ * nothing to build on host updates.
+ */
+class PeakEwmaThreadAwareLoadBalancer : public Upstream::ThreadAwareLoadBalancer {
+public:
+  PeakEwmaThreadAwareLoadBalancer(Upstream::LoadBalancerFactorySharedPtr factory)
+      : factory_(std::move(factory)) {}
+
+  // Upstream::ThreadAwareLoadBalancer
+  Upstream::LoadBalancerFactorySharedPtr factory() override { return factory_; }
+  void initialize() override {}
+
+private:
+  const Upstream::LoadBalancerFactorySharedPtr factory_;
+};
+
+} // namespace PeakEwma
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,56 @@
+#include "source/extensions/network/socket_interface/io_uring/config.h"
+
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/network/socket_interface/io_uring/io_uring_socket_handle_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+
+constexpr uint32_t DefaultIoUringSize = 1000;
+constexpr uint32_t DefaultReadBufferSize = 8192;
+
+} // namespace
+
+Server::BootstrapExtensionPtr IoUringSocketInterface::createBootstrapExtension(
+    const Protobuf::Message& config, Server::Configuration::ServerFactoryContext& context) {
+  const auto& message = MessageUtil::downcastAndValidate<
+      const envoy::extensions::network::socket_interface::io_uring::v3::IoUringSocketInterface&>(
+      config, context.messageValidationVisitor());
+
+  if (!Io::isIoUringSupported()) {
+    ENVOY_LOG(warn, "io_uring is not supported by this kernel, using readiness-based socket IO");
+    return std::make_unique<SocketInterfaceExtension>(*this);
+  }
+
+  auto io_uring_worker_factory = std::make_shared<Io::IoUringWorkerFactoryImpl>(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(message, io_uring_size, DefaultIoUringSize),
+      message.enable_submission_queue_polling(),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(message, read_buffer_size, DefaultReadBufferSize),
+      context.threadLocal());
+  io_uring_worker_factory_ = io_uring_worker_factory;
+  return std::make_unique<IoUringSocketInterfaceExtension>(*this,
+                                                           std::move(io_uring_worker_factory));
+}
+
+ProtobufTypes::MessagePtr IoUringSocketInterface::createEmptyConfigProto() {
+  return std::make_unique<
+      envoy::extensions::network::socket_interface::io_uring::v3::IoUringSocketInterface>();
+}
+
+IoHandlePtr IoUringSocketInterface::makeSocket(int socket_fd, bool socket_v6only,
+                                               absl::optional<int> domain) const {
+  Io::IoUringWorkerFactorySharedPtr io_uring_worker_factory = io_uring_worker_factory_.lock();
+  if (io_uring_worker_factory == nullptr) {
+    return SocketInterfaceImpl::makeSocket(socket_fd, socket_v6only, domain);
+  }
+  return std::make_unique<IoUringSocketHandleImpl>(*io_uring_worker_factory, socket_fd,
+                                                   socket_v6only, domain);
+}
+
+REGISTER_FACTORY(IoUringSocketInterface, Server::Configuration::BootstrapExtensionFactory);
+
+} // namespace Network
+} // namespace Envoy
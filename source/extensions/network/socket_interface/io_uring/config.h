@@ -0,0 +1,59 @@
+#pragma once
+
+#include "envoy/extensions/network/socket_interface/io_uring/v3/io_uring_socket_interface.pb.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/io/io_uring_worker_impl.h"
+#include "source/common/network/socket_interface.h"
+#include "source/common/network/socket_interface_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Socket interface which hands stream sockets to the io_uring worker of the thread they are used
+ * on. Everything else, including socket creation, behaves like SocketInterfaceImpl.
+ */
+class IoUringSocketInterface : public SocketInterfaceImpl,
+                               protected Logger::Loggable<Logger::Id::io> {
+public:
+  // Server::Configuration::BootstrapExtensionFactory
+  Server::BootstrapExtensionPtr
+  createBootstrapExtension(const Protobuf::Message& config,
+                           Server::Configuration::ServerFactoryContext& context) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+  std::string name() const override {
+    return "envoy.extensions.network.socket_interface.io_uring";
+  };
+
+protected:
+  // SocketInterfaceImpl
+  IoHandlePtr makeSocket(int socket_fd, bool socket_v6only,
+                         absl::optional<int> domain) const override;
+
+private:
+  // Owned by the bootstrap extension, which outlives all sockets of the server.
+  std::weak_ptr<Io::IoUringWorkerFactory> io_uring_worker_factory_;
+};
+
+/**
+ * Bootstrap extension creating the per-thread io_uring workers once the server's threads exist.
+ */
+class IoUringSocketInterfaceExtension : public SocketInterfaceExtension {
+public:
+  IoUringSocketInterfaceExtension(SocketInterface& sock_interface,
+                                  Io::IoUringWorkerFactorySharedPtr io_uring_worker_factory)
+      : SocketInterfaceExtension(sock_interface),
+        io_uring_worker_factory_(std::move(io_uring_worker_factory)) {}
+
+  // Server::BootstrapExtension
+  void onServerInitialized() override { io_uring_worker_factory_->onServerInitialized(); }
+
+private:
+  const Io::IoUringWorkerFactorySharedPtr io_uring_worker_factory_;
+};
+
+DECLARE_FACTORY(IoUringSocketInterface);
+
+} // namespace Network
+} // namespace Envoy
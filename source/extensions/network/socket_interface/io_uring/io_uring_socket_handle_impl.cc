@@ -0,0 +1,353 @@
+#include "source/extensions/network/socket_interface/io_uring/io_uring_socket_handle_impl.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/utility.h"
+
+namespace Envoy {
+namespace Network {
+
+IoUringSocketHandleImpl::IoUringSocketHandleImpl(Io::IoUringWorkerFactory& io_uring_worker_factory,
+                                                 os_fd_t fd, bool socket_v6only,
+                                                 absl::optional<int> domain, bool is_accepted)
+    : IoSocketHandleImpl(fd, socket_v6only, domain),
+      io_uring_worker_factory_(io_uring_worker_factory), is_accepted_(is_accepted) {}
+
+IoUringSocketHandleImpl::~IoUringSocketHandleImpl() {
+  if (io_uring_socket_ != nullptr && SOCKET_VALID(fd_)) {
+    IoUringSocketHandleImpl::close();
+  }
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::close() {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::close();
+  }
+
+  ASSERT(SOCKET_VALID(fd_));
+  // The ring closes the fd once buffered writes have been flushed.
+  io_uring_socket_->close(true);
+  io_uring_socket_ = nullptr;
+  activate_cb_.reset();
+  cb_ = nullptr;
+  SET_SOCKET_INVALID(fd_);
+  return Api::ioCallUint64ResultNoError();
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::readv(uint64_t max_length,
+                                                       Buffer::RawSlice* slices,
+                                                       uint64_t num_slice) {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::readv(max_length, slices, num_slice);
+  }
+
+  Io::IoUringStreamSocket& socket = streamSocket();
+  Buffer::Instance& read_buffer = socket.readBuffer();
+  if (read_buffer.length() == 0) {
+    if (socket.readError() != 0) {
+      return errorResult(socket.readError());
+    }
+    return socket.readEof() ? Api::ioCallUint64ResultNoError() : errorResult(SOCKET_ERROR_AGAIN);
+  }
+
+  uint64_t bytes_read = 0;
+  for (uint64_t i = 0; i < num_slice && bytes_read < max_length; i++) {
+    const uint64_t length = std::min({static_cast<uint64_t>(slices[i].len_),
+                                      max_length - bytes_read, read_buffer.length() - bytes_read});
+    if (length == 0) {
+      break;
+    }
+    read_buffer.copyOut(bytes_read, length, slices[i].mem_);
+    bytes_read += length;
+  }
+  read_buffer.drain(bytes_read);
+  if (enabled_events_ & Event::FileReadyType::Read) {
+    socket.enableRead();
+  }
+  return {bytes_read, Api::IoErrorPtr(nullptr, IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::read(Buffer::Instance& buffer,
+                                                      absl::optional<uint64_t> max_length) {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::read(buffer, max_length);
+  }
+
+  Io::IoUringStreamSocket& socket = streamSocket();
+  Buffer::Instance& read_buffer = socket.readBuffer();
+  if (read_buffer.length() == 0) {
+    if (socket.readError() != 0) {
+      return errorResult(socket.readError());
+    }
+    return socket.readEof() ? Api::ioCallUint64ResultNoError() : errorResult(SOCKET_ERROR_AGAIN);
+  }
+
+  // Moving whole slices avoids copying the data the kernel has read.
+  const uint64_t bytes_read = std::min(read_buffer.length(), max_length.value_or(UINT64_MAX));
+  buffer.move(read_buffer, bytes_read);
+  if (enabled_events_ & Event::FileReadyType::Read) {
+    socket.enableRead();
+  }
+  return {bytes_read, Api::IoErrorPtr(nullptr, IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::writev(const Buffer::RawSlice* slices,
+                                                        uint64_t num_slice) {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::writev(slices, num_slice);
+  }
+
+  Buffer::OwnedImpl data;
+  for (uint64_t i = 0; i < num_slice; i++) {
+    if (slices[i].mem_ != nullptr && slices[i].len_ != 0) {
+      data.add(slices[i].mem_, slices[i].len_);
+    }
+  }
+  return write(data);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::write(Buffer::Instance& buffer) {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::write(buffer);
+  }
+
+  Io::IoUringStreamSocket& socket = streamSocket();
+  if (socket.writeError() != 0) {
+    return errorResult(socket.writeError());
+  }
+  if (buffer.length() == 0) {
+    return Api::ioCallUint64ResultNoError();
+  }
+  const uint64_t bytes_written = socket.write(buffer);
+  if (bytes_written == 0) {
+    return errorResult(SOCKET_ERROR_AGAIN);
+  }
+  return {bytes_written, Api::IoErrorPtr(nullptr, IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::recv(void* buffer, size_t length, int flags) {
+  if (io_uring_socket_ == nullptr) {
+    return IoSocketHandleImpl::recv(buffer, length, flags);
+  }
+
+  Io::IoUringStreamSocket& socket = streamSocket();
+  Buffer::Instance& read_buffer = socket.readBuffer();
+  if (read_buffer.length() == 0) {
+    if (socket.readError() != 0) {
+      return errorResult(socket.readError());
+    }
+    return socket.readEof() ? Api::ioCallUint64ResultNoError() : errorResult(SOCKET_ERROR_AGAIN);
+  }
+
+  const uint64_t bytes_read = std::min(read_buffer.length(), static_cast<uint64_t>(length));
+  read_buffer.copyOut(0, bytes_read, buffer);
+  if (!(flags & MSG_PEEK)) {
+    read_buffer.drain(bytes_read);
+  }
+  return {bytes_read, Api::IoErrorPtr(nullptr, IoSocketError::deleteIoError)};
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::listen(int backlog) {
+  is_listener_ = true;
+  return IoSocketHandleImpl::listen(backlog);
+}
+
+IoHandlePtr IoUringSocketHandleImpl::accept(struct sockaddr* addr, socklen_t* addrlen) {
+  if (io_uring_socket_ == nullptr) {
+    auto result = Api::OsSysCallsSingleton::get().accept(fd_, addr, addrlen);
+    if (SOCKET_INVALID(result.return_value_)) {
+      return nullptr;
+    }
+    return std::make_unique<IoUringSocketHandleImpl>(io_uring_worker_factory_, result.return_value_,
+                                                     socket_v6only_, domain_, true);
+  }
+
+  auto accepted = acceptSocket().popAcceptedSocket();
+  if (!accepted.has_value()) {
+    return nullptr;
+  }
+  // Sockets accepted by the ring are blocking. Keep them non-blocking like accept4() does, since
+  // the handle may still fall back to readiness-based IO.
+  Api::OsSysCallsSingleton::get().setsocketblocking(accepted->fd_, false);
+  if (addr != nullptr && addrlen != nullptr) {
+    const socklen_t len = std::min(*addrlen, accepted->remote_addr_len_);
+    memcpy(addr, &accepted->remote_addr_, len); // NOLINT(safe-memcpy)
+    *addrlen = accepted->remote_addr_len_;
+  }
+  return std::make_unique<IoUringSocketHandleImpl>(io_uring_worker_factory_, accepted->fd_,
+                                                   socket_v6only_, domain_, true);
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::connect(Address::InstanceConstSharedPtr address) {
+  if (io_uring_socket_ == nullptr) {
+    // The connect is issued before the ring takes over. If it is still in progress then, the ring
+    // waits for its outcome before submitting reads and writes.
+    const Api::SysCallIntResult result = IoSocketHandleImpl::connect(address);
+    connected_ = result.return_value_ == 0;
+    connect_in_progress_ =
+        result.return_value_ != 0 && result.errno_ == SOCKET_ERROR_IN_PROGRESS;
+    return result;
+  }
+
+  streamSocket().connect(address);
+  return {-1, SOCKET_ERROR_IN_PROGRESS};
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::getOption(int level, int optname, void* optval,
+                                                         socklen_t* optlen) {
+  // The outcome of a connect submitted to the ring isn't visible through SO_ERROR.
+  if (io_uring_socket_ != nullptr && !is_listener_ && level == SOL_SOCKET && optname == SO_ERROR &&
+      streamSocket().connectError() != 0 && *optlen >= sizeof(int)) {
+    *static_cast<int*>(optval) = streamSocket().connectError();
+    *optlen = sizeof(int);
+    return {0, 0};
+  }
+  return IoSocketHandleImpl::getOption(level, optname, optval, optlen);
+}
+
+void IoUringSocketHandleImpl::initializeFileEvent(Event::Dispatcher& dispatcher,
+                                                  Event::FileReadyCb cb,
+                                                  Event::FileTriggerType trigger,
+                                                  uint32_t events) {
+  if (io_uring_socket_ != nullptr) {
+    // Re-attach after resetFileEvents(), e.g. when a connection takes over a socket from the
+    // listener filters. Data read in between is kept in the socket.
+    ASSERT(cb_ == nullptr);
+    cb_ = std::move(cb);
+    io_uring_socket_->setFileReadyCb([this](uint32_t events) { onEvents(events); });
+    enableFileEvents(events);
+    return;
+  }
+
+  OptRef<Io::IoUringWorkerImpl> worker = ioUringWorkerFor(dispatcher);
+  if (!worker.has_value()) {
+    IoSocketHandleImpl::initializeFileEvent(dispatcher, cb, trigger, events);
+    return;
+  }
+
+  cb_ = std::move(cb);
+  activate_cb_ = dispatcher.createSchedulableCallback([this]() {
+    const uint32_t events = injected_events_;
+    injected_events_ = 0;
+    if (cb_ != nullptr && events != 0) {
+      cb_(events);
+    }
+  });
+  if (is_listener_) {
+    io_uring_socket_ =
+        &worker->addAcceptSocket(fd_, [this](uint32_t events) { onEvents(events); });
+  } else {
+    io_uring_socket_ = &worker->addStreamSocket(fd_, is_accepted_ || connected_,
+                                                [this](uint32_t events) { onEvents(events); });
+    if (connect_in_progress_) {
+      streamSocket().awaitConnect();
+    }
+  }
+  enableFileEvents(events);
+}
+
+IoHandlePtr IoUringSocketHandleImpl::duplicate() {
+  auto result = Api::OsSysCallsSingleton::get().duplicate(fd_);
+  RELEASE_ASSERT(result.return_value_ != -1,
+                 fmt::format("duplicate failed for '{}': ({}) {}", fd_, result.errno_,
+                             errorDetails(result.errno_)));
+  // Listen sockets are duplicated for every worker, so each worker's copy must know it accepts.
+  auto handle = std::make_unique<IoUringSocketHandleImpl>(
+      io_uring_worker_factory_, result.return_value_, socket_v6only_, domain_, is_accepted_);
+  handle->is_listener_ = is_listener_;
+  return handle;
+}
+
+void IoUringSocketHandleImpl::activateFileEvents(uint32_t events) {
+  if (io_uring_socket_ == nullptr) {
+    IoSocketHandleImpl::activateFileEvents(events);
+    return;
+  }
+
+  injected_events_ |= events;
+  activate_cb_->scheduleCallbackCurrentIteration();
+}
+
+void IoUringSocketHandleImpl::enableFileEvents(uint32_t events) {
+  if (io_uring_socket_ == nullptr) {
+    IoSocketHandleImpl::enableFileEvents(events);
+    return;
+  }
+
+  enabled_events_ = events;
+  if (events & Event::FileReadyType::Read) {
+    io_uring_socket_->enableRead();
+  } else {
+    io_uring_socket_->disableRead();
+  }
+  // Like re-arming an edge triggered epoll event, enabling an event which is ready already
+  // reports it right away.
+  const uint32_t ready_events = io_uring_socket_->readyEvents() & events;
+  if (ready_events != 0) {
+    activateFileEvents(ready_events);
+  }
+}
+
+void IoUringSocketHandleImpl::resetFileEvents() {
+  if (io_uring_socket_ == nullptr) {
+    IoSocketHandleImpl::resetFileEvents();
+    return;
+  }
+
+  cb_ = nullptr;
+  enabled_events_ = 0;
+  injected_events_ = 0;
+  io_uring_socket_->setFileReadyCb(nullptr);
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::shutdown(int how) {
+  if (io_uring_socket_ == nullptr || is_listener_) {
+    return IoSocketHandleImpl::shutdown(how);
+  }
+
+  // Defer the shutdown until the writes queued to the ring are on the wire.
+  streamSocket().shutdown(how);
+  return {0, 0};
+}
+
+OptRef<Io::IoUringWorkerImpl>
+IoUringSocketHandleImpl::ioUringWorkerFor(Event::Dispatcher& dispatcher) {
+  OptRef<Io::IoUringWorkerImpl> worker = io_uring_worker_factory_.getIoUringWorker();
+  if (!worker.has_value() || &worker->dispatcher() != &dispatcher) {
+    return absl::nullopt;
+  }
+
+  // Only stream sockets are driven by the ring.
+  int socket_type = 0;
+  socklen_t socket_type_len = sizeof(socket_type);
+  if (IoSocketHandleImpl::getOption(SOL_SOCKET, SO_TYPE, &socket_type, &socket_type_len)
+              .return_value_ != 0 ||
+      socket_type != SOCK_STREAM) {
+    return absl::nullopt;
+  }
+  return worker;
+}
+
+Io::IoUringStreamSocket& IoUringSocketHandleImpl::streamSocket() {
+  ASSERT(io_uring_socket_ != nullptr && !is_listener_);
+  return static_cast<Io::IoUringStreamSocket&>(*io_uring_socket_);
+}
+
+Io::IoUringAcceptSocket& IoUringSocketHandleImpl::acceptSocket() {
+  ASSERT(io_uring_socket_ != nullptr && is_listener_);
+  return static_cast<Io::IoUringAcceptSocket&>(*io_uring_socket_);
+}
+
+void IoUringSocketHandleImpl::onEvents(uint32_t events) {
+  events &= enabled_events_;
+  if (cb_ != nullptr && events != 0) {
+    cb_(events);
+  }
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::errorResult(int error) {
+  return sysCallResultToIoCallResult(Api::SysCallSizeResult{-1, error});
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "envoy/event/schedulable_cb.h"
+
+#include "source/common/io/io_uring_worker_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * IoHandle derivative for stream sockets driven by the io_uring worker of the thread the file
+ * event is initialized on. The handle behaves exactly like IoSocketHandleImpl until
+ * initializeFileEvent() is called on a thread which has a worker. From then on reads are served
+ * from the data the ring has read ahead, writes are queued to the ring, and readiness events are
+ * derived from request completions.
+ */
+class IoUringSocketHandleImpl : public IoSocketHandleImpl {
+public:
+  IoUringSocketHandleImpl(Io::IoUringWorkerFactory& io_uring_worker_factory,
+                          os_fd_t fd = INVALID_SOCKET, bool socket_v6only = false,
+                          absl::optional<int> domain = absl::nullopt, bool is_accepted = false);
+  ~IoUringSocketHandleImpl() override;
+
+  // Network::IoHandle
+  Api::IoCallUint64Result close() override;
+  Api::IoCallUint64Result readv(uint64_t max_length, Buffer::RawSlice* slices,
+                                uint64_t num_slice) override;
+  Api::IoCallUint64Result read(Buffer::Instance& buffer,
+                               absl::optional<uint64_t> max_length) override;
+  Api::IoCallUint64Result writev(const Buffer::RawSlice* slices, uint64_t num_slice) override;
+  Api::IoCallUint64Result write(Buffer::Instance& buffer) override;
+  Api::IoCallUint64Result recv(void* buffer, size_t length, int flags) override;
+  Api::SysCallIntResult listen(int backlog) override;
+  IoHandlePtr accept(struct sockaddr* addr, socklen_t* addrlen) override;
+  Api::SysCallIntResult connect(Address::InstanceConstSharedPtr address) override;
+  Api::SysCallIntResult getOption(int level, int optname, void* optval, socklen_t* optlen) override;
+  void initializeFileEvent(Event::Dispatcher& dispatcher, Event::FileReadyCb cb,
+                           Event::FileTriggerType trigger, uint32_t events) override;
+  IoHandlePtr duplicate() override;
+  void activateFileEvents(uint32_t events) override;
+  void enableFileEvents(uint32_t events) override;
+  void resetFileEvents() override;
+  Api::SysCallIntResult shutdown(int how) override;
+
+private:
+  // Returns the worker to drive this socket with, if the socket and the dispatcher qualify.
+  OptRef<Io::IoUringWorkerImpl> ioUringWorkerFor(Event::Dispatcher& dispatcher);
+  Io::IoUringStreamSocket& streamSocket();
+  Io::IoUringAcceptSocket& acceptSocket();
+  void onEvents(uint32_t events);
+  Api::IoCallUint64Result errorResult(int error);
+
+  Io::IoUringWorkerFactory& io_uring_worker_factory_;
+  const bool is_accepted_;
+  bool is_listener_{false};
+  // Set by a connect issued before the ring takes over, once it has succeeded or while it is in
+  // progress.
+  bool connected_{false};
+  bool connect_in_progress_{false};
+  // Set once the socket has been handed over to the ring. Owned by the worker.
+  Io::IoUringSocketEntry* io_uring_socket_{nullptr};
+  Event::FileReadyCb cb_;
+  uint32_t enabled_events_{0};
+  uint32_t injected_events_{0};
+  Event::SchedulableCallbackPtr activate_cb_;
+};
+
+} // namespace Network
+} // namespace Envoy
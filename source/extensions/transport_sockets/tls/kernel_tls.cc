@@ -0,0 +1,195 @@
+#include "source/extensions/transport_sockets/tls/kernel_tls.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "envoy/common/platform.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+
+#include "absl/container/fixed_array.h"
+#include "openssl/mem.h"
+
+#ifdef __linux__
+#include <linux/tls.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+#ifdef __linux__
+
+namespace {
+
+// RFC 5246, section 6.2.1 and 7.2.
+constexpr uint8_t AlertContentType = 21;
+constexpr uint8_t ApplicationDataContentType = 23;
+constexpr uint8_t AlertLevelWarning = 1;
+constexpr uint8_t AlertCloseNotify = 0;
+
+// Size of the implicit part of the AES-GCM nonce, RFC 5288, section 3.
+constexpr size_t SaltSize = 4;
+
+size_t keySize(const SSL* ssl) {
+  switch (SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl))) {
+  case NID_aes_128_gcm:
+    return TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  case NID_aes_256_gcm:
+    return TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+  default:
+    return 0;
+  }
+}
+
+template <typename CryptoInfo>
+Api::SysCallIntResult installKeys(Network::IoHandle& io_handle, int optname, uint16_t cipher_type,
+                                  const uint8_t* key, const uint8_t* salt, uint64_t sequence) {
+  CryptoInfo crypto_info{};
+  crypto_info.info.version = TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = cipher_type;
+  static_assert(sizeof(crypto_info.salt) == SaltSize);
+  memcpy(crypto_info.key, key, sizeof(crypto_info.key));
+  memcpy(crypto_info.salt, salt, sizeof(crypto_info.salt));
+  // BoringSSL uses the sequence number as the explicit part of the nonce, and the kernel advances
+  // both together.
+  for (size_t i = 0; i < sizeof(crypto_info.rec_seq); ++i) {
+    crypto_info.rec_seq[i] = sequence >> (8 * (sizeof(crypto_info.rec_seq) - 1 - i));
+  }
+  static_assert(sizeof(crypto_info.iv) == sizeof(crypto_info.rec_seq));
+  memcpy(crypto_info.iv, crypto_info.rec_seq, sizeof(crypto_info.iv));
+
+  const Api::SysCallIntResult result =
+      io_handle.setOption(SOL_TLS, optname, &crypto_info, sizeof(crypto_info));
+  OPENSSL_cleanse(&crypto_info, sizeof(crypto_info));
+  return result;
+}
+
+} // namespace
+
+bool KernelTls::sessionSupported(const SSL* ssl) {
+  return SSL_version(ssl) == TLS1_2_VERSION && keySize(ssl) != 0;
+}
+
+bool KernelTls::enable(const SSL* ssl, Network::IoHandle& io_handle, Direction direction) {
+  ASSERT(sessionSupported(ssl));
+  if (direction == Direction::Rx && SSL_has_pending(ssl)) {
+    return false;
+  }
+
+  // The ULP stays installed once the first direction is offloaded.
+  static constexpr char Ulp[] = "tls";
+  const Api::SysCallIntResult ulp_result =
+      io_handle.setOption(IPPROTO_TCP, TCP_ULP, Ulp, sizeof(Ulp));
+  if (ulp_result.return_value_ != 0 && ulp_result.errno_ != EEXIST) {
+    return false;
+  }
+
+  // For AEAD ciphers the key block is the client and server keys followed by the client and server
+  // salts, RFC 5246, section 6.3.
+  const size_t key_size = keySize(ssl);
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl));
+  if (key_block.size() != 2 * (key_size + SaltSize) ||
+      !SSL_generate_key_block(ssl, key_block.data(), key_block.size())) {
+    return false;
+  }
+  const bool client_keys = static_cast<bool>(SSL_is_server(ssl)) == (direction == Direction::Rx);
+  const uint8_t* key = key_block.data() + (client_keys ? 0 : key_size);
+  const uint8_t* salt = key_block.data() + 2 * key_size + (client_keys ? 0 : SaltSize);
+  const int optname = direction == Direction::Tx ? TLS_TX : TLS_RX;
+  const uint64_t sequence = direction == Direction::Tx ? SSL_get_write_sequence(ssl)
+                                                       : SSL_get_read_sequence(ssl);
+
+  const Api::SysCallIntResult result =
+      key_size == TLS_CIPHER_AES_GCM_128_KEY_SIZE
+          ? installKeys<tls12_crypto_info_aes_gcm_128>(io_handle, optname,
+                                                       TLS_CIPHER_AES_GCM_128, key, salt, sequence)
+          : installKeys<tls12_crypto_info_aes_gcm_256>(io_handle, optname,
+                                                       TLS_CIPHER_AES_GCM_256, key, salt, sequence);
+  OPENSSL_cleanse(key_block.data(), key_block.size());
+  return result.return_value_ == 0;
+}
+
+KernelTls::ReadResult KernelTls::readv(Network::IoHandle& io_handle, Buffer::RawSlice* slices,
+                                       uint64_t num_slices) {
+  absl::FixedArray<iovec> iov(num_slices);
+  for (uint64_t i = 0; i < num_slices; ++i) {
+    iov[i].iov_base = slices[i].mem_;
+    iov[i].iov_len = slices[i].len_;
+  }
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))];
+  msghdr message{};
+  message.msg_iov = iov.data();
+  message.msg_iovlen = iov.size();
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ReadResult result{Api::OsSysCallsSingleton::get().recvmsg(io_handle.fdDoNotUse(), &message, 0)};
+  if (result.result_.return_value_ <= 0) {
+    return result;
+  }
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&message, cmsg)) {
+    if (cmsg->cmsg_level != SOL_TLS || cmsg->cmsg_type != TLS_GET_RECORD_TYPE) {
+      continue;
+    }
+    const uint8_t content_type = *CMSG_DATA(cmsg);
+    if (content_type != ApplicationDataContentType) {
+      const auto* record = static_cast<const uint8_t*>(slices[0].mem_);
+      const bool close_notify = content_type == AlertContentType &&
+                                result.result_.return_value_ == 2 && slices[0].len_ >= 2 &&
+                                record[1] == AlertCloseNotify;
+      result.record_type_ = close_notify ? RecordType::CloseNotify : RecordType::Other;
+    }
+    break;
+  }
+  return result;
+}
+
+Api::SysCallSizeResult KernelTls::sendCloseNotify(Network::IoHandle& io_handle) {
+  uint8_t alert[] = {AlertLevelWarning, AlertCloseNotify};
+  iovec iov{alert, sizeof(alert)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))]{};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = AlertContentType;
+  return Api::OsSysCallsSingleton::get().sendmsg(io_handle.fdDoNotUse(), &message, 0);
+}
+
+#else
+
+bool KernelTls::sessionSupported(const SSL*) { return false; }
+
+bool KernelTls::enable(const SSL*, Network::IoHandle&, Direction) { return false; }
+
+KernelTls::ReadResult KernelTls::readv(Network::IoHandle&, Buffer::RawSlice*, uint64_t) {
+  return {{-1, SOCKET_ERROR_NOT_SUP}};
+}
+
+Api::SysCallSizeResult KernelTls::sendCloseNotify(Network::IoHandle&) {
+  return {-1, SOCKET_ERROR_NOT_SUP};
+}
+
+#endif
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/api/os_sys_calls_common.h"
+#include "envoy/buffer/buffer.h"
+#include "envoy/network/io_handle.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+/**
+ * Offloads the record layer of an established TLS session to the kernel (kTLS), so that the
+ * application data of the connection can be written and read with plain socket calls.
+ *
+ * Only TLS 1.2 sessions using AES-GCM can be offloaded, as that is the only case for which
+ * BoringSSL exposes the traffic keys. Once a direction is offloaded, BoringSSL must not be used
+ * for that direction of the connection anymore.
+ */
+class KernelTls {
+public:
+  enum class Direction { Tx, Rx };
+
+  /**
+   * The type of the record read by readv().
+   */
+  enum class RecordType {
+    // Application data, the only type of record an established TLS 1.2 session is expected to
+    // receive.
+    ApplicationData,
+    // A close_notify alert, the graceful end of the TLS stream.
+    CloseNotify,
+    // Any other record. Its contents are left in the slices.
+    Other,
+  };
+
+  struct ReadResult {
+    Api::SysCallSizeResult result_;
+    RecordType record_type_{RecordType::ApplicationData};
+  };
+
+  /**
+   * @return whether the negotiated version and cipher of the session can be offloaded.
+   */
+  static bool sessionSupported(const SSL* ssl);
+
+  /**
+   * Installs the traffic keys and sequence number of one direction of the session on the socket.
+   * The session must be supported, see sessionSupported(), and BoringSSL must not have buffered any
+   * records of that direction.
+   * @return whether the direction is offloaded. On failure the socket is left as it was.
+   */
+  static bool enable(const SSL* ssl, Network::IoHandle& io_handle, Direction direction);
+
+  /**
+   * Reads application data from a socket whose receive direction is offloaded. Reading stops at
+   * any other type of record, which is then returned alone.
+   */
+  static ReadResult readv(Network::IoHandle& io_handle, Buffer::RawSlice* slices,
+                          uint64_t num_slices);
+
+  /**
+   * Sends a close_notify alert on a socket whose transmit direction is offloaded.
+   */
+  static Api::SysCallSizeResult sendCloseNotify(Network::IoHandle& io_handle);
+};
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
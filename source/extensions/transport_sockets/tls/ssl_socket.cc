@@ -110,6 +110,10 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     }
   }
 
+  if (ktls_rx_) {
+    return doKernelTlsRead(read_buffer);
+  }
+
   bool keep_reading = true;
   bool end_stream = false;
   PostIoAction action = PostIoAction::KeepOpen;
@@ -165,6 +169,51 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
   return {action, bytes_read, end_stream};
 }
 
+Network::IoResult SslSocket::doKernelTlsRead(Buffer::Instance& read_buffer) {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  bool end_stream = false;
+  while (true) {
+    Buffer::Reservation reservation = read_buffer.reserveForRead();
+    const KernelTls::ReadResult result =
+        KernelTls::readv(callbacks_->ioHandle(), reservation.slices(), reservation.numSlices());
+    ENVOY_CONN_LOG(trace, "ktls read returns: {}", callbacks_->connection(),
+                   result.result_.return_value_);
+    if (result.result_.return_value_ < 0) {
+      if (result.result_.errno_ != SOCKET_ERROR_AGAIN) {
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+    if (result.record_type_ == KernelTls::RecordType::CloseNotify ||
+        result.result_.return_value_ == 0) {
+      // Graceful shutdown using close_notify TLS alert, or non-graceful shutdown by closing the
+      // underlying socket.
+      end_stream = true;
+      break;
+    }
+    if (result.record_type_ != KernelTls::RecordType::ApplicationData) {
+      // A fatal alert or a renegotiation attempt, neither of which we handle.
+      failure_reason_ = "TLS error: unexpected record received by kernel TLS";
+      ENVOY_CONN_LOG(debug, "{}", callbacks_->connection(), failure_reason_);
+      ctx_->stats().connection_error_.inc();
+      action = PostIoAction::Close;
+      break;
+    }
+
+    reservation.commit(result.result_.return_value_);
+    bytes_read += result.result_.return_value_;
+    if (callbacks_->shouldDrainReadBuffer()) {
+      callbacks_->setTransportSocketIsReadable();
+      break;
+    }
+  }
+
+  ENVOY_CONN_LOG(trace, "ktls read {} bytes", callbacks_->connection(), bytes_read);
+
+  return {action, bytes_read, end_stream};
+}
+
 void SslSocket::onPrivateKeyMethodComplete() { resumeHandshake(); }
 
 void SslSocket::resumeHandshake() {
@@ -183,6 +232,9 @@ Network::Connection& SslSocket::connection() const { return callbacks_->connecti
 
 void SslSocket::onSuccess(SSL* ssl) {
   ctx_->logHandshake(ssl);
+  if (ctx_->kernelTlsOffload()) {
+    enableKernelTls();
+  }
   if (callbacks_->connection().streamInfo().upstreamInfo()) {
     callbacks_->connection()
         .streamInfo()
@@ -198,6 +250,37 @@ void SslSocket::onSuccess(SSL* ssl) {
 
 void SslSocket::onFailure() { drainErrorQueue(); }
 
+void SslSocket::enableKernelTls() {
+  if (!KernelTls::sessionSupported(rawSsl())) {
+    ctx_->stats().ktls_unsupported_.inc();
+    return;
+  }
+  // Records BoringSSL has buffered already can't be handed to the kernel, so the session is kept
+  // in userspace. This is not a failure of the kernel.
+  if (SSL_has_pending(rawSsl())) {
+    ctx_->stats().ktls_skipped_.inc();
+    return;
+  }
+
+  // The receive direction goes first, and the transmit one is only offloaded with it: if only one
+  // direction can be offloaded, it is better for BoringSSL to keep the transmit one, as it can
+  // then still send alerts.
+  ktls_rx_ = KernelTls::enable(rawSsl(), callbacks_->ioHandle(), KernelTls::Direction::Rx);
+  ktls_tx_ =
+      ktls_rx_ && KernelTls::enable(rawSsl(), callbacks_->ioHandle(), KernelTls::Direction::Tx);
+  if (ktls_rx_) {
+    ctx_->stats().ktls_rx_enabled_.inc();
+  }
+  if (ktls_tx_) {
+    ctx_->stats().ktls_tx_enabled_.inc();
+  }
+  if (!ktls_rx_ || !ktls_tx_) {
+    ctx_->stats().ktls_failed_.inc();
+  }
+  ENVOY_CONN_LOG(debug, "kernel TLS offload: rx={} tx={}", callbacks_->connection(), ktls_rx_,
+                 ktls_tx_);
+}
+
 PostIoAction SslSocket::doHandshake() { return info_->doHandshake(); }
 
 void SslSocket::drainErrorQueue() {
@@ -247,6 +330,10 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
     }
   }
 
+  if (ktls_tx_) {
+    return doKernelTlsWrite(write_buffer, end_stream);
+  }
+
   uint64_t bytes_to_write;
   if (bytes_to_retry_) {
     bytes_to_write = bytes_to_retry_;
@@ -297,6 +384,31 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
   return {PostIoAction::KeepOpen, total_bytes_written, false};
 }
 
+Network::IoResult SslSocket::doKernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream) {
+  // The kernel splits the data into records itself, so there is no need to linearize it.
+  uint64_t total_bytes_written = 0;
+  while (write_buffer.length() > 0) {
+    Api::IoCallUint64Result result = callbacks_->ioHandle().write(write_buffer);
+    ENVOY_CONN_LOG(trace, "ktls write returns: {}", callbacks_->connection(),
+                   result.return_value_);
+    if (!result.ok()) {
+      if (result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+        return {PostIoAction::KeepOpen, total_bytes_written, false};
+      }
+      ENVOY_CONN_LOG(debug, "ktls write error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      return {PostIoAction::Close, total_bytes_written, false};
+    }
+    total_bytes_written += result.return_value_;
+  }
+
+  if (end_stream) {
+    shutdownSsl();
+  }
+
+  return {PostIoAction::KeepOpen, total_bytes_written, false};
+}
+
 void SslSocket::onConnected() { ASSERT(info_->state() == Ssl::SocketState::PreHandshake); }
 
 Ssl::ConnectionInfoConstSharedPtr SslSocket::ssl() const { return info_; }
@@ -305,6 +417,15 @@ void SslSocket::shutdownSsl() {
   ASSERT(info_->state() != Ssl::SocketState::PreHandshake);
   if (info_->state() != Ssl::SocketState::ShutdownSent &&
       callbacks_->connection().state() != Network::Connection::State::Closed) {
+    if (ktls_tx_) {
+      // BoringSSL no longer knows the write sequence number, so the close_notify alert has to be
+      // sent by the kernel.
+      const Api::SysCallSizeResult result = KernelTls::sendCloseNotify(callbacks_->ioHandle());
+      ENVOY_CONN_LOG(debug, "kernel TLS shutdown: rc={}", callbacks_->connection(),
+                     result.return_value_);
+      info_->setState(Ssl::SocketState::ShutdownSent);
+      return;
+    }
     int rc = SSL_shutdown(rawSsl());
     if constexpr (Event::PlatformDefaultTriggerType == Event::FileTriggerType::EmulatedEdge) {
       // Windows operate under `EmulatedEdge`. These are level events that are artificially
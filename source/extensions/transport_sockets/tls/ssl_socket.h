@@ -16,6 +16,7 @@
 #include "source/common/common/logger.h"
 #include "source/common/network/transport_socket_options_impl.h"
 #include "source/extensions/transport_sockets/tls/context_impl.h"
+#include "source/extensions/transport_sockets/tls/kernel_tls.h"
 #include "source/extensions/transport_sockets/tls/ssl_handshaker.h"
 #include "source/extensions/transport_sockets/tls/utility.h"
 
@@ -85,6 +86,12 @@ private:
   };
   ReadResult sslReadIntoSlice(Buffer::RawSlice& slice);
 
+  // Offloads the record layer to the kernel if configured and possible. Called once the handshake
+  // completes.
+  void enableKernelTls();
+  Network::IoResult doKernelTlsRead(Buffer::Instance& read_buffer);
+  Network::IoResult doKernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream);
+
   Network::PostIoAction doHandshake();
   void drainErrorQueue();
   void shutdownSsl();
@@ -96,6 +103,10 @@ private:
   ContextImplSharedPtr ctx_;
   uint64_t bytes_to_retry_{};
   std::string failure_reason_;
+  // Whether the transmit and receive directions are offloaded to the kernel. BoringSSL must not be
+  // used for an offloaded direction.
+  bool ktls_tx_{false};
+  bool ktls_rx_{false};
 
   SslHandshakerImplSharedPtr info_;
 };
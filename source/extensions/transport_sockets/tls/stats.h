@@ -20,7 +20,12 @@ namespace Tls {
   COUNTER(ocsp_staple_failed)                                                                      \
   COUNTER(ocsp_staple_omitted)                                                                     \
   COUNTER(ocsp_staple_responses)                                                                   \
-  COUNTER(ocsp_staple_requests)
+  COUNTER(ocsp_staple_requests)                                                                    \
+  COUNTER(ktls_failed)                                                                             \
+  COUNTER(ktls_rx_enabled)                                                                         \
+  COUNTER(ktls_skipped)                                                                            \
+  COUNTER(ktls_tx_enabled)                                                                         \
+  COUNTER(ktls_unsupported)
 
 /**
  * Wrapper struct for SSL stats. @see stats_macros.h
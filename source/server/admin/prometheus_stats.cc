@@ -77,6 +77,41 @@ struct MetricLessThan {
   }
 };
 
+/**
+ * Outputs a group of metrics sharing a tag-extracted name, preceded by their TYPE annotation.
+ *
+ * @param tag_extracted_name The tag-extracted name shared by the metrics.
+ * @param metrics The metrics to output, which are sorted by name.
+ * @param generate_output A function which returns the output text for this metric.
+ * @param type The name of the prometheus metric type for used in TYPE annotations.
+ * @param response The buffer to put the output into.
+ * @return whether the group was output, which it isn't if it has no valid metric name.
+ */
+template <class StatType>
+bool outputMetricGroup(
+    const std::string& tag_extracted_name, std::vector<const StatType*>& metrics,
+    const std::function<std::string(
+        const StatType& metric, const std::string& prefixed_tag_extracted_name)>& generate_output,
+    absl::string_view type, Buffer::Instance& response,
+    const Stats::CustomStatNamespaces& custom_namespaces) {
+  const absl::optional<std::string> prefixed_tag_extracted_name =
+      PrometheusStatsFormatter::metricName(tag_extracted_name, custom_namespaces);
+  if (!prefixed_tag_extracted_name.has_value()) {
+    return false;
+  }
+  response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type));
+
+  // Sort before producing the final output to satisfy the "preferred" ordering from the
+  // prometheus spec: metrics will be sorted by their tags' textual representation, which will
+  // be consistent across calls.
+  std::sort(metrics.begin(), metrics.end(), MetricLessThan());
+
+  for (const auto& metric : metrics) {
+    response.add(generate_output(*metric, prefixed_tag_extracted_name.value()));
+  }
+  return true;
+}
+
 /**
  * Processes a stat type (counter, gauge, histogram) by generating all output lines, sorting
  * them by tag-extracted metric name, and then outputting them in the correct sorted order into
@@ -139,24 +174,11 @@ uint64_t outputStatType(
     groups[metric->tagExtractedStatName()].push_back(metric.get());
   }
 
-  auto result = groups.size();
+  uint64_t result = 0;
   for (auto& group : groups) {
-    const absl::optional<std::string> prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(global_symbol_table.toString(group.first),
-                                             custom_namespaces);
-    if (!prefixed_tag_extracted_name.has_value()) {
-      --result;
-      continue;
-    }
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type));
-
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), MetricLessThan());
-
-    for (const auto& metric : group.second) {
-      response.add(generate_output(*metric, prefixed_tag_extracted_name.value()));
+    if (outputMetricGroup<StatType>(global_symbol_table.toString(group.first), group.second,
+                                    generate_output, type, response, custom_namespaces)) {
+      ++result;
     }
   }
   return result;
@@ -285,5 +307,38 @@ uint64_t PrometheusStatsFormatter::statsAsPrometheus(
   return metric_name_count;
 }
 
+bool PrometheusStatsFormatter::metricGroupAsPrometheus(
+    const std::string& tag_extracted_name, std::vector<const Stats::Counter*>& counters,
+    Buffer::Instance& response, const Stats::CustomStatNamespaces& custom_namespaces) {
+  return outputMetricGroup<Stats::Counter>(tag_extracted_name, counters,
+                                           generateNumericOutput<Stats::Counter>, "counter",
+                                           response, custom_namespaces);
+}
+
+bool PrometheusStatsFormatter::metricGroupAsPrometheus(
+    const std::string& tag_extracted_name, std::vector<const Stats::Gauge*>& gauges,
+    Buffer::Instance& response, const Stats::CustomStatNamespaces& custom_namespaces) {
+  return outputMetricGroup<Stats::Gauge>(tag_extracted_name, gauges,
+                                         generateNumericOutput<Stats::Gauge>, "gauge", response,
+                                         custom_namespaces);
+}
+
+bool PrometheusStatsFormatter::metricGroupAsPrometheus(
+    const std::string& tag_extracted_name, std::vector<const Stats::TextReadout*>& text_readouts,
+    Buffer::Instance& response, const Stats::CustomStatNamespaces& custom_namespaces) {
+  // TextReadout stats are returned in gauge format, so "gauge" type is set intentionally.
+  return outputMetricGroup<Stats::TextReadout>(tag_extracted_name, text_readouts,
+                                               generateTextReadoutOutput, "gauge", response,
+                                               custom_namespaces);
+}
+
+bool PrometheusStatsFormatter::metricGroupAsPrometheus(
+    const std::string& tag_extracted_name, std::vector<const Stats::ParentHistogram*>& histograms,
+    Buffer::Instance& response, const Stats::CustomStatNamespaces& custom_namespaces) {
+  return outputMetricGroup<Stats::ParentHistogram>(tag_extracted_name, histograms,
+                                                   generateHistogramOutput, "histogram", response,
+                                                   custom_namespaces);
+}
+
 } // namespace Server
 } // namespace Envoy
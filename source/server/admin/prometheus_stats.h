@@ -30,6 +30,33 @@ public:
                                     const std::vector<Stats::TextReadoutSharedPtr>& text_readouts,
                                     Buffer::Instance& response, const StatsParams& params,
                                     const Stats::CustomStatNamespaces& custom_namespaces);
+  /**
+   * Renders a group of metrics sharing a tag-extracted name, preceded by their TYPE line. All
+   * metrics with the same tag-extracted name must be rendered in a single group, which makes
+   * groups the unit in which StatsRequest streams Prometheus output.
+   * @param tag_extracted_name the tag-extracted name shared by the metrics.
+   * @param metrics the metrics in the group, which are sorted by name.
+   * @param response the buffer to append the output to.
+   * @param custom_namespaces namespace mappings used for the metric name.
+   * @return whether the group was rendered; it is skipped if it has no valid metric name.
+   */
+  static bool metricGroupAsPrometheus(const std::string& tag_extracted_name,
+                                      std::vector<const Stats::Counter*>& metrics,
+                                      Buffer::Instance& response,
+                                      const Stats::CustomStatNamespaces& custom_namespaces);
+  static bool metricGroupAsPrometheus(const std::string& tag_extracted_name,
+                                      std::vector<const Stats::Gauge*>& metrics,
+                                      Buffer::Instance& response,
+                                      const Stats::CustomStatNamespaces& custom_namespaces);
+  static bool metricGroupAsPrometheus(const std::string& tag_extracted_name,
+                                      std::vector<const Stats::TextReadout*>& metrics,
+                                      Buffer::Instance& response,
+                                      const Stats::CustomStatNamespaces& custom_namespaces);
+  static bool metricGroupAsPrometheus(const std::string& tag_extracted_name,
+                                      std::vector<const Stats::ParentHistogram*>& metrics,
+                                      Buffer::Instance& response,
+                                      const Stats::CustomStatNamespaces& custom_namespaces);
+
   /**
    * Format the given tags, returning a string as a comma-separated list
    * of <tag_name>="<tag_value>" pairs.
@@ -33,66 +33,47 @@ public:
                                               Buffer::Instance& response, AdminStream&);
   Http::Code handlerStatsRecentLookupsEnable(Http::ResponseHeaderMap& response_headers,
                                              Buffer::Instance& response, AdminStream&);
-  Http::Code handlerPrometheusStats(Http::ResponseHeaderMap& response_headers,
-                                    Buffer::Instance& response, AdminStream&);
+  Http::Code handlerContention(Http::ResponseHeaderMap& response_headers,
+                               Buffer::Instance& response, AdminStream&);
 
   /**
-   * Parses and executes a prometheus stats request.
+   * When stats are rendered in HTML mode, we want users to be able to tweak
+   * parameters after the stats page is rendered, such as tweaking the filter or
+   * `usedonly`. We use the same stats UrlHandler both for the admin home page
+   * and for rendering in /stats?format=html. We share the same UrlHandler in
+   * both contexts by defining an API for it here.
    *
-   * @param path_and_query the URL path and query
-   * @param response buffer into which to write response
-   * @return http response code
+   * @return a URL handler for stats.
    */
-  Http::Code prometheusStats(absl::string_view path_and_query, Buffer::Instance& response);
+  Admin::UrlHandler statsHandler();
 
   /**
-   * Checks the server_ to see if a flush is needed, and then renders the
-   * prometheus stats request.
-   *
-   * @params params the already-parsed parameters.
-   * @param response buffer into which to write response
+   * @return a URL handler streaming stats in Prometheus format, regardless of
+   * the format query parameter.
    */
-  void prometheusFlushAndRender(const StatsParams& params, Buffer::Instance& response);
+  Admin::UrlHandler prometheusStatsHandler();
 
   /**
-   * Renders the stats as prometheus. This is broken out as a separately
+   * Creates a streaming stats request. This is broken out as a separately
    * callable API to facilitate the benchmark
    * (test/server/admin/stats_handler_speed_test.cc) which does not have a
    * server object.
    *
-   * @params stats the stats store to read
+   * @param stats the stats store to read
+   * @param params the already-parsed parameters.
    * @param custom_namespaces namespace mappings used for prometheus
-   * @params params the already-parsed parameters.
-   * @param response buffer into which to write response
+   * @param url_handler_fn supplies the handler used to render HTML controls.
+   * @return the request.
    */
-  static void prometheusRender(Stats::Store& stats,
-                               const Stats::CustomStatNamespaces& custom_namespaces,
-                               const StatsParams& params, Buffer::Instance& response);
-
-  Http::Code handlerContention(Http::ResponseHeaderMap& response_headers,
-                               Buffer::Instance& response, AdminStream&);
-
-  /**
-   * When stats are rendered in HTML mode, we want users to be able to tweak
-   * parameters after the stats page is rendered, such as tweaking the filter or
-   * `usedonly`. We use the same stats UrlHandler both for the admin home page
-   * and for rendering in /stats?format=html. We share the same UrlHandler in
-   * both contexts by defining an API for it here.
-   *
-   * @return a URL handler for stats.
-   */
-  Admin::UrlHandler statsHandler();
-
   static Admin::RequestPtr makeRequest(Stats::Store& stats, const StatsParams& params,
+                                       const Stats::CustomStatNamespaces& custom_namespaces,
                                        StatsRequest::UrlHandlerFn url_handler_fn = nullptr);
   Admin::RequestPtr makeRequest(AdminStream&);
-  // static Admin::RequestPtr makeRequest(Stats::Store& stats, const StatsParams& params,
-  //                                     StatsRequest::UrlHandlerFn url_handler_fn);
+  Admin::RequestPtr makePrometheusRequest(AdminStream&);
 
 private:
-  static Http::Code prometheusStats(absl::string_view path_and_query, Buffer::Instance& response,
-                                    Stats::Store& stats,
-                                    Stats::CustomStatNamespaces& custom_namespaces);
+  // Flushes stats if configured to on admin requests, and creates the request.
+  Admin::RequestPtr makeFlushedRequest(const StatsParams& params);
 };
 
 } // namespace Server
@@ -1,5 +1,9 @@
 #include "source/server/admin/stats_request.h"
 
+#include <algorithm>
+
+#include "source/server/admin/prometheus_stats.h"
+
 #ifdef ENVOY_ADMIN_HTML
 #include "source/server/admin/stats_html_render.h"
 #endif
@@ -8,8 +12,14 @@ namespace Envoy {
 namespace Server {
 
 StatsRequest::StatsRequest(Stats::Store& stats, const StatsParams& params,
+                           const Stats::CustomStatNamespaces& custom_namespaces,
                            UrlHandlerFn url_handler_fn)
-    : params_(params), stats_(stats), url_handler_fn_(url_handler_fn) {
+    : params_(params), stats_(stats), url_handler_fn_(url_handler_fn),
+      custom_namespaces_(custom_namespaces),
+      counter_groups_(Stats::StatNameLessThan(stats.symbolTable())),
+      gauge_groups_(Stats::StatNameLessThan(stats.symbolTable())),
+      text_readout_groups_(Stats::StatNameLessThan(stats.symbolTable())),
+      histogram_groups_(Stats::StatNameLessThan(stats.symbolTable())) {
   switch (params_.type_) {
   case StatsType::TextReadouts:
   case StatsType::All:
@@ -46,9 +56,9 @@ Http::Code StatsRequest::start(Http::ResponseHeaderMap& response_headers) {
   }
 #endif
   case StatsFormat::Prometheus:
-    // TODO(#16139): once Prometheus shares this algorithm here, this becomes a legitimate choice.
-    IS_ENVOY_BUG("reached Prometheus case in switch unexpectedly");
-    return Http::Code::BadRequest;
+    // Prometheus groups are rendered directly by PrometheusStatsFormatter, as
+    // the StatsRender interface renders one named value at a time.
+    break;
   }
 
   // Populate the top-level scopes and the stats underneath any scopes with an empty name.
@@ -60,7 +70,11 @@ Http::Code StatsRequest::start(Http::ResponseHeaderMap& response_headers) {
       [this](size_t s) { scopes_.reserve(s); },
       [this](const Stats::Scope& scope) { scopes_.emplace_back(scope.getConstShared()); });
 
-  startPhase();
+  if (params_.format_ == StatsFormat::Prometheus) {
+    startPrometheusPhase();
+  } else {
+    startPhase();
+  }
   return Http::Code::OK;
 }
 
@@ -71,6 +85,10 @@ bool StatsRequest::nextChunk(Buffer::Instance& response) {
     ASSERT(response_.length() == 0);
   }
 
+  if (params_.format_ == StatsFormat::Prometheus) {
+    return nextPrometheusChunk(response);
+  }
+
   // nextChunk's contract is to add up to chunk_size_ additional bytes. The
   // caller is not required to drain the bytes after each call to nextChunk.
   const uint64_t starting_response_length = response.length();
@@ -192,12 +210,7 @@ template <class StatType> void StatsRequest::populateStatsFromScopes(const Scope
     // differs in that Prometheus only uses stat->name() for filtering, not
     // rendering, so it only grab the name if there's a filter.
     std::string name = stat->name();
-    if (params_.filter_ != nullptr) {
-      if (!std::regex_search(name, *params_.filter_)) {
-        return true;
-      }
-    } else if (params_.re2_filter_ != nullptr &&
-               !re2::RE2::PartialMatch(name, *params_.re2_filter_)) {
+    if (!matchesFilter(name)) {
       return true;
     }
     stat_map_[name] = stat;
@@ -208,6 +221,13 @@ template <class StatType> void StatsRequest::populateStatsFromScopes(const Scope
   }
 }
 
+bool StatsRequest::matchesFilter(const std::string& name) const {
+  if (params_.filter_ != nullptr) {
+    return std::regex_search(name, *params_.filter_);
+  }
+  return params_.re2_filter_ == nullptr || re2::RE2::PartialMatch(name, *params_.re2_filter_);
+}
+
 template <class SharedStatType>
 void StatsRequest::renderStat(const std::string& name, Buffer::Instance& response,
                               StatOrScopes& variant) {
@@ -215,5 +235,116 @@ void StatsRequest::renderStat(const std::string& name, Buffer::Instance& respons
   render_->generate(response, name, stat->value());
 }
 
+bool StatsRequest::nextPrometheusChunk(Buffer::Instance& response) {
+  // As for the other formats, add up to chunk_size_ additional bytes. Groups
+  // are never split, so a chunk may exceed chunk_size_ by up to one group.
+  const uint64_t starting_response_length = response.length();
+  while (response.length() - starting_response_length < chunk_size_) {
+    bool rendered = false;
+    switch (prometheus_phase_) {
+    case PrometheusPhase::Counters:
+      rendered = renderPrometheusGroup(counter_groups_, response);
+      break;
+    case PrometheusPhase::Gauges:
+      rendered = renderPrometheusGroup(gauge_groups_, response);
+      break;
+    case PrometheusPhase::TextReadouts:
+      rendered = renderPrometheusGroup(text_readout_groups_, response);
+      break;
+    case PrometheusPhase::Histograms:
+      rendered = renderPrometheusGroup(histogram_groups_, response);
+      break;
+    }
+    if (rendered) {
+      continue;
+    }
+
+    switch (prometheus_phase_) {
+    case PrometheusPhase::Counters:
+      prometheus_phase_ = PrometheusPhase::Gauges;
+      break;
+    case PrometheusPhase::Gauges:
+      // Text readouts are rendered as gauges, which is opt-in as it increases
+      // the size of the output.
+      prometheus_phase_ = params_.prometheus_text_readouts_ ? PrometheusPhase::TextReadouts
+                                                            : PrometheusPhase::Histograms;
+      break;
+    case PrometheusPhase::TextReadouts:
+      prometheus_phase_ = PrometheusPhase::Histograms;
+      break;
+    case PrometheusPhase::Histograms:
+      return false;
+    }
+    startPrometheusPhase();
+  }
+  return true;
+}
+
+void StatsRequest::startPrometheusPhase() {
+  switch (prometheus_phase_) {
+  case PrometheusPhase::Counters:
+    populatePrometheusGroups<Stats::Counter>(counter_groups_);
+    break;
+  case PrometheusPhase::Gauges:
+    populatePrometheusGroups<Stats::Gauge>(gauge_groups_);
+    break;
+  case PrometheusPhase::TextReadouts:
+    populatePrometheusGroups<Stats::TextReadout>(text_readout_groups_);
+    break;
+  case PrometheusPhase::Histograms:
+    populatePrometheusGroups<Stats::Histogram, Stats::ParentHistogram>(histogram_groups_);
+    break;
+  }
+}
+
+template <class StatType, class GroupStatType>
+void StatsRequest::populatePrometheusGroups(PrometheusGroups<GroupStatType>& groups) {
+  ASSERT(groups.empty());
+  using SharedStatType = Stats::RefcountPtr<StatType>;
+  Stats::IterateFn<StatType> add_stat = [this, &groups](const SharedStatType& stat) -> bool {
+    if (params_.used_only_ && !stat->used()) {
+      return true;
+    }
+
+    // Prometheus renders the tags rather than the name, so the name is only
+    // built if it is needed for filtering.
+    if ((params_.filter_ != nullptr || params_.re2_filter_ != nullptr) &&
+        !matchesFilter(stat->name())) {
+      return true;
+    }
+    GroupStatType* group_stat = dynamic_cast<GroupStatType*>(stat.get());
+    if (group_stat != nullptr) {
+      groups[group_stat->tagExtractedStatName()].emplace_back(group_stat);
+    }
+    return true;
+  };
+  for (const Stats::ConstScopeSharedPtr& scope : scopes_) {
+    scope->iterate(add_stat);
+  }
+}
+
+template <class StatType>
+bool StatsRequest::renderPrometheusGroup(PrometheusGroups<StatType>& groups,
+                                         Buffer::Instance& response) {
+  if (groups.empty()) {
+    return false;
+  }
+
+  auto iter = groups.begin();
+  std::vector<const StatType*> metrics;
+  metrics.reserve(iter->second.size());
+  for (const Stats::RefcountPtr<StatType>& metric : iter->second) {
+    metrics.push_back(metric.get());
+  }
+  // Scopes with the same name share their stats, which are then collected once
+  // for each of those scopes.
+  std::sort(metrics.begin(), metrics.end());
+  metrics.erase(std::unique(metrics.begin(), metrics.end()), metrics.end());
+  PrometheusStatsFormatter::metricGroupAsPrometheus(stats_.symbolTable().toString(iter->first),
+                                                    metrics, response, custom_namespaces_);
+  groups.erase(iter);
+  return true;
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "envoy/server/admin.h"
+#include "envoy/stats/custom_stat_namespaces.h"
 
+#include "source/common/stats/symbol_table.h"
 #include "source/server/admin/stats_params.h"
 #include "source/server/admin/stats_render.h"
 #include "source/server/admin/utils.h"
@@ -34,12 +36,33 @@ class StatsRequest : public Admin::Request {
     Histograms,
   };
 
+  // Prometheus requires all stats sharing a tag-extracted name to be emitted as
+  // one group, with counters, gauges, text readouts and histograms in separate
+  // passes. Tag-extracted names don't follow the scope hierarchy, so scopes
+  // can't be expanded lazily as they are for the other formats. Instead, each
+  // phase collects the stats of its type from all scopes, grouped by
+  // tag-extracted name, and nextChunk renders whole groups until the chunk is
+  // full. This holds references to the stats of one type at a time, rather than
+  // buffering the serialized output of all of them.
+  enum class PrometheusPhase {
+    Counters,
+    Gauges,
+    TextReadouts,
+    Histograms,
+  };
+
+  template <class StatType>
+  using PrometheusGroups =
+      absl::btree_map<Stats::StatName, std::vector<Stats::RefcountPtr<StatType>>,
+                      Stats::StatNameLessThan>;
+
 public:
   using UrlHandlerFn = std::function<Admin::UrlHandler()>;
 
   static constexpr uint64_t DefaultChunkSize = 2 * 1000 * 1000;
 
   StatsRequest(Stats::Store& stats, const StatsParams& params,
+               const Stats::CustomStatNamespaces& custom_namespaces,
                UrlHandlerFn url_handler_fn = nullptr);
 
   // Admin::Request
@@ -101,6 +124,27 @@ public:
   void setChunkSize(uint64_t chunk_size) { chunk_size_ = chunk_size; }
 
 private:
+  // Returns whether a stat named `name` passes the filter in the request parameters.
+  bool matchesFilter(const std::string& name) const;
+
+  // Streams out the next chunk of Prometheus groups, moving on to the next
+  // phase whenever the groups of the current one have all been rendered.
+  bool nextPrometheusChunk(Buffer::Instance& response);
+
+  // Collects the groups of stats for the current Prometheus phase.
+  void startPrometheusPhase();
+
+  // Groups the StatType stats of all scopes by tag-extracted name. Histograms
+  // are grouped as GroupStatType, which is the ParentHistogram the Prometheus
+  // formatter needs.
+  template <class StatType, class GroupStatType = StatType>
+  void populatePrometheusGroups(PrometheusGroups<GroupStatType>& groups);
+
+  // Renders and removes the first group in `groups`.
+  // @return false if there are no groups left to render.
+  template <class StatType>
+  bool renderPrometheusGroup(PrometheusGroups<StatType>& groups, Buffer::Instance& response);
+
   StatsParams params_;
   std::unique_ptr<StatsRender> render_;
   Stats::Store& stats_;
@@ -112,6 +156,12 @@ private:
   Buffer::OwnedImpl response_;
   UrlHandlerFn url_handler_fn_;
   uint64_t chunk_size_{DefaultChunkSize};
+  const Stats::CustomStatNamespaces& custom_namespaces_;
+  PrometheusPhase prometheus_phase_{PrometheusPhase::Counters};
+  PrometheusGroups<Stats::Counter> counter_groups_;
+  PrometheusGroups<Stats::Gauge> gauge_groups_;
+  PrometheusGroups<Stats::TextReadout> text_readout_groups_;
+  PrometheusGroups<Stats::ParentHistogram> histogram_groups_;
 };
 
 } // namespace Server
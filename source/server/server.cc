@@ -26,6 +26,7 @@
 
 #include "source/common/api/api_impl.h"
 #include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/mutex_tracer_impl.h"
 #include "source/common/common/utility.h"
@@ -274,6 +275,12 @@ void InstanceImpl::updateServerStats() {
                                        parent_stats.parent_memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
   server_stats_->memory_physical_size_.set(Memory::Stats::totalPhysicalBytes());
+  const Buffer::SlicePool::Stats slice_pool_stats = Buffer::SlicePool::stats();
+  server_stats_->buffer_slice_pool_hits_.add(slice_pool_stats.hits_ -
+                                             server_stats_->buffer_slice_pool_hits_.value());
+  server_stats_->buffer_slice_pool_misses_.add(slice_pool_stats.misses_ -
+                                               server_stats_->buffer_slice_pool_misses_.value());
+  server_stats_->buffer_slice_pool_bytes_.set(slice_pool_stats.pooled_bytes_);
   server_stats_->parent_connections_.set(parent_stats.parent_connections_);
   server_stats_->total_connections_.set(listener_manager_->numConnections() +
                                         parent_stats.parent_connections_);
@@ -2,6 +2,7 @@
 #include "envoy/http/stream_reset_handler.h"
 
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/buffer/watermark_buffer.h"
 #include "source/common/common/assert.h"
 
@@ -343,6 +344,33 @@ BENCHMARK(bufferReserveCommitPartial)
     ->Arg(64 * 1024)
     ->Arg(128 * 1024);
 
+// Test the read cycle of a proxied connection: reserve for read, commit what the socket returned,
+// move the data to the buffer of the other connection and drain it once written. state.range(0) is
+// the number of bytes read per cycle and state.range(1) is whether slice storage is pooled. The
+// counters report the slice pool hits and misses per cycle.
+static void bufferReadDrainCycle(benchmark::State& state) {
+  const uint64_t read_size = state.range(0);
+  Buffer::SlicePool::setMaxBytesPerThread(
+      state.range(1) ? Buffer::SlicePool::DefaultMaxBytesPerThread : 0);
+  const Buffer::SlicePool::Stats start = Buffer::SlicePool::stats();
+  Buffer::OwnedImpl read_buffer;
+  Buffer::OwnedImpl write_buffer;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    Buffer::Reservation reservation = read_buffer.reserveForRead();
+    reservation.commit(read_size);
+    write_buffer.move(read_buffer);
+    write_buffer.drain(write_buffer.length());
+  }
+  const Buffer::SlicePool::Stats end = Buffer::SlicePool::stats();
+  state.counters["pool_hits"] =
+      benchmark::Counter(end.hits_ - start.hits_, benchmark::Counter::kAvgIterations);
+  state.counters["pool_misses"] =
+      benchmark::Counter(end.misses_ - start.misses_, benchmark::Counter::kAvgIterations);
+  Buffer::SlicePool::setMaxBytesPerThread(Buffer::SlicePool::DefaultMaxBytesPerThread);
+}
+BENCHMARK(bufferReadDrainCycle)->ArgsProduct({{1024, 16 * 1024, 64 * 1024}, {0, 1}});
+
 // Test the linearization of a buffer in the best case where the data is in one slice.
 static void bufferLinearizeSimple(benchmark::State& state) {
   const std::string data(state.range(0), 'a');
@@ -0,0 +1,122 @@
+#include <thread>
+
+#include "source/common/buffer/slice_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+class SlicePoolTest : public testing::Test {
+protected:
+  // The pool of the test thread may hold storage from earlier tests, so each test starts with an
+  // empty pool.
+  void SetUp() override {
+    SlicePool::setMaxBytesPerThread(0);
+    SlicePool::release(SlicePool::allocate(16384), 16384);
+    SlicePool::setMaxBytesPerThread(SlicePool::DefaultMaxBytesPerThread);
+    start_ = SlicePool::stats();
+  }
+
+  void TearDown() override {
+    SlicePool::setMaxBytesPerThread(SlicePool::DefaultMaxBytesPerThread);
+  }
+
+  uint64_t hits() { return SlicePool::stats().hits_ - start_.hits_; }
+  uint64_t misses() { return SlicePool::stats().misses_ - start_.misses_; }
+
+  SlicePool::Stats start_;
+};
+
+TEST_F(SlicePoolTest, RecyclesStorage) {
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+  uint8_t* mem = SlicePool::allocate(16384);
+  EXPECT_EQ(1, misses());
+  SlicePool::release(mem, 16384);
+  EXPECT_EQ(16384, SlicePool::stats().pooled_bytes_);
+
+  EXPECT_EQ(mem, SlicePool::allocate(16384));
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+  SlicePool::release(mem, 16384);
+}
+
+TEST_F(SlicePoolTest, SizeClasses) {
+  uint8_t* mem = SlicePool::allocate(8192);
+  SlicePool::release(mem, 8192);
+
+  // Storage is only reused for the same size.
+  uint8_t* other = SlicePool::allocate(16384);
+  EXPECT_EQ(2, misses());
+  EXPECT_EQ(mem, SlicePool::allocate(8192));
+  EXPECT_EQ(1, hits());
+  SlicePool::release(mem, 8192);
+  SlicePool::release(other, 16384);
+  EXPECT_EQ(8192 + 16384, SlicePool::stats().pooled_bytes_);
+}
+
+TEST_F(SlicePoolTest, UnpooledSizes) {
+  for (const uint64_t size : {100, 4097, 65536 + 4096, 1024 * 1024}) {
+    SlicePool::release(SlicePool::allocate(size), size);
+  }
+  EXPECT_EQ(0, hits());
+  EXPECT_EQ(0, misses());
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+}
+
+TEST_F(SlicePoolTest, MaxBytesPerThread) {
+  SlicePool::setMaxBytesPerThread(2 * 16384);
+  uint8_t* mem[3];
+  for (auto& m : mem) {
+    m = SlicePool::allocate(16384);
+  }
+  for (auto& m : mem) {
+    SlicePool::release(m, 16384);
+  }
+  EXPECT_EQ(2 * 16384, SlicePool::stats().pooled_bytes_);
+
+  // Lowering the limit frees the excess of the calling thread right away.
+  SlicePool::setMaxBytesPerThread(16384);
+  EXPECT_EQ(16384, SlicePool::stats().pooled_bytes_);
+  SlicePool::setMaxBytesPerThread(0);
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+}
+
+TEST_F(SlicePoolTest, OtherThreadsTrimOnRelease) {
+  uint8_t* mem[2];
+  for (auto& m : mem) {
+    m = SlicePool::allocate(16384);
+  }
+  for (auto& m : mem) {
+    SlicePool::release(m, 16384);
+  }
+
+  std::thread thread([]() { SlicePool::setMaxBytesPerThread(0); });
+  thread.join();
+  EXPECT_EQ(2 * 16384, SlicePool::stats().pooled_bytes_);
+
+  // Allocations don't trim the pool, the next release frees the excess.
+  uint8_t* hit = SlicePool::allocate(16384);
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(16384, SlicePool::stats().pooled_bytes_);
+  SlicePool::release(hit, 16384);
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+}
+
+TEST_F(SlicePoolTest, ThreadExit) {
+  std::thread thread([]() {
+    SlicePool::release(SlicePool::allocate(16384), 16384);
+    SlicePool::release(SlicePool::allocate(16384), 16384);
+  });
+  thread.join();
+
+  // The storage of the exited thread is freed and its counters are kept.
+  EXPECT_EQ(1, hits());
+  EXPECT_EQ(1, misses());
+  EXPECT_EQ(0, SlicePool::stats().pooled_bytes_);
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
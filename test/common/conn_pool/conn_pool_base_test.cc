@@ -353,6 +353,56 @@ TEST_F(ConnPoolImplBaseTest, ExplicitPreconnectNotHealthy) {
   EXPECT_FALSE(pool_.maybePreconnectImpl(1));
 }
 
+TEST_F(ConnPoolImplBaseTest, AdaptivePreconnect) {
+  MonotonicTime now;
+  ON_CALL(dispatcher_, approximateMonotonicTime()).WillByDefault(Invoke([&]() { return now; }));
+  ON_CALL(*cluster_, adaptivePreconnectWindow)
+      .WillByDefault(Return(std::chrono::milliseconds(1000)));
+  Upstream::ClusterTrafficStats& traffic_stats = *pool_.host()->cluster().trafficStats();
+
+  // Without any connect time yet, only the connection for the stream is created.
+  EXPECT_CALL(pool_, instantiateActiveClient);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(0 /*active*/, 1 /*pending*/, 1 /*connecting capacity*/);
+
+  // The first connection takes a second to connect.
+  now += std::chrono::seconds(1);
+  EXPECT_CALL(pool_, onPoolReady);
+  clients_[0]->onEvent(Network::ConnectionEvent::Connected);
+  clients_[0]->active_streams_--;
+  pool_.onStreamClosed(*clients_[0], false);
+  CHECK_STATE(0 /*active*/, 0 /*pending*/, 1 /*connecting capacity*/);
+
+  // Another stream arrives within the window. One more stream is expected to arrive while a new
+  // connection is established, so a connection is created ahead of demand.
+  EXPECT_CALL(pool_, onPoolReady);
+  EXPECT_CALL(pool_, instantiateActiveClient);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(1 /*active*/, 0 /*pending*/, 1 /*connecting capacity*/);
+
+  // The preconnected connection serves the next stream. With the higher arrival rate, two more
+  // streams are expected while a new connection is established.
+  now += std::chrono::milliseconds(100);
+  clients_[1]->onEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(pool_, onPoolReady);
+  EXPECT_CALL(pool_, instantiateActiveClient).Times(2);
+  pool_.newStreamImpl(context_, /*can_send_early_data=*/false);
+  CHECK_STATE(2 /*active*/, 0 /*pending*/, 2 /*connecting capacity*/);
+  EXPECT_EQ(1, traffic_stats.upstream_cx_preconnect_hit_.value());
+  EXPECT_EQ(0, traffic_stats.upstream_cx_preconnect_waste_.value());
+
+  // Once the streams are done, nothing is expected anymore. The connections which were
+  // preconnected but never used are wasted.
+  for (int i = 0; i < 2; ++i) {
+    clients_[i]->active_streams_--;
+    pool_.onStreamClosed(*clients_[i], false);
+  }
+  EXPECT_CALL(pool_, instantiateActiveClient).Times(0);
+  pool_.destructAllConnections();
+  EXPECT_EQ(1, traffic_stats.upstream_cx_preconnect_hit_.value());
+  EXPECT_EQ(2, traffic_stats.upstream_cx_preconnect_waste_.value());
+}
+
 TEST_F(ConnPoolImplDispatcherBaseTest, MaxConnectionDurationTimerNull) {
   // Force a null max connection duration optional.
   // newActiveClientAndStream() will expect the connection duration timer to remain null.
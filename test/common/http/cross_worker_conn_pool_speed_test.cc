@@ -0,0 +1,193 @@
+// Usage: bazel run //test/common/http:cross_worker_conn_pool_speed_test
+//
+// Measures the latency a request and its response add when a worker hands its streams over to the
+// HTTP/2 connections of another worker running on its own thread, compared to streams on the pool
+// of the worker. The upstream responds right away, so the difference is the cost of the four
+// thread hops of a request without a body. The local_pools counter is the number of pools, each
+// with its own connections to the host, all the workers need.
+
+#include <atomic>
+#include <memory>
+
+#include "source/common/http/cross_worker_conn_pool.h"
+#include "source/common/http/header_map_impl.h"
+
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+// A pool whose streams are ready right away, and respond as soon as the request ends.
+class InstantPool : public ConnectionPool::Instance {
+public:
+  InstantPool(Upstream::HostConstSharedPtr host, TimeSource& time_source)
+      : host_(std::move(host)), stream_info_(time_source, nullptr) {
+    ON_CALL(encoder_.stream_, addCallbacks(_)).WillByDefault(Return());
+    ON_CALL(encoder_, encodeHeaders(_, _))
+        .WillByDefault(Invoke([this](const RequestHeaderMap&, bool end_stream) -> Status {
+          if (end_stream) {
+            auto headers = ResponseHeaderMapImpl::create();
+            headers->setStatus(200);
+            decoder_->decodeHeaders(std::move(headers), true);
+          }
+          return okStatus();
+        }));
+  }
+
+  // ConnectionPool::Instance
+  void addIdleCallback(IdleCb) override {}
+  bool isIdle() const override { return false; }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior) override {}
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+  bool hasActiveConnections() const override { return true; }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& decoder,
+                                         ConnectionPool::Callbacks& callbacks,
+                                         const Instance::StreamOptions&) override {
+    decoder_ = &decoder;
+    callbacks.onPoolReady(encoder_, host_, stream_info_, Protocol::Http2);
+    return nullptr;
+  }
+  absl::string_view protocolDescription() const override { return "HTTP/2"; }
+
+private:
+  const Upstream::HostConstSharedPtr host_;
+  StreamInfo::StreamInfoImpl stream_info_;
+  NiceMock<MockRequestEncoder> encoder_;
+  ResponseDecoder* decoder_{};
+};
+
+// Sends a request without a body once the stream is ready, and exits the dispatcher of its worker
+// once the response is complete.
+class Client : public ResponseDecoder, public ConnectionPool::Callbacks {
+public:
+  Client(Event::Dispatcher& dispatcher, bool exit_on_response)
+      : dispatcher_(dispatcher), exit_on_response_(exit_on_response) {
+    request_headers_.setMethod("GET");
+    request_headers_.setPath("/");
+    request_headers_.setHost("host");
+    request_headers_.setScheme("http");
+  }
+
+  // Http::StreamDecoder
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ResponseDecoder
+  void decode1xxHeaders(ResponseHeaderMapPtr&&) override {}
+  void decodeHeaders(ResponseHeaderMapPtr&&, bool end_stream) override {
+    if (end_stream) {
+      done_ = true;
+      if (exit_on_response_) {
+        dispatcher_.exit();
+      }
+    }
+  }
+  void decodeTrailers(ResponseTrailerMapPtr&&) override {}
+  void dumpState(std::ostream&, int) const override {}
+
+  // ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason, absl::string_view,
+                     Upstream::HostDescriptionConstSharedPtr) override {
+    RELEASE_ASSERT(false, "unexpected pool failure");
+  }
+  void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                   StreamInfo::StreamInfo&, absl::optional<Protocol>) override {
+    RELEASE_ASSERT(encoder.encodeHeaders(request_headers_, true).ok(), "");
+  }
+
+  bool done_{};
+
+private:
+  Event::Dispatcher& dispatcher_;
+  const bool exit_on_response_;
+  TestRequestHeaderMapImpl request_headers_;
+};
+
+// Args: whether the streams are handed over to another worker, number of workers. The streams are
+// sent by one of the workers, the others only create their pool for the host.
+void bmRequestLatency(::benchmark::State& state) {
+  const bool shared = state.range(0) != 0;
+  const uint64_t num_workers = state.range(1);
+
+  Api::ApiPtr api = Api::createApiForTest();
+  auto host = std::make_shared<NiceMock<Upstream::MockHost>>();
+  auto registry = std::make_shared<CrossWorkerConnPoolRegistry>();
+  const CrossWorkerConnPoolRegistry::Key key{host.get(), Upstream::ResourcePriority::Default, {}};
+  std::atomic<uint64_t> local_pools{0};
+  auto create_pool = [&](Event::Dispatcher& dispatcher) -> ConnectionPool::InstancePtr {
+    auto local_pool_factory = [&, time_source = &dispatcher.timeSource()]() {
+      local_pools++;
+      return ConnectionPool::InstancePtr{std::make_unique<InstantPool>(host, *time_source)};
+    };
+    if (!shared) {
+      return local_pool_factory();
+    }
+    return std::make_unique<CrossWorkerConnPool>(dispatcher, host, registry, key,
+                                                 local_pool_factory);
+  };
+
+  // The owner of the shared connections runs on its own thread.
+  Event::DispatcherPtr owner_dispatcher = api->allocateDispatcher("owner");
+  ConnectionPool::InstancePtr owner_pool;
+  Thread::ThreadPtr owner_thread = api->threadFactory().createThread(
+      [&]() { owner_dispatcher->run(Event::Dispatcher::RunType::RunUntilExit); });
+  if (shared) {
+    absl::Notification created;
+    owner_dispatcher->post([&]() {
+      owner_pool = create_pool(*owner_dispatcher);
+      created.Notify();
+    });
+    created.WaitForNotification();
+  }
+
+  std::vector<Event::DispatcherPtr> worker_dispatchers;
+  std::vector<ConnectionPool::InstancePtr> worker_pools;
+  for (uint64_t i = 0; i < num_workers - (shared ? 1 : 0); i++) {
+    worker_dispatchers.push_back(api->allocateDispatcher(absl::StrCat("worker_", i)));
+    worker_pools.push_back(create_pool(*worker_dispatchers.back()));
+  }
+
+  Event::Dispatcher& dispatcher = *worker_dispatchers[0];
+  Client client(dispatcher, shared);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    client.done_ = false;
+    worker_pools[0]->newStream(client, client, {false, false});
+    if (!client.done_) {
+      dispatcher.run(Event::Dispatcher::RunType::RunUntilExit);
+    }
+  }
+  state.counters["local_pools"] = local_pools.load();
+
+  dispatcher.run(Event::Dispatcher::RunType::NonBlock);
+  worker_pools.clear();
+  absl::Notification destroyed;
+  owner_dispatcher->post([&]() {
+    owner_pool.reset();
+    destroyed.Notify();
+  });
+  destroyed.WaitForNotification();
+  owner_dispatcher->exit();
+  owner_thread->join();
+}
+BENCHMARK(bmRequestLatency)
+    ->Args({0, 2})
+    ->Args({1, 2})
+    ->Args({0, 16})
+    ->Args({1, 16})
+    ->Unit(::benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
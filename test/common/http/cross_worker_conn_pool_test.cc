@@ -0,0 +1,428 @@
+#include <functional>
+#include <memory>
+
+#include "envoy/config/overload/v3/overload.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/watermark_buffer.h"
+#include "source/common/http/cross_worker_conn_pool.h"
+
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/common.h"
+#include "test/mocks/http/conn_pool.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/http/stream_decoder.h"
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/http/stream_reset_handler.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+class CrossWorkerConnPoolTest : public testing::Test {
+public:
+  CrossWorkerConnPoolTest()
+      : api_(Api::createApiForTest()), owner_dispatcher_(api_->allocateDispatcher("owner")),
+        worker_dispatcher_(api_->allocateDispatcher("worker")),
+        registry_(std::make_shared<CrossWorkerConnPoolRegistry>()) {}
+
+  ~CrossWorkerConnPoolTest() override {
+    // Streams still in flight are reset by the pools, which is handed over to the other side.
+    worker_pool_.reset();
+    runDispatchers();
+    owner_pool_.reset();
+    runDispatchers();
+  }
+
+  std::unique_ptr<CrossWorkerConnPool> createPool(Event::Dispatcher& dispatcher) {
+    return std::make_unique<CrossWorkerConnPool>(
+        dispatcher, host_, registry_,
+        CrossWorkerConnPoolRegistry::Key{host_.get(), Upstream::ResourcePriority::Default, {}},
+        [this]() {
+          auto pool = std::make_unique<NiceMock<ConnectionPool::MockInstance>>();
+          local_pools_.push_back(pool.get());
+          return pool;
+        });
+  }
+
+  // Creates the owner's pool, then the pool of the worker which hands its streams over.
+  void createPools() {
+    owner_pool_ = createPool(*owner_dispatcher_);
+    worker_pool_ = createPool(*worker_dispatcher_);
+    ASSERT_EQ(1, local_pools_.size());
+  }
+
+  // Runs both dispatchers until all the events handed over in both directions are processed.
+  void runDispatchers() {
+    for (int i = 0; i < 4; i++) {
+      owner_dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      worker_dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  // Starts a stream on the worker and expects it on the owner's local pool.
+  ConnectionPool::Cancellable* newWorkerStream() {
+    EXPECT_CALL(*local_pools_[0], newStream(_, _, _))
+        .WillOnce(Invoke([this](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks,
+                                const ConnectionPool::Instance::StreamOptions&) {
+          owner_decoder_ = &decoder;
+          owner_callbacks_ = &callbacks;
+          return &owner_cancellable_;
+        }));
+    ConnectionPool::Cancellable* cancellable =
+        worker_pool_->newStream(worker_decoder_, worker_callbacks_, {false, false});
+    EXPECT_NE(nullptr, cancellable);
+    runDispatchers();
+    EXPECT_NE(nullptr, owner_callbacks_);
+    return cancellable;
+  }
+
+  // Makes the owner's stream ready and returns the encoder the worker gets.
+  RequestEncoder& readyWorkerStream() {
+    RequestEncoder* worker_encoder = nullptr;
+    EXPECT_CALL(worker_callbacks_, onPoolReady(_, _, _, _))
+        .WillOnce(Invoke([&](RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                             StreamInfo::StreamInfo&, absl::optional<Protocol> protocol) {
+          EXPECT_EQ(Protocol::Http2, protocol);
+          worker_encoder = &encoder;
+        }));
+    owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_stream_info_, Protocol::Http2);
+    runDispatchers();
+    EXPECT_NE(nullptr, worker_encoder);
+    EXPECT_NE(&owner_encoder_, worker_encoder);
+    worker_encoder->getStream().addCallbacks(worker_stream_callbacks_);
+    return *worker_encoder;
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr owner_dispatcher_;
+  Event::DispatcherPtr worker_dispatcher_;
+  CrossWorkerConnPoolRegistrySharedPtr registry_;
+  std::shared_ptr<NiceMock<Upstream::MockHost>> host_{
+      std::make_shared<NiceMock<Upstream::MockHost>>()};
+  std::vector<NiceMock<ConnectionPool::MockInstance>*> local_pools_;
+  std::unique_ptr<CrossWorkerConnPool> owner_pool_;
+  std::unique_ptr<CrossWorkerConnPool> worker_pool_;
+
+  NiceMock<MockResponseDecoder> worker_decoder_;
+  NiceMock<ConnectionPool::MockCallbacks> worker_callbacks_;
+  NiceMock<MockStreamCallbacks> worker_stream_callbacks_;
+
+  ResponseDecoder* owner_decoder_{};
+  ConnectionPool::Callbacks* owner_callbacks_{};
+  NiceMock<Envoy::ConnectionPool::MockCancellable> owner_cancellable_;
+  NiceMock<MockRequestEncoder> owner_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> owner_stream_info_;
+};
+
+// The pools of all the workers share the pool of the first one.
+TEST_F(CrossWorkerConnPoolTest, SharesOwnerPool) {
+  createPools();
+  EXPECT_TRUE(owner_pool_->isOwner());
+  EXPECT_FALSE(worker_pool_->isOwner());
+  auto other_worker_pool = createPool(*worker_dispatcher_);
+  EXPECT_FALSE(other_worker_pool->isOwner());
+  EXPECT_EQ(1, local_pools_.size());
+
+  // Streams of the owner go directly to its pool.
+  EXPECT_CALL(*local_pools_[0], newStream(_, _, _)).WillOnce(Return(nullptr));
+  EXPECT_EQ(nullptr, owner_pool_->newStream(worker_decoder_, worker_callbacks_, {false, false}));
+  EXPECT_EQ(0, host_->cluster_.traffic_stats_->upstream_rq_cross_worker_.value());
+}
+
+TEST_F(CrossWorkerConnPoolTest, RequestAndResponse) {
+  createPools();
+  newWorkerStream();
+  EXPECT_EQ(1, host_->cluster_.traffic_stats_->upstream_rq_cross_worker_.value());
+  EXPECT_FALSE(worker_pool_->isIdle());
+  RequestEncoder& encoder = readyWorkerStream();
+
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+  EXPECT_CALL(owner_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  EXPECT_TRUE(encoder.encodeHeaders(request_headers, false).ok());
+
+  // Without a memory account on the stream, the slices of the body are moved.
+  Buffer::OwnedImpl request_body(std::string(16384, 'a'));
+  const void* request_slice = request_body.frontSlice().mem_;
+  EXPECT_CALL(owner_encoder_, encodeData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) {
+        EXPECT_EQ(request_slice, data.frontSlice().mem_);
+        EXPECT_EQ(16384, data.length());
+        data.drain(data.length());
+      }));
+  encoder.encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+  runDispatchers();
+
+  EXPECT_CALL(worker_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(worker_decoder_, decodeData(BufferStringEqual("response"), true));
+  owner_decoder_->decodeHeaders(ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{
+                                    {":status", "200"}}},
+                                false);
+  Buffer::OwnedImpl response_body("response");
+  owner_decoder_->decodeData(response_body, true);
+  runDispatchers();
+  EXPECT_TRUE(worker_pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, CancelPendingStream) {
+  createPools();
+  ConnectionPool::Cancellable* cancellable = newWorkerStream();
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess));
+  cancellable->cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess);
+  EXPECT_TRUE(worker_pool_->isIdle());
+  runDispatchers();
+}
+
+// A stream which becomes ready while its cancellation is handed over is reset on the owner.
+TEST_F(CrossWorkerConnPoolTest, CancelRacesWithReady) {
+  createPools();
+  ConnectionPool::Cancellable* cancellable = newWorkerStream();
+  cancellable->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_stream_info_, Protocol::Http2);
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runDispatchers();
+}
+
+TEST_F(CrossWorkerConnPoolTest, PoolFailure) {
+  createPools();
+  newWorkerStream();
+  EXPECT_CALL(worker_callbacks_,
+              onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                            "connection refused", _));
+  owner_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                  "connection refused", host_);
+  runDispatchers();
+  EXPECT_TRUE(worker_pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, RemoteReset) {
+  createPools();
+  newWorkerStream();
+  readyWorkerStream();
+  EXPECT_CALL(worker_stream_callbacks_, onResetStream(StreamResetReason::RemoteReset, _));
+  owner_encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+  runDispatchers();
+  EXPECT_TRUE(worker_pool_->isIdle());
+}
+
+TEST_F(CrossWorkerConnPoolTest, LocalReset) {
+  createPools();
+  newWorkerStream();
+  RequestEncoder& encoder = readyWorkerStream();
+
+  // The reset callbacks of the worker run right away.
+  EXPECT_CALL(worker_stream_callbacks_, onResetStream(StreamResetReason::LocalReset, _));
+  encoder.getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(worker_pool_->isIdle());
+
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runDispatchers();
+}
+
+TEST_F(CrossWorkerConnPoolTest, Watermarks) {
+  createPools();
+  newWorkerStream();
+  readyWorkerStream();
+  EXPECT_CALL(worker_stream_callbacks_, onAboveWriteBufferHighWatermark());
+  owner_encoder_.stream_.runHighWatermarkCallbacks();
+  runDispatchers();
+  EXPECT_CALL(worker_stream_callbacks_, onBelowWriteBufferLowWatermark());
+  owner_encoder_.stream_.runLowWatermarkCallbacks();
+  runDispatchers();
+}
+
+// Once the owner is drained, the next worker which creates a stream becomes the owner.
+TEST_F(CrossWorkerConnPoolTest, NewOwnerAfterDrain) {
+  createPools();
+  owner_pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+
+  EXPECT_CALL(*local_pools_[0], newStream(_, _, _)).Times(0);
+  worker_pool_->newStream(worker_decoder_, worker_callbacks_, {false, false});
+  EXPECT_TRUE(worker_pool_->isOwner());
+  ASSERT_EQ(2, local_pools_.size());
+}
+
+// A stream handed over to an owner which is drained in the meantime goes to the new owner.
+TEST_F(CrossWorkerConnPoolTest, OwnerDrainedWhileHandedOver) {
+  createPools();
+  EXPECT_CALL(*local_pools_[0], newStream(_, _, _)).Times(0);
+  worker_pool_->newStream(worker_decoder_, worker_callbacks_, {false, false});
+  owner_pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+
+  owner_dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_FALSE(worker_pool_->isOwner());
+  worker_dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_TRUE(worker_pool_->isOwner());
+  ASSERT_EQ(2, local_pools_.size());
+
+  // The worker hands the stream over to itself.
+  EXPECT_CALL(*local_pools_[1], newStream(_, _, _)).WillOnce(Return(&owner_cancellable_));
+  runDispatchers();
+}
+
+TEST_F(CrossWorkerConnPoolTest, PoolDestroyedWithPendingStream) {
+  createPools();
+  newWorkerStream();
+  EXPECT_CALL(worker_callbacks_,
+              onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure, _, _));
+  worker_pool_.reset();
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::Default));
+  runDispatchers();
+}
+
+TEST_F(CrossWorkerConnPoolTest, OwnerIdleWaitsForRemoteStreams) {
+  createPools();
+  ReadyWatcher idle;
+  owner_pool_->addIdleCallback([&]() { idle.ready(); });
+  ON_CALL(*local_pools_[0], isIdle()).WillByDefault(Return(true));
+
+  newWorkerStream();
+  EXPECT_FALSE(owner_pool_->isIdle());
+  EXPECT_CALL(idle, ready());
+  EXPECT_CALL(worker_callbacks_, onPoolFailure(_, _, _));
+  owner_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::Timeout, "", host_);
+  EXPECT_TRUE(owner_pool_->isIdle());
+  runDispatchers();
+}
+
+// Runs the owner and the worker on threads of their own, like the workers of the server.
+class CrossWorkerConnPoolThreadsTest : public CrossWorkerConnPoolTest {
+public:
+  CrossWorkerConnPoolThreadsTest() {
+    config_.set_minimum_account_to_track_power_of_two(20);
+    owner_thread_ = startThread(*owner_dispatcher_);
+    worker_thread_ = startThread(*worker_dispatcher_);
+  }
+
+  ~CrossWorkerConnPoolThreadsTest() override {
+    runOn(*worker_dispatcher_, [this]() { worker_pool_.reset(); });
+    runOn(*owner_dispatcher_, [this]() { owner_pool_.reset(); });
+    owner_dispatcher_->exit();
+    worker_dispatcher_->exit();
+    owner_thread_->join();
+    worker_thread_->join();
+  }
+
+  Thread::ThreadPtr startThread(Event::Dispatcher& dispatcher) {
+    return api_->threadFactory().createThread(
+        [&dispatcher]() { dispatcher.run(Event::Dispatcher::RunType::RunUntilExit); });
+  }
+
+  // Runs the function on the thread of the dispatcher and waits for it.
+  void runOn(Event::Dispatcher& dispatcher, std::function<void()> function) {
+    absl::Notification done;
+    dispatcher.post([&function, &done]() {
+      function();
+      done.Notify();
+    });
+    done.WaitForNotification();
+  }
+
+  static uint64_t balance(const Buffer::BufferMemoryAccountSharedPtr& account) {
+    return static_cast<Buffer::BufferMemoryAccountImpl*>(account.get())->balance();
+  }
+
+  envoy::config::overload::v3::BufferFactoryConfig config_;
+  Thread::ThreadPtr owner_thread_;
+  Thread::ThreadPtr worker_thread_;
+};
+
+// The bodies of streams with a memory account are copied when handed over between the threads, so
+// that they are no longer charged to the account, which is only credited on its own thread.
+TEST_F(CrossWorkerConnPoolThreadsTest, HandOverAccountedBodies) {
+  Buffer::WatermarkBufferFactory factory(config_);
+  NiceMock<MockStreamResetHandler> worker_reset_handler;
+  NiceMock<MockStreamResetHandler> owner_reset_handler;
+  Buffer::BufferMemoryAccountSharedPtr worker_account =
+      factory.createAccount(worker_reset_handler);
+  Buffer::BufferMemoryAccountSharedPtr owner_account = factory.createAccount(owner_reset_handler);
+
+  runOn(*owner_dispatcher_, [this]() { owner_pool_ = createPool(*owner_dispatcher_); });
+  ASSERT_EQ(1, local_pools_.size());
+
+  absl::Notification stream_created;
+  EXPECT_CALL(*local_pools_[0], newStream(_, _, _))
+      .WillOnce(Invoke([&](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks,
+                           const ConnectionPool::Instance::StreamOptions&) {
+        owner_decoder_ = &decoder;
+        owner_callbacks_ = &callbacks;
+        stream_created.Notify();
+        return &owner_cancellable_;
+      }));
+  runOn(*worker_dispatcher_, [this]() {
+    worker_pool_ = createPool(*worker_dispatcher_);
+    EXPECT_NE(nullptr, worker_pool_->newStream(worker_decoder_, worker_callbacks_, {false, false}));
+  });
+  stream_created.WaitForNotification();
+
+  absl::Notification stream_ready;
+  RequestEncoder* encoder = nullptr;
+  EXPECT_CALL(worker_callbacks_, onPoolReady(_, _, _, _))
+      .WillOnce(Invoke([&](RequestEncoder& worker_encoder, Upstream::HostDescriptionConstSharedPtr,
+                           StreamInfo::StreamInfo&, absl::optional<Protocol>) {
+        encoder = &worker_encoder;
+        stream_ready.Notify();
+      }));
+  runOn(*owner_dispatcher_, [this]() {
+    owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_stream_info_, Protocol::Http2);
+  });
+  stream_ready.WaitForNotification();
+
+  ON_CALL(owner_encoder_.stream_, account()).WillByDefault(Return(owner_account));
+  absl::Notification request_done;
+  EXPECT_CALL(owner_encoder_, encodeData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) {
+        EXPECT_EQ(16384, data.length());
+        data.drain(data.length());
+        request_done.Notify();
+      }));
+  runOn(*worker_dispatcher_, [&]() {
+    encoder->getStream().addCallbacks(worker_stream_callbacks_);
+    encoder->getStream().setAccount(worker_account);
+    TestRequestHeaderMapImpl request_headers{
+        {":method", "POST"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+    EXPECT_TRUE(encoder->encodeHeaders(request_headers, false).ok());
+    Buffer::OwnedImpl request_body(worker_account);
+    request_body.add(std::string(16384, 'a'));
+    EXPECT_LT(0, balance(worker_account));
+    encoder->encodeData(request_body, true);
+    EXPECT_EQ(0, balance(worker_account));
+  });
+  request_done.WaitForNotification();
+
+  absl::Notification response_done;
+  EXPECT_CALL(worker_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(worker_decoder_, decodeData(BufferStringEqual("response"), true))
+      .WillOnce(Invoke([&](Buffer::Instance&, bool) { response_done.Notify(); }));
+  runOn(*owner_dispatcher_, [&]() {
+    owner_decoder_->decodeHeaders(
+        ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{{":status", "200"}}}, false);
+    Buffer::OwnedImpl response_body(owner_account);
+    response_body.add("response");
+    EXPECT_LT(0, balance(owner_account));
+    owner_decoder_->decodeData(response_body, true);
+    EXPECT_EQ(0, balance(owner_account));
+  });
+  response_done.WaitForNotification();
+
+  worker_account->clearDownstream();
+  owner_account->clearDownstream();
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
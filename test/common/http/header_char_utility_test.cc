@@ -0,0 +1,108 @@
+#include <string>
+
+#include "source/common/http/header_char_utility.h"
+
+#include "test/test_common/utility.h"
+
+#include "absl/strings/ascii.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+using Implementation = HeaderCharUtility::Implementation;
+
+bool isTokenChar(int c) {
+  return absl::ascii_isalnum(c) ||
+         absl::string_view("!#$%&'*+-.^_`|~").find(static_cast<char>(c)) != absl::string_view::npos;
+}
+
+class HeaderCharUtilityTest : public testing::TestWithParam<Implementation> {
+protected:
+  void SetUp() override {
+    kernels_ = HeaderCharUtility::kernels(GetParam());
+    if (kernels_ == nullptr) {
+      GTEST_SKIP() << "implementation not supported by this CPU";
+    }
+  }
+
+  std::string toLowerCase(std::string s) {
+    kernels_->to_lower_case_(s.data(), s.size());
+    return s;
+  }
+  bool isToken(absl::string_view s) { return kernels_->is_token_(s.data(), s.size()); }
+  bool isValidHeaderValue(absl::string_view s) {
+    return kernels_->is_valid_header_value_(s.data(), s.size());
+  }
+
+  const HeaderCharUtility::Kernels* kernels_{};
+};
+
+INSTANTIATE_TEST_SUITE_P(Implementations, HeaderCharUtilityTest,
+                         testing::Values(Implementation::Scalar, Implementation::Sse42,
+                                         Implementation::Avx2));
+
+TEST(HeaderCharUtilityActiveTest, ScalarAlwaysSupported) {
+  EXPECT_NE(nullptr, HeaderCharUtility::kernels(Implementation::Scalar));
+  EXPECT_NE(nullptr, HeaderCharUtility::kernels(HeaderCharUtility::activeImplementation()));
+}
+
+TEST_P(HeaderCharUtilityTest, Basic) {
+  EXPECT_EQ("content-type", toLowerCase("Content-Type"));
+  EXPECT_EQ("", toLowerCase(""));
+  EXPECT_TRUE(isToken("x-forwarded-for"));
+  EXPECT_TRUE(isToken(""));
+  EXPECT_FALSE(isToken("x forwarded"));
+  EXPECT_FALSE(isToken("x-forwarded:"));
+  EXPECT_TRUE(isValidHeaderValue("text/html; charset=utf-8\t"));
+  EXPECT_TRUE(isValidHeaderValue(""));
+  EXPECT_FALSE(isValidHeaderValue("foo\r\nbar"));
+  EXPECT_FALSE(isValidHeaderValue(absl::string_view("foo\0bar", 7)));
+}
+
+// Every byte value is checked at every position of strings long enough to cover the vectorized
+// loops as well as the scalar tails.
+TEST_P(HeaderCharUtilityTest, AllBytesAllPositions) {
+  const HeaderCharUtility::Kernels& scalar = *HeaderCharUtility::kernels(Implementation::Scalar);
+  for (const size_t size : {1, 15, 16, 17, 31, 32, 33, 64, 70}) {
+    for (size_t pos = 0; pos < size; ++pos) {
+      for (int c = 0; c < 256; ++c) {
+        std::string s(size, 'a');
+        s[pos] = static_cast<char>(c);
+        const bool token_char = isTokenChar(c);
+        const bool value_char = c == '\t' || (c >= 0x20 && c != 0x7f);
+        EXPECT_EQ(token_char, isToken(s)) << c << " at " << pos << " of " << size;
+        EXPECT_EQ(token_char, scalar.is_token_(s.data(), s.size()));
+        EXPECT_EQ(value_char, isValidHeaderValue(s)) << c << " at " << pos << " of " << size;
+
+        std::string expected = s;
+        expected[pos] = absl::ascii_tolower(static_cast<unsigned char>(c));
+        EXPECT_EQ(expected, toLowerCase(s)) << c << " at " << pos << " of " << size;
+      }
+    }
+  }
+}
+
+TEST_P(HeaderCharUtilityTest, RandomStringsMatchScalar) {
+  const HeaderCharUtility::Kernels& scalar = *HeaderCharUtility::kernels(Implementation::Scalar);
+  TestRandomGenerator rand;
+  for (int i = 0; i < 10000; ++i) {
+    const size_t size = rand.random() % 200;
+    // Mostly printable strings, so that the valid paths are exercised too.
+    std::string s(size, 'a');
+    for (char& c : s) {
+      c = rand.random() % 8 == 0 ? static_cast<char>(rand.random() % 256)
+                                 : static_cast<char>(0x20 + rand.random() % 0x5f);
+    }
+    EXPECT_EQ(scalar.is_token_(s.data(), s.size()), isToken(s));
+    EXPECT_EQ(scalar.is_valid_header_value_(s.data(), s.size()), isValidHeaderValue(s));
+    std::string expected = s;
+    scalar.to_lower_case_(expected.data(), expected.size());
+    EXPECT_EQ(expected, toLowerCase(s));
+  }
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
@@ -67,6 +67,9 @@ INSTANTIATE_TEST_SUITE_P(InvalidPrepareMethodParamsTest, IoUringImplParamTest,
                              },
                              [](IoUring& uring, os_fd_t fd) -> IoUringResult {
                                return uring.prepareClose(fd, nullptr);
+                             },
+                             [](IoUring& uring, os_fd_t) -> IoUringResult {
+                               return uring.prepareCancel(nullptr, nullptr);
                              }));
 
 TEST_P(IoUringImplParamTest, InvalidParams) {
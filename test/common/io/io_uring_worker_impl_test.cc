@@ -0,0 +1,262 @@
+#include <sys/socket.h>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/io/io_uring_worker_impl.h"
+#include "source/common/network/address_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Io {
+namespace {
+
+class IoUringWorkerImplTest : public ::testing::Test {
+public:
+  IoUringWorkerImplTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")),
+        should_skip_(!isIoUringSupported()) {
+    if (!should_skip_) {
+      worker_ = std::make_unique<IoUringWorkerImpl>(8, false, 1024, *dispatcher_);
+    }
+  }
+
+  void SetUp() override {
+    if (should_skip_) {
+      GTEST_SKIP();
+    }
+  }
+
+  void runUntil(const std::function<bool()>& condition) {
+    while (!condition()) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  void createSocketPair() {
+    ASSERT_EQ(0, Api::OsSysCallsSingleton::get().socketpair(AF_UNIX, SOCK_STREAM, 0, fds_)
+                     .return_value_);
+  }
+
+  os_fd_t createListener(Network::Address::InstanceConstSharedPtr& address) {
+    Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+    os_fd_t fd = os_sys_calls.socket(AF_INET, SOCK_STREAM, 0).return_value_;
+    auto loopback = std::make_shared<Network::Address::Ipv4Instance>("127.0.0.1", 0);
+    EXPECT_EQ(0, os_sys_calls.bind(fd, loopback->sockAddr(), loopback->sockAddrLen()).return_value_);
+    EXPECT_EQ(0, os_sys_calls.listen(fd, 5).return_value_);
+    sockaddr_in bound{};
+    socklen_t bound_len = sizeof(bound);
+    EXPECT_EQ(0, os_sys_calls.getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &bound_len)
+                     .return_value_);
+    address = std::make_shared<Network::Address::Ipv4Instance>(&bound);
+    return fd;
+  }
+
+  std::string readPeer(size_t length) {
+    std::string data(length, '\0');
+    size_t received = 0;
+    while (received < length) {
+      auto result = Api::OsSysCallsSingleton::get().recv(fds_[1], data.data() + received,
+                                                          length - received, MSG_DONTWAIT);
+      if (result.return_value_ > 0) {
+        received += result.return_value_;
+      } else {
+        dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      }
+    }
+    return data;
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  const bool should_skip_;
+  std::unique_ptr<IoUringWorkerImpl> worker_;
+  os_fd_t fds_[2];
+  uint32_t events_{0};
+};
+
+TEST_F(IoUringWorkerImplTest, ReadAndWrite) {
+  createSocketPair();
+  IoUringStreamSocket& socket =
+      worker_->addStreamSocket(fds_[0], true, [this](uint32_t events) { events_ |= events; });
+  EXPECT_EQ(1, worker_->numSockets());
+  socket.enableRead();
+
+  Api::OsSysCallsSingleton::get().write(fds_[1], "hello", 5);
+  runUntil([&socket]() { return socket.readBuffer().length() == 5; });
+  EXPECT_TRUE(events_ & Event::FileReadyType::Read);
+  EXPECT_EQ("hello", socket.readBuffer().toString());
+  socket.readBuffer().drain(5);
+
+  EXPECT_TRUE(socket.writable());
+  Buffer::OwnedImpl data("world");
+  EXPECT_EQ(5, socket.write(data));
+  EXPECT_EQ(0, data.length());
+  EXPECT_EQ("world", readPeer(5));
+  runUntil([this]() { return events_ & Event::FileReadyType::Write; });
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+TEST_F(IoUringWorkerImplTest, WriteBufferLimitPartialWrite) {
+  createSocketPair();
+  IoUringStreamSocket& socket = worker_->addStreamSocket(fds_[0], true, [](uint32_t) {});
+
+  // The write buffer takes up to the buffer size, the rest is left in the input.
+  Buffer::OwnedImpl data(std::string(4096, 'a'));
+  EXPECT_EQ(1024, socket.write(data));
+  EXPECT_EQ(3072, data.length());
+  EXPECT_EQ(std::string(1024, 'a'), readPeer(1024));
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+TEST_F(IoUringWorkerImplTest, ReadBufferLimitPausesReads) {
+  createSocketPair();
+  IoUringStreamSocket& socket = worker_->addStreamSocket(fds_[0], true, [](uint32_t) {});
+  socket.enableRead();
+
+  const std::string data(4096, 'a');
+  Api::OsSysCallsSingleton::get().write(fds_[1], data.data(), data.size());
+  runUntil([&socket]() { return socket.readBuffer().length() >= 1024; });
+  // No further reads are submitted until the owner consumes the buffer.
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1024, socket.readBuffer().length());
+
+  socket.readBuffer().drain(socket.readBuffer().length());
+  socket.enableRead();
+  runUntil([&socket]() { return socket.readBuffer().length() > 0; });
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+TEST_F(IoUringWorkerImplTest, PeerClose) {
+  createSocketPair();
+  IoUringStreamSocket& socket =
+      worker_->addStreamSocket(fds_[0], true, [this](uint32_t events) { events_ |= events; });
+  socket.enableRead();
+
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+  runUntil([&socket]() { return socket.readEof(); });
+  EXPECT_TRUE(events_ & Event::FileReadyType::Read);
+  EXPECT_TRUE(events_ & Event::FileReadyType::Closed);
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+}
+
+TEST_F(IoUringWorkerImplTest, CloseCancelsInflightRead) {
+  createSocketPair();
+  IoUringStreamSocket& socket =
+      worker_->addStreamSocket(fds_[0], true, [this](uint32_t events) { events_ |= events; });
+  socket.enableRead();
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+  // The owner isn't notified about the cancellation.
+  EXPECT_EQ(0, events_);
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+TEST_F(IoUringWorkerImplTest, ShutdownAfterFlush) {
+  createSocketPair();
+  IoUringStreamSocket& socket = worker_->addStreamSocket(fds_[0], true, [](uint32_t) {});
+
+  Buffer::OwnedImpl data("bye");
+  EXPECT_EQ(3, socket.write(data));
+  socket.shutdown(SHUT_WR);
+  EXPECT_EQ("bye", readPeer(3));
+
+  char c;
+  runUntil([this, &c]() {
+    return Api::OsSysCallsSingleton::get().recv(fds_[1], &c, 1, MSG_DONTWAIT).return_value_ == 0;
+  });
+
+  socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+TEST_F(IoUringWorkerImplTest, AcceptAndConnect) {
+  Network::Address::InstanceConstSharedPtr address;
+  const os_fd_t listen_fd = createListener(address);
+  IoUringAcceptSocket& accept_socket =
+      worker_->addAcceptSocket(listen_fd, [this](uint32_t events) { events_ |= events; });
+  accept_socket.enableRead();
+
+  uint32_t client_events = 0;
+  const os_fd_t client_fd =
+      Api::OsSysCallsSingleton::get().socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_;
+  IoUringStreamSocket& client = worker_->addStreamSocket(
+      client_fd, false, [&client_events](uint32_t events) { client_events |= events; });
+  EXPECT_FALSE(client.writable());
+  client.connect(address);
+  EXPECT_TRUE(client.connecting());
+
+  runUntil([&]() {
+    return (events_ & Event::FileReadyType::Read) && (client_events & Event::FileReadyType::Write);
+  });
+  EXPECT_EQ(0, client.connectError());
+  EXPECT_TRUE(client.writable());
+
+  auto accepted = accept_socket.popAcceptedSocket();
+  ASSERT_TRUE(accepted.has_value());
+  EXPECT_EQ(AF_INET, accepted->remote_addr_.ss_family);
+  EXPECT_FALSE(accept_socket.popAcceptedSocket().has_value());
+  EXPECT_EQ(0, accept_socket.readyEvents());
+
+  IoUringStreamSocket& server = worker_->addStreamSocket(accepted->fd_, true, [](uint32_t) {});
+  server.enableRead();
+  Buffer::OwnedImpl data("ping");
+  EXPECT_EQ(4, client.write(data));
+  runUntil([&server]() { return server.readBuffer().length() == 4; });
+
+  client.close(true);
+  server.close(true);
+  accept_socket.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+}
+
+TEST_F(IoUringWorkerImplTest, ConnectFailure) {
+  Network::Address::InstanceConstSharedPtr address;
+  const os_fd_t listen_fd = createListener(address);
+  // Nothing listens on the port any more.
+  Api::OsSysCallsSingleton::get().close(listen_fd);
+
+  const os_fd_t client_fd =
+      Api::OsSysCallsSingleton::get().socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_;
+  IoUringStreamSocket& client = worker_->addStreamSocket(
+      client_fd, false, [this](uint32_t events) { events_ |= events; });
+  client.enableRead();
+  client.connect(address);
+  runUntil([this]() { return events_ & Event::FileReadyType::Write; });
+  EXPECT_EQ(ECONNREFUSED, client.connectError());
+  EXPECT_FALSE(client.writable());
+
+  client.close(true);
+  runUntil([this]() { return worker_->numSockets() == 0; });
+}
+
+TEST_F(IoUringWorkerImplTest, DestructionCancelsInflightRequests) {
+  createSocketPair();
+  IoUringStreamSocket& socket = worker_->addStreamSocket(fds_[0], true, [](uint32_t) {});
+  socket.enableRead();
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+
+  // Waits for the cancelled read and closes the socket through the ring.
+  worker_.reset();
+  Api::OsSysCallsSingleton::get().close(fds_[1]);
+}
+
+} // namespace
+} // namespace Io
+} // namespace Envoy
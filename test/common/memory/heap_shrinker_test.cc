@@ -1,3 +1,4 @@
+#include "source/common/buffer/slice_pool.h"
 #include "source/common/event/dispatcher_impl.h"
 #include "source/common/memory/heap_shrinker.h"
 #include "source/common/memory/stats.h"
@@ -62,6 +63,7 @@ TEST_F(HeapShrinkerTest, ShrinkWhenTriggered) {
   Envoy::Stats::Counter& shrink_count =
       stats_.counter("overload.envoy.overload_actions.shrink_heap.shrink_count");
   action_cb(Server::OverloadActionState::saturated());
+  EXPECT_EQ(0, Buffer::SlicePool::maxBytesPerThread());
   step();
   EXPECT_EQ(1, shrink_count.value());
 
@@ -78,6 +80,7 @@ TEST_F(HeapShrinkerTest, ShrinkWhenTriggered) {
   EXPECT_EQ(2, shrink_count.value());
 
   action_cb(Server::OverloadActionState::inactive());
+  EXPECT_EQ(Buffer::SlicePool::DefaultMaxBytesPerThread, Buffer::SlicePool::maxBytesPerThread());
   step();
   step();
   EXPECT_EQ(2, shrink_count.value());
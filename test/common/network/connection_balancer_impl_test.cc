@@ -0,0 +1,152 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "source/common/network/connection_balancer_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class TestBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  explicit TestBalancedConnectionHandler(uint64_t num_connections = 0)
+      : num_connections_(num_connections) {}
+
+  // Network::BalancedConnectionHandler
+  uint64_t numConnections() const override { return num_connections_; }
+  void incNumConnections() override { ++num_connections_; }
+  void post(ConnectionSocketPtr&&) override {}
+  void onAcceptWorker(ConnectionSocketPtr&&, bool, bool) override {}
+
+  std::atomic<uint64_t> num_connections_;
+};
+
+TEST(LeastLoadedConnectionBalancerImplTest, SingleHandler) {
+  LeastLoadedConnectionBalancerImpl balancer;
+  TestBalancedConnectionHandler handler;
+  balancer.registerHandler(handler);
+
+  EXPECT_EQ(&handler, &balancer.pickTargetHandler(handler));
+  EXPECT_EQ(&handler, &balancer.pickTargetHandler(handler));
+  EXPECT_EQ(2, handler.numConnections());
+  balancer.unregisterHandler(handler);
+}
+
+TEST(LeastLoadedConnectionBalancerImplTest, PicksLeastLoaded) {
+  LeastLoadedConnectionBalancerImpl balancer;
+  TestBalancedConnectionHandler handler1(5);
+  TestBalancedConnectionHandler handler2(2);
+  TestBalancedConnectionHandler handler3(3);
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+  balancer.registerHandler(handler3);
+
+  EXPECT_EQ(&handler2, &balancer.pickTargetHandler(handler1));
+  EXPECT_EQ(3, handler2.numConnections());
+  // handler2 and handler3 are tied, so the accepting handler keeps the connection.
+  EXPECT_EQ(&handler3, &balancer.pickTargetHandler(handler3));
+  EXPECT_EQ(4, handler3.numConnections());
+  EXPECT_EQ(&handler2, &balancer.pickTargetHandler(handler3));
+  EXPECT_EQ(5, handler1.numConnections());
+
+  balancer.unregisterHandler(handler1);
+  balancer.unregisterHandler(handler2);
+  balancer.unregisterHandler(handler3);
+}
+
+TEST(LeastLoadedConnectionBalancerImplTest, MaxImbalance) {
+  LeastLoadedConnectionBalancerImpl balancer(2);
+  TestBalancedConnectionHandler handler1(2);
+  TestBalancedConnectionHandler handler2(0);
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+
+  EXPECT_EQ(&handler1, &balancer.pickTargetHandler(handler1));
+  EXPECT_EQ(3, handler1.numConnections());
+  EXPECT_EQ(&handler2, &balancer.pickTargetHandler(handler1));
+  EXPECT_EQ(1, handler2.numConnections());
+
+  balancer.unregisterHandler(handler1);
+  balancer.unregisterHandler(handler2);
+}
+
+TEST(LeastLoadedConnectionBalancerImplTest, UnregisteredHandlerNotPicked) {
+  LeastLoadedConnectionBalancerImpl balancer;
+  TestBalancedConnectionHandler handler1(3);
+  TestBalancedConnectionHandler handler2(0);
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+  balancer.unregisterHandler(handler2);
+
+  EXPECT_EQ(&handler1, &balancer.pickTargetHandler(handler1));
+  EXPECT_EQ(0, handler2.numConnections());
+
+  // The slot of the unregistered handler is reused.
+  TestBalancedConnectionHandler handler3(1);
+  balancer.registerHandler(handler3);
+  EXPECT_EQ(&handler3, &balancer.pickTargetHandler(handler1));
+  EXPECT_EQ(2, handler3.numConnections());
+
+  balancer.unregisterHandler(handler1);
+  balancer.unregisterHandler(handler3);
+}
+
+// Handlers are registered and unregistered while other threads pick targets. Every pick must
+// account for its connection on a handler that is registered for the whole test or was still
+// registered when the pick started.
+TEST(LeastLoadedConnectionBalancerImplTest, ConcurrentPicksAndUnregister) {
+  constexpr int NumThreads = 4;
+  constexpr int PicksPerThread = 20000;
+  LeastLoadedConnectionBalancerImpl balancer;
+  std::vector<std::unique_ptr<TestBalancedConnectionHandler>> handlers;
+  for (int i = 0; i < NumThreads; ++i) {
+    handlers.push_back(std::make_unique<TestBalancedConnectionHandler>());
+    balancer.registerHandler(*handlers.back());
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> transient_connections{0};
+  std::thread churn([&]() {
+    while (!done) {
+      TestBalancedConnectionHandler transient;
+      balancer.registerHandler(transient);
+      balancer.unregisterHandler(transient);
+      transient_connections += transient.numConnections();
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NumThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < PicksPerThread; ++j) {
+        balancer.pickTargetHandler(*handlers[i]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  done = true;
+  churn.join();
+
+  uint64_t total = transient_connections;
+  uint64_t max_connections = 0;
+  uint64_t min_connections = UINT64_MAX;
+  for (auto& handler : handlers) {
+    total += handler->numConnections();
+    max_connections = std::max<uint64_t>(max_connections, handler->numConnections());
+    min_connections = std::min<uint64_t>(min_connections, handler->numConnections());
+    balancer.unregisterHandler(*handler);
+  }
+  EXPECT_EQ(NumThreads * PicksPerThread, total);
+  // Picks race with each other, so the counts are only approximately balanced.
+  EXPECT_LE(max_connections - min_connections, PicksPerThread / 10);
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
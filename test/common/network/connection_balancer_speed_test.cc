@@ -0,0 +1,145 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "source/common/network/connection_balancer_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+enum class BalancerType { Nop, Exact, LeastLoaded };
+
+ConnectionBalancerSharedPtr createBalancer(BalancerType type) {
+  switch (type) {
+  case BalancerType::Nop:
+    return std::make_shared<NopConnectionBalancerImpl>();
+  case BalancerType::Exact:
+    return std::make_shared<ExactConnectionBalancerImpl>();
+  case BalancerType::LeastLoaded:
+    return std::make_shared<LeastLoadedConnectionBalancerImpl>();
+  }
+  return nullptr;
+}
+
+class TestBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  // Network::BalancedConnectionHandler
+  uint64_t numConnections() const override { return num_connections_; }
+  void incNumConnections() override { ++num_connections_; }
+  void post(ConnectionSocketPtr&&) override {}
+  void onAcceptWorker(ConnectionSocketPtr&&, bool, bool) override {}
+
+  std::atomic<uint64_t> num_connections_{};
+};
+
+// Simulates state.range(1) workers accepting one connection per iteration. Half of the connections
+// are accepted by the first worker, as happens when the kernel keeps waking the same thread, and
+// 5% of the connections live 200 times longer than the others. The load of the worker that serves
+// each connection stands in for the latency of the connection; its tail is reported in the
+// counters along with the share of connections transferred to another worker.
+void bmSkewedConnectionLifetimes(benchmark::State& state) {
+  const auto type = static_cast<BalancerType>(state.range(0));
+  const size_t num_workers = state.range(1);
+  ConnectionBalancerSharedPtr balancer = createBalancer(type);
+  std::vector<TestBalancedConnectionHandler> handlers(num_workers);
+  for (auto& handler : handlers) {
+    balancer->registerHandler(handler);
+  }
+
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<size_t> uniform_worker(0, num_workers - 1);
+  std::bernoulli_distribution first_worker(0.5);
+  std::bernoulli_distribution long_lived(0.05);
+  std::exponential_distribution<double> short_lifetime(1.0 / 10);
+  std::exponential_distribution<double> long_lifetime(1.0 / 2000);
+
+  // Pairs of the tick a connection closes at and the index of the worker serving it.
+  using Close = std::pair<uint64_t, size_t>;
+  std::priority_queue<Close, std::vector<Close>, std::greater<Close>> closes;
+  std::vector<uint64_t> loads;
+  uint64_t rebalanced = 0;
+  uint64_t tick = 0;
+  for (auto _ : state) { // NOLINT
+    while (!closes.empty() && closes.top().first <= tick) {
+      --handlers[closes.top().second].num_connections_;
+      closes.pop();
+    }
+
+    TestBalancedConnectionHandler& current =
+        handlers[first_worker(random) ? 0 : uniform_worker(random)];
+    BalancedConnectionHandler& target = balancer->pickTargetHandler(current);
+    if (&target != &current) {
+      ++rebalanced;
+    }
+    loads.push_back(target.numConnections());
+    const double lifetime = long_lived(random) ? long_lifetime(random) : short_lifetime(random);
+    closes.emplace(tick + 1 + static_cast<uint64_t>(lifetime),
+                   static_cast<TestBalancedConnectionHandler*>(&target) - handlers.data());
+    ++tick;
+  }
+
+  std::sort(loads.begin(), loads.end());
+  state.counters["p50_load"] = loads[loads.size() / 2];
+  state.counters["p99_load"] = loads[loads.size() * 99 / 100];
+  state.counters["p999_load"] = loads[loads.size() * 999 / 1000];
+  state.counters["max_load"] = loads.back();
+  state.counters["rebalanced_pct"] = 100.0 * rebalanced / loads.size();
+
+  for (auto& handler : handlers) {
+    balancer->unregisterHandler(handler);
+  }
+}
+BENCHMARK(bmSkewedConnectionLifetimes)
+    ->ArgsProduct({{static_cast<int64_t>(BalancerType::Nop),
+                    static_cast<int64_t>(BalancerType::Exact),
+                    static_cast<int64_t>(BalancerType::LeastLoaded)},
+                   {4, 16}})
+    ->Iterations(200000);
+
+// Measures the cost of picking a target when every benchmark thread accepts connections on its
+// own handler, which is where the lock of the exact balancer is contended.
+ConnectionBalancerSharedPtr concurrent_balancer;
+std::vector<std::unique_ptr<TestBalancedConnectionHandler>> concurrent_handlers;
+
+void bmConcurrentPick(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    concurrent_balancer = createBalancer(static_cast<BalancerType>(state.range(0)));
+    concurrent_handlers.clear();
+    for (int i = 0; i < state.threads(); ++i) {
+      concurrent_handlers.push_back(std::make_unique<TestBalancedConnectionHandler>());
+      concurrent_balancer->registerHandler(*concurrent_handlers.back());
+    }
+  }
+
+  for (auto _ : state) { // NOLINT
+    auto& target =
+        concurrent_balancer->pickTargetHandler(*concurrent_handlers[state.thread_index()]);
+    // Close the connection right away so that the counts stay small.
+    --static_cast<TestBalancedConnectionHandler&>(target).num_connections_;
+  }
+
+  if (state.thread_index() == 0) {
+    for (auto& handler : concurrent_handlers) {
+      concurrent_balancer->unregisterHandler(*handler);
+    }
+    concurrent_balancer.reset();
+  }
+}
+BENCHMARK(bmConcurrentPick)
+    ->Arg(static_cast<int64_t>(BalancerType::Exact))
+    ->Arg(static_cast<int64_t>(BalancerType::LeastLoaded))
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
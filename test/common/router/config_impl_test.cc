@@ -4932,6 +4932,45 @@ virtual_hosts:
   EXPECT_EQ(100, ProtobufPercentHelper::fractionalPercentDenominatorToInt(percent.denominator()));
 }
 
+TEST_F(RouteMatcherTest, HedgeOnResponseTime) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  routes:
+  - match: {prefix: /foo}
+    route:
+      cluster: www
+      hedge_policy:
+        hedge_on_response_time: {percentile: 95}
+  - match: {prefix: /bar}
+    route:
+      cluster: www
+      hedge_policy:
+        hedge_on_response_time: {percentile: 99.9, budget_percent: {value: 2.5}}
+  - match: {prefix: /}
+    route: {cluster: www}
+  )EOF";
+
+  factory_context_.cluster_manager_.initializeClusters({"www"}, {});
+  TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true);
+
+  const HedgePolicy& foo_policy =
+      config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(95, foo_policy.hedgeOnResponseTimePercentile());
+  EXPECT_EQ(10, foo_policy.hedgeBudgetPercent());
+
+  const HedgePolicy& bar_policy =
+      config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(99.9, bar_policy.hedgeOnResponseTimePercentile());
+  EXPECT_EQ(2.5, bar_policy.hedgeBudgetPercent());
+
+  EXPECT_EQ(absl::nullopt, config.route(genHeaders("www.lyft.com", "/", "GET"), 0)
+                               ->routeEntry()
+                               ->hedgePolicy()
+                               .hedgeOnResponseTimePercentile());
+}
+
 TEST_F(RouteMatcherTest, HedgeVirtualHostLevel) {
   const std::string yaml = R"EOF(
 virtual_hosts:
@@ -8528,6 +8567,73 @@ virtual_hosts:
                 ->clusterName());
 }
 
+// Tests that the route path index selects the same routes as evaluating them one by one.
+TEST_F(RouteMatcherTest, RoutePathIndex) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+  - name: indexed
+    domains: ["*"]
+    enable_route_path_index: true
+    routes:
+      - match:
+          prefix: "/api"
+          headers:
+          - name: x-canary
+            string_match:
+              exact: "true"
+        route: { cluster: canary-cluster }
+      - match:
+          safe_regex:
+            regex: "/api/v[0-9]+/regex"
+        route: { cluster: regex-cluster }
+      - match:
+          path: "/api/v1/users"
+        route: { cluster: exact-cluster }
+      - match:
+          path: "/API/v1/Users"
+          case_sensitive: false
+        route: { cluster: case-insensitive-cluster }
+      - match:
+          path_separated_prefix: "/api/v1"
+        route: { cluster: path-separated-cluster }
+      - match:
+          prefix: "/api"
+        route: { cluster: prefix-cluster }
+      - match:
+          prefix: "/"
+        route: { cluster: default-cluster }
+  )EOF";
+
+  factory_context_.cluster_manager_.initializeClusters(
+      {"canary-cluster", "regex-cluster", "exact-cluster", "case-insensitive-cluster",
+       "path-separated-cluster", "prefix-cluster", "default-cluster"},
+      {});
+  auto route_configuration = parseRouteConfigurationFromYaml(yaml);
+  for (const bool enable_route_path_index : {false, true}) {
+    route_configuration.mutable_virtual_hosts(0)->set_enable_route_path_index(
+        enable_route_path_index);
+    TestConfigImpl config(route_configuration, factory_context_, true);
+    auto cluster_name = [&config](const std::string& path) {
+      return config.route(genHeaders("www.lyft.com", path, "GET"), 0)->routeEntry()->clusterName();
+    };
+
+    EXPECT_EQ("exact-cluster", cluster_name("/api/v1/users"));
+    EXPECT_EQ("exact-cluster", cluster_name("/api/v1/users?filter=all"));
+    EXPECT_EQ("case-insensitive-cluster", cluster_name("/API/V1/USERS"));
+    EXPECT_EQ("regex-cluster", cluster_name("/api/v2/regex"));
+    EXPECT_EQ("path-separated-cluster", cluster_name("/api/v1"));
+    EXPECT_EQ("path-separated-cluster", cluster_name("/api/v1/groups"));
+    EXPECT_EQ("prefix-cluster", cluster_name("/api/v12"));
+    EXPECT_EQ("default-cluster", cluster_name("/API/v1/groups#fragment"));
+    EXPECT_EQ("default-cluster", cluster_name("/ap"));
+
+    Http::TestRequestHeaderMapImpl canary_headers =
+        genHeaders("www.lyft.com", "/api/v1/users", "GET");
+    canary_headers.addCopy("x-canary", "true");
+    EXPECT_EQ("canary-cluster", config.route(canary_headers, 0)->routeEntry()->clusterName());
+  }
+}
+
 TEST_F(RouteMatcherTest, PathSeparatedPrefixMatchRewrite) {
 
   const std::string yaml = R"EOF(
@@ -10280,6 +10386,51 @@ virtual_hosts:
   EXPECT_EQ(accepted_route->routeEntry()->clusterName(), "default");
 }
 
+TEST_F(RouteMatchOverrideTest, VerifyAllMatchableRoutesWithRoutePathIndex) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+  - name: bar
+    domains: ["*"]
+    enable_route_path_index: true
+    routes:
+      - match: { prefix: "/foo/bar/baz" }
+        route:
+          cluster: foo_bar_baz
+      - match: { prefix: "/bar" }
+        route:
+          cluster: bar
+      - match: { prefix: "/foo" }
+        route:
+          cluster: foo
+      - match: { path: "/foo/bar" }
+        route:
+          cluster: foo_bar
+)EOF";
+
+  factory_context_.cluster_manager_.initializeClusters({"foo_bar_baz", "bar", "foo", "foo_bar"},
+                                                       {});
+  TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true);
+  std::vector<std::string> clusters{"foo", "foo_bar_baz"};
+
+  // Routes which can't match the path are skipped, so the last matchable route is reported with
+  // NoMoreRoutes even though more routes are configured.
+  RouteConstSharedPtr accepted_route = config.route(
+      [&clusters](RouteConstSharedPtr route,
+                  RouteEvalStatus route_eval_status) -> RouteMatchStatus {
+        EXPECT_FALSE(clusters.empty());
+        EXPECT_EQ(clusters[clusters.size() - 1], route->routeEntry()->clusterName());
+        clusters.pop_back();
+        if (clusters.empty()) {
+          EXPECT_EQ(route_eval_status, RouteEvalStatus::NoMoreRoutes);
+          return RouteMatchStatus::Accept;
+        }
+        EXPECT_EQ(route_eval_status, RouteEvalStatus::HasMoreRoutes);
+        return RouteMatchStatus::Continue;
+      },
+      genHeaders("bat.com", "/foo/bar/baz", "GET"));
+  EXPECT_EQ(accepted_route->routeEntry()->clusterName(), "foo");
+}
+
 TEST_F(RouteMatchOverrideTest, VerifyRouteOverrideStops) {
   const std::string yaml = R"EOF(
 virtual_hosts:
@@ -1,5 +1,6 @@
 #include <chrono>
 
+#include "envoy/config/cluster/v3/circuit_breaker.pb.h"
 #include "envoy/config/route/v3/route_components.pb.h"
 #include "envoy/stats/stats.h"
 
@@ -8,6 +9,7 @@
 #include "source/common/router/reset_header_parser.h"
 #include "source/common/router/retry_state_impl.h"
 #include "source/common/upstream/resource_manager_impl.h"
+#include "source/common/upstream/retry_token_bucket.h"
 
 #include "test/common/http/common.h"
 #include "test/mocks/common.h"
@@ -15,6 +17,7 @@
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/upstream/cluster_info.h"
+#include "test/mocks/upstream/host.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/simulated_time_system.h"
 #include "test/test_common/test_runtime.h"
@@ -1319,6 +1322,82 @@ TEST_F(RouterRetryStateImplTest, HostSelectionAttempts) {
   EXPECT_EQ(2, state_->hostSelectionMaxAttempts());
 }
 
+TEST_F(RouterRetryStateImplTest, RetryTokenBucketExhausted) {
+  envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket config;
+  config.set_max_tokens(1);
+  Upstream::RetryTokenBucketsImpl buckets(config);
+  ON_CALL(cluster_, retryTokenBuckets())
+      .WillByDefault(Return(Upstream::RetryTokenBucketsOptRef(buckets)));
+
+  Http::TestRequestHeaderMapImpl request_headers{{"x-envoy-retry-on", "5xx"},
+                                                 {"x-envoy-max-retries", "3"}};
+  Http::TestResponseHeaderMapImpl response_headers{{":status", "500"}};
+  setup(request_headers);
+  EXPECT_TRUE(state_->enabled());
+
+  expectTimerCreateAndEnable();
+  EXPECT_EQ(RetryStatus::Yes,
+            state_->shouldRetryHeaders(response_headers, request_headers, header_callback_));
+  EXPECT_CALL(callback_ready_, ready());
+  retry_timer_->invokeCallback();
+
+  EXPECT_EQ(RetryStatus::NoOverflow,
+            state_->shouldRetryHeaders(response_headers, request_headers, header_callback_));
+  EXPECT_EQ(1UL, cluster_.trafficStats()->upstream_rq_retry_token_bucket_exhausted_.value());
+  EXPECT_EQ(1UL, cluster_.trafficStats()->upstream_rq_retry_.value());
+
+  // Successful responses earn back the token.
+  for (uint32_t i = 0; i < 10; i++) {
+    buckets.clusterBucket().onSuccess();
+  }
+  EXPECT_CALL(*retry_timer_, enableTimer(_, _));
+  EXPECT_EQ(RetryStatus::Yes,
+            state_->shouldRetryHeaders(response_headers, request_headers, header_callback_));
+  EXPECT_EQ(1UL, cluster_.trafficStats()->upstream_rq_retry_token_bucket_exhausted_.value());
+  EXPECT_EQ(2UL, cluster_.trafficStats()->upstream_rq_retry_.value());
+}
+
+TEST_F(RouterRetryStateImplTest, RetryTokenBucketsAvoidHosts) {
+  envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket config;
+  TestUtility::loadFromYaml(R"EOF(
+    max_tokens: 10
+    max_host_tokens: 1
+    host_failure_streak: 2
+    host_selection_max_attempts: 4
+  )EOF",
+                            config);
+  Upstream::RetryTokenBucketsImpl buckets(config);
+  ON_CALL(cluster_, retryTokenBuckets())
+      .WillByDefault(Return(Upstream::RetryTokenBucketsOptRef(buckets)));
+  policy_.host_selection_max_attempts_ = 2;
+  policy_.retry_on_ = RetryPolicy::RETRY_ON_CONNECT_FAILURE;
+
+  setup();
+  EXPECT_EQ(4, state_->hostSelectionMaxAttempts());
+
+  auto host = std::make_shared<NiceMock<Upstream::MockHost>>();
+  Upstream::RetryTokenBucketPtr host_bucket = buckets.createHostBucket();
+  ON_CALL(*host, retryTokenBucket())
+      .WillByDefault(Return(Upstream::RetryTokenBucketOptRef(*host_bucket)));
+  EXPECT_FALSE(state_->shouldSelectAnotherHost(*host));
+
+  // The first attempt isn't a retry, the second one takes the token of the host.
+  state_->onHostAttempted(host);
+  EXPECT_TRUE(host_bucket->hasToken());
+  state_->onHostAttempted(host);
+  EXPECT_FALSE(host_bucket->hasToken());
+  EXPECT_TRUE(state_->shouldSelectAnotherHost(*host));
+  EXPECT_EQ(1UL, cluster_.trafficStats()->upstream_rq_retry_host_skipped_.value());
+
+  // A host without a bucket is avoided on a streak of failures.
+  NiceMock<Upstream::MockHost> failing_host;
+  ON_CALL(failing_host.outlier_detector_, consecutiveFailures()).WillByDefault(Return(1));
+  EXPECT_FALSE(state_->shouldSelectAnotherHost(failing_host));
+  ON_CALL(failing_host.outlier_detector_, consecutiveFailures()).WillByDefault(Return(2));
+  EXPECT_TRUE(state_->shouldSelectAnotherHost(failing_host));
+  EXPECT_EQ(2UL, cluster_.trafficStats()->upstream_rq_retry_host_skipped_.value());
+}
+
 TEST_F(RouterRetryStateImplTest, Cancel) {
   // Cover the case where we start a retry, and then we get destructed. This is how the router
   // uses the implementation in the cancel case.
@@ -0,0 +1,100 @@
+#include "source/common/router/route_path_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+class RoutePathIndexTest : public testing::Test {
+public:
+  RoutePathIndex::Candidates find(absl::optional<absl::string_view> path) {
+    RoutePathIndex::Candidates candidates;
+    index_.findCandidates(path, candidates);
+    return candidates;
+  }
+
+  RoutePathIndex index_;
+};
+
+TEST_F(RoutePathIndexTest, Empty) {
+  EXPECT_THAT(find("/foo"), IsEmpty());
+  EXPECT_THAT(find(absl::nullopt), IsEmpty());
+  EXPECT_EQ(1, index_.numNodes());
+}
+
+TEST_F(RoutePathIndexTest, Prefix) {
+  index_.addRoute(0, PathMatchType::Prefix, "/foo/bar");
+  index_.addRoute(1, PathMatchType::Prefix, "/foo");
+  index_.addRoute(2, PathMatchType::Prefix, "/");
+  index_.addRoute(3, PathMatchType::Prefix, "/foo/baz");
+
+  EXPECT_THAT(find("/foo/bar/baz"), ElementsAre(0, 1, 2));
+  EXPECT_THAT(find("/foo/ba"), ElementsAre(1, 2));
+  EXPECT_THAT(find("/foobar"), ElementsAre(1, 2));
+  EXPECT_THAT(find("/fo"), ElementsAre(2));
+  EXPECT_THAT(find("foo"), IsEmpty());
+  // Routes without a path are never candidates for path based routes.
+  EXPECT_THAT(find(absl::nullopt), IsEmpty());
+}
+
+TEST_F(RoutePathIndexTest, Exact) {
+  index_.addRoute(0, PathMatchType::Exact, "/foo");
+  index_.addRoute(1, PathMatchType::Exact, "/foo/bar");
+  index_.addRoute(2, PathMatchType::Exact, "/foo");
+
+  EXPECT_THAT(find("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(find("/foo/bar"), ElementsAre(1));
+  EXPECT_THAT(find("/foo/"), IsEmpty());
+  EXPECT_THAT(find("/fo"), IsEmpty());
+}
+
+TEST_F(RoutePathIndexTest, PathSeparatedPrefix) {
+  index_.addRoute(0, PathMatchType::PathSeparatedPrefix, "/foo");
+
+  EXPECT_THAT(find("/foo"), ElementsAre(0));
+  EXPECT_THAT(find("/foo/bar"), ElementsAre(0));
+  EXPECT_THAT(find("/foobar"), IsEmpty());
+}
+
+TEST_F(RoutePathIndexTest, CaseInsensitiveCandidates) {
+  index_.addRoute(0, PathMatchType::Prefix, "/Foo");
+  index_.addRoute(1, PathMatchType::Exact, "/foo/BAR");
+
+  // The index doesn't know which routes are case sensitive, so both spellings are candidates.
+  EXPECT_THAT(find("/FOO/bar"), ElementsAre(0, 1));
+  EXPECT_THAT(find("/foo/bar"), ElementsAre(0, 1));
+}
+
+TEST_F(RoutePathIndexTest, UnindexedRoutesKeepConfigurationOrder) {
+  index_.addRoute(0, PathMatchType::Regex, "");
+  index_.addRoute(1, PathMatchType::Prefix, "/foo");
+  index_.addRoute(2, PathMatchType::None, "");
+  index_.addRoute(3, PathMatchType::Exact, "/foo");
+  index_.addRoute(4, PathMatchType::Prefix, "/");
+
+  EXPECT_THAT(find("/foo"), ElementsAre(0, 1, 2, 3, 4));
+  EXPECT_THAT(find("/bar"), ElementsAre(0, 2, 4));
+  EXPECT_THAT(find(absl::nullopt), ElementsAre(0, 2));
+}
+
+TEST_F(RoutePathIndexTest, SplitsEdges) {
+  index_.addRoute(0, PathMatchType::Exact, "/shelves/shelf_1/route_1");
+  index_.addRoute(1, PathMatchType::Exact, "/shelves/shelf_2/route_2");
+  index_.addRoute(2, PathMatchType::Prefix, "/shelves/");
+  // Root, "/shelves/shelf_", "1/route_1", "2/route_2" and "/shelves/" splitting the second node.
+  EXPECT_EQ(5, index_.numNodes());
+
+  EXPECT_THAT(find("/shelves/shelf_1/route_1"), ElementsAre(0, 2));
+  EXPECT_THAT(find("/shelves/shelf_2/route_2"), ElementsAre(1, 2));
+  EXPECT_THAT(find("/shelves/shelf_3/route_3"), ElementsAre(2));
+  EXPECT_THAT(find("/shelves"), IsEmpty());
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -30,6 +30,8 @@
 #include "source/common/stream_info/uint32_accessor_impl.h"
 #include "source/common/stream_info/utility.h"
 #include "source/common/tracing/http_tracer_impl.h"
+#include "source/common/upstream/response_time_tracker.h"
+#include "source/common/upstream/retry_token_bucket.h"
 #include "source/common/upstream/upstream_impl.h"
 
 #include "test/common/http/common.h"
@@ -2087,7 +2089,262 @@ TEST_F(RouterTest, HedgedPerTryTimeoutFirstRequestSucceeds) {
   EXPECT_EQ(0U, router_.upstreamRequests().size());
   EXPECT_FALSE(router_.finalUpstreamRequest() == nullptr);
 
-  // TODO: Verify hedge stats here once they are implemented.
+  EXPECT_EQ(1U,
+            cm_.thread_local_cluster_.cluster_.info_->stats_store_.counter("upstream_rq_hedge")
+                .value());
+}
+
+// Tests that a request slower than the configured percentile of the response times of the cluster
+// is hedged, and that the first request is reset when the hedged request responds.
+TEST_F(RouterTest, HedgeOnResponseTimeHedgedRequestSucceeds) {
+  Upstream::ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < Upstream::ResponseTimeTrackerImpl::MinRequests; i++) {
+    tracker.recordResponseTime(std::chrono::microseconds(1000));
+  }
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, responseTimeTracker())
+      .WillByDefault(Return(std::reference_wrapper<Upstream::ResponseTimeTracker>(tracker)));
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_response_time_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_budget_percent_ = 10;
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder1, Http::Protocol::Http10);
+  // The 90th percentile is the upper bound of the bucket of 1ms.
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableHRTimer(std::chrono::microseconds(1023), _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+
+  // No global timeout, so the hedge timer is the only timer.
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(encoder1.stream_, resetStream(_)).Times(0);
+  router_.retry_state_->expectHedgedPerTryTimeoutRetry();
+  hedge_timer->invokeCallback();
+  EXPECT_EQ(1U,
+            cm_.thread_local_cluster_.cluster_.info_->stats_store_.counter("upstream_rq_hedge")
+                .value());
+
+  NiceMock<Http::MockRequestEncoder> encoder2;
+  Http::ResponseDecoder* response_decoder2 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder2, &response_decoder2, Http::Protocol::Http10);
+  router_.retry_state_->callback_();
+  EXPECT_EQ(2U, router_.upstreamRequests().size());
+
+  // The hedged request responds first, the first request is reset.
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(encoder1.stream_, resetStream(_));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  ASSERT(response_decoder2);
+  response_decoder2->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+  EXPECT_EQ(0U, router_.upstreamRequests().size());
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_overflow")
+                    .value());
+}
+
+// Tests that no hedged request is sent once the hedge budget of the cluster is used up.
+TEST_F(RouterTest, HedgeOnResponseTimeBudgetExhausted) {
+  Upstream::ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < Upstream::ResponseTimeTrackerImpl::MinRequests; i++) {
+    tracker.recordResponseTime(std::chrono::microseconds(1000));
+  }
+  // 1% of 128 requests.
+  EXPECT_TRUE(tracker.tryHedge(1));
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, responseTimeTracker())
+      .WillByDefault(Return(std::reference_wrapper<Upstream::ResponseTimeTracker>(tracker)));
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_response_time_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_budget_percent_ = 1;
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder1, Http::Protocol::Http10);
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableHRTimer(_, _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(*router_.retry_state_, shouldHedgeRetryPerTryTimeout(_)).Times(0);
+  hedge_timer->invokeCallback();
+  EXPECT_EQ(1U, router_.upstreamRequests().size());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_overflow")
+                    .value());
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  ASSERT(response_decoder1);
+  response_decoder1->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+  // The time doesn't advance, so the response time is 0.
+  EXPECT_EQ(std::chrono::microseconds(0), tracker.responseTimePercentile(0.5));
+}
+
+// Tests that a hedged request which the retry limits don't allow gives its hedge budget back.
+TEST_F(RouterTest, HedgeOnResponseTimeRetryLimited) {
+  Upstream::ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < Upstream::ResponseTimeTrackerImpl::MinRequests; i++) {
+    tracker.recordResponseTime(std::chrono::microseconds(1000));
+  }
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, responseTimeTracker())
+      .WillByDefault(Return(std::reference_wrapper<Upstream::ResponseTimeTracker>(tracker)));
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_response_time_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_budget_percent_ = 1;
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder1, Http::Protocol::Http10);
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableHRTimer(_, _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(*router_.retry_state_, shouldHedgeRetryPerTryTimeout(_))
+      .WillOnce(Return(RetryStatus::No));
+  hedge_timer->invokeCallback();
+  EXPECT_EQ(1U, router_.upstreamRequests().size());
+  EXPECT_EQ(0U,
+            cm_.thread_local_cluster_.cluster_.info_->stats_store_.counter("upstream_rq_hedge")
+                .value());
+  // 1% of 128 requests, which was not used.
+  EXPECT_TRUE(tracker.tryHedge(1));
+  EXPECT_FALSE(tracker.tryHedge(1));
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  ASSERT(response_decoder1);
+  response_decoder1->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// Tests that a request which was already retried isn't hedged.
+TEST_F(RouterTest, HedgeOnResponseTimeAfterRetry) {
+  Upstream::ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < Upstream::ResponseTimeTrackerImpl::MinRequests; i++) {
+    tracker.recordResponseTime(std::chrono::microseconds(1000));
+  }
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, responseTimeTracker())
+      .WillByDefault(Return(std::reference_wrapper<Upstream::ResponseTimeTracker>(tracker)));
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_response_time_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_budget_percent_ = 10;
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder, Http::Protocol::Http10);
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableHRTimer(_, _));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-retry-on", "5xx"},
+                                         {"x-envoy-internal", "true"},
+                                         {"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  // The first request is retried on a 5xx response.
+  router_.retry_state_->expectHeadersRetry();
+  Http::ResponseHeaderMapPtr response_headers1(
+      new Http::TestResponseHeaderMapImpl{{":status", "503"}});
+  response_decoder->decodeHeaders(std::move(response_headers1), true);
+  NiceMock<Http::MockRequestEncoder> encoder2;
+  expectNewStreamWithImmediateEncoder(encoder2, &response_decoder, Http::Protocol::Http10);
+  router_.retry_state_->callback_();
+  EXPECT_EQ(1U, router_.upstreamRequests().size());
+
+  // The retry is the only request in flight, but it isn't hedged.
+  EXPECT_CALL(*router_.retry_state_, shouldHedgeRetryPerTryTimeout(_)).Times(0);
+  hedge_timer->invokeCallback();
+  EXPECT_EQ(1U, router_.upstreamRequests().size());
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers2(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers2), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 1));
+}
+
+// Tests that the hedge timer isn't armed without enough recent response times.
+TEST_F(RouterTest, HedgeOnResponseTimeWithoutPercentile) {
+  Upstream::ResponseTimeTrackerImpl tracker;
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, responseTimeTracker())
+      .WillByDefault(Return(std::reference_wrapper<Upstream::ResponseTimeTracker>(tracker)));
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_on_response_time_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.hedge_budget_percent_ = 10;
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder1, Http::Protocol::Http10);
+  EXPECT_CALL(callbacks_.dispatcher_, createTimer_(_)).Times(0);
+
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  ASSERT(response_decoder1);
+  response_decoder1->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// Tests that a successful response puts back tokens in the retry token buckets of the cluster and
+// of the host.
+TEST_F(RouterTest, RetryTokenBucketsRefilledOnSuccess) {
+  envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket config;
+  config.set_max_tokens(1);
+  config.mutable_max_host_tokens()->set_value(1);
+  config.mutable_token_ratio()->set_value(1.0);
+  Upstream::RetryTokenBucketsImpl buckets(config);
+  Upstream::RetryTokenBucketPtr host_bucket = buckets.createHostBucket();
+  ASSERT_TRUE(buckets.clusterBucket().tryTakeToken());
+  ASSERT_TRUE(host_bucket->tryTakeToken());
+  ON_CALL(*cm_.thread_local_cluster_.cluster_.info_, retryTokenBuckets())
+      .WillByDefault(Return(Upstream::RetryTokenBucketsOptRef(buckets)));
+  ON_CALL(*cm_.thread_local_cluster_.conn_pool_.host_, retryTokenBucket())
+      .WillByDefault(Return(Upstream::RetryTokenBucketOptRef(*host_bucket)));
+
+  NiceMock<Http::MockRequestEncoder> encoder1;
+  Http::ResponseDecoder* response_decoder1 = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder1, &response_decoder1, Http::Protocol::Http10);
+
+  Http::TestRequestHeaderMapImpl headers{{"x-envoy-upstream-rq-timeout-ms", "0"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetryHeaders(_, _, _))
+      .WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  ASSERT(response_decoder1);
+  response_decoder1->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+
+  EXPECT_TRUE(buckets.clusterBucket().hasToken());
+  EXPECT_TRUE(host_bucket->hasToken());
 }
 
 // Tests that an upstream request is reset even if it can't be retried as long as there is
@@ -4414,25 +4671,28 @@ TEST_F(RouterTest, ShadowWithClusterHeader) {
   HttpTestUtility::addDefaultHeaders(headers);
   headers.addCopy("some_header", "some_cluster");
 
+  MockShadowStream shadow_stream;
+  EXPECT_CALL(*shadow_writer_, streamingShadow_("some_cluster", _, _))
+      .WillOnce(Invoke([&](const std::string&, Http::RequestHeaderMapPtr& shadow_headers,
+                           const Http::AsyncClient::RequestOptions& options) -> ShadowStream* {
+        EXPECT_EQ(headers.getHostValue(), shadow_headers->getHostValue());
+        EXPECT_EQ(absl::optional<std::chrono::milliseconds>(10), options.timeout);
+        EXPECT_TRUE(options.sampled_.value());
+        EXPECT_TRUE(options.is_shadow);
+        return &shadow_stream;
+      }));
   router_.decodeHeaders(headers, false);
 
+  // The body is streamed to the shadow rather than buffered.
   Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
-  EXPECT_CALL(callbacks_, addDecodedData(_, true));
+  EXPECT_CALL(callbacks_, addDecodedData(_, _)).Times(0);
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("hello"), false));
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("hello"), false));
   EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
 
   Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
-  EXPECT_CALL(callbacks_, decodingBuffer())
-      .Times(AtLeast(2))
-      .WillRepeatedly(Return(body_data.get()));
-
-  EXPECT_CALL(*shadow_writer_, shadow_("some_cluster", _, _))
-      .WillOnce(Invoke([](const std::string&, Http::RequestMessagePtr& request,
-                          const Http::AsyncClient::RequestOptions& options) -> void {
-        EXPECT_NE(request->body().length(), 0);
-        EXPECT_NE(nullptr, request->trailers());
-        EXPECT_EQ(absl::optional<std::chrono::milliseconds>(10), options.timeout);
-        EXPECT_TRUE(options.sampled_.value());
-      }));
+  EXPECT_CALL(shadow_stream, sendTrailers(HeaderMapEqualRef(&trailers)));
+  EXPECT_CALL(*shadow_writer_, shadow_(_, _, _)).Times(0);
   router_.decodeTrailers(trailers);
   EXPECT_EQ(1U,
             callbacks_.route_->route_entry_.virtual_cluster_.stats().upstream_rq_total_.value());
@@ -4461,10 +4721,11 @@ TEST_F(RouterTest, ShadowNoClusterHeaderInHeader) {
   expectResponseTimerCreate();
   Http::TestRequestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
+  EXPECT_CALL(*shadow_writer_, streamingShadow_(_, _, _)).Times(0);
   router_.decodeHeaders(headers, false);
 
   Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
-  EXPECT_CALL(callbacks_, addDecodedData(_, true));
+  EXPECT_CALL(callbacks_, addDecodedData(_, _)).Times(0);
   EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
 
   Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
@@ -4499,10 +4760,11 @@ TEST_F(RouterTest, ShadowClusterNameEmptyInHeader) {
   Http::TestRequestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
   headers.addCopy("some_header", "");
+  EXPECT_CALL(*shadow_writer_, streamingShadow_(_, _, _)).Times(0);
   router_.decodeHeaders(headers, false);
 
   Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
-  EXPECT_CALL(callbacks_, addDecodedData(_, true));
+  EXPECT_CALL(callbacks_, addDecodedData(_, _)).Times(0);
   EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
 
   Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
@@ -4541,6 +4803,187 @@ TEST_F(RouterTest, Shadow) {
                      testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)), 43))
       .WillOnce(Return(true));
 
+  MockShadowStream foo_stream;
+  MockShadowStream fizz_stream;
+  EXPECT_CALL(*shadow_writer_, streamingShadow_("foo", _, _))
+      .WillOnce(Invoke([&](const std::string&, Http::RequestHeaderMapPtr&,
+                           const Http::AsyncClient::RequestOptions& options) -> ShadowStream* {
+        EXPECT_EQ(absl::optional<std::chrono::milliseconds>(10), options.timeout);
+        EXPECT_TRUE(options.sampled_.value());
+        return &foo_stream;
+      }));
+  EXPECT_CALL(*shadow_writer_, streamingShadow_("fizz", _, _))
+      .WillOnce(Invoke([&](const std::string&, Http::RequestHeaderMapPtr&,
+                           const Http::AsyncClient::RequestOptions& options) -> ShadowStream* {
+        EXPECT_EQ(absl::optional<std::chrono::milliseconds>(10), options.timeout);
+        EXPECT_FALSE(options.sampled_.value());
+        return &fizz_stream;
+      }));
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  // Every shadow and the upstream request get the whole body, each in its own buffer.
+  Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
+  EXPECT_CALL(callbacks_, addDecodedData(_, _)).Times(0);
+  EXPECT_CALL(foo_stream, sendData(BufferStringEqual("hello"), false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) { data.drain(data.length()); }));
+  EXPECT_CALL(fizz_stream, sendData(BufferStringEqual("hello"), false));
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("hello"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(*body_data, false));
+
+  Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
+  EXPECT_CALL(foo_stream, sendTrailers(HeaderMapEqualRef(&trailers)));
+  EXPECT_CALL(fizz_stream, sendTrailers(HeaderMapEqualRef(&trailers)));
+  EXPECT_CALL(*shadow_writer_, shadow_(_, _, _)).Times(0);
+  router_.decodeTrailers(trailers);
+  EXPECT_EQ(1U,
+            callbacks_.route_->route_entry_.virtual_cluster_.stats().upstream_rq_total_.value());
+
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterTest, ShadowEndStreamWithData) {
+  ShadowPolicyPtr policy = makeShadowPolicy("foo", "", "bar");
+  callbacks_.route_->route_entry_.shadow_policies_.push_back(policy);
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  expectResponseTimerCreate();
+
+  EXPECT_CALL(
+      runtime_.snapshot_,
+      featureEnabled("bar", testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)),
+                     43))
+      .WillOnce(Return(true));
+
+  MockShadowStream shadow_stream;
+  EXPECT_CALL(*shadow_writer_, streamingShadow_("foo", _, _)).WillOnce(Return(&shadow_stream));
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  Buffer::OwnedImpl body_data1("hello");
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("hello"), false));
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("hello"), false));
+  router_.decodeData(body_data1, false);
+
+  // The request is ended by the last data, so the shadow isn't used anymore.
+  Buffer::OwnedImpl body_data2("world");
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("world"), true));
+  EXPECT_CALL(encoder, encodeData(BufferStringEqual("world"), true));
+  EXPECT_CALL(*shadow_writer_, shadow_(_, _, _)).Times(0);
+  router_.decodeData(body_data2, true);
+
+  EXPECT_CALL(shadow_stream, reset()).Times(0);
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  router_.onDestroy();
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterTest, ShadowResetOnIncompleteRequest) {
+  ShadowPolicyPtr policy = makeShadowPolicy("foo", "", "bar");
+  callbacks_.route_->route_entry_.shadow_policies_.push_back(policy);
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  EXPECT_CALL(
+      runtime_.snapshot_,
+      featureEnabled("bar", testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)),
+                     43))
+      .WillOnce(Return(true));
+
+  MockShadowStream shadow_stream;
+  EXPECT_CALL(*shadow_writer_, streamingShadow_("foo", _, _)).WillOnce(Return(&shadow_stream));
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  Buffer::OwnedImpl body_data("hello");
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("hello"), false));
+  router_.decodeData(body_data, false);
+
+  // The downstream request is reset before it is complete.
+  EXPECT_CALL(shadow_stream, reset());
+  EXPECT_CALL(encoder.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  router_.onDestroy();
+}
+
+TEST_F(RouterTest, ShadowHeaderOnlyRequest) {
+  ShadowPolicyPtr policy = makeShadowPolicy("foo", "", "bar");
+  callbacks_.route_->route_entry_.shadow_policies_.push_back(policy);
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  expectResponseTimerCreate();
+
+  EXPECT_CALL(
+      runtime_.snapshot_,
+      featureEnabled("bar", testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)),
+                     43))
+      .WillOnce(Return(true));
+
+  // There is no body to stream, so the complete request is shadowed.
+  EXPECT_CALL(*shadow_writer_, streamingShadow_(_, _, _)).Times(0);
+  EXPECT_CALL(*shadow_writer_, shadow_("foo", _, _))
+      .WillOnce(Invoke([](const std::string&, Http::RequestMessagePtr& request,
+                          const Http::AsyncClient::RequestOptions& options) -> void {
+        EXPECT_EQ(request->body().length(), 0);
+        EXPECT_EQ(nullptr, request->trailers());
+        EXPECT_EQ(absl::optional<std::chrono::milliseconds>(10), options.timeout);
+      }));
+  Http::TestRequestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  Http::ResponseHeaderMapPtr response_headers(
+      new Http::TestResponseHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterTest, ShadowBufferedWithoutStreaming) {
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.streaming_shadow", "false"}});
+
+  ShadowPolicyPtr policy = makeShadowPolicy("foo", "", "bar");
+  callbacks_.route_->route_entry_.shadow_policies_.push_back(policy);
+  policy = makeShadowPolicy("fizz", "", "buzz", envoy::type::v3::FractionalPercent(), false);
+  callbacks_.route_->route_entry_.shadow_policies_.push_back(policy);
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockRequestEncoder> encoder;
+  Http::ResponseDecoder* response_decoder = nullptr;
+  expectNewStreamWithImmediateEncoder(encoder, &response_decoder, Http::Protocol::Http10);
+
+  expectResponseTimerCreate();
+
+  EXPECT_CALL(
+      runtime_.snapshot_,
+      featureEnabled("bar", testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)),
+                     43))
+      .WillOnce(Return(true));
+  EXPECT_CALL(
+      runtime_.snapshot_,
+      featureEnabled("buzz",
+                     testing::Matcher<const envoy::type::v3::FractionalPercent&>(Percent(0)), 43))
+      .WillOnce(Return(true));
+
+  EXPECT_CALL(*shadow_writer_, streamingShadow_(_, _, _)).Times(0);
   Http::TestRequestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
   router_.decodeHeaders(headers, false);
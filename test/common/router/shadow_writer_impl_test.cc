@@ -1,11 +1,16 @@
 #include <chrono>
 #include <string>
 
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/header_map_impl.h"
 #include "source/common/http/headers.h"
 #include "source/common/http/message_impl.h"
 #include "source/common/router/shadow_writer_impl.h"
 
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/http/mocks.h"
 #include "test/mocks/upstream/cluster_manager.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -44,10 +49,37 @@ public:
     writer_.shadow("foo", std::move(message), options);
   }
 
+  ShadowStream* expectStreamingShadowWriter(absl::string_view host,
+                                            absl::string_view shadowed_host) {
+    auto headers = Http::RequestHeaderMapImpl::create();
+    headers->setHost(host);
+    cm_.initializeThreadLocalClusters({"foo"});
+    EXPECT_CALL(cm_, getThreadLocalCluster(Eq("foo")));
+    EXPECT_CALL(cm_.thread_local_cluster_, httpAsyncClient())
+        .WillOnce(ReturnRef(cm_.thread_local_cluster_.async_client_));
+    auto options = Http::AsyncClient::RequestOptions().setTimeout(std::chrono::milliseconds(5));
+    EXPECT_CALL(cm_.thread_local_cluster_.async_client_, start(_, _))
+        .WillOnce(Invoke([&](Http::AsyncClient::StreamCallbacks& callbacks,
+                             const Http::AsyncClient::StreamOptions& inner_options)
+                             -> Http::AsyncClient::Stream* {
+          EXPECT_EQ(std::chrono::milliseconds(5), inner_options.timeout);
+          EXPECT_TRUE(inner_options.is_shadow);
+          stream_callbacks_ = &callbacks;
+          return &stream_;
+        }));
+    EXPECT_CALL(stream_, sendHeaders(_, false))
+        .WillOnce(Invoke([shadowed_host](Http::RequestHeaderMap& headers, bool) {
+          EXPECT_EQ(shadowed_host, headers.getHostValue());
+        }));
+    return writer_.streamingShadow("foo", std::move(headers), options);
+  }
+
   Upstream::MockClusterManager cm_;
   ShadowWriterImpl writer_{cm_};
   Http::MockAsyncClientRequest request_{&cm_.thread_local_cluster_.async_client_};
   Http::AsyncClient::Callbacks* callback_{};
+  Http::MockAsyncClientStream stream_;
+  Http::AsyncClient::StreamCallbacks* stream_callbacks_{};
 };
 
 TEST_F(ShadowWriterImplTest, Success) {
@@ -75,6 +107,103 @@ TEST_F(ShadowWriterImplTest, NoCluster) {
   writer_.shadow("foo", std::move(message), options);
 }
 
+TEST_F(ShadowWriterImplTest, StreamingSuccess) {
+  InSequence s;
+
+  ShadowStream* shadow_stream =
+      expectStreamingShadowWriter("cluster1:8000", "cluster1-shadow:8000");
+  ASSERT_NE(nullptr, shadow_stream);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(false));
+  EXPECT_CALL(stream_, sendData(BufferStringEqual("hello"), false));
+  shadow_stream->sendData(data, false);
+
+  Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
+  EXPECT_CALL(stream_, sendTrailers(HeaderMapEqualRef(&trailers)));
+  shadow_stream->sendTrailers(trailers);
+
+  // The shadow stream deletes itself once the response is complete.
+  stream_callbacks_->onHeaders(
+      Http::ResponseHeaderMapPtr{new Http::TestResponseHeaderMapImpl{{":status", "200"}}}, true);
+  stream_callbacks_->onComplete();
+}
+
+TEST_F(ShadowWriterImplTest, StreamingCompleteBeforeRequestEnds) {
+  InSequence s;
+
+  ShadowStream* shadow_stream = expectStreamingShadowWriter("cluster1", "cluster1-shadow");
+  ASSERT_NE(nullptr, shadow_stream);
+
+  // The shadow responds early, so the rest of the request is dropped.
+  stream_callbacks_->onHeaders(
+      Http::ResponseHeaderMapPtr{new Http::TestResponseHeaderMapImpl{{":status", "400"}}}, true);
+  stream_callbacks_->onComplete();
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, isAboveWriteBufferHighWatermark()).Times(0);
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow_stream->sendData(data, true);
+}
+
+TEST_F(ShadowWriterImplTest, StreamingAboveHighWatermark) {
+  InSequence s;
+
+  ShadowStream* shadow_stream = expectStreamingShadowWriter("cluster1", "cluster1-shadow");
+  ASSERT_NE(nullptr, shadow_stream);
+
+  // The shadow is given up on rather than buffering the body for it.
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  EXPECT_CALL(stream_, reset()).WillOnce(Invoke([this]() { stream_callbacks_->onReset(); }));
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow_stream->sendData(data, false);
+
+  Http::TestRequestTrailerMapImpl trailers{{"some", "trailer"}};
+  EXPECT_CALL(stream_, sendTrailers(_)).Times(0);
+  shadow_stream->sendTrailers(trailers);
+}
+
+TEST_F(ShadowWriterImplTest, StreamingReset) {
+  InSequence s;
+
+  ShadowStream* shadow_stream = expectStreamingShadowWriter("cluster1", "cluster1-shadow");
+  ASSERT_NE(nullptr, shadow_stream);
+
+  EXPECT_CALL(stream_, reset()).WillOnce(Invoke([this]() { stream_callbacks_->onReset(); }));
+  shadow_stream->reset();
+}
+
+TEST_F(ShadowWriterImplTest, StreamingStartFailure) {
+  InSequence s;
+
+  cm_.initializeThreadLocalClusters({"foo"});
+  EXPECT_CALL(cm_, getThreadLocalCluster(Eq("foo")));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpAsyncClient())
+      .WillOnce(ReturnRef(cm_.thread_local_cluster_.async_client_));
+  EXPECT_CALL(cm_.thread_local_cluster_.async_client_, start(_, _))
+      .WillOnce(Invoke([](Http::AsyncClient::StreamCallbacks& callbacks,
+                          const Http::AsyncClient::StreamOptions&) -> Http::AsyncClient::Stream* {
+        callbacks.onReset();
+        return nullptr;
+      }));
+  auto headers = Http::RequestHeaderMapImpl::create();
+  headers->setHost("cluster1");
+  EXPECT_EQ(nullptr, writer_.streamingShadow("foo", std::move(headers),
+                                             Http::AsyncClient::RequestOptions()));
+}
+
+TEST_F(ShadowWriterImplTest, StreamingNoCluster) {
+  InSequence s;
+
+  EXPECT_CALL(cm_, getThreadLocalCluster(Eq("foo"))).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpAsyncClient()).Times(0);
+  auto headers = Http::RequestHeaderMapImpl::create();
+  headers->setHost("cluster1");
+  EXPECT_EQ(nullptr, writer_.streamingShadow("foo", std::move(headers),
+                                             Http::AsyncClient::RequestOptions()));
+}
+
 } // namespace
 } // namespace Router
 } // namespace Envoy
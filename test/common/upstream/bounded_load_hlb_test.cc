@@ -6,6 +6,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/test_runtime.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -39,7 +40,7 @@ public:
 
 private:
   HostOverloadFactorPredicate host_overload_factor_;
-  double hostOverloadFactor(const Host& host, double weight) const override {
+  double hostOverloadFactor(const Host& host, double weight, uint32_t) const override {
     return host_overload_factor_(host, weight);
   }
 };
@@ -86,6 +87,14 @@ public:
   std::unique_ptr<ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer> lb_;
   std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
 
+  // The shuffling of the hosts seeded by the hash, which the tests of the exact fallback host
+  // sequences below were written for.
+  void useShuffling() {
+    scoped_runtime_.mergeValues(
+        {{"envoy.reloadable_features.bounded_load_hash_probe_steps", "false"}});
+  }
+
+  TestScopedRuntime scoped_runtime_;
   HostOverloadFactorPredicate host_overload_factor_predicate_;
 };
 
@@ -176,6 +185,7 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, OneHostOverloaded) {
   NormalizedHostWeightVector ring(normalized_host_weights);
   hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
 
+  useShuffling();
   lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
                                                              host_overload_factor_predicate_);
 
@@ -204,6 +214,7 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, MultipleHostOverloaded) {
   NormalizedHostWeightVector ring(normalized_host_weights);
   hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
 
+  useShuffling();
   lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
                                                              host_overload_factor_predicate_);
 
@@ -231,6 +242,7 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, MultipleHashSameHostOverloaded) {
 
   hlb_ = std::make_shared<TestHashingLoadBalancer>(hosts_on_ring);
 
+  useShuffling();
   lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
                                                              host_overload_factor_predicate_);
 
@@ -261,6 +273,7 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, AllHostsOverloaded) {
   NormalizedHostWeightVector ring(normalized_host_weights);
   hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
 
+  useShuffling();
   lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
                                                              host_overload_factor_predicate_);
 
@@ -269,6 +282,130 @@ TEST_F(BoundedLoadHashingLoadBalancerTest, AllHostsOverloaded) {
   EXPECT_EQ(host->address()->asString(), "127.0.0.11:90");
 };
 
+// The hosts are probed from the overloaded host by a step picked by the hash. The step for hash 2
+// is 2, so host 4 is picked up.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingOneHostOverloaded) {
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  NormalizedHostWeightVector ring(normalized_host_weights);
+  hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
+
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_EQ(host->address()->asString(), "127.0.0.14:90");
+};
+
+// Hosts 2, 4 and 1 are overloaded, so probing by step 2 from host 2 passes over hosts 4 and 1 and
+// picks host 3 up.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingMultipleHostOverloaded) {
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.12:90");
+  addresses.push_back("127.0.0.14:90");
+  addresses.push_back("127.0.0.11:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  NormalizedHostWeightVector ring(normalized_host_weights);
+  hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
+
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(2, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_EQ(host->address()->asString(), "127.0.0.13:90");
+};
+
+// The hashes 6 and 7 map to the overloaded host 3, and probe from it by the steps 2 and 1, so they
+// overflow to different hosts.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingMultipleHashSameHostOverloaded) {
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.13:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights, hosts_on_ring;
+  createHosts(5, normalized_host_weights, hosts_on_ring);
+
+  hlb_ = std::make_shared<TestHashingLoadBalancer>(hosts_on_ring);
+
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host1 = lb_->chooseHost(6, 1);
+  EXPECT_NE(host1, nullptr);
+  EXPECT_EQ(host1->address()->asString(), "127.0.0.10:90");
+  HostConstSharedPtr host2 = lb_->chooseHost(7, 1);
+  EXPECT_NE(host2, nullptr);
+  EXPECT_EQ(host2->address()->asString(), "127.0.0.14:90");
+};
+
+// When all hosts are overloaded, every host is probed exactly once and the least overloaded one
+// is picked up.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingAllHostsOverloaded) {
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.13:90");
+  addresses.push_back("127.0.0.10:90");
+  addresses.push_back("127.0.0.14:90");
+  addresses.push_back("127.0.0.11:90");
+  addresses.push_back("127.0.0.12:90");
+  absl::flat_hash_map<std::string, uint32_t> probes;
+  HostOverloadFactorPredicate overload_factor = getHostOverloadFactorPredicate(addresses);
+  host_overload_factor_predicate_ = [&](const Host& host, double weight) {
+    probes[host.address()->asString()]++;
+    return overload_factor(host, weight);
+  };
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(5, normalized_host_weights);
+
+  NormalizedHostWeightVector ring(normalized_host_weights);
+  hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
+
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  for (uint32_t hash = 0; hash < 5; hash++) {
+    probes.clear();
+    HostConstSharedPtr host = lb_->chooseHost(hash, 1);
+    EXPECT_NE(host, nullptr);
+    EXPECT_EQ(host->address()->asString(), "127.0.0.13:90");
+    EXPECT_EQ(probes.size(), 5);
+    for (const auto& [address, count] : probes) {
+      EXPECT_EQ(count, 1) << address;
+    }
+  }
+};
+
+// A single overloaded host is kept, as there is nowhere else to go.
+TEST_F(BoundedLoadHashingLoadBalancerTest, ProbingSingleHostOverloaded) {
+  std::vector<std::string> addresses;
+  addresses.push_back("127.0.0.10:90");
+  host_overload_factor_predicate_ = getHostOverloadFactorPredicate(addresses);
+
+  NormalizedHostWeightVector normalized_host_weights;
+  createHosts(1, normalized_host_weights);
+
+  NormalizedHostWeightVector ring(normalized_host_weights);
+  hlb_ = std::make_shared<TestHashingLoadBalancer>(ring);
+
+  lb_ = std::make_unique<TestBoundedLoadHashingLoadBalancer>(hlb_, normalized_host_weights, 1,
+                                                             host_overload_factor_predicate_);
+
+  HostConstSharedPtr host = lb_->chooseHost(0, 1);
+  EXPECT_NE(host, nullptr);
+  EXPECT_EQ(host->address()->asString(), "127.0.0.10:90");
+};
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -35,8 +35,9 @@ public:
   }
 
   void invokeClusterAdded(ThreadLocalCluster& cluster) {
+    ThreadLocalClusterCommand command = [&cluster]() -> ThreadLocalCluster& { return cluster; };
     for (auto& cb : update_callbacks_) {
-      cb->onClusterAddOrUpdate(cluster);
+      cb->onClusterAddOrUpdate(cluster.info()->name(), command);
     }
   }
 
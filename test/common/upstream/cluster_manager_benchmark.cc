@@ -0,0 +1,125 @@
+// Usage: bazel run //test/common/upstream:cluster_manager_benchmark
+//
+// Measures the memory and the time it takes to create a cluster manager with many static clusters,
+// with and without deferred cluster creation. The thread local instance of the test runs on the
+// main thread, so the difference between the two modes is what every worker saves.
+
+#include <memory>
+
+#include "envoy/config/bootstrap/v3/bootstrap.pb.h"
+#include "envoy/config/cluster/v3/cluster.pb.h"
+
+#include "source/common/memory/stats.h"
+#include "source/common/router/context_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/test_cluster_manager.h"
+#include "test/mocks/protobuf/mocks.h"
+#include "test/mocks/server/instance.h"
+#include "test/test_common/registry.h"
+#include "test/test_common/simulated_time_system.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+envoy::config::bootstrap::v3::Bootstrap staticClustersBootstrap(uint64_t num_clusters,
+                                                                uint64_t hosts_per_cluster,
+                                                                bool deferred) {
+  envoy::config::bootstrap::v3::Bootstrap bootstrap;
+  if (deferred) {
+    bootstrap.mutable_cluster_manager()->mutable_deferred_cluster_creation();
+  }
+  for (uint64_t i = 0; i < num_clusters; i++) {
+    auto* cluster = bootstrap.mutable_static_resources()->add_clusters();
+    cluster->set_name(absl::StrCat("cluster_", i));
+    cluster->set_type(envoy::config::cluster::v3::Cluster::STATIC);
+    cluster->mutable_connect_timeout()->set_seconds(1);
+    auto* lb_endpoints =
+        cluster->mutable_load_assignment()->add_endpoints()->mutable_lb_endpoints();
+    for (uint64_t j = 0; j < hosts_per_cluster; j++) {
+      auto* socket_address =
+          lb_endpoints->Add()->mutable_endpoint()->mutable_address()->mutable_socket_address();
+      socket_address->set_address(fmt::format("10.{}.{}.{}", i % 256, j / 256, j % 256));
+      socket_address->set_port_value(80);
+    }
+  }
+  return bootstrap;
+}
+
+class ClusterManagerTester {
+public:
+  ClusterManagerTester()
+      : http_context_(factory_.stats_.symbolTable()), grpc_context_(factory_.stats_.symbolTable()),
+        router_context_(factory_.stats_.symbolTable()),
+        registered_dns_factory_(dns_resolver_factory_) {}
+
+  void create(const envoy::config::bootstrap::v3::Bootstrap& bootstrap) {
+    cluster_manager_ = std::make_unique<TestClusterManagerImpl>(
+        bootstrap, factory_, factory_.stats_, factory_.tls_, factory_.runtime_,
+        factory_.local_info_, log_manager_, factory_.dispatcher_, admin_, validation_context_,
+        *factory_.api_, http_context_, grpc_context_, router_context_, server_);
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<TestClusterManagerFactory> factory_;
+  NiceMock<ProtobufMessage::MockValidationContext> validation_context_;
+  NiceMock<AccessLog::MockAccessLogManager> log_manager_;
+  NiceMock<Server::MockAdmin> admin_;
+  Http::ContextImpl http_context_;
+  Grpc::ContextImpl grpc_context_;
+  Router::ContextImpl router_context_;
+  NiceMock<Server::MockInstance> server_;
+  NiceMock<Network::MockDnsResolverFactory> dns_resolver_factory_;
+  Registry::InjectFactory<Network::DnsResolverFactory> registered_dns_factory_;
+  std::unique_ptr<TestClusterManagerImpl> cluster_manager_;
+};
+
+// Args: number of clusters, hosts per cluster, clusters looked up, deferred cluster creation.
+void benchmarkClusterManagerCreate(::benchmark::State& state) {
+  const uint64_t num_clusters = state.range(0);
+  const uint64_t hosts_per_cluster = state.range(1);
+  const uint64_t used_clusters = state.range(2);
+  const bool deferred = state.range(3) != 0;
+  if (benchmark::skipExpensiveBenchmarks() && num_clusters > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  const auto bootstrap = staticClustersBootstrap(num_clusters, hosts_per_cluster, deferred);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    ClusterManagerTester tester;
+    const size_t start_mem = Memory::Stats::totalCurrentlyAllocated();
+
+    state.ResumeTiming();
+    tester.create(bootstrap);
+    for (uint64_t i = 0; i < used_clusters; i++) {
+      RELEASE_ASSERT(tester.cluster_manager_->getThreadLocalCluster(absl::StrCat("cluster_", i)) !=
+                         nullptr,
+                     "");
+    }
+    state.PauseTiming();
+
+    const size_t end_mem = Memory::Stats::totalCurrentlyAllocated();
+    state.counters["memory"] = end_mem - start_mem;
+    state.counters["memory_per_cluster"] = (end_mem - start_mem) / num_clusters;
+    tester.factory_.tls_.shutdownThread();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(benchmarkClusterManagerCreate)
+    ->Args({100, 10, 100, 0})
+    ->Args({100, 10, 100, 1})
+    ->Args({100, 10, 10, 1})
+    ->Args({1000, 10, 1000, 0})
+    ->Args({1000, 10, 10, 1})
+    ->Args({1000, 100, 1000, 0})
+    ->Args({1000, 100, 10, 1})
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
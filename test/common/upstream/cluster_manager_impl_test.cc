@@ -1975,7 +1975,7 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
       .WillOnce(Return(std::make_pair(cluster1, nullptr)));
   EXPECT_CALL(*cluster1, initializePhase()).Times(0);
   EXPECT_CALL(*cluster1, initialize(_));
-  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_));
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_, _));
   EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("fake_cluster"), ""));
   checkStats(1 /*added*/, 0 /*modified*/, 0 /*removed*/, 0 /*active*/, 1 /*warming*/);
   EXPECT_EQ(1, cluster_manager_->warmingClusterCount());
@@ -2004,7 +2004,7 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
         // Test inline init.
         initialize_callback();
       }));
-  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_));
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_, _));
   EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(update_cluster, ""));
 
   EXPECT_EQ(cluster2->info_, cluster_manager_->getThreadLocalCluster("fake_cluster")->info());
@@ -2061,6 +2061,99 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(callbacks.get()));
 }
 
+// Verify that with deferred cluster creation, thread local clusters are only created when they are
+// looked up, or when an update callback asks for them.
+TEST_F(ClusterManagerImplTest, DeferredClusterCreation) {
+  const std::string json = fmt::sprintf("{\"static_resources\":{%s}}",
+                                        clustersJson({defaultStaticClusterJson("cluster_1")}));
+  auto bootstrap = parseBootstrapFromV3Json(json);
+  bootstrap.mutable_cluster_manager()->mutable_deferred_cluster_creation();
+  create(bootstrap);
+
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterCreated("cluster_1"));
+  ThreadLocalCluster* cluster = cluster_manager_->getThreadLocalCluster("cluster_1");
+  ASSERT_NE(nullptr, cluster);
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_1"));
+  EXPECT_EQ(1UL, cluster->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  Cluster& active_cluster = cluster_manager_->activeClusters().at("cluster_1");
+  EXPECT_EQ(active_cluster.prioritySet().hostSetsPerPriority()[0]->hosts()[0],
+            cluster->loadBalancer().chooseHost(nullptr));
+  EXPECT_EQ(nullptr, cluster_manager_->getThreadLocalCluster("unknown"));
+
+  std::unique_ptr<MockClusterUpdateCallbacks> callbacks(new NiceMock<MockClusterUpdateCallbacks>());
+  ClusterUpdateCallbacksHandlePtr cb =
+      cluster_manager_->addThreadLocalClusterUpdateCallbacks(*callbacks);
+
+  // Callbacks are notified of a new cluster without creating it.
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate("cluster_2", _));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("cluster_2"), ""));
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterCreated("cluster_2"));
+
+  // Unless one of them asks for it.
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate("cluster_3", _))
+      .WillOnce(Invoke([](absl::string_view, ThreadLocalClusterCommand& get_cluster) {
+        EXPECT_EQ("cluster_3", get_cluster().info()->name());
+      }));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("cluster_3"), ""));
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_3"));
+
+  // Clusters that were never created can be removed.
+  EXPECT_CALL(*callbacks, onClusterRemoval("cluster_2"));
+  EXPECT_TRUE(cluster_manager_->removeCluster("cluster_2"));
+  EXPECT_EQ(nullptr, cluster_manager_->getThreadLocalCluster("cluster_2"));
+
+  EXPECT_CALL(*callbacks, onClusterRemoval("cluster_3"));
+  EXPECT_TRUE(cluster_manager_->removeCluster("cluster_3"));
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterCreated("cluster_3"));
+  EXPECT_EQ(nullptr, cluster_manager_->getThreadLocalCluster("cluster_3"));
+
+  factory_.tls_.shutdownThread();
+}
+
+// Verify that deferred clusters that are not used for an idle timeout are dropped, and are created
+// again when they are looked up. Clusters tracked by update callbacks are kept.
+TEST_F(ClusterManagerImplTest, DeferredClusterIdleTimeout) {
+  const std::string json = fmt::sprintf(
+      "{\"static_resources\":{%s}}",
+      clustersJson({defaultStaticClusterJson("cluster_1"), defaultStaticClusterJson("cluster_2")}));
+  auto bootstrap = parseBootstrapFromV3Json(json);
+  bootstrap.mutable_cluster_manager()
+      ->mutable_deferred_cluster_creation()
+      ->mutable_idle_timeout()
+      ->set_seconds(60);
+  Event::MockTimer* idle_timer = new NiceMock<Event::MockTimer>(&factory_.tls_.dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000), _)).Times(3);
+  create(bootstrap);
+
+  std::unique_ptr<MockClusterUpdateCallbacks> callbacks(new NiceMock<MockClusterUpdateCallbacks>());
+  ClusterUpdateCallbacksHandlePtr cb =
+      cluster_manager_->addThreadLocalClusterUpdateCallbacks(*callbacks);
+  ON_CALL(*callbacks, tracksCluster(_)).WillByDefault(Return(false));
+  ON_CALL(*callbacks, tracksCluster("cluster_2")).WillByDefault(Return(true));
+
+  ASSERT_NE(nullptr, cluster_manager_->getThreadLocalCluster("cluster_1"));
+  ASSERT_NE(nullptr, cluster_manager_->getThreadLocalCluster("cluster_2"));
+
+  // The clusters were used in this period, so they are kept.
+  EXPECT_CALL(*callbacks, onClusterAddOrUpdate(_, _)).Times(0);
+  idle_timer->invokeCallback();
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_1"));
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_2"));
+
+  // They were not used in the next one. The untracked cluster is dropped without notifying the
+  // callbacks, and the cluster the callbacks hold on to is kept.
+  idle_timer->invokeCallback();
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterCreated("cluster_1"));
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_2"));
+
+  ThreadLocalCluster* cluster = cluster_manager_->getThreadLocalCluster("cluster_1");
+  ASSERT_NE(nullptr, cluster);
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterCreated("cluster_1"));
+  EXPECT_EQ(1UL, cluster->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  factory_.tls_.shutdownThread();
+}
+
 TEST_F(ClusterManagerImplTest, AddOrUpdateClusterStaticExists) {
   const std::string json = fmt::sprintf("{\"static_resources\":{%s}}",
                                         clustersJson({defaultStaticClusterJson("fake_cluster")}));
@@ -41,6 +41,8 @@ TEST_F(ClusterUpdateTrackerTest, ClusterDoesExistAtConstructionTime) {
 
   EXPECT_TRUE(cluster_tracker.threadLocalCluster().has_value());
   EXPECT_EQ(cluster_tracker.threadLocalCluster()->get().info(), expected_.cluster_.info_);
+  EXPECT_TRUE(cluster_tracker.tracksCluster(cluster_name_));
+  EXPECT_FALSE(cluster_tracker.tracksCluster(irrelevant_.cluster_.info_->name_));
 }
 
 TEST_F(ClusterUpdateTrackerTest, ShouldProperlyHandleUpdateCallbacks) {
@@ -52,14 +54,16 @@ TEST_F(ClusterUpdateTrackerTest, ShouldProperlyHandleUpdateCallbacks) {
 
   {
     // Simulate addition of an irrelevant cluster.
-    cluster_tracker.onClusterAddOrUpdate(irrelevant_);
+    ThreadLocalClusterCommand command = [this]() -> ThreadLocalCluster& { return irrelevant_; };
+    cluster_tracker.onClusterAddOrUpdate(irrelevant_.cluster_.info_->name_, command);
 
     EXPECT_FALSE(cluster_tracker.threadLocalCluster().has_value());
   }
 
   {
     // Simulate addition of the relevant cluster.
-    cluster_tracker.onClusterAddOrUpdate(expected_);
+    ThreadLocalClusterCommand command = [this]() -> ThreadLocalCluster& { return expected_; };
+    cluster_tracker.onClusterAddOrUpdate(expected_.cluster_.info_->name_, command);
 
     ASSERT_TRUE(cluster_tracker.threadLocalCluster().has_value());
     EXPECT_EQ(cluster_tracker.threadLocalCluster()->get().info(), expected_.cluster_.info_);
@@ -4676,6 +4676,140 @@ TEST_F(TcpHealthCheckerImplTest, ConnectionLocalFailure) {
   EXPECT_EQ(0UL, cluster_->info_->stats_store_.counter("health_check.passive_failure").value());
 }
 
+// Tests that a host which is in two clusters with the same shared health check config is checked
+// by the session of one cluster only, and that the results are applied to the host of the other.
+TEST_F(TcpHealthCheckerImplTest, SharedAcrossClusters) {
+  const std::string yaml = R"EOF(
+    timeout: 1s
+    interval: 1s
+    no_traffic_interval: 10s
+    unhealthy_threshold: 1
+    healthy_threshold: 1
+    share_across_clusters: true
+    tcp_health_check: {}
+    )EOF";
+  auto scheduler = std::make_shared<SharedHealthCheckScheduler>();
+  allocHealthChecker(yaml);
+  health_checker_->setSharedScheduler(scheduler);
+  auto other_cluster = std::make_shared<NiceMock<MockClusterMockPrioritySet>>();
+  auto other_health_checker = std::make_shared<TcpHealthCheckerImpl>(
+      *other_cluster, parseHealthCheckFromV3Yaml(yaml), dispatcher_, runtime_, random_,
+      std::make_unique<NiceMock<MockHealthCheckEventLogger>>());
+  other_health_checker->setSharedScheduler(scheduler);
+
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80", simTime())};
+  other_cluster->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(other_cluster->info_, "tcp://127.0.0.1:80", simTime())};
+  const HostSharedPtr other_host = other_cluster->prioritySet().getMockHostSet(0)->hosts_[0];
+
+  // Both sessions send their initial check, so that no cluster waits for another one to warm.
+  expectSessionCreate();
+  expectClientCreate();
+  health_checker_->start();
+  Event::MockTimer* prober_interval_timer = interval_timer_;
+  Network::MockClientConnection* prober_connection = connection_;
+
+  expectSessionCreate();
+  expectClientCreate();
+  other_health_checker->start();
+  EXPECT_EQ(1UL, scheduler->numGroups());
+
+  // Only the session which joined the group first keeps checking the host. The first interval of
+  // the group is shortened to its phase.
+  EXPECT_CALL(*interval_timer_, enableTimer(_, _)).Times(0);
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_FALSE(other_host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC));
+  EXPECT_CALL(*prober_interval_timer, enableTimer(std::chrono::milliseconds(6180), _));
+  prober_connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // A failed check of the prober is applied to the host of the other cluster.
+  expectClientCreate();
+  prober_interval_timer->invokeCallback();
+  EXPECT_CALL(*prober_interval_timer, enableTimer(std::chrono::milliseconds(10000), _));
+  connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_TRUE(other_host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC));
+  EXPECT_EQ(1UL, other_cluster->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(1UL, other_cluster->info_->stats_store_.counter("health_check.failure").value());
+
+  // When the host leaves the cluster of the prober, the session of the other cluster takes over.
+  testing::Mock::VerifyAndClearExpectations(interval_timer_);
+  HostVector removed = cluster_->prioritySet().getMockHostSet(0)->hosts_;
+  cluster_->prioritySet().getMockHostSet(0)->hosts_.clear();
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  cluster_->prioritySet().getMockHostSet(0)->runCallbacks({}, removed);
+  EXPECT_EQ(1UL, scheduler->numGroups());
+
+  other_health_checker.reset();
+  EXPECT_EQ(0UL, scheduler->numGroups());
+}
+
+class MockSharedHealthCheckSubscriber : public SharedHealthCheckSubscriber {
+public:
+  MOCK_METHOD(void, onSharedResult, (const SharedHealthCheckResult& result));
+  MOCK_METHOD(void, onProbingStarted, ());
+  MOCK_METHOD(std::chrono::milliseconds, nextCheckInterval, (), (const));
+};
+
+TEST(SharedHealthCheckSchedulerTest, GroupsProbersAndResults) {
+  SharedHealthCheckScheduler scheduler;
+  const SharedHealthCheckScheduler::Key key{1, "127.0.0.1:80"};
+  NiceMock<MockSharedHealthCheckSubscriber> first;
+  NiceMock<MockSharedHealthCheckSubscriber> second;
+  NiceMock<MockSharedHealthCheckSubscriber> third;
+
+  EXPECT_TRUE(scheduler.subscribe(key, first));
+  EXPECT_FALSE(scheduler.subscribe(key, second));
+  EXPECT_FALSE(scheduler.subscribe(key, third));
+  EXPECT_EQ(1UL, scheduler.numGroups());
+
+  // The result of the prober is applied to all the other sessions of the group.
+  EXPECT_CALL(first, onSharedResult(_)).Times(0);
+  EXPECT_CALL(second, onSharedResult(_));
+  EXPECT_CALL(third, onSharedResult(_));
+  scheduler.publish(key, first, {false, false, envoy::data::core::v3::NETWORK, false});
+
+  // Only a leaving prober hands over the probing.
+  EXPECT_CALL(first, onProbingStarted()).Times(0);
+  EXPECT_CALL(third, onProbingStarted()).Times(0);
+  scheduler.unsubscribe(key, third);
+  EXPECT_CALL(second, onProbingStarted());
+  scheduler.unsubscribe(key, first);
+  scheduler.unsubscribe(key, second);
+  EXPECT_EQ(0UL, scheduler.numGroups());
+}
+
+TEST(SharedHealthCheckSchedulerTest, IntervalsAndPhases) {
+  SharedHealthCheckScheduler scheduler;
+  NiceMock<MockSharedHealthCheckSubscriber> subscribers[4];
+  for (auto& subscriber : subscribers) {
+    ON_CALL(subscriber, nextCheckInterval()).WillByDefault(Return(std::chrono::milliseconds(1000)));
+  }
+  // A session without a result yet does not shorten the interval of its group.
+  ON_CALL(subscribers[1], nextCheckInterval()).WillByDefault(Return(std::chrono::milliseconds(0)));
+  ON_CALL(subscribers[2], nextCheckInterval())
+      .WillByDefault(Return(std::chrono::milliseconds(500)));
+
+  const SharedHealthCheckScheduler::Key first_key{1, "127.0.0.1:80"};
+  const SharedHealthCheckScheduler::Key second_key{1, "127.0.0.2:80"};
+  const SharedHealthCheckScheduler::Key third_key{2, "127.0.0.1:80"};
+  scheduler.subscribe(first_key, subscribers[0]);
+  scheduler.subscribe(first_key, subscribers[1]);
+  scheduler.subscribe(second_key, subscribers[2]);
+  scheduler.subscribe(second_key, subscribers[0]);
+  scheduler.subscribe(third_key, subscribers[3]);
+  EXPECT_EQ(3UL, scheduler.numGroups());
+
+  // The first intervals of the groups are spread over the interval, the following ones are the
+  // shortest interval of the sessions of the group.
+  EXPECT_EQ(std::chrono::milliseconds(618), scheduler.nextCheckInterval(first_key));
+  EXPECT_EQ(std::chrono::milliseconds(1000), scheduler.nextCheckInterval(first_key));
+  EXPECT_EQ(std::chrono::milliseconds(118), scheduler.nextCheckInterval(second_key));
+  EXPECT_EQ(std::chrono::milliseconds(500), scheduler.nextCheckInterval(second_key));
+  EXPECT_EQ(std::chrono::milliseconds(854), scheduler.nextCheckInterval(third_key));
+  EXPECT_EQ(std::chrono::milliseconds(1000), scheduler.nextCheckInterval(third_key));
+}
+
 class TestGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
 public:
   using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
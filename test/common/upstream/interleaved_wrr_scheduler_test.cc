@@ -0,0 +1,193 @@
+#include "source/common/upstream/interleaved_wrr_scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+TEST(InterleavedWrrSchedulerTest, Empty) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  EXPECT_TRUE(sched.empty());
+  EXPECT_EQ(nullptr, sched.peekAgain([](const double&) { return 0; }));
+  EXPECT_EQ(nullptr, sched.pickAndAdd([](const double&) { return 0; }));
+}
+
+// Validate we get regular RR behavior when all weights are the same.
+TEST(InterleavedWrrSchedulerTest, Unweighted) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  constexpr uint32_t num_entries = 128;
+  std::shared_ptr<uint32_t> entries[num_entries];
+
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched.add(1, entries[i]);
+  }
+
+  for (uint32_t rounds = 0; rounds < 128; ++rounds) {
+    for (uint32_t i = 0; i < num_entries; ++i) {
+      auto peek = sched.peekAgain([](const double&) { return 1; });
+      auto p = sched.pickAndAdd([](const double&) { return 1; });
+      EXPECT_EQ(i, *p);
+      EXPECT_EQ(*peek, *p);
+    }
+  }
+}
+
+// Validate we get weighted RR behavior when weights are distinct.
+TEST(InterleavedWrrSchedulerTest, Weighted) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  constexpr uint32_t num_entries = 128;
+  std::shared_ptr<uint32_t> entries[num_entries];
+  uint32_t pick_count[num_entries];
+
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched.add(i + 1, entries[i]);
+    pick_count[i] = 0;
+  }
+
+  for (uint32_t i = 0; i < (num_entries * (1 + num_entries)) / 2; ++i) {
+    auto peek = sched.peekAgain([](const double& orig) { return orig + 1; });
+    auto p = sched.pickAndAdd([](const double& orig) { return orig + 1; });
+    EXPECT_EQ(*p, *peek);
+    ++pick_count[*p];
+  }
+
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    EXPECT_EQ(i + 1, pick_count[i]);
+  }
+}
+
+// Validate the order of the picks: every round picks the entries of weight at least its number, in
+// the order they were added.
+TEST(InterleavedWrrSchedulerTest, Rounds) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  std::shared_ptr<uint32_t> entries[4];
+  const double weights[4] = {1, 3, 2, 3};
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched.add(weights[i], entries[i]);
+  }
+
+  const std::vector<uint32_t> cycle = {1, 3, 2, 0, 1, 3, 2, 1, 3};
+  for (uint32_t rounds = 0; rounds < 3; ++rounds) {
+    for (const uint32_t expected : cycle) {
+      EXPECT_EQ(expected, *sched.pickAndAdd([](const double&) { return 1; }));
+    }
+  }
+}
+
+// Validate that weights are rounded to integers of at least 1.
+TEST(InterleavedWrrSchedulerTest, RoundedWeights) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  auto first_entry = std::make_shared<uint32_t>(37);
+  auto second_entry = std::make_shared<uint32_t>(42);
+  sched.add(0.1, first_entry);
+  sched.add(1.6, second_entry);
+
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(37, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+}
+
+// Validate that adding entries after picks starts a new cycle with them.
+TEST(InterleavedWrrSchedulerTest, AddAfterPicks) {
+  InterleavedWrrScheduler<uint32_t> sched;
+  auto first_entry = std::make_shared<uint32_t>(37);
+  auto second_entry = std::make_shared<uint32_t>(42);
+  sched.add(1, first_entry);
+  EXPECT_EQ(37, *sched.pickAndAdd([](const double&) { return 1; }));
+
+  sched.add(2, second_entry);
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(37, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+}
+
+// Validate that expired entries are ignored.
+TEST(InterleavedWrrSchedulerTest, Expired) {
+  InterleavedWrrScheduler<uint32_t> sched;
+
+  auto second_entry = std::make_shared<uint32_t>(42);
+  {
+    auto first_entry = std::make_shared<uint32_t>(37);
+    sched.add(2, first_entry);
+    sched.add(1, second_entry);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    auto peek = sched.peekAgain([](const double&) { return 1; });
+    auto p = sched.pickAndAdd([](const double&) { return 1; });
+    EXPECT_EQ(*peek, *p);
+    EXPECT_EQ(*second_entry, *p);
+  }
+}
+
+// Validate that an entry of the largest weight expiring in the middle of a cycle is ignored.
+TEST(InterleavedWrrSchedulerTest, ExpiredMidCycle) {
+  InterleavedWrrScheduler<uint32_t> sched;
+
+  auto first_entry = std::make_shared<uint32_t>(37);
+  auto second_entry = std::make_shared<uint32_t>(42);
+  sched.add(3, first_entry);
+  sched.add(2, second_entry);
+
+  EXPECT_EQ(37, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(37, *sched.pickAndAdd([](const double&) { return 1; }));
+  EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  first_entry.reset();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(42, *sched.pickAndAdd([](const double&) { return 1; }));
+  }
+}
+
+// Validate that expired entries are not peeked.
+TEST(InterleavedWrrSchedulerTest, ExpiredPeekedIsNotPicked) {
+  InterleavedWrrScheduler<uint32_t> sched;
+
+  {
+    auto second_entry = std::make_shared<uint32_t>(42);
+    auto first_entry = std::make_shared<uint32_t>(37);
+    sched.add(2, first_entry);
+    sched.add(1, second_entry);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(sched.peekAgain([](const double&) { return 1; }) != nullptr);
+    }
+  }
+
+  EXPECT_TRUE(sched.peekAgain([](const double&) { return 1; }) == nullptr);
+  EXPECT_TRUE(sched.pickAndAdd([](const double&) { return 1; }) == nullptr);
+  EXPECT_TRUE(sched.empty());
+}
+
+TEST(InterleavedWrrSchedulerTest, ManyPeekahead) {
+  InterleavedWrrScheduler<uint32_t> sched1;
+  InterleavedWrrScheduler<uint32_t> sched2;
+  constexpr uint32_t num_entries = 128;
+  std::shared_ptr<uint32_t> entries[num_entries];
+
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    entries[i] = std::make_shared<uint32_t>(i);
+    sched1.add(i % 3 + 1, entries[i]);
+    sched2.add(i % 3 + 1, entries[i]);
+  }
+
+  std::vector<uint32_t> picks;
+  for (uint32_t rounds = 0; rounds < 10; ++rounds) {
+    picks.push_back(*sched1.peekAgain([](const double&) { return 1; }));
+  }
+  for (uint32_t rounds = 0; rounds < 10; ++rounds) {
+    auto p1 = sched1.pickAndAdd([](const double&) { return 1; });
+    auto p2 = sched2.pickAndAdd([](const double&) { return 1; });
+    EXPECT_EQ(picks[rounds], *p1);
+    EXPECT_EQ(*p2, *p1);
+  }
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
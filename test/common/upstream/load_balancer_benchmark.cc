@@ -1,20 +1,26 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
 #include <memory>
+#include <queue>
+#include <random>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
 #include "source/common/common/random_generator.h"
 #include "source/common/memory/stats.h"
+#include "source/common/router/metadatamatchcriteria_impl.h"
 #include "source/common/upstream/maglev_lb.h"
 #include "source/common/upstream/ring_hash_lb.h"
 #include "source/common/upstream/subset_lb.h"
 #include "source/common/upstream/upstream_impl.h"
+#include "source/extensions/load_balancing_policies/anchor_hash/anchor_hash_lb.h"
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
 
 #include "test/benchmark/main.h"
 #include "test/common/upstream/utility.h"
 #include "test/mocks/upstream/cluster_info.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/test_runtime.h"
 
 #include "benchmark/benchmark.h"
 
@@ -77,8 +83,14 @@ public:
 
 class RoundRobinTester : public BaseTester {
 public:
-  RoundRobinTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0)
-      : BaseTester(num_hosts, weighted_subset_percent, weight) {}
+  RoundRobinTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
+                   bool interleaved_scheduler = false)
+      : BaseTester(num_hosts, weighted_subset_percent, weight) {
+    if (interleaved_scheduler) {
+      round_robin_lb_config_.set_weighted_scheduler(
+          envoy::config::cluster::v3::Cluster::RoundRobinLbConfig::INTERLEAVED);
+    }
+  }
 
   void initialize() {
     lb_ = std::make_unique<RoundRobinLoadBalancer>(priority_set_, &local_priority_set_, stats_,
@@ -106,6 +118,7 @@ void benchmarkRoundRobinLoadBalancerBuild(::benchmark::State& state) {
   const uint64_t num_hosts = state.range(0);
   const uint64_t weighted_subset_percent = state.range(1);
   const uint64_t weight = state.range(2);
+  const bool interleaved_scheduler = state.range(3);
 
   if (benchmark::skipExpensiveBenchmarks() && num_hosts > 10000) {
     state.SkipWithError("Skipping expensive benchmark");
@@ -115,7 +128,7 @@ void benchmarkRoundRobinLoadBalancerBuild(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     state.PauseTiming();
     const size_t start_tester_mem = Memory::Stats::totalCurrentlyAllocated();
-    RoundRobinTester tester(num_hosts, weighted_subset_percent, weight);
+    RoundRobinTester tester(num_hosts, weighted_subset_percent, weight, interleaved_scheduler);
     const size_t end_tester_mem = Memory::Stats::totalCurrentlyAllocated();
     const size_t start_mem = Memory::Stats::totalCurrentlyAllocated();
 
@@ -131,22 +144,32 @@ void benchmarkRoundRobinLoadBalancerBuild(::benchmark::State& state) {
   }
 }
 BENCHMARK(benchmarkRoundRobinLoadBalancerBuild)
-    ->Args({1, 0, 1})
-    ->Args({500, 0, 1})
-    ->Args({500, 50, 50})
-    ->Args({500, 100, 50})
-    ->Args({2500, 0, 1})
-    ->Args({2500, 50, 50})
-    ->Args({2500, 100, 50})
-    ->Args({10000, 0, 1})
-    ->Args({10000, 50, 50})
-    ->Args({10000, 100, 50})
-    ->Args({25000, 0, 1})
-    ->Args({25000, 50, 50})
-    ->Args({25000, 100, 50})
-    ->Args({50000, 0, 1})
-    ->Args({50000, 50, 50})
-    ->Args({50000, 100, 50})
+    ->Args({1, 0, 1, 0})
+    ->Args({500, 0, 1, 0})
+    ->Args({500, 50, 50, 0})
+    ->Args({500, 50, 50, 1})
+    ->Args({500, 100, 50, 0})
+    ->Args({500, 100, 50, 1})
+    ->Args({2500, 0, 1, 0})
+    ->Args({2500, 50, 50, 0})
+    ->Args({2500, 50, 50, 1})
+    ->Args({2500, 100, 50, 0})
+    ->Args({2500, 100, 50, 1})
+    ->Args({10000, 0, 1, 0})
+    ->Args({10000, 50, 50, 0})
+    ->Args({10000, 50, 50, 1})
+    ->Args({10000, 100, 50, 0})
+    ->Args({10000, 100, 50, 1})
+    ->Args({25000, 0, 1, 0})
+    ->Args({25000, 50, 50, 0})
+    ->Args({25000, 50, 50, 1})
+    ->Args({25000, 100, 50, 0})
+    ->Args({25000, 100, 50, 1})
+    ->Args({50000, 0, 1, 0})
+    ->Args({50000, 50, 50, 0})
+    ->Args({50000, 50, 50, 1})
+    ->Args({50000, 100, 50, 0})
+    ->Args({50000, 100, 50, 1})
     ->Unit(::benchmark::kMillisecond);
 
 class RingHashTester : public BaseTester {
@@ -164,8 +187,14 @@ public:
 
 class MaglevTester : public BaseTester {
 public:
-  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0)
+  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
+               uint32_t hash_balance_factor = 0)
       : BaseTester(num_hosts, weighted_subset_percent, weight) {
+    if (hash_balance_factor > 0) {
+      common_config_.mutable_consistent_hashing_lb_config()
+          ->mutable_hash_balance_factor()
+          ->set_value(hash_balance_factor);
+    }
     maglev_lb_ = std::make_unique<MaglevLoadBalancer>(priority_set_, stats_, stats_store_, runtime_,
                                                       random_, config_, common_config_);
   }
@@ -174,6 +203,19 @@ public:
   std::unique_ptr<MaglevLoadBalancer> maglev_lb_;
 };
 
+class AnchorHashTester : public BaseTester {
+public:
+  using AnchorHashLoadBalancer =
+      Extensions::LoadBalancingPolicies::AnchorHash::AnchorHashLoadBalancer;
+
+  AnchorHashTester(uint64_t num_hosts) : BaseTester(num_hosts) {
+    anchor_hash_lb_ = std::make_unique<AnchorHashLoadBalancer>(
+        priority_set_, stats_, stats_store_, runtime_, random_, 0, false, 0, common_config_);
+  }
+
+  std::unique_ptr<AnchorHashLoadBalancer> anchor_hash_lb_;
+};
+
 uint64_t hashInt(uint64_t i) {
   // Hack to hash an integer.
   return HashUtil::xxHash64(absl::string_view(reinterpret_cast<const char*>(&i), sizeof(i)));
@@ -231,6 +273,107 @@ BENCHMARK(benchmarkMaglevLoadBalancerBuildTable)
     ->Arg(500)
     ->Unit(::benchmark::kMillisecond);
 
+void benchmarkAnchorHashLoadBalancerBuildTable(::benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    const uint64_t num_hosts = state.range(0);
+    AnchorHashTester tester(num_hosts);
+
+    const size_t start_mem = Memory::Stats::totalCurrentlyAllocated();
+
+    // We are only interested in timing the initial table build.
+    state.ResumeTiming();
+    tester.anchor_hash_lb_->initialize();
+    state.PauseTiming();
+    const size_t end_mem = Memory::Stats::totalCurrentlyAllocated();
+    state.counters["memory"] = end_mem - start_mem;
+    state.counters["memory_per_host"] = (end_mem - start_mem) / num_hosts;
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(benchmarkAnchorHashLoadBalancerBuildTable)
+    ->Arg(100)
+    ->Arg(200)
+    ->Arg(500)
+    ->Unit(::benchmark::kMillisecond);
+
+// Replaces the hosts of priority 0, which rebuilds the thread aware load balancers' tables.
+void updateHosts(PrioritySetImpl& priority_set, const HostVector& hosts, const HostVector& added,
+                 const HostVector& removed) {
+  HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+  priority_set.updateHosts(
+      0, HostSetImpl::partitionHosts(updated_hosts, makeHostsPerLocality({hosts})), {}, added,
+      removed, absl::nullopt);
+}
+
+void benchmarkRingHashLoadBalancerChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+  const uint64_t num_churned_hosts = state.range(2);
+  RingHashTester tester(num_hosts, min_ring_size);
+  tester.ring_hash_lb_->initialize();
+  const HostVector all_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  const HostVector churned_hosts(all_hosts.begin(), all_hosts.begin() + num_churned_hosts);
+  const HostVector remaining_hosts(all_hosts.begin() + num_churned_hosts, all_hosts.end());
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // Each iteration removes the churned hosts and adds them back, so the ring is rebuilt twice.
+    updateHosts(tester.priority_set_, remaining_hosts, {}, churned_hosts);
+    updateHosts(tester.priority_set_, all_hosts, churned_hosts, {});
+  }
+}
+BENCHMARK(benchmarkRingHashLoadBalancerChurn)
+    ->Args({500, 65536, 1})
+    ->Args({500, 65536, 50})
+    ->Args({5000, 65536, 1})
+    ->Args({5000, 65536, 50})
+    ->Args({5000, 256000, 1})
+    ->Unit(::benchmark::kMillisecond);
+
+void benchmarkMaglevLoadBalancerChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t num_churned_hosts = state.range(1);
+  MaglevTester tester(num_hosts);
+  tester.maglev_lb_->initialize();
+  const HostVector all_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  const HostVector churned_hosts(all_hosts.begin(), all_hosts.begin() + num_churned_hosts);
+  const HostVector remaining_hosts(all_hosts.begin() + num_churned_hosts, all_hosts.end());
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // Each iteration removes the churned hosts and adds them back, so the table is rebuilt twice.
+    updateHosts(tester.priority_set_, remaining_hosts, {}, churned_hosts);
+    updateHosts(tester.priority_set_, all_hosts, churned_hosts, {});
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerChurn)
+    ->Args({500, 1})
+    ->Args({500, 50})
+    ->Args({5000, 1})
+    ->Args({5000, 50})
+    ->Unit(::benchmark::kMillisecond);
+
+void benchmarkAnchorHashLoadBalancerChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t num_churned_hosts = state.range(1);
+  AnchorHashTester tester(num_hosts);
+  tester.anchor_hash_lb_->initialize();
+  const HostVector all_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  const HostVector churned_hosts(all_hosts.begin(), all_hosts.begin() + num_churned_hosts);
+  const HostVector remaining_hosts(all_hosts.begin() + num_churned_hosts, all_hosts.end());
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // Each iteration removes the churned hosts and adds them back, so the table is updated twice.
+    updateHosts(tester.priority_set_, remaining_hosts, {}, churned_hosts);
+    updateHosts(tester.priority_set_, all_hosts, churned_hosts, {});
+  }
+}
+BENCHMARK(benchmarkAnchorHashLoadBalancerChurn)
+    ->Args({500, 1})
+    ->Args({500, 50})
+    ->Args({5000, 1})
+    ->Args({5000, 50})
+    ->Unit(::benchmark::kMillisecond);
+
 class TestLoadBalancerContext : public LoadBalancerContextBase {
 public:
   // Upstream::LoadBalancerContext
@@ -301,6 +444,123 @@ BENCHMARK(benchmarkLeastRequestLoadBalancerChooseHost)
     ->Args({100, 100, 1000000})
     ->Unit(::benchmark::kMillisecond);
 
+class PeakEwmaTester : public BaseTester {
+public:
+  PeakEwmaTester(uint64_t num_hosts) : BaseTester(num_hosts) {
+    lb_ = std::make_unique<Extensions::LoadBalancingPolicies::PeakEwma::PeakEwmaLoadBalancer>(
+        priority_set_, &local_priority_set_, stats_, runtime_, random_, common_config_,
+        std::chrono::seconds(1), std::chrono::milliseconds(10), std::chrono::seconds(1),
+        simTime());
+  }
+
+  std::unique_ptr<Extensions::LoadBalancingPolicies::PeakEwma::PeakEwmaLoadBalancer> lb_;
+};
+
+// Sends a request every 100us to a fleet in which one host in slow_host_ratio takes 20ms to
+// respond instead of 1ms, and each response is further delayed by the requests the host has in
+// flight. Reports the mean and p99 of the simulated response times.
+template <class Tester>
+void simulateHeterogeneousLatency(::benchmark::State& state, Tester& tester,
+                                  uint64_t slow_host_ratio, uint64_t requests_to_simulate) {
+  struct InFlight {
+    MonotonicTime completion_;
+    MonotonicTime start_;
+    HostConstSharedPtr host_;
+    bool operator>(const InFlight& other) const { return completion_ > other.completion_; }
+  };
+  std::priority_queue<InFlight, std::vector<InFlight>, std::greater<InFlight>> in_flight;
+  absl::flat_hash_map<const HostDescription*, uint64_t> base_latency_us;
+  const HostVector& hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  for (uint64_t i = 0; i < hosts.size(); ++i) {
+    base_latency_us[hosts[i].get()] = i % slow_host_ratio == 0 ? 20000 : 1000;
+  }
+
+  std::vector<uint64_t> latencies_us;
+  latencies_us.reserve(requests_to_simulate);
+  for (uint64_t i = 0; i < requests_to_simulate; ++i) {
+    tester.simTime().advanceTimeWait(std::chrono::microseconds(100));
+    const MonotonicTime now = tester.simTime().monotonicTime();
+    while (!in_flight.empty() && in_flight.top().completion_ <= now) {
+      const InFlight& done = in_flight.top();
+      done.host_->stats().rq_active_.dec();
+      if (auto callbacks = tester.lb_->responseTimeCallbacks(); callbacks.has_value()) {
+        callbacks->onHostResponseTime(*done.host_,
+                                      std::chrono::duration_cast<std::chrono::microseconds>(
+                                          done.completion_ - done.start_));
+      }
+      in_flight.pop();
+    }
+
+    HostConstSharedPtr host = tester.lb_->chooseHost(nullptr);
+    const uint64_t latency_us =
+        base_latency_us[host.get()] * (1 + host->stats().rq_active_.value() / 4);
+    host->stats().rq_active_.inc();
+    in_flight.push({now + std::chrono::microseconds(latency_us), now, host});
+    latencies_us.push_back(latency_us);
+  }
+
+  while (!in_flight.empty()) {
+    in_flight.top().host_->stats().rq_active_.dec();
+    in_flight.pop();
+  }
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  double sum = 0;
+  for (const uint64_t latency_us : latencies_us) {
+    sum += latency_us;
+  }
+  state.counters["mean_latency_ms"] = sum / latencies_us.size() / 1000;
+  state.counters["p99_latency_ms"] = latencies_us[latencies_us.size() * 99 / 100] / 1000.0;
+}
+
+void benchmarkLeastRequestLoadBalancerHeterogeneousLatency(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t slow_host_ratio = state.range(1);
+  const uint64_t requests_to_simulate = state.range(2);
+
+  if (benchmark::skipExpensiveBenchmarks() && requests_to_simulate > 1000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    LeastRequestTester tester(num_hosts, 2);
+    state.ResumeTiming();
+
+    simulateHeterogeneousLatency(state, tester, slow_host_ratio, requests_to_simulate);
+  }
+}
+BENCHMARK(benchmarkLeastRequestLoadBalancerHeterogeneousLatency)
+    ->Args({100, 10, 1000})
+    ->Args({100, 10, 100000})
+    ->Args({100, 2, 100000})
+    ->Unit(::benchmark::kMillisecond);
+
+void benchmarkPeakEwmaLoadBalancerHeterogeneousLatency(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t slow_host_ratio = state.range(1);
+  const uint64_t requests_to_simulate = state.range(2);
+
+  if (benchmark::skipExpensiveBenchmarks() && requests_to_simulate > 1000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    PeakEwmaTester tester(num_hosts);
+    state.ResumeTiming();
+
+    simulateHeterogeneousLatency(state, tester, slow_host_ratio, requests_to_simulate);
+  }
+}
+BENCHMARK(benchmarkPeakEwmaLoadBalancerHeterogeneousLatency)
+    ->Args({100, 10, 1000})
+    ->Args({100, 10, 100000})
+    ->Args({100, 2, 100000})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkRingHashLoadBalancerChooseHost(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     // Do not time the creation of the ring.
@@ -373,6 +633,39 @@ BENCHMARK(benchmarkMaglevLoadBalancerChooseHost)
     ->Args({500, 100000})
     ->Unit(::benchmark::kMillisecond);
 
+void benchmarkAnchorHashLoadBalancerChooseHost(::benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // Do not time the creation of the table.
+    state.PauseTiming();
+    const uint64_t num_hosts = state.range(0);
+    const uint64_t keys_to_simulate = state.range(1);
+    AnchorHashTester tester(num_hosts);
+    tester.anchor_hash_lb_->initialize();
+    LoadBalancerPtr lb = tester.anchor_hash_lb_->factory()->create();
+    absl::node_hash_map<std::string, uint64_t> hit_counter;
+    TestLoadBalancerContext context;
+    state.ResumeTiming();
+
+    // Note: To a certain extent this is benchmarking the performance of xxhash as well as
+    // absl::node_hash_map. However, it should be roughly equivalent to the work done when
+    // comparing different hashing algorithms.
+    for (uint64_t i = 0; i < keys_to_simulate; i++) {
+      context.hash_key_ = hashInt(i);
+      hit_counter[lb->chooseHost(&context)->address()->asString()] += 1;
+    }
+
+    // Do not time computation of mean, standard deviation, and relative standard deviation.
+    state.PauseTiming();
+    computeHitStats(state, hit_counter);
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(benchmarkAnchorHashLoadBalancerChooseHost)
+    ->Args({100, 100000})
+    ->Args({200, 100000})
+    ->Args({500, 100000})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkRingHashLoadBalancerHostLoss(::benchmark::State& state) {
   const uint64_t num_hosts = state.range(0);
   const uint64_t min_ring_size = state.range(1);
@@ -472,6 +765,55 @@ BENCHMARK(benchmarkMaglevLoadBalancerHostLoss)
     ->Args({500, 3, 10000})
     ->Unit(::benchmark::kMillisecond);
 
+// Unlike the other host loss benchmarks, the hosts are removed from the table of the same load
+// balancer, which updates the table instead of building another one.
+void benchmarkAnchorHashLoadBalancerHostLoss(::benchmark::State& state) {
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    const uint64_t num_hosts = state.range(0);
+    const uint64_t hosts_to_lose = state.range(1);
+    const uint64_t keys_to_simulate = state.range(2);
+
+    AnchorHashTester tester(num_hosts);
+    tester.anchor_hash_lb_->initialize();
+    LoadBalancerPtr lb = tester.anchor_hash_lb_->factory()->create();
+    std::vector<HostConstSharedPtr> hosts;
+    TestLoadBalancerContext context;
+    for (uint64_t i = 0; i < keys_to_simulate; i++) {
+      context.hash_key_ = hashInt(i);
+      hosts.push_back(lb->chooseHost(&context));
+    }
+
+    const HostVector all_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+    updateHosts(tester.priority_set_,
+                HostVector(all_hosts.begin() + hosts_to_lose, all_hosts.end()), {},
+                HostVector(all_hosts.begin(), all_hosts.begin() + hosts_to_lose));
+    lb = tester.anchor_hash_lb_->factory()->create();
+    std::vector<HostConstSharedPtr> hosts2;
+    for (uint64_t i = 0; i < keys_to_simulate; i++) {
+      context.hash_key_ = hashInt(i);
+      hosts2.push_back(lb->chooseHost(&context));
+    }
+
+    ASSERT(hosts.size() == hosts2.size());
+    uint64_t num_different_hosts = 0;
+    for (uint64_t i = 0; i < hosts.size(); i++) {
+      if (hosts[i]->address()->asString() != hosts2[i]->address()->asString()) {
+        num_different_hosts++;
+      }
+    }
+
+    state.counters["percent_different"] =
+        (static_cast<double>(num_different_hosts) / hosts.size()) * 100;
+    state.counters["host_loss_over_N_optimal"] =
+        (static_cast<double>(hosts_to_lose) / num_hosts) * 100;
+  }
+}
+BENCHMARK(benchmarkAnchorHashLoadBalancerHostLoss)
+    ->Args({500, 1, 10000})
+    ->Args({500, 2, 10000})
+    ->Args({500, 3, 10000})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkMaglevLoadBalancerWeighted(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     const uint64_t num_hosts = state.range(0);
@@ -531,6 +873,49 @@ BENCHMARK(benchmarkMaglevLoadBalancerWeighted)
     ->Args({500, 95, 75, 25, 10000})
     ->Unit(::benchmark::kMillisecond);
 
+// Args: whether overloaded hosts are replaced by probing by a step (1) or by shuffling all the
+// hosts (0), number of hosts. Half of the keys are one of 10 hot keys, the others are spread over
+// 100000 keys, and the last 4 requests per host are kept active. With a hash_balance_factor of
+// 125 the hosts of the hot keys are overloaded, so most of their requests go to another host.
+void benchmarkMaglevLoadBalancerBoundedLoadChooseHost(::benchmark::State& state) {
+  const bool probe_steps = state.range(0) != 0;
+  const uint64_t num_hosts = state.range(1);
+
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues({{"envoy.reloadable_features.bounded_load_hash_probe_steps",
+                               probe_steps ? "true" : "false"}});
+  MaglevTester tester(num_hosts, 0, 0, 125);
+  tester.maglev_lb_->initialize();
+  LoadBalancerPtr lb = tester.maglev_lb_->factory()->create();
+
+  std::vector<uint64_t> hashes(65536);
+  std::mt19937_64 random(1);
+  for (uint64_t& hash : hashes) {
+    hash = hashInt(random() % 2 == 0 ? random() % 10 : random() % 100000);
+  }
+  Stats::Gauge& cluster_active = tester.info_->trafficStats()->upstream_rq_active_;
+  std::vector<HostConstSharedPtr> active(num_hosts * 4);
+  TestLoadBalancerContext context;
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    context.hash_key_ = hashes[i % hashes.size()];
+    HostConstSharedPtr& host = active[i % active.size()];
+    if (host != nullptr) {
+      host->stats().rq_active_.dec();
+      cluster_active.dec();
+    }
+    host = lb->chooseHost(&context);
+    host->stats().rq_active_.inc();
+    cluster_active.inc();
+    i++;
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerBoundedLoadChooseHost)
+    ->Args({0, 100})
+    ->Args({1, 100})
+    ->Args({0, 1000})
+    ->Args({1, 1000});
+
 class SubsetLbTester : public BaseTester {
 public:
   SubsetLbTester(uint64_t num_hosts, bool single_host_per_subset)
@@ -608,9 +993,48 @@ void benchmarkSubsetLoadBalancerUpdate(::benchmark::State& state) {
 }
 
 BENCHMARK(benchmarkSubsetLoadBalancerUpdate)
-    ->Ranges({{false, true}, {50, 2500}})
+    ->Ranges({{false, true}, {50, 10000}})
     ->Unit(::benchmark::kMillisecond);
 
+class MetadataMatchLoadBalancerContext : public LoadBalancerContextBase {
+public:
+  MetadataMatchLoadBalancerContext(uint64_t value) {
+    ProtobufWkt::Struct metadata_matches;
+    (*metadata_matches.mutable_fields())[std::string(BaseTester::metadata_key)].set_number_value(
+        value);
+    metadata_match_ = std::make_unique<Router::MetadataMatchCriteriaImpl>(metadata_matches);
+  }
+
+  // Upstream::LoadBalancerContext
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() override {
+    return metadata_match_.get();
+  }
+
+private:
+  std::unique_ptr<Router::MetadataMatchCriteriaImpl> metadata_match_;
+};
+
+void benchmarkSubsetLoadBalancerChooseHost(::benchmark::State& state) {
+  const bool single_host_per_subset = state.range(0);
+  const uint64_t num_hosts = state.range(1);
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  SubsetLbTester tester(num_hosts, single_host_per_subset);
+  std::vector<std::unique_ptr<MetadataMatchLoadBalancerContext>> contexts;
+  for (uint64_t i = 0; i < std::min<uint64_t>(num_hosts, 1000); i++) {
+    contexts.push_back(std::make_unique<MetadataMatchLoadBalancerContext>(i));
+  }
+  uint64_t i = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    ::benchmark::DoNotOptimize(tester.lb_->chooseHost(contexts[i++ % contexts.size()].get()));
+  }
+}
+
+BENCHMARK(benchmarkSubsetLoadBalancerChooseHost)->Ranges({{false, true}, {50, 10000}});
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
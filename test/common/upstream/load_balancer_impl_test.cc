@@ -1053,6 +1053,37 @@ TEST_P(RoundRobinLoadBalancerTest, WeightedSeed) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
 }
 
+// Validate that the interleaved scheduler picks in rounds of the hosts of weight at least the
+// number of the round, and is rebuilt with the new weights on host updates.
+TEST_P(RoundRobinLoadBalancerTest, WeightedInterleaved) {
+  round_robin_lb_config_.set_weighted_scheduler(
+      envoy::config::cluster::v3::Cluster::RoundRobinLbConfig::INTERLEAVED);
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime(), 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", simTime(), 2),
+                              makeTestHost(info_, "tcp://127.0.0.1:82", simTime(), 3)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  init(false);
+  for (int cycle = 0; cycle < 2; ++cycle) {
+    EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+  }
+
+  // Weights are only taken into account on host updates.
+  hostSet().healthy_hosts_[0]->weight(4);
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+  hostSet().runCallbacks({}, {});
+  peekThenPick({0, 2, 1});
+  for (const int i : {0, 2, 1, 0, 2, 0}) {
+    EXPECT_EQ(hostSet().healthy_hosts_[i], lb_->chooseHost(nullptr));
+  }
+}
+
 TEST_P(RoundRobinLoadBalancerTest, MaxUnhealthyPanic) {
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
                               makeTestHost(info_, "tcp://127.0.0.1:81", simTime())};
@@ -0,0 +1,108 @@
+// Usage: bazel run //test/common/upstream:outlier_detection_benchmark
+//
+// Measures how the throughput of reporting results to the outlier detector scales with the number
+// of worker threads, and the cost of the main thread interval processing.
+
+#include <memory>
+
+#include "envoy/config/cluster/v3/outlier_detection.pb.h"
+
+#include "source/common/upstream/outlier_detection_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/cluster_priority_set.h"
+#include "test/mocks/upstream/host_set.h"
+#include "test/test_common/simulated_time_system.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+namespace Outlier {
+namespace {
+
+class DetectorTester {
+public:
+  DetectorTester(uint64_t num_hosts) {
+    HostVector& hosts = cluster_.prioritySet().getMockHostSet(0)->hosts_;
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      hosts.push_back(makeTestHost(cluster_.info_,
+                                   fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256),
+                                   time_system_));
+    }
+    envoy::config::cluster::v3::OutlierDetection config;
+    config.mutable_success_rate_minimum_hosts()->set_value(1);
+    config.mutable_failure_percentage_minimum_hosts()->set_value(1);
+    detector_ = DetectorImpl::create(cluster_, config, dispatcher_, runtime_, time_system_,
+                                     nullptr, random_);
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<MockClusterMockPrioritySet> cluster_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  Event::MockTimer* interval_timer_ = new NiceMock<Event::MockTimer>(&dispatcher_);
+  std::shared_ptr<DetectorImpl> detector_;
+};
+
+std::unique_ptr<DetectorTester> concurrent_tester;
+
+// Args: number of hosts the results are reported for. Every benchmark thread acts as a worker
+// reporting successful responses, round robin over the hosts. With a single host all workers
+// report to the same host, which is the worst case for contention.
+void bmConcurrentPutHttpResponseCode(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  if (state.thread_index() == 0) {
+    concurrent_tester = std::make_unique<DetectorTester>(num_hosts);
+  }
+
+  uint64_t next_host = state.thread_index();
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    const HostVector& hosts = concurrent_tester->cluster_.prioritySet().getMockHostSet(0)->hosts_;
+    hosts[next_host++ % num_hosts]->outlierDetector().putHttpResponseCode(200);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    concurrent_tester.reset();
+  }
+}
+BENCHMARK(bmConcurrentPutHttpResponseCode)->Arg(1)->Arg(100)->ThreadRange(1, 16)->UseRealTime();
+
+// Args: number of hosts. Measures the interval processing of the main thread, which collects the
+// results of all workers and computes the success rates and failure percentages of all hosts.
+void bmIntervalProcessing(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 1000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  DetectorTester tester(num_hosts);
+  const HostVector& hosts = tester.cluster_.prioritySet().getMockHostSet(0)->hosts_;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      // Every 10th host fails half of its requests, so that there are outliers to detect.
+      for (uint64_t j = 0; j < 200; j++) {
+        hosts[i]->outlierDetector().putHttpResponseCode(i % 10 == 0 && j % 2 == 0 ? 503 : 200);
+      }
+    }
+    state.ResumeTiming();
+
+    tester.interval_timer_->invokeCallback();
+  }
+}
+BENCHMARK(bmIntervalProcessing)->Arg(100)->Arg(1000)->Arg(10000)->Unit(::benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Outlier
+} // namespace Upstream
+} // namespace Envoy
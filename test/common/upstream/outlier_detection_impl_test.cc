@@ -22,6 +22,7 @@
 #include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/host_set.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
 #include "test/test_common/utility.h"
 
 #include "absl/types/optional.h"
@@ -299,9 +300,12 @@ TEST_F(OutlierDetectorImplTest, BasicFlow5xxViaHttpCodes) {
 
   // Cause a consecutive 5xx error on host[0] by reporting HTTP codes.
   loadRq(hosts_[0], 1, 500);
+  EXPECT_EQ(1U, hosts_[0]->outlierDetector().consecutiveFailures());
   loadRq(hosts_[0], 1, 200);
+  EXPECT_EQ(0U, hosts_[0]->outlierDetector().consecutiveFailures());
   hosts_[0]->outlierDetector().putResponseTime(std::chrono::milliseconds(5));
   loadRq(hosts_[0], 4, 500);
+  EXPECT_EQ(4U, hosts_[0]->outlierDetector().consecutiveFailures());
 
   time_system_.setMonotonicTime(std::chrono::milliseconds(0));
   EXPECT_CALL(checker_, check(hosts_[0]));
@@ -2238,11 +2242,7 @@ TEST(OutlierDetectionEventLoggerImplTest, All) {
 }
 
 TEST(OutlierUtility, SRThreshold) {
-  std::vector<HostSuccessRatePair> data = {
-      HostSuccessRatePair(nullptr, 50),  HostSuccessRatePair(nullptr, 100),
-      HostSuccessRatePair(nullptr, 100), HostSuccessRatePair(nullptr, 100),
-      HostSuccessRatePair(nullptr, 100),
-  };
+  std::vector<double> data = {50, 100, 100, 100, 100};
   double sum = 450;
 
   DetectorImpl::EjectionPair success_rate_nums =
@@ -2251,6 +2251,56 @@ TEST(OutlierUtility, SRThreshold) {
   EXPECT_EQ(52.0, success_rate_nums.ejection_threshold_);   // ejection threshold
 }
 
+TEST(OutlierResultAccumulatorTest, CollectSumsAndResetsAllShards) {
+  ResultAccumulator accumulator(ResultAccumulator::MaxShards);
+  ResultAccumulator::Slot slot = accumulator.allocate();
+
+  // Report from a few threads, which land in different shards of the accumulator.
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < 4; i++) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&accumulator, slot]() {
+      HostResultCounters& counters = accumulator.threadCounters(slot);
+      for (uint32_t j = 0; j < 1000; j++) {
+        counters.external_origin_total_++;
+        counters.external_origin_success_++;
+        counters.local_origin_total_++;
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  accumulator.threadCounters(slot).external_origin_total_++;
+
+  HostResults results = accumulator.collect(slot);
+  EXPECT_EQ(4000, results.external_origin_success_);
+  EXPECT_EQ(4001, results.external_origin_total_);
+  EXPECT_EQ(0, results.local_origin_success_);
+  EXPECT_EQ(4000, results.local_origin_total_);
+
+  results = accumulator.collect(slot);
+  EXPECT_EQ(0, results.external_origin_total_);
+  EXPECT_EQ(0, results.local_origin_total_);
+}
+
+TEST(OutlierResultAccumulatorTest, ReusedSlotIsCleared) {
+  ResultAccumulator accumulator(2);
+  std::vector<ResultAccumulator::Slot> slots;
+  for (uint32_t i = 0; i < ResultAccumulator::HostsPerBlock + 1; i++) {
+    slots.push_back(accumulator.allocate());
+  }
+  // Slots of the same block share the rows of the block, slots of another block don't.
+  EXPECT_EQ(slots[0].rows_, slots[ResultAccumulator::HostsPerBlock - 1].rows_);
+  EXPECT_NE(slots[0].rows_, slots[ResultAccumulator::HostsPerBlock].rows_);
+
+  accumulator.threadCounters(slots[1]).external_origin_total_ += 10;
+  accumulator.release(slots[1]);
+  ResultAccumulator::Slot reused = accumulator.allocate();
+  EXPECT_EQ(slots[1].rows_, reused.rows_);
+  EXPECT_EQ(slots[1].index_, reused.index_);
+  EXPECT_EQ(0, accumulator.collect(reused).external_origin_total_);
+}
+
 } // namespace
 } // namespace Outlier
 } // namespace Upstream
@@ -0,0 +1,112 @@
+#include <chrono>
+
+#include "source/common/upstream/response_time_tracker.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+using std::chrono::microseconds;
+
+TEST(ResponseTimeTrackerImplTest, NoPercentileBelowMinRequests) {
+  ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < ResponseTimeTrackerImpl::MinRequests - 1; i++) {
+    tracker.recordResponseTime(microseconds(1000));
+  }
+  EXPECT_EQ(absl::nullopt, tracker.responseTimePercentile(50));
+
+  tracker.recordResponseTime(microseconds(1000));
+  EXPECT_TRUE(tracker.responseTimePercentile(50).has_value());
+}
+
+TEST(ResponseTimeTrackerImplTest, SmallResponseTimesAreExact) {
+  ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < ResponseTimeTrackerImpl::MinRequests; i++) {
+    tracker.recordResponseTime(microseconds(i % 16));
+  }
+  tracker.recordResponseTime(microseconds(-1));
+
+  EXPECT_EQ(microseconds(0), tracker.responseTimePercentile(0.1));
+  EXPECT_EQ(microseconds(7), tracker.responseTimePercentile(50));
+  EXPECT_EQ(microseconds(15), tracker.responseTimePercentile(100));
+}
+
+TEST(ResponseTimeTrackerImplTest, PercentilesWithinBucketError) {
+  ResponseTimeTrackerImpl tracker;
+  // 1ms to 1s.
+  for (uint32_t i = 1; i <= 1000; i++) {
+    tracker.recordResponseTime(microseconds(i * 1000));
+  }
+
+  for (const double percentile : {50.0, 90.0, 95.0, 99.0, 99.9}) {
+    const microseconds expected(static_cast<int64_t>(percentile * 10) * 1000);
+    const absl::optional<microseconds> actual = tracker.responseTimePercentile(percentile);
+    ASSERT_TRUE(actual.has_value());
+    // The upper bound of the bucket of the percentile is returned.
+    EXPECT_GE(actual.value(), expected) << percentile;
+    EXPECT_LE(actual.value().count(), expected.count() * 1.125) << percentile;
+  }
+
+  // Response times of hours are tracked too.
+  for (uint32_t i = 0; i < 1000; i++) {
+    tracker.recordResponseTime(std::chrono::hours(1));
+  }
+  EXPECT_GT(tracker.responseTimePercentile(99).value(), std::chrono::minutes(30));
+}
+
+TEST(ResponseTimeTrackerImplTest, RecentResponseTimesWeighMost) {
+  ResponseTimeTrackerImpl tracker;
+  for (uint32_t i = 0; i < ResponseTimeTrackerImpl::WindowSize; i++) {
+    tracker.recordResponseTime(microseconds(100));
+  }
+  EXPECT_EQ(microseconds(103), tracker.responseTimePercentile(50));
+
+  // The counts are halved every window, so the old response times fade out.
+  for (uint32_t i = 0; i < 3 * ResponseTimeTrackerImpl::WindowSize; i++) {
+    tracker.recordResponseTime(microseconds(5000));
+  }
+  EXPECT_EQ(microseconds(5119), tracker.responseTimePercentile(90));
+  EXPECT_EQ(microseconds(5119), tracker.responseTimePercentile(10));
+}
+
+TEST(ResponseTimeTrackerImplTest, HedgeBudget) {
+  ResponseTimeTrackerImpl tracker;
+  EXPECT_FALSE(tracker.tryHedge(10));
+
+  for (uint32_t i = 0; i < 100; i++) {
+    tracker.recordResponseTime(microseconds(1000));
+  }
+  for (uint32_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(tracker.tryHedge(10));
+  }
+  EXPECT_FALSE(tracker.tryHedge(10));
+  EXPECT_TRUE(tracker.tryHedge(20));
+
+  // A cancelled hedge is given back to the budget.
+  tracker.cancelHedge();
+  EXPECT_TRUE(tracker.tryHedge(20));
+  EXPECT_FALSE(tracker.tryHedge(20));
+  tracker.cancelHedge();
+
+  for (uint32_t i = 0; i < 20; i++) {
+    tracker.recordResponseTime(microseconds(1000));
+  }
+  EXPECT_TRUE(tracker.tryHedge(10));
+  EXPECT_FALSE(tracker.tryHedge(10));
+
+  // The hedges are halved with the requests.
+  for (uint32_t i = 120; i < ResponseTimeTrackerImpl::WindowSize; i++) {
+    tracker.recordResponseTime(microseconds(1000));
+  }
+  // 512 requests and 6 hedges.
+  for (uint32_t i = 0; i < 45; i++) {
+    EXPECT_TRUE(tracker.tryHedge(10));
+  }
+  EXPECT_FALSE(tracker.tryHedge(10));
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,113 @@
+#include "envoy/config/cluster/v3/circuit_breaker.pb.h"
+
+#include "source/common/upstream/retry_token_bucket.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+TEST(RetryTokenBucketImplTest, TakeTokens) {
+  RetryTokenBucketImpl bucket(3, 0.5);
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_TRUE(bucket.hasToken());
+    EXPECT_TRUE(bucket.tryTakeToken());
+  }
+  EXPECT_FALSE(bucket.hasToken());
+  EXPECT_FALSE(bucket.tryTakeToken());
+}
+
+TEST(RetryTokenBucketImplTest, SuccessesPutBackTokens) {
+  RetryTokenBucketImpl bucket(2, 0.4);
+  EXPECT_TRUE(bucket.tryTakeToken());
+  EXPECT_TRUE(bucket.tryTakeToken());
+
+  // It takes 3 successes to earn back a token.
+  bucket.onSuccess();
+  bucket.onSuccess();
+  EXPECT_FALSE(bucket.hasToken());
+  bucket.onSuccess();
+  EXPECT_TRUE(bucket.tryTakeToken());
+  EXPECT_FALSE(bucket.tryTakeToken());
+
+  // The bucket doesn't fill up beyond its maximum.
+  for (uint32_t i = 0; i < 100; i++) {
+    bucket.onSuccess();
+  }
+  EXPECT_TRUE(bucket.tryTakeToken());
+  EXPECT_TRUE(bucket.tryTakeToken());
+  EXPECT_FALSE(bucket.tryTakeToken());
+}
+
+TEST(RetryTokenBucketImplTest, TinyTokenRatio) {
+  RetryTokenBucketImpl bucket(1, 0.0);
+  EXPECT_TRUE(bucket.tryTakeToken());
+
+  // A success always puts back a thousandth of a token.
+  for (uint32_t i = 0; i < 999; i++) {
+    bucket.onSuccess();
+  }
+  EXPECT_FALSE(bucket.hasToken());
+  bucket.onSuccess();
+  EXPECT_TRUE(bucket.hasToken());
+}
+
+TEST(RetryTokenBucketsImplTest, Defaults) {
+  envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket config;
+  TestUtility::loadFromYaml("max_tokens: 10", config);
+  RetryTokenBucketsImpl buckets(config);
+
+  EXPECT_EQ(nullptr, buckets.createHostBucket());
+  EXPECT_EQ(0U, buckets.hostFailureStreak());
+  EXPECT_EQ(RetryTokenBucketsImpl::DefaultHostSelectionMaxAttempts,
+            buckets.hostSelectionMaxAttempts());
+
+  for (uint32_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(buckets.clusterBucket().tryTakeToken());
+  }
+  EXPECT_FALSE(buckets.clusterBucket().tryTakeToken());
+  // The default token ratio earns back a token every 10 successes.
+  for (uint32_t i = 0; i < 10; i++) {
+    EXPECT_FALSE(buckets.clusterBucket().hasToken());
+    buckets.clusterBucket().onSuccess();
+  }
+  EXPECT_TRUE(buckets.clusterBucket().hasToken());
+}
+
+TEST(RetryTokenBucketsImplTest, HostBuckets) {
+  envoy::config::cluster::v3::CircuitBreakers::RetryTokenBucket config;
+  TestUtility::loadFromYaml(R"EOF(
+    max_tokens: 10
+    max_host_tokens: 2
+    token_ratio: 0.5
+    host_failure_streak: 3
+    host_selection_max_attempts: 5
+  )EOF",
+                            config);
+  RetryTokenBucketsImpl buckets(config);
+
+  EXPECT_EQ(3U, buckets.hostFailureStreak());
+  EXPECT_EQ(5U, buckets.hostSelectionMaxAttempts());
+
+  RetryTokenBucketPtr host_bucket = buckets.createHostBucket();
+  ASSERT_NE(nullptr, host_bucket);
+  EXPECT_TRUE(host_bucket->tryTakeToken());
+  EXPECT_TRUE(host_bucket->tryTakeToken());
+  EXPECT_FALSE(host_bucket->tryTakeToken());
+
+  // Every host has its own bucket.
+  EXPECT_TRUE(buckets.createHostBucket()->hasToken());
+  EXPECT_TRUE(buckets.clusterBucket().hasToken());
+
+  host_bucket->onSuccess();
+  EXPECT_FALSE(host_bucket->hasToken());
+  host_bucket->onSuccess();
+  EXPECT_TRUE(host_bucket->hasToken());
+}
+
+} // namespace
+} // namespace Upstream
+} // namespace Envoy
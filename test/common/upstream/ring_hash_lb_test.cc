@@ -893,6 +893,78 @@ TEST_P(RingHashLoadBalancerTest, LopsidedWeightSmallScale) {
   }
 }
 
+// Rings rebuilt from the previous ring after hosts are added, removed, reweighted and re-keyed
+// should match a ring built from scratch.
+TEST_P(RingHashLoadBalancerTest, IncrementalRebuildMatchesFullBuild) {
+  for (uint32_t i = 0; i < 8; ++i) {
+    hostSet().hosts_.push_back(makeTestHostWithHashKey(
+        info_, absl::StrCat("key", i), fmt::format("tcp://127.0.0.1:{}", 90 + i), simTime()));
+  }
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = envoy::config::cluster::v3::Cluster::RingHashLbConfig();
+  config_.value().mutable_minimum_ring_size()->set_value(64);
+  init();
+  EXPECT_EQ(64, lb_->stats().size_.value());
+
+  // Remove :91, add :98, give :92 more hashes and :93 fewer, and re-key :94.
+  const HostSharedPtr removed = hostSet().hosts_[1];
+  hostSet().hosts_.erase(hostSet().hosts_.begin() + 1);
+  hostSet().hosts_.push_back(
+      makeTestHostWithHashKey(info_, "key8", "tcp://127.0.0.1:98", simTime()));
+  for (const auto& host : hostSet().hosts_) {
+    host->weight(2);
+  }
+  hostSet().hosts_[1]->weight(3);
+  hostSet().hosts_[2]->weight(1);
+  hostSet().hosts_[3]->metadata(
+      makeTestHostWithHashKey(info_, "rekeyed", "tcp://127.0.0.1:99", simTime())->metadata());
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({hostSet().hosts_.back()}, {removed});
+  LoadBalancerPtr incremental = lb_->factory()->create();
+  EXPECT_EQ(64, lb_->stats().size_.value());
+  EXPECT_EQ(4, lb_->stats().min_hashes_per_host_.value());
+  EXPECT_EQ(12, lb_->stats().max_hashes_per_host_.value());
+
+  RingHashLoadBalancer full(priority_set_, stats_, stats_store_, runtime_, random_, config_,
+                            common_config_);
+  full.initialize();
+  LoadBalancerPtr expected = full.factory()->create();
+  for (uint64_t i = 0; i < 4096; ++i) {
+    TestLoadBalancerContext context(i * 0x9e3779b97f4a7c15);
+    EXPECT_EQ(expected->chooseHost(&context), incremental->chooseHost(&context));
+  }
+}
+
+// An update of one priority should not rebuild the rings of the others.
+TEST_P(RingHashFailoverTest, UnchangedPriorityIsShared) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime())};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  failover_host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:82", simTime())};
+  failover_host_set_.healthy_hosts_ = failover_host_set_.hosts_;
+
+  config_ = envoy::config::cluster::v3::Cluster::RingHashLbConfig();
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  init();
+  EXPECT_EQ(12, lb_->stats().max_hashes_per_host_.value());
+
+  // The gauges are set by the last ring built. P=1 comes last, so they only show the new P=0 ring
+  // if the P=1 ring was not rebuilt.
+  host_set_.hosts_.push_back(makeTestHost(info_, "tcp://127.0.0.1:81", simTime()));
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({host_set_.hosts_.back()}, {});
+  EXPECT_EQ(6, lb_->stats().max_hashes_per_host_.value());
+
+  // Losing all healthy hosts at P=0 flips its panic state and rebuilds it, P=1 is still shared.
+  host_set_.healthy_hosts_.clear();
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(6, lb_->stats().max_hashes_per_host_.value());
+  LoadBalancerPtr lb = lb_->factory()->create();
+  EXPECT_CALL(random_, random()).WillOnce(Return(0));
+  EXPECT_EQ(failover_host_set_.hosts_[0], lb->chooseHost(nullptr));
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
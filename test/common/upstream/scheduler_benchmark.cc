@@ -5,6 +5,7 @@
 
 #include "source/common/common/random_generator.h"
 #include "source/common/upstream/edf_scheduler.h"
+#include "source/common/upstream/interleaved_wrr_scheduler.h"
 #include "source/common/upstream/wrsq_scheduler.h"
 
 #include "test/benchmark/main.h"
@@ -159,6 +160,48 @@ void uniqueWeightPickWRSQ(::benchmark::State& state) {
                             });
 }
 
+void splitWeightAddInterleaved(::benchmark::State& state) {
+  const size_t num_objs = state.range(0);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // A new scheduler per iteration, as the entries are sorted on the first pick, like on a
+    // refresh of the LB.
+    InterleavedWrrScheduler<SchedulerTester::ObjInfo> iwrr;
+    SchedulerTester::setupSplitWeights(iwrr, num_objs, state);
+    iwrr.pickAndAdd([](const auto& i) { return i.weight; });
+  }
+}
+
+void uniqueWeightAddInterleaved(::benchmark::State& state) {
+  const size_t num_objs = state.range(0);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    // A new scheduler per iteration, as the entries are sorted on the first pick, like on a
+    // refresh of the LB.
+    InterleavedWrrScheduler<SchedulerTester::ObjInfo> iwrr;
+    SchedulerTester::setupUniqueWeights(iwrr, num_objs, state);
+    iwrr.pickAndAdd([](const auto& i) { return i.weight; });
+  }
+}
+
+void splitWeightPickInterleaved(::benchmark::State& state) {
+  InterleavedWrrScheduler<SchedulerTester::ObjInfo> iwrr;
+  const size_t num_objs = state.range(0);
+
+  SchedulerTester::pickTest(iwrr, state,
+                            [num_objs, &state](Scheduler<SchedulerTester::ObjInfo>& sched) {
+                              return SchedulerTester::setupSplitWeights(sched, num_objs, state);
+                            });
+}
+
+void uniqueWeightPickInterleaved(::benchmark::State& state) {
+  InterleavedWrrScheduler<SchedulerTester::ObjInfo> iwrr;
+  const size_t num_objs = state.range(0);
+
+  SchedulerTester::pickTest(iwrr, state,
+                            [num_objs, &state](Scheduler<SchedulerTester::ObjInfo>& sched) {
+                              return SchedulerTester::setupUniqueWeights(sched, num_objs, state);
+                            });
+}
+
 BENCHMARK(splitWeightAddEdf)
     ->Unit(::benchmark::kMicrosecond)
     ->RangeMultiplier(8)
@@ -167,8 +210,13 @@ BENCHMARK(splitWeightAddWRSQ)
     ->Unit(::benchmark::kMicrosecond)
     ->RangeMultiplier(8)
     ->Range(1 << 6, 1 << 14);
+BENCHMARK(splitWeightAddInterleaved)
+    ->Unit(::benchmark::kMicrosecond)
+    ->RangeMultiplier(8)
+    ->Range(1 << 6, 1 << 14);
 BENCHMARK(splitWeightPickEdf)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
 BENCHMARK(splitWeightPickWRSQ)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
+BENCHMARK(splitWeightPickInterleaved)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
 BENCHMARK(uniqueWeightAddEdf)
     ->Unit(::benchmark::kMicrosecond)
     ->RangeMultiplier(8)
@@ -177,8 +225,13 @@ BENCHMARK(uniqueWeightAddWRSQ)
     ->Unit(::benchmark::kMicrosecond)
     ->RangeMultiplier(8)
     ->Range(1 << 6, 1 << 14);
+BENCHMARK(uniqueWeightAddInterleaved)
+    ->Unit(::benchmark::kMicrosecond)
+    ->RangeMultiplier(8)
+    ->Range(1 << 6, 1 << 14);
 BENCHMARK(uniqueWeightPickEdf)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
 BENCHMARK(uniqueWeightPickWRSQ)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
+BENCHMARK(uniqueWeightPickInterleaved)->RangeMultiplier(8)->Range(1 << 6, 1 << 14);
 
 } // namespace
 } // namespace Upstream
@@ -1262,6 +1262,48 @@ TEST_P(SubsetLoadBalancerTest, UpdateRemovingLastSubsetHost) {
   EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
 }
 
+// The values of the metadata of the hosts change on every update, so the values of the old
+// versions are forgotten while the current versions keep matching their subsets. The ids of the
+// forgotten values are reused by the later versions.
+TEST_P(SubsetLoadBalancerTest, MetadataValuesChurn) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
+
+  std::vector<SubsetSelectorPtr> subset_selectors = {makeSelector(
+      {"version"},
+      envoy::config::cluster::v3::Cluster::LbSubsetConfig::LbSubsetSelector::NOT_DEFINED)};
+  EXPECT_CALL(subset_info_, subsetSelectors()).WillRepeatedly(ReturnRef(subset_selectors));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}}},
+      {"tcp://127.0.0.1:81", {{"version", "stable"}}},
+  });
+
+  TestLoadBalancerContext context_stable({{"version", "stable"}});
+  for (uint32_t i = 1; i <= 100; i++) {
+    const std::string version = absl::StrCat("1.", i);
+    const std::string previous_version = absl::StrCat("1.", i - 1);
+    host_set_.hosts_[0]->metadata(buildMetadata(version));
+    host_set_.runCallbacks({}, {});
+
+    TestLoadBalancerContext context({{"version", version}});
+    TestLoadBalancerContext previous_context({{"version", previous_version}});
+    EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context));
+    EXPECT_EQ(nullptr, lb_->chooseHost(&previous_context));
+    EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_stable));
+    EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+    EXPECT_EQ(2U + i, stats_.lb_subsets_created_.value());
+    EXPECT_EQ(i, stats_.lb_subsets_removed_.value());
+  }
+
+  // A new metadata object with the same values keeps the host in its subset.
+  host_set_.hosts_[1]->metadata(buildMetadata("stable"));
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_stable));
+  EXPECT_EQ(102U, stats_.lb_subsets_created_.value());
+  EXPECT_EQ(100U, stats_.lb_subsets_removed_.value());
+}
+
 TEST_P(SubsetLoadBalancerTest, UpdateRemovingUnknownHost) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::config::cluster::v3::Cluster::LbSubsetConfig::NO_FALLBACK));
@@ -206,6 +206,10 @@ public:
   ClusterDiscoveryManager createAndSwapClusterDiscoveryManager(std::string thread_name) {
     return ClusterManagerImpl::createAndSwapClusterDiscoveryManager(std::move(thread_name));
   }
+
+  bool threadLocalClusterCreated(absl::string_view name) {
+    return ClusterManagerImpl::threadLocalClusterCreated(name);
+  }
 };
 
 // Override postThreadLocalClusterUpdate so we can test that merged updates calls
@@ -3489,6 +3489,52 @@ TEST_F(ClusterInfoImplTest, RetryBudgetDefaultPopulation) {
   EXPECT_EQ(min_retry_concurrency, 123UL);
 }
 
+TEST_F(ClusterInfoImplTest, RetryTokenBuckets) {
+  const std::string yaml_disabled = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    circuit_breakers:
+      thresholds:
+      - priority: DEFAULT
+        max_retries: 123
+  )EOF";
+
+  auto cluster = makeCluster(yaml_disabled);
+  EXPECT_FALSE(cluster->info()->retryTokenBuckets().has_value());
+  EXPECT_FALSE(makeTestHost(cluster->info(), "tcp://10.0.0.1:1234", api_->timeSource())
+                   ->retryTokenBucket()
+                   .has_value());
+
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    circuit_breakers:
+      retry_token_bucket:
+        max_tokens: 10
+        max_host_tokens: 1
+        host_failure_streak: 3
+  )EOF";
+
+  cluster = makeCluster(yaml);
+  ASSERT_TRUE(cluster->info()->retryTokenBuckets().has_value());
+  RetryTokenBuckets& buckets = cluster->info()->retryTokenBuckets()->get();
+  EXPECT_TRUE(buckets.clusterBucket().hasToken());
+  EXPECT_EQ(3U, buckets.hostFailureStreak());
+  EXPECT_EQ(3U, buckets.hostSelectionMaxAttempts());
+
+  HostSharedPtr host1 = makeTestHost(cluster->info(), "tcp://10.0.0.1:1234", api_->timeSource());
+  HostSharedPtr host2 = makeTestHost(cluster->info(), "tcp://10.0.0.2:1234", api_->timeSource());
+  ASSERT_TRUE(host1->retryTokenBucket().has_value());
+  ASSERT_TRUE(host2->retryTokenBucket().has_value());
+  EXPECT_TRUE(host1->retryTokenBucket()->get().tryTakeToken());
+  EXPECT_FALSE(host1->retryTokenBucket()->get().hasToken());
+  EXPECT_TRUE(host2->retryTokenBucket()->get().hasToken());
+}
+
 TEST_F(ClusterInfoImplTest, UnsupportedPerHostFields) {
   std::string yaml = R"EOF(
     name: name
@@ -3950,6 +3996,33 @@ TEST_F(ClusterInfoImplTest, TestTrackTimeoutBudgets) {
             tb_stats.upstream_rq_timeout_budget_per_try_percent_used_.unit());
 }
 
+TEST_F(ClusterInfoImplTest, TestTrackResponseTimePercentiles) {
+  const std::string yaml_disabled = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    track_cluster_stats: { timeout_budgets : true }
+  )EOF";
+
+  auto cluster = makeCluster(yaml_disabled);
+  EXPECT_FALSE(cluster->info()->responseTimeTracker().has_value());
+
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    track_cluster_stats: { response_time_percentiles : true }
+  )EOF";
+
+  cluster = makeCluster(yaml);
+  ASSERT_TRUE(cluster->info()->responseTimeTracker().has_value());
+  EXPECT_FALSE(cluster->info()->timeoutBudgetStats().has_value());
+  EXPECT_EQ(absl::nullopt,
+            cluster->info()->responseTimeTracker()->get().responseTimePercentile(50));
+}
+
 TEST_F(ClusterInfoImplTest, DEPRECATED_FEATURE_TEST(TestTrackTimeoutBudgetsOld)) {
   // Check that without the flag specified, the histogram is null.
   const std::string yaml_disabled = R"EOF(
@@ -5118,6 +5191,20 @@ TEST_F(ClusterInfoImplTest, MaxRequestsPerConnectionValidation) {
                             "HttpProtocolOptions can be specified");
 }
 
+TEST_F(ClusterInfoImplTest, ShareHttp2ConnectionsAcrossWorkersValidation) {
+  const std::string yaml = R"EOF(
+  name: cluster1
+  type: STRICT_DNS
+  lb_policy: ROUND_ROBIN
+  share_http2_connections_across_workers: true
+  connection_pool_per_downstream_connection: true
+)EOF";
+
+  EXPECT_THROW_WITH_MESSAGE(makeCluster(yaml), EnvoyException,
+                            "share_http2_connections_across_workers cannot be combined with "
+                            "connection_pool_per_downstream_connection");
+}
+
 TEST_F(ClusterInfoImplTest, DeprecatedMaxRequestsPerConnection) {
   const std::string yaml = R"EOF(
   name: cluster1
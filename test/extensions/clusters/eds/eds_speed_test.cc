@@ -107,9 +107,9 @@ public:
   }
 
   // Set up an EDS config with multiple priorities, localities, weights and make sure
-  // they are loaded as expected.
+  // they are loaded as expected. Unless timed, the update is applied with timing paused.
   void priorityAndLocalityWeightedHelper(bool ignore_unknown_dynamic_fields, size_t num_hosts,
-                                         bool healthy) {
+                                         bool healthy, bool timed = true) {
     state_.PauseTiming();
 
     envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
@@ -146,7 +146,9 @@ public:
     response->set_version_info(fmt::format("version-{}", version_++));
     auto* resource = response->mutable_resources()->Add();
     resource->PackFrom(cluster_load_assignment);
-    state_.ResumeTiming();
+    if (timed) {
+      state_.ResumeTiming();
+    }
     if (use_unified_mux_) {
       dynamic_cast<Config::XdsMux::GrpcMuxSotw&>(*grpc_mux_)
           .grpcStreamForTest()
@@ -237,3 +239,24 @@ static void healthOnlyUpdate(State& state) {
 }
 
 BENCHMARK(healthOnlyUpdate)->Ranges({{1, 100000}, {false, true}})->Unit(benchmark::kMillisecond);
+
+// Times an update that adds an endpoint to, or removes one from, the previous update.
+static void singleEndpointUpdate(State& state) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_state(spdlog::level::warn,
+                                       Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock, false);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    Envoy::Upstream::EdsSpeedTest speed_test(state, false);
+    uint32_t endpoints = skipExpensiveBenchmarks() ? 2 : state.range(0);
+
+    speed_test.priorityAndLocalityWeightedHelper(true, endpoints, true, false);
+    state.ResumeTiming();
+    const uint32_t updated_endpoints = state.range(1) ? endpoints + 1 : endpoints - 1;
+    speed_test.priorityAndLocalityWeightedHelper(true, updated_endpoints, true);
+  }
+}
+
+BENCHMARK(singleEndpointUpdate)
+    ->RangeMultiplier(10)
+    ->Ranges({{10, 100000}, {false, true}})
+    ->Unit(benchmark::kMillisecond);
@@ -384,6 +384,63 @@ TEST_F(EdsTest, EndpointWeightChangeCausesRebuild) {
   EXPECT_EQ(new_hosts[0]->weight(), 31);
 }
 
+// Verify that endpoints keep their hosts across updates, whether they changed or not, unless their
+// locality changed.
+TEST_F(EdsTest, EndpointHostsKeptAcrossUpdates) {
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  endpoints->mutable_locality()->set_zone("zone_a");
+  auto add_endpoint = [](envoy::config::endpoint::v3::LocalityLbEndpoints& endpoints,
+                         const std::string& address) {
+    auto* endpoint = endpoints.add_lb_endpoints();
+    endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address()->set_address(
+        address);
+    endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address()->set_port_value(80);
+    return endpoint;
+  };
+  add_endpoint(*endpoints, "1.2.3.4");
+  auto* weighted = add_endpoint(*endpoints, "2.3.4.5");
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_TRUE(initialized_);
+  const HostVector first_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(2, first_hosts.size());
+
+  // Adding an endpoint and changing the weight of another keeps the existing hosts.
+  add_endpoint(*endpoints, "3.4.5.6");
+  weighted->mutable_load_balancing_weight()->set_value(20);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  {
+    const auto& hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+    ASSERT_EQ(3, hosts.size());
+    EXPECT_EQ(first_hosts[0], hosts[0]);
+    EXPECT_EQ(first_hosts[1], hosts[1]);
+    EXPECT_EQ(20, hosts[1]->weight());
+    EXPECT_EQ("3.4.5.6:80", hosts[2]->address()->asString());
+  }
+
+  // Moving an endpoint to another locality replaces its host.
+  endpoints->mutable_lb_endpoints()->erase(endpoints->mutable_lb_endpoints()->begin());
+  auto* other_endpoints = cluster_load_assignment.add_endpoints();
+  other_endpoints->mutable_locality()->set_zone("zone_b");
+  add_endpoint(*other_endpoints, "1.2.3.4");
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  const HostVector moved_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(3, moved_hosts.size());
+  EXPECT_EQ(first_hosts[1], moved_hosts[0]);
+  EXPECT_EQ("1.2.3.4:80", moved_hosts[2]->address()->asString());
+  EXPECT_NE(first_hosts[0], moved_hosts[2]);
+  EXPECT_EQ("zone_b", moved_hosts[2]->locality().zone());
+
+  // The same update again does not rebuild the cluster, and keeps the host of the moved endpoint.
+  const uint64_t no_rebuild = stats_.counter("cluster.name.update_no_rebuild").value();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(no_rebuild + 1, stats_.counter("cluster.name.update_no_rebuild").value());
+  EXPECT_EQ(moved_hosts, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts());
+}
+
 // Validate that onConfigUpdate() updates the endpoint metadata.
 TEST_F(EdsTest, EndpointMetadata) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
@@ -0,0 +1,297 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+
+#include "source/common/network/address_impl.h"
+#include "source/common/network/utility.h"
+#include "source/extensions/filters/common/rbac/compiled_policies.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Const;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+namespace {
+
+class CompiledPoliciesTest : public testing::Test {
+protected:
+  void initialize(const std::string& yaml) {
+    TestUtility::loadFromYaml(yaml, rules_);
+    for (const auto& policy : rules_.policies()) {
+      if (policy.second.has_condition() && builder_ == nullptr) {
+        builder_ = Expr::createBuilder(&arena_);
+      }
+    }
+    compiled_ = std::make_unique<CompiledPolicies>(rules_, builder_.get(),
+                                                   ProtobufMessage::getStrictValidationVisitor());
+    reference_.clear();
+    for (const auto& policy : rules_.policies()) {
+      reference_.emplace(policy.first, std::make_unique<PolicyMatcher>(
+                                           policy.second, builder_.get(),
+                                           ProtobufMessage::getStrictValidationVisitor()));
+    }
+  }
+
+  void setSourceAddress(const std::string& address) {
+    connection_.stream_info_.downstream_connection_info_provider_->setRemoteAddress(
+        Network::Utility::parseInternetAddress(address, 1234, false));
+  }
+
+  void setPeerCertificate(std::vector<std::string> uri_sans, std::vector<std::string> dns_sans,
+                          std::string subject) {
+    uri_sans_ = std::move(uri_sans);
+    dns_sans_ = std::move(dns_sans);
+    subject_ = std::move(subject);
+    auto ssl = std::make_shared<NiceMock<Ssl::MockConnectionInfo>>();
+    ON_CALL(*ssl, uriSanPeerCertificate()).WillByDefault(Return(uri_sans_));
+    ON_CALL(*ssl, dnsSansPeerCertificate()).WillByDefault(Return(dns_sans_));
+    ON_CALL(*ssl, subjectPeerCertificate()).WillByDefault(ReturnRef(subject_));
+    ON_CALL(Const(connection_), ssl()).WillByDefault(Return(ssl));
+  }
+
+  // The policy the engine matched before policies were compiled.
+  std::string expectedMatch() {
+    for (const auto& policy : reference_) {
+      if (policy.second->matches(connection_, headers_, info_)) {
+        return policy.first;
+      }
+    }
+    return "";
+  }
+
+  std::string firstMatch() {
+    const std::string* policy = compiled_->firstMatch(connection_, headers_, info_);
+    EXPECT_EQ(expectedMatch(), policy == nullptr ? "" : *policy);
+    return policy == nullptr ? "" : *policy;
+  }
+
+  envoy::config::rbac::v3::RBAC rules_;
+  Protobuf::Arena arena_;
+  Expr::BuilderPtr builder_;
+  std::unique_ptr<CompiledPolicies> compiled_;
+  std::map<std::string, std::unique_ptr<PolicyMatcher>> reference_;
+  NiceMock<Network::MockConnection> connection_;
+  Http::TestRequestHeaderMapImpl headers_;
+  NiceMock<StreamInfo::MockStreamInfo> info_;
+  std::vector<std::string> uri_sans_;
+  std::vector<std::string> dns_sans_;
+  std::string subject_;
+};
+
+TEST_F(CompiledPoliciesTest, SourceIpIndex) {
+  initialize(R"EOF(
+policies:
+  b-wide:
+    permissions: [{any: true}]
+    principals: [{source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}}]
+  a-narrow:
+    permissions: [{header: {name: ":method", string_match: {exact: GET}}}]
+    principals:
+    - or_ids:
+        ids:
+        - source_ip: {address_prefix: 10.1.0.0, prefix_len: 16}
+        - source_ip: {address_prefix: "2001:db8::", prefix_len: 32}
+)EOF");
+
+  setSourceAddress("10.1.2.3");
+  EXPECT_EQ("b-wide", firstMatch());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "GET"}};
+  EXPECT_EQ("a-narrow", firstMatch());
+  setSourceAddress("10.2.2.3");
+  EXPECT_EQ("b-wide", firstMatch());
+  setSourceAddress("2001:db8::1");
+  EXPECT_EQ("a-narrow", firstMatch());
+  setSourceAddress("11.1.2.3");
+  EXPECT_EQ("", firstMatch());
+}
+
+TEST_F(CompiledPoliciesTest, NonIpAddress) {
+  initialize(R"EOF(
+policies:
+  ip:
+    permissions: [{any: true}]
+    principals: [{source_ip: {address_prefix: 0.0.0.0, prefix_len: 0}}]
+)EOF");
+
+  connection_.stream_info_.downstream_connection_info_provider_->setRemoteAddress(
+      std::make_shared<Network::Address::PipeInstance>("/foo"));
+  EXPECT_EQ("", firstMatch());
+}
+
+TEST_F(CompiledPoliciesTest, PrincipalNameIndex) {
+  initialize(R"EOF(
+policies:
+  exact:
+    permissions: [{any: true}]
+    principals:
+    - authenticated: {principal_name: {exact: "spiffe://cluster.local/ns/default/sa/foo"}}
+    - authenticated: {principal_name: {exact: "foo.example.com"}}
+  ignore-case:
+    permissions: [{any: true}]
+    principals:
+    - authenticated: {principal_name: {exact: "SUBJECT", ignore_case: true}}
+  prefix:
+    permissions: [{any: true}]
+    principals:
+    - authenticated: {principal_name: {prefix: "spiffe://cluster.local/ns/prod/"}}
+)EOF");
+
+  EXPECT_EQ("", firstMatch());
+  setPeerCertificate({"spiffe://cluster.local/ns/default/sa/foo"}, {}, "");
+  EXPECT_EQ("exact", firstMatch());
+  setPeerCertificate({"spiffe://cluster.local/ns/default/sa/bar"}, {"foo.example.com"}, "");
+  EXPECT_EQ("exact", firstMatch());
+  setPeerCertificate({"spiffe://cluster.local/ns/prod/sa/bar"}, {}, "subject");
+  EXPECT_EQ("ignore-case", firstMatch());
+  setPeerCertificate({"spiffe://cluster.local/ns/prod/sa/bar"}, {}, "other");
+  EXPECT_EQ("prefix", firstMatch());
+  setPeerCertificate({}, {}, "spiffe://cluster.local/ns/default/sa/foo");
+  EXPECT_EQ("exact", firstMatch());
+}
+
+TEST_F(CompiledPoliciesTest, SharedMatchers) {
+  initialize(R"EOF(
+policies:
+  a:
+    permissions:
+    - and_rules:
+        rules:
+        - header: {name: ":method", string_match: {exact: POST}}
+        - url_path: {path: {prefix: "/admin"}}
+    principals: [{any: true}]
+  b:
+    permissions:
+    - not_rule: {header: {name: ":method", string_match: {exact: POST}}}
+    principals:
+    - not_id: {url_path: {path: {prefix: "/admin"}}}
+  c:
+    permissions: [{url_path: {path: {prefix: "/admin"}}}]
+    principals: [{header: {name: ":method", string_match: {exact: GET}}}]
+)EOF");
+
+  EXPECT_EQ(2, compiled_->sharedMatcherCount());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "POST"}, {":path", "/admin/x"}};
+  EXPECT_EQ("a", firstMatch());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "GET"}, {":path", "/status"}};
+  EXPECT_EQ("b", firstMatch());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "GET"}, {":path", "/admin"}};
+  EXPECT_EQ("c", firstMatch());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "POST"}, {":path", "/status"}};
+  EXPECT_EQ("", firstMatch());
+}
+
+TEST_F(CompiledPoliciesTest, Condition) {
+  initialize(R"EOF(
+policies:
+  a:
+    permissions: [{any: true}]
+    principals: [{source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}}]
+    condition:
+      call_expr:
+        function: _==_
+        args:
+        - select_expr:
+            operand: {ident_expr: {name: request}}
+            field: method
+        - const_expr: {string_value: GET}
+  b:
+    permissions: [{any: true}]
+    principals: [{source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}}]
+)EOF");
+
+  setSourceAddress("10.0.0.1");
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "GET"}};
+  EXPECT_EQ("a", firstMatch());
+  headers_ = Http::TestRequestHeaderMapImpl{{":method", "POST"}};
+  EXPECT_EQ("b", firstMatch());
+}
+
+// Random policies over a small set of rules yield the same first match as the PolicyMatchers.
+TEST_F(CompiledPoliciesTest, RandomPoliciesMatchReference) {
+  const std::vector<std::string> permissions = {
+      "{any: true}",
+      "{header: {name: ':method', string_match: {exact: GET}}}",
+      "{header: {name: ':method', string_match: {exact: POST}}}",
+      "{url_path: {path: {prefix: '/api'}}}",
+      "{not_rule: {url_path: {path: {prefix: '/api'}}}}",
+      "{destination_port: 443}",
+      "{and_rules: {rules: [{header: {name: ':method', string_match: {exact: GET}}}, "
+      "{url_path: {path: {exact: '/api/v1'}}}]}}",
+  };
+  const std::vector<std::string> principals = {
+      "{any: true}",
+      "{source_ip: {address_prefix: 10.0.0.0, prefix_len: 8}}",
+      "{source_ip: {address_prefix: 10.1.0.0, prefix_len: 16}}",
+      "{remote_ip: {address_prefix: 192.168.0.0, prefix_len: 16}}",
+      "{direct_remote_ip: {address_prefix: 192.168.1.0, prefix_len: 24}}",
+      "{authenticated: {principal_name: {exact: 'spiffe://a'}}}",
+      "{authenticated: {principal_name: {exact: 'spiffe://b'}}}",
+      "{authenticated: {principal_name: {suffix: '//b'}}}",
+      "{header: {name: ':method', string_match: {exact: GET}}}",
+      "{not_id: {source_ip: {address_prefix: 10.1.0.0, prefix_len: 16}}}",
+      "{or_ids: {ids: [{source_ip: {address_prefix: 10.2.0.0, prefix_len: 16}}, "
+      "{authenticated: {principal_name: {exact: 'spiffe://c'}}}]}}",
+  };
+  const std::vector<std::string> addresses = {"10.1.0.1", "10.2.0.1", "10.3.0.1", "192.168.1.1",
+                                              "192.168.2.1", "172.16.0.1"};
+  const std::vector<std::string> sans = {"spiffe://a", "spiffe://b", "spiffe://c", "spiffe://d"};
+
+  TestRandomGenerator rand;
+  for (int config = 0; config < 20; ++config) {
+    std::string yaml = "policies:\n";
+    for (int policy = 0; policy < 10; ++policy) {
+      absl::StrAppend(&yaml, "  p", rand.random() % 100, "-", policy, ":\n    permissions:\n");
+      for (uint64_t i = 0, n = 1 + rand.random() % 2; i < n; ++i) {
+        absl::StrAppend(&yaml, "    - ", permissions[rand.random() % permissions.size()], "\n");
+      }
+      absl::StrAppend(&yaml, "    principals:\n");
+      for (uint64_t i = 0, n = 1 + rand.random() % 3; i < n; ++i) {
+        absl::StrAppend(&yaml, "    - ", principals[rand.random() % principals.size()], "\n");
+      }
+    }
+    initialize(yaml);
+
+    for (int request = 0; request < 50; ++request) {
+      setSourceAddress(addresses[rand.random() % addresses.size()]);
+      info_.downstream_connection_info_provider_->setRemoteAddress(
+          Network::Utility::parseInternetAddress(addresses[rand.random() % addresses.size()]));
+      info_.downstream_connection_info_provider_->setDirectRemoteAddressForTest(
+          Network::Utility::parseInternetAddress(addresses[rand.random() % addresses.size()]));
+      info_.downstream_connection_info_provider_->setLocalAddress(
+          Network::Utility::parseInternetAddress("127.0.0.1", rand.random() % 2 == 0 ? 80 : 443));
+      if (rand.random() % 2 == 0) {
+        setPeerCertificate({sans[rand.random() % sans.size()]}, {}, "subject");
+      } else {
+        ON_CALL(Const(connection_), ssl()).WillByDefault(Return(nullptr));
+      }
+      headers_ = Http::TestRequestHeaderMapImpl{
+          {":method", rand.random() % 2 == 0 ? "GET" : "POST"},
+          {":path", rand.random() % 2 == 0 ? "/api/v1" : "/index.html"}};
+      firstMatch();
+    }
+  }
+}
+
+} // namespace
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,100 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/rbac/v3/rbac.pb.h"
+
+#include "source/common/common/fmt.h"
+#include "source/common/network/utility.h"
+#include "source/extensions/filters/common/rbac/engine_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/test_runtime.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+namespace {
+
+std::string serviceAccount(int64_t service) {
+  return absl::StrCat("spiffe://cluster.local/ns/default/sa/service-", service);
+}
+
+std::string servicePath(int64_t service) { return absl::StrCat("/service-", service % 16, "/"); }
+
+// One policy per service, as generated by service meshes: the service is identified either by the
+// SAN of its certificate or by its subnet, and may issue GET requests to the path of its backend.
+envoy::config::rbac::v3::RBAC makeRules(int64_t services) {
+  envoy::config::rbac::v3::RBAC rules;
+  rules.set_action(envoy::config::rbac::v3::RBAC::ALLOW);
+  for (int64_t service = 0; service < services; ++service) {
+    envoy::config::rbac::v3::Policy policy;
+    TestUtility::loadFromYaml(
+        fmt::format(R"EOF(
+permissions:
+- and_rules:
+    rules:
+    - header: {{name: ":method", string_match: {{exact: GET}}}}
+    - url_path: {{path: {{prefix: "{}"}}}}
+principals:
+- authenticated: {{principal_name: {{exact: "{}"}}}}
+- source_ip: {{address_prefix: "10.{}.{}.0", prefix_len: 24}}
+)EOF",
+                    servicePath(service), serviceAccount(service), service / 256,
+                    service % 256),
+        policy);
+    (*rules.mutable_policies())[absl::StrCat("service-", service)] = policy;
+  }
+  return rules;
+}
+
+// Evaluates a request of the last service, through the policies as compiled when state.range(0)
+// is 1 or through the PolicyMatcher of each policy otherwise, with state.range(1) policies.
+void bmEngineHandleAction(benchmark::State& state) {
+  const bool compiled = state.range(0) == 1;
+  const int64_t services = state.range(1);
+  TestScopedRuntime scoped_runtime;
+  scoped_runtime.mergeValues(
+      {{"envoy.reloadable_features.rbac_compile_policies", compiled ? "true" : "false"}});
+  const RoleBasedAccessControlEngineImpl engine(makeRules(services),
+                                                ProtobufMessage::getStrictValidationVisitor());
+
+  testing::NiceMock<Network::MockConnection> connection;
+  connection.stream_info_.downstream_connection_info_provider_->setRemoteAddress(
+      Network::Utility::parseInternetAddress(
+          absl::StrCat("10.", (services - 1) / 256, ".", (services - 1) % 256, ".1"), 1234));
+  auto ssl = std::make_shared<testing::NiceMock<Ssl::MockConnectionInfo>>();
+  const std::vector<std::string> uri_sans{serviceAccount(services - 1)};
+  const std::vector<std::string> dns_sans;
+  const std::string subject = "CN=service";
+  ON_CALL(*ssl, uriSanPeerCertificate()).WillByDefault(testing::Return(uri_sans));
+  ON_CALL(*ssl, dnsSansPeerCertificate()).WillByDefault(testing::Return(dns_sans));
+  ON_CALL(*ssl, subjectPeerCertificate()).WillByDefault(testing::ReturnRef(subject));
+  ON_CALL(testing::Const(connection), ssl()).WillByDefault(testing::Return(ssl));
+  const Http::TestRequestHeaderMapImpl headers{
+      {":method", "GET"}, {":path", absl::StrCat(servicePath(services - 1), "index.html")}};
+  testing::NiceMock<StreamInfo::MockStreamInfo> info;
+
+  for (auto _ : state) { // NOLINT
+    if (!engine.handleAction(connection, headers, info, nullptr)) {
+      state.SkipWithError("request denied");
+      break;
+    }
+  }
+}
+BENCHMARK(bmEngineHandleAction)->ArgsProduct({{0, 1}, {10, 100, 1000}});
+
+} // namespace
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -7,9 +7,11 @@
 #include "source/common/common/hash.h"
 #include "source/common/network/socket_impl.h"
 #include "source/common/network/socket_option_impl.h"
+#include "source/common/network/udp_packet_writer_handler_impl.h"
 #include "source/extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
 
 #include "test/mocks/api/mocks.h"
+#include "test/mocks/network/mocks.h"
 #include "test/mocks/network/socket.h"
 #include "test/mocks/server/listener_factory_context.h"
 #include "test/mocks/upstream/cluster_manager.h"
@@ -40,9 +42,18 @@ namespace {
 
 class TestUdpProxyFilter : public UdpProxyFilter {
 public:
-  using UdpProxyFilter::UdpProxyFilter;
+  TestUdpProxyFilter(Network::UdpReadFilterCallbacks& callbacks,
+                     const UdpProxyFilterConfigSharedPtr& config)
+      : UdpProxyFilter(callbacks, config) {
+    ON_CALL(*this, createUdpPacketWriter(_, _))
+        .WillByDefault(Invoke([](Network::IoHandle& io_handle, Stats::Scope&) {
+          return std::make_unique<Network::UdpDefaultWriter>(io_handle);
+        }));
+  }
 
   MOCK_METHOD(Network::SocketPtr, createSocket, (const Upstream::HostConstSharedPtr& host));
+  MOCK_METHOD(Network::UdpPacketWriterPtr, createUdpPacketWriter,
+              (Network::IoHandle & io_handle, Stats::Scope& scope));
 };
 
 Api::IoCallUint64Result makeNoError(uint64_t rc) {
@@ -221,7 +232,7 @@ public:
       factory_context_.cluster_manager_.initializeThreadLocalClusters({"fake_cluster"});
     }
     EXPECT_CALL(factory_context_.cluster_manager_, getThreadLocalCluster("fake_cluster"));
-    filter_ = std::make_unique<TestUdpProxyFilter>(callbacks_, config_);
+    filter_ = std::make_unique<NiceMock<TestUdpProxyFilter>>(callbacks_, config_);
     expect_gro_ = expect_gro;
   }
 
@@ -557,6 +568,180 @@ matcher:
   EXPECT_EQ(output_.front(), "2 1");
 }
 
+// Datagrams written through a batching writer are flushed once per event loop iteration.
+TEST_F(UdpProxyFilterTest, BatchedUpstreamWrites) {
+  setup(readConfig(R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+  )EOF"));
+
+  auto* writer = new NiceMock<Network::MockUdpPacketWriter>();
+  ON_CALL(*writer, isBatchMode()).WillByDefault(Return(true));
+  expectSessionCreate(upstream_address_);
+  EXPECT_CALL(*test_sessions_[0].idle_timer_, enableTimer(_, _)).Times(AtLeast(1));
+  EXPECT_CALL(*filter_, createUdpPacketWriter(_, _))
+      .WillOnce(Return(ByMove(Network::UdpPacketWriterPtr{writer})));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, connect(_))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(*writer, writePacket(_, _, _))
+      .WillOnce(Invoke([&](const Buffer::Instance& buffer, const Network::Address::Ip*,
+                           const Network::Address::Instance& peer_address) {
+        EXPECT_EQ("hello", buffer.toString());
+        EXPECT_EQ(*upstream_address_, peer_address);
+        return makeNoError(0);
+      }));
+  auto* flush_cb = new Event::MockSchedulableCallback(&callbacks_.udp_listener_.dispatcher_);
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+
+  // The second datagram joins the pending batch without scheduling another flush.
+  EXPECT_CALL(*writer, writePacket(_, _, _)).WillOnce(Return(ByMove(makeNoError(0))));
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "world");
+  EXPECT_EQ(
+      2, TestUtility::findCounter(
+             factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_,
+             "udp.sess_tx_datagrams")
+             ->value());
+
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeNoError(10))));
+  flush_cb->invokeCallback();
+
+  // A failed flush counts as a single upstream send error.
+  EXPECT_CALL(*writer, writePacket(_, _, _)).WillOnce(Return(ByMove(makeNoError(0))));
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeError(ENOBUFS))));
+  flush_cb->invokeCallback();
+  EXPECT_EQ(
+      1, TestUtility::findCounter(
+             factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_,
+             "udp.sess_tx_errors")
+             ->value());
+}
+
+// A batch that the socket cannot take stays buffered, and is flushed again once the socket is
+// writable. It is dropped if the session is removed before that.
+TEST_F(UdpProxyFilterTest, BlockedUpstreamFlush) {
+  setup(readConfig(R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+  )EOF"));
+
+  auto* writer = new NiceMock<Network::MockUdpPacketWriter>();
+  ON_CALL(*writer, isBatchMode()).WillByDefault(Return(true));
+  expectSessionCreate(upstream_address_);
+  EXPECT_CALL(*test_sessions_[0].idle_timer_, enableTimer(_, _)).Times(AtLeast(1));
+  EXPECT_CALL(*filter_, createUdpPacketWriter(_, _))
+      .WillOnce(Return(ByMove(Network::UdpPacketWriterPtr{writer})));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, connect(_))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(*writer, writePacket(_, _, _)).WillOnce(Return(ByMove(makeNoError(0))));
+  auto* flush_cb = new Event::MockSchedulableCallback(&callbacks_.udp_listener_.dispatcher_);
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeError(EAGAIN))));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_,
+              enableFileEvents(Event::FileReadyType::Read | Event::FileReadyType::Write));
+  flush_cb->invokeCallback();
+  Stats::CounterSharedPtr tx_errors = TestUtility::findCounter(
+      factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_,
+      "udp.sess_tx_errors");
+  EXPECT_EQ(0, tx_errors->value());
+
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_,
+              enableFileEvents(Event::FileReadyType::Read));
+  EXPECT_CALL(*writer, setWritable());
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeNoError(5))));
+  test_sessions_[0].file_event_cb_(Event::FileReadyType::Write);
+  EXPECT_EQ(0, tx_errors->value());
+
+  // Block again, and remove the session before the socket is writable.
+  EXPECT_CALL(*writer, writePacket(_, _, _)).WillOnce(Return(ByMove(makeNoError(0))));
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeError(EAGAIN))));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_,
+              enableFileEvents(Event::FileReadyType::Read | Event::FileReadyType::Write));
+  flush_cb->invokeCallback();
+
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeError(EAGAIN))));
+  test_sessions_[0].idle_timer_->invokeCallback();
+  EXPECT_EQ(0, config_->stats().downstream_sess_active_.value());
+  EXPECT_EQ(1, tx_errors->value());
+}
+
+// A session that is removed with buffered datagrams flushes them first.
+TEST_F(UdpProxyFilterTest, BatchedUpstreamWritesFlushedOnSessionRemoval) {
+  setup(readConfig(R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+  )EOF"));
+
+  auto* writer = new NiceMock<Network::MockUdpPacketWriter>();
+  ON_CALL(*writer, isBatchMode()).WillByDefault(Return(true));
+  expectSessionCreate(upstream_address_);
+  EXPECT_CALL(*test_sessions_[0].idle_timer_, enableTimer(_, _)).Times(AtLeast(1));
+  EXPECT_CALL(*filter_, createUdpPacketWriter(_, _))
+      .WillOnce(Return(ByMove(Network::UdpPacketWriterPtr{writer})));
+  EXPECT_CALL(*test_sessions_[0].socket_->io_handle_, connect(_))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(*writer, writePacket(_, _, _)).WillOnce(Return(ByMove(makeNoError(0))));
+  auto* flush_cb = new Event::MockSchedulableCallback(&callbacks_.udp_listener_.dispatcher_);
+  EXPECT_CALL(*flush_cb, scheduleCallbackCurrentIteration());
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+
+  EXPECT_CALL(*writer, flush()).WillOnce(Return(ByMove(makeNoError(5))));
+  test_sessions_[0].idle_timer_->invokeCallback();
+  EXPECT_EQ(0, config_->stats().downstream_sess_active_.value());
+
+  // The session and its writer are gone, so there is nothing left to flush.
+  flush_cb->invokeCallback();
+}
+
+// UDP_GRO is enabled on upstream sockets when GRO is preferred.
+TEST_F(UdpProxyFilterTest, UpstreamSocketGroOption) {
+  if (!ENVOY_SOCKET_UDP_GRO.hasValue()) {
+    return;
+  }
+
+  setup(readConfig(R"EOF(
+stat_prefix: foo
+matcher:
+  on_no_match:
+    action:
+      name: route
+      typed_config:
+        '@type': type.googleapis.com/envoy.extensions.filters.udp.udp_proxy.v3.Route
+        cluster: fake_cluster
+  )EOF"));
+
+  expectSessionCreate(upstream_address_);
+  test_sessions_[0].expectSetIpTransparentSocketOption();
+  test_sessions_[0].expectWriteToUpstream("hello", 0, nullptr, true);
+  recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
+  EXPECT_EQ(1, test_sessions_[0]
+                   .sock_opts_[ENVOY_SOCKET_UDP_GRO.level()][ENVOY_SOCKET_UDP_GRO.option()]);
+}
+
 // Verify downstream send and receive error handling.
 TEST_F(UdpProxyFilterTest, SendReceiveErrorHandling) {
   InSequence s;
@@ -748,28 +933,45 @@ matcher:
   // Add a cluster that we don't care about.
   NiceMock<Upstream::MockThreadLocalCluster> other_thread_local_cluster;
   other_thread_local_cluster.cluster_.info_->name_ = "other_cluster";
-  cluster_update_callbacks_->onClusterAddOrUpdate(other_thread_local_cluster);
+  cluster_update_callbacks_->onClusterAddOrUpdate(
+      other_thread_local_cluster.info()->name(),
+      [&]() -> Upstream::ThreadLocalCluster& { return other_thread_local_cluster; });
   recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
   EXPECT_EQ(2, config_->stats().downstream_sess_no_route_.value());
   EXPECT_EQ(0, config_->stats().downstream_sess_total_.value());
   EXPECT_EQ(0, config_->stats().downstream_sess_active_.value());
+  EXPECT_FALSE(cluster_update_callbacks_->tracksCluster("other_cluster"));
 
   // Now add the cluster we care about.
   cluster_update_callbacks_->onClusterAddOrUpdate(
-      factory_context_.cluster_manager_.thread_local_cluster_);
+      factory_context_.cluster_manager_.thread_local_cluster_.info()->name(),
+      [&]() -> Upstream::ThreadLocalCluster& {
+        return factory_context_.cluster_manager_.thread_local_cluster_;
+      });
   expectSessionCreate(upstream_address_);
   test_sessions_[0].expectWriteToUpstream("hello", 0, nullptr, true);
   recvDataFromDownstream("10.0.0.1:1000", "10.0.0.2:80", "hello");
   EXPECT_EQ(1, config_->stats().downstream_sess_total_.value());
   EXPECT_EQ(1, config_->stats().downstream_sess_active_.value());
+  EXPECT_TRUE(cluster_update_callbacks_->tracksCluster("fake_cluster"));
 
   // Remove a cluster we don't care about.
   cluster_update_callbacks_->onClusterRemoval("other_cluster");
   EXPECT_EQ(1, config_->stats().downstream_sess_active_.value());
 
-  // Remove the cluster we do care about. This should purge all sessions.
-  cluster_update_callbacks_->onClusterRemoval("fake_cluster");
+  // Update the cluster we do care about. The new cluster replaces the old one, which purges all
+  // its sessions.
+  NiceMock<Upstream::MockThreadLocalCluster> updated_thread_local_cluster;
+  updated_thread_local_cluster.cluster_.info_->name_ = "fake_cluster";
+  cluster_update_callbacks_->onClusterAddOrUpdate(
+      "fake_cluster",
+      [&]() -> Upstream::ThreadLocalCluster& { return updated_thread_local_cluster; });
   EXPECT_EQ(0, config_->stats().downstream_sess_active_.value());
+  EXPECT_TRUE(cluster_update_callbacks_->tracksCluster("fake_cluster"));
+
+  // Remove the cluster we do care about.
+  cluster_update_callbacks_->onClusterRemoval("fake_cluster");
+  EXPECT_FALSE(cluster_update_callbacks_->tracksCluster("fake_cluster"));
 }
 
 // Hitting the maximum per-cluster connection/session circuit breaker.
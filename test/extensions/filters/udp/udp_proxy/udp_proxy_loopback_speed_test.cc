@@ -0,0 +1,176 @@
+// Compares the upstream datagram paths of a UDP proxy session over loopback. upstreamWrite sends
+// bursts of datagrams one sendmsg() at a time or batched through the GSO writer. upstreamRead
+// drains the bursts the way sessions used to (one recvmsg() per datagram), with recvmmsg(), and
+// with UDP_GRO enabled on the socket.
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/utility.h"
+#include "source/common/network/address_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/common/network/socket_option_impl.h"
+#include "source/common/network/udp_packet_writer_handler_impl.h"
+#include "source/common/network/utility.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#ifdef ENVOY_ENABLE_QUIC
+#include "source/common/quic/udp_gso_batch_writer.h"
+#endif
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+namespace {
+
+// Datagrams per burst, the number of datagrams read by one recvmmsg() call.
+constexpr uint32_t BurstSize = Network::NUM_DATAGRAMS_PER_RECEIVE;
+
+class DatagramCounter : public Network::UdpPacketProcessor {
+public:
+  explicit DatagramCounter(uint64_t max_datagram_size) : max_datagram_size_(max_datagram_size) {}
+
+  // Network::UdpPacketProcessor
+  void processPacket(Network::Address::InstanceConstSharedPtr,
+                     Network::Address::InstanceConstSharedPtr, Buffer::InstancePtr,
+                     MonotonicTime) override {
+    ++received_;
+  }
+  uint64_t maxDatagramSize() const override { return max_datagram_size_; }
+  void onDatagramsDropped(uint32_t) override {}
+  size_t numPacketsExpectedPerEventLoop() const override {
+    return Network::MAX_NUM_PACKETS_PER_EVENT_LOOP;
+  }
+
+  uint64_t received_{};
+
+private:
+  const uint64_t max_datagram_size_;
+};
+
+// A connected pair of UDP sockets on 127.0.0.1, standing in for a session socket and its host.
+class LoopbackSockets {
+public:
+  LoopbackSockets() {
+    Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+    receiver_ = std::make_unique<Network::IoSocketHandleImpl>(
+        os_sys_calls.socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0).return_value_);
+    RELEASE_ASSERT(
+        receiver_->bind(std::make_shared<Network::Address::Ipv4Instance>("127.0.0.1", 0))
+                .return_value_ == 0,
+        "");
+    receiver_address_ = receiver_->localAddress();
+
+    sender_ = std::make_unique<Network::IoSocketHandleImpl>(
+        os_sys_calls.socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0).return_value_);
+    RELEASE_ASSERT(sender_->connect(receiver_address_).return_value_ == 0, "");
+  }
+
+  bool enableGro() {
+    const int on = 1;
+    return ENVOY_SOCKET_UDP_GRO.hasValue() &&
+           receiver_
+                   ->setOption(ENVOY_SOCKET_UDP_GRO.level(), ENVOY_SOCKET_UDP_GRO.option(), &on,
+                               sizeof(on))
+                   .return_value_ == 0;
+  }
+
+  // Reads from the receiver until `expected` more datagrams have been counted.
+  void drain(DatagramCounter& counter, bool prefer_gro, uint64_t expected) {
+    const uint64_t target = counter.received_ + expected;
+    uint32_t packets_dropped = 0;
+    while (counter.received_ < target) {
+      Network::Utility::readPacketsFromSocket(*receiver_, *receiver_address_, counter,
+                                              time_source_, prefer_gro, packets_dropped);
+    }
+  }
+
+  RealTimeSource time_source_;
+  Network::IoHandlePtr receiver_;
+  Network::Address::InstanceConstSharedPtr receiver_address_;
+  Network::IoHandlePtr sender_;
+};
+
+// Args: datagram size, batched through the GSO writer.
+void upstreamWrite(benchmark::State& state) {
+  const uint64_t datagram_size = state.range(0);
+  LoopbackSockets sockets;
+  Stats::IsolatedStoreImpl store;
+  Network::UdpPacketWriterPtr writer;
+  if (state.range(1) == 0) {
+    writer = std::make_unique<Network::UdpDefaultWriter>(*sockets.sender_);
+  } else {
+#ifdef ENVOY_ENABLE_QUIC
+#if UDP_GSO_BATCH_WRITER_COMPILETIME_SUPPORT
+    if (Api::OsSysCallsSingleton::get().supportsUdpGso()) {
+      writer = std::make_unique<Quic::UdpGsoBatchWriter>(*sockets.sender_, *store.rootScope());
+    }
+#endif
+#endif
+    if (writer == nullptr) {
+      state.SkipWithError("UDP GSO is not supported");
+      return;
+    }
+  }
+
+  Buffer::OwnedImpl datagram(std::string(datagram_size, 'a'));
+  DatagramCounter counter(datagram_size);
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    for (uint32_t i = 0; i < BurstSize; ++i) {
+      RELEASE_ASSERT(writer->writePacket(datagram, nullptr, *sockets.receiver_address_).ok(), "");
+    }
+    RELEASE_ASSERT(writer->flush().ok(), "");
+    sockets.drain(counter, false, BurstSize);
+  }
+  state.SetItemsProcessed(state.iterations() * BurstSize);
+}
+BENCHMARK(upstreamWrite)
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({512, 0})
+    ->Args({512, 1})
+    ->Args({1200, 0})
+    ->Args({1200, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+// Args: datagram size, read mode. Mode 0 prefers GRO without UDP_GRO set on the socket, so every
+// recvmsg() returns a single datagram. Mode 1 reads with recvmmsg(). Mode 2 sets UDP_GRO.
+void upstreamRead(benchmark::State& state) {
+  const uint64_t datagram_size = state.range(0);
+  const int64_t mode = state.range(1);
+  LoopbackSockets sockets;
+  if (mode == 2 && !sockets.enableGro()) {
+    state.SkipWithError("UDP GRO is not supported");
+    return;
+  }
+
+  Network::UdpDefaultWriter writer(*sockets.sender_);
+  Buffer::OwnedImpl datagram(std::string(datagram_size, 'a'));
+  DatagramCounter counter(datagram_size);
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    for (uint32_t i = 0; i < BurstSize; ++i) {
+      RELEASE_ASSERT(writer.writePacket(datagram, nullptr, *sockets.receiver_address_).ok(), "");
+    }
+    sockets.drain(counter, mode != 1, BurstSize);
+  }
+  state.SetItemsProcessed(state.iterations() * BurstSize);
+}
+BENCHMARK(upstreamRead)
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({64, 2})
+    ->Args({1200, 0})
+    ->Args({1200, 1})
+    ->Args({1200, 2})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
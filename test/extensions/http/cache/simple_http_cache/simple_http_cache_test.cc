@@ -6,6 +6,7 @@
 #include "source/extensions/filters/http/cache/cache_headers_utils.h"
 #include "source/extensions/http/cache/simple_http_cache/simple_http_cache.h"
 
+#include "test/common/stats/stat_test_utility.h"
 #include "test/extensions/filters/http/cache/common.h"
 #include "test/extensions/filters/http/cache/http_cache_implementation_test_common.h"
 #include "test/mocks/server/factory_context.h"
@@ -26,7 +27,9 @@ public:
   bool validationEnabled() const override { return true; }
 
 private:
-  std::shared_ptr<SimpleHttpCache> cache_ = std::make_shared<SimpleHttpCache>();
+  Stats::TestUtil::TestStore stats_store_;
+  std::shared_ptr<SimpleHttpCache> cache_ =
+      std::make_shared<SimpleHttpCache>(SimpleHttpCacheConfig(), *stats_store_.rootScope());
 };
 
 INSTANTIATE_TEST_SUITE_P(SimpleHttpCacheTest, HttpCacheImplementationTest,
@@ -35,6 +38,116 @@ INSTANTIATE_TEST_SUITE_P(SimpleHttpCacheTest, HttpCacheImplementationTest,
                            return "SimpleHttpCache";
                          });
 
+class SimpleHttpCacheEvictionTest : public testing::Test {
+public:
+  SimpleHttpCacheEvictionTest()
+      : vary_allow_list_(envoy::extensions::filters::http::cache::v3::CacheConfig()
+                             .allowed_vary_headers()) {
+    request_headers_.setMethod("GET");
+    request_headers_.setHost("example.com");
+    request_headers_.setScheme("https");
+  }
+
+  void initialize(uint32_t shards, uint64_t max_cache_size_bytes) {
+    SimpleHttpCacheConfig config;
+    config.mutable_shards()->set_value(shards);
+    config.mutable_max_cache_size_bytes()->set_value(max_cache_size_bytes);
+    cache_ = std::make_unique<SimpleHttpCache>(config, *stats_store_.rootScope());
+  }
+
+  LookupRequest makeLookupRequest(absl::string_view path) {
+    request_headers_.setPath(path);
+    return {request_headers_, time_system_.systemTime(), vary_allow_list_};
+  }
+
+  bool insert(absl::string_view path, absl::string_view body) {
+    return cache_->insert(makeLookupRequest(path).key(),
+                          Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers_),
+                          {time_system_.systemTime()}, std::string(body), nullptr);
+  }
+
+  bool cached(absl::string_view path) {
+    return cache_->lookup(makeLookupRequest(path)).response_headers_ != nullptr;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter(absl::StrCat("simple_http_cache.", name)).value();
+  }
+
+  uint64_t gauge(const std::string& name) {
+    return stats_store_
+        .gauge(absl::StrCat("simple_http_cache.", name), Stats::Gauge::ImportMode::NeverImport)
+        .value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::TestUtil::TestStore stats_store_;
+  VaryAllowList vary_allow_list_;
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Http::TestResponseHeaderMapImpl response_headers_{{":status", "200"},
+                                                    {"cache-control", "public,max-age=3600"}};
+  std::unique_ptr<SimpleHttpCache> cache_;
+};
+
+TEST_F(SimpleHttpCacheEvictionTest, EvictsLeastRecentlyUsed) {
+  const std::string body(1000, 'a');
+  // Room for two entries in the single shard.
+  initialize(1, 2500);
+
+  EXPECT_TRUE(insert("/a", body));
+  EXPECT_TRUE(insert("/b", body));
+  EXPECT_EQ(2, gauge("size_count"));
+  // Make /a the most recently used entry.
+  EXPECT_TRUE(cached("/a"));
+
+  EXPECT_TRUE(insert("/c", body));
+  EXPECT_TRUE(cached("/a"));
+  EXPECT_FALSE(cached("/b"));
+  EXPECT_TRUE(cached("/c"));
+
+  EXPECT_EQ(3, counter("insert"));
+  EXPECT_EQ(1, counter("eviction"));
+  EXPECT_EQ(3, counter("lookup_hit"));
+  EXPECT_EQ(1, counter("lookup_miss"));
+  EXPECT_EQ(2, gauge("size_count"));
+  EXPECT_LE(gauge("size_bytes"), 2500);
+  EXPECT_GT(gauge("size_bytes"), 2000);
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, ReplaceKeepsAccounting) {
+  initialize(1, 10000);
+
+  EXPECT_TRUE(insert("/a", std::string(1000, 'a')));
+  const uint64_t size_bytes = gauge("size_bytes");
+  EXPECT_TRUE(insert("/a", std::string(2000, 'a')));
+  EXPECT_EQ(1, gauge("size_count"));
+  EXPECT_EQ(size_bytes + 1000, gauge("size_bytes"));
+  EXPECT_EQ(0, counter("eviction"));
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, RejectsEntriesLargerThanShard) {
+  // Each of the 4 shards gets 1000 bytes.
+  initialize(4, 4000);
+
+  EXPECT_FALSE(insert("/a", std::string(2000, 'a')));
+  EXPECT_FALSE(cached("/a"));
+  EXPECT_EQ(1, counter("insert_rejected"));
+  EXPECT_EQ(0, gauge("size_count"));
+}
+
+TEST_F(SimpleHttpCacheEvictionTest, ShardsStayWithinBudget) {
+  const std::string body(100, 'a');
+  initialize(8, 8 * 1000);
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(insert(absl::StrCat("/", i), body));
+  }
+  EXPECT_LE(gauge("size_bytes"), 8 * 1000);
+  EXPECT_EQ(1000 - gauge("size_count"), counter("eviction"));
+  // The most recent insert is always kept.
+  EXPECT_TRUE(cached("/999"));
+}
+
 TEST(Registration, GetFactory) {
   HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
       "envoy.extensions.http.cache.simple_http_cache.v3.SimpleHttpCacheConfig");
@@ -46,6 +159,25 @@ TEST(Registration, GetFactory) {
             "envoy.extensions.http.cache.simple");
 }
 
+TEST(Registration, MismatchedConfig) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.http.cache.simple_http_cache.v3.SimpleHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  testing::NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  SimpleHttpCacheConfig simple_config;
+  config.mutable_typed_config()->PackFrom(simple_config);
+  std::shared_ptr<HttpCache> cache = factory->getCache(config, factory_context);
+
+  // The same configuration shares the cache.
+  EXPECT_EQ(cache, factory->getCache(config, factory_context));
+
+  simple_config.mutable_shards()->set_value(2);
+  config.mutable_typed_config()->PackFrom(simple_config);
+  EXPECT_THROW_WITH_REGEX(factory->getCache(config, factory_context), EnvoyException,
+                          "mismatched SimpleHttpCacheConfig");
+}
+
 } // namespace
 } // namespace Cache
 } // namespace HttpFilters
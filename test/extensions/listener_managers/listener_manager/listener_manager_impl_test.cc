@@ -19,6 +19,7 @@
 #include "source/common/config/metadata.h"
 #include "source/common/init/manager_impl.h"
 #include "source/common/network/address_impl.h"
+#include "source/common/network/connection_balancer_impl.h"
 #include "source/common/network/io_socket_handle_impl.h"
 #include "source/common/network/socket_interface_impl.h"
 #include "source/common/network/utility.h"
@@ -990,6 +991,9 @@ TEST_P(ListenerManagerImplTest, RejectTcpOptionsWithInternalListenerConfig) {
       [](envoy::config::listener::v3::Listener& l) {
         l.mutable_connection_balance_config()->mutable_exact_balance();
       },
+      [](envoy::config::listener::v3::Listener& l) {
+        l.mutable_connection_balance_config()->mutable_least_loaded_balance();
+      },
       [](envoy::config::listener::v3::Listener& l) { l.mutable_enable_reuse_port(); },
       [](envoy::config::listener::v3::Listener& l) { l.mutable_freebind()->set_value(true); },
       [](envoy::config::listener::v3::Listener& l) { l.mutable_tcp_backlog_size(); },
@@ -7915,6 +7919,25 @@ TEST_P(ListenerManagerImplWithRealFiltersTest, InvalidExtendConnectionBalanceCon
 #endif
 }
 
+TEST_P(ListenerManagerImplWithRealFiltersTest, LeastLoadedConnectionBalanceConfig) {
+// Envoy always use ExactBalance at WIN32, so ignore it.
+#ifndef WIN32
+  auto listener = createIPv4Listener("TCPListener");
+  listener.mutable_connection_balance_config()->mutable_least_loaded_balance()->set_max_imbalance(
+      2);
+
+  auto listener_impl = ListenerImpl(listener, "version", *manager_, "foo", true, false,
+                                    /*hash=*/static_cast<uint64_t>(0));
+  auto socket_factory = std::make_unique<Network::MockListenSocketFactory>();
+  Network::Address::InstanceConstSharedPtr address(
+      new Network::Address::Ipv4Instance("192.168.0.1", 80, nullptr));
+  EXPECT_CALL(*socket_factory, localAddress()).WillOnce(ReturnRef(address));
+  listener_impl.addSocketFactory(std::move(socket_factory));
+  EXPECT_NE(nullptr, dynamic_cast<Network::LeastLoadedConnectionBalancerImpl*>(
+                         &listener_impl.connectionBalancer(*address)));
+#endif
+}
+
 TEST_P(ListenerManagerImplWithRealFiltersTest, EmptyConnectionBalanceConfig) {
 // Envoy always use ExactBalance at WIN32, so ignore it.
 #ifndef WIN32
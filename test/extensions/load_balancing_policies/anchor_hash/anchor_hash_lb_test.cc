@@ -0,0 +1,341 @@
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/load_balancing_policies/anchor_hash/v3/anchor_hash.pb.h"
+
+#include "source/common/common/hash.h"
+#include "source/extensions/load_balancing_policies/anchor_hash/anchor_hash_lb.h"
+#include "source/extensions/load_balancing_policies/anchor_hash/config.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/mocks/upstream/host_set.h"
+#include "test/mocks/upstream/load_balancer_context.h"
+#include "test/mocks/upstream/priority_set.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace AnchorHash {
+namespace {
+
+class TestLoadBalancerContext : public Upstream::LoadBalancerContextBase {
+public:
+  using HostPredicate = std::function<bool(const Upstream::Host&)>;
+
+  TestLoadBalancerContext(uint64_t hash_key)
+      : TestLoadBalancerContext(hash_key, 0, [](const Upstream::Host&) { return false; }) {}
+  TestLoadBalancerContext(uint64_t hash_key, uint32_t retry_count,
+                          HostPredicate should_select_another_host)
+      : hash_key_(hash_key), retry_count_(retry_count),
+        should_select_another_host_(should_select_another_host) {}
+
+  // Upstream::LoadBalancerContext
+  absl::optional<uint64_t> computeHashKey() override { return hash_key_; }
+  uint32_t hostSelectionRetryCount() const override { return retry_count_; };
+  bool shouldSelectAnotherHost(const Upstream::Host& host) override {
+    return should_select_another_host_(host);
+  }
+
+  absl::optional<uint64_t> hash_key_;
+  uint32_t retry_count_;
+  HostPredicate should_select_another_host_;
+};
+
+// Note: ThreadAwareLoadBalancer base is heavily tested by RingHashLoadBalancerTest. Only the
+//       table and its updates are covered here.
+class AnchorHashLoadBalancerTest : public Event::TestUsingSimulatedTime, public testing::Test {
+public:
+  AnchorHashLoadBalancerTest()
+      : stat_names_(stats_store_.symbolTable()), stats_(stat_names_, stats_store_) {}
+
+  void init(uint32_t min_capacity = 0, uint32_t hash_balance_factor = 0) {
+    lb_ = std::make_unique<AnchorHashLoadBalancer>(priority_set_, stats_, stats_store_, runtime_,
+                                                   random_, min_capacity, false,
+                                                   hash_balance_factor, common_config_);
+    lb_->initialize();
+  }
+
+  Upstream::HostSharedPtr makeHost(uint32_t port) {
+    return Upstream::makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", port), simTime());
+  }
+
+  void setHosts(Upstream::HostVector hosts) {
+    host_set_.hosts_ = std::move(hosts);
+    host_set_.healthy_hosts_ = host_set_.hosts_;
+    host_set_.runCallbacks({}, {});
+  }
+
+  // The address of the host chosen for each of the first num_keys hash keys.
+  std::vector<std::string> chooseHosts(uint32_t num_keys) {
+    Upstream::LoadBalancerPtr lb = lb_->factory()->create();
+    std::vector<std::string> addresses;
+    addresses.reserve(num_keys);
+    for (uint32_t i = 0; i < num_keys; ++i) {
+      TestLoadBalancerContext context(HashUtil::xxHash64(absl::StrCat(i)));
+      addresses.push_back(lb->chooseHost(&context)->address()->asString());
+    }
+    return addresses;
+  }
+
+  NiceMock<Upstream::MockPrioritySet> priority_set_;
+  Upstream::MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<Upstream::MockClusterInfo> info_{new NiceMock<Upstream::MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  Upstream::ClusterLbStatNames stat_names_;
+  Upstream::ClusterLbStats stats_;
+  envoy::config::cluster::v3::Cluster::CommonLbConfig common_config_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  std::unique_ptr<AnchorHashLoadBalancer> lb_;
+};
+
+// Works correctly without any hosts.
+TEST_F(AnchorHashLoadBalancerTest, NoHost) {
+  init();
+  EXPECT_EQ(nullptr, lb_->factory()->create()->chooseHost(nullptr));
+  TestLoadBalancerContext context(1);
+  EXPECT_EQ(nullptr, lb_->factory()->create()->chooseHost(&context));
+}
+
+// Every host gets about the same share of the keys, and a key always maps to the same host.
+TEST_F(AnchorHashLoadBalancerTest, Basic) {
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  init();
+
+  EXPECT_EQ("anchor_hash_lb.capacity", lb_->stats().capacity_.name());
+  EXPECT_EQ(8, lb_->stats().capacity_.value());
+  EXPECT_EQ(1, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(0, lb_->stats().table_updated_.value());
+
+  const std::vector<std::string> addresses = chooseHosts(10000);
+  absl::flat_hash_map<std::string, uint32_t> counts;
+  for (const std::string& address : addresses) {
+    counts[address]++;
+  }
+  EXPECT_EQ(4, counts.size());
+  for (const auto& [address, count] : counts) {
+    EXPECT_NEAR(2500, count, 250) << address;
+  }
+  EXPECT_EQ(addresses, chooseHosts(10000));
+}
+
+// A table built from scratch doesn't depend on the order of the hosts.
+TEST_F(AnchorHashLoadBalancerTest, IndependentOfHostOrder) {
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  init();
+  const std::vector<std::string> addresses = chooseHosts(1000);
+
+  setHosts({makeHost(93), makeHost(91), makeHost(90), makeHost(92)});
+  init();
+  EXPECT_EQ(addresses, chooseHosts(1000));
+}
+
+// Only the keys of a removed host move, and they spread over the other hosts.
+TEST_F(AnchorHashLoadBalancerTest, RemoveHost) {
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  init();
+  const std::vector<std::string> before = chooseHosts(10000);
+
+  setHosts({host_set_.hosts_[0], host_set_.hosts_[2], host_set_.hosts_[3]});
+  EXPECT_EQ(1, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(1, lb_->stats().table_updated_.value());
+  EXPECT_EQ(8, lb_->stats().capacity_.value());
+
+  const std::vector<std::string> after = chooseHosts(10000);
+  absl::flat_hash_map<std::string, uint32_t> moved_to;
+  for (uint32_t i = 0; i < before.size(); ++i) {
+    if (before[i] != "127.0.0.1:91") {
+      EXPECT_EQ(before[i], after[i]);
+    } else {
+      moved_to[after[i]]++;
+    }
+  }
+  EXPECT_EQ(3, moved_to.size());
+}
+
+// A host added after a removal takes over exactly the keys of the removed host, and adding the
+// removed host back restores the original table.
+TEST_F(AnchorHashLoadBalancerTest, ReplaceHost) {
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  init();
+  const Upstream::HostVector original_hosts = host_set_.hosts_;
+  const std::vector<std::string> before = chooseHosts(10000);
+
+  setHosts({original_hosts[0], makeHost(94), original_hosts[2], original_hosts[3]});
+  const std::vector<std::string> replaced = chooseHosts(10000);
+  for (uint32_t i = 0; i < before.size(); ++i) {
+    EXPECT_EQ(before[i] == "127.0.0.1:91" ? "127.0.0.1:94" : before[i], replaced[i]);
+  }
+
+  setHosts(original_hosts);
+  EXPECT_EQ(before, chooseHosts(10000));
+  EXPECT_EQ(1, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(2, lb_->stats().table_updated_.value());
+}
+
+// Keys only move to an added host.
+TEST_F(AnchorHashLoadBalancerTest, AddHost) {
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  init();
+  const std::vector<std::string> before = chooseHosts(10000);
+
+  Upstream::HostVector hosts = host_set_.hosts_;
+  hosts.push_back(makeHost(94));
+  setHosts(hosts);
+  EXPECT_EQ(1, lb_->stats().table_updated_.value());
+
+  const std::vector<std::string> after = chooseHosts(10000);
+  uint32_t moved = 0;
+  for (uint32_t i = 0; i < before.size(); ++i) {
+    if (before[i] != after[i]) {
+      EXPECT_EQ("127.0.0.1:94", after[i]);
+      moved++;
+    }
+  }
+  EXPECT_NEAR(2000, moved, 250);
+}
+
+// A host that is a new object with the key of a previous host keeps its keys, and is the host
+// returned for them.
+TEST_F(AnchorHashLoadBalancerTest, RecreatedHost) {
+  setHosts({makeHost(90), makeHost(91)});
+  init();
+  const std::vector<std::string> before = chooseHosts(1000);
+
+  const Upstream::HostSharedPtr recreated = makeHost(91);
+  setHosts({host_set_.hosts_[0], recreated});
+  EXPECT_EQ(before, chooseHosts(1000));
+
+  Upstream::LoadBalancerPtr lb = lb_->factory()->create();
+  for (uint32_t i = 0; i < before.size(); ++i) {
+    if (before[i] == "127.0.0.1:91") {
+      TestLoadBalancerContext context(HashUtil::xxHash64(absl::StrCat(i)));
+      EXPECT_EQ(recreated, lb->chooseHost(&context));
+      break;
+    }
+  }
+}
+
+// The table is rebuilt with twice as many buckets as hosts once the hosts don't fit.
+TEST_F(AnchorHashLoadBalancerTest, GrowBeyondCapacity) {
+  setHosts({makeHost(90), makeHost(91)});
+  init();
+  EXPECT_EQ(4, lb_->stats().capacity_.value());
+
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93)});
+  EXPECT_EQ(1, lb_->stats().table_updated_.value());
+  EXPECT_EQ(4, lb_->stats().capacity_.value());
+
+  setHosts({makeHost(90), makeHost(91), makeHost(92), makeHost(93), makeHost(94)});
+  EXPECT_EQ(2, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(10, lb_->stats().capacity_.value());
+  const std::vector<std::string> addresses = chooseHosts(1000);
+
+  // The rebuilt table is the one built from scratch for the same hosts.
+  init();
+  EXPECT_EQ(addresses, chooseHosts(1000));
+}
+
+// The configured capacity is used when it is larger than twice the number of hosts.
+TEST_F(AnchorHashLoadBalancerTest, MinCapacity) {
+  setHosts({makeHost(90), makeHost(91)});
+  init(100);
+  EXPECT_EQ(100, lb_->stats().capacity_.value());
+
+  Upstream::HostVector hosts;
+  for (uint32_t i = 0; i < 50; ++i) {
+    hosts.push_back(makeHost(90 + i));
+  }
+  setHosts(hosts);
+  EXPECT_EQ(1, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(1, lb_->stats().table_updated_.value());
+}
+
+// Replacing all the hosts or removing all of them rebuilds the table.
+TEST_F(AnchorHashLoadBalancerTest, RemoveAllHosts) {
+  setHosts({makeHost(90), makeHost(91)});
+  init();
+
+  setHosts({makeHost(92), makeHost(93)});
+  EXPECT_EQ(2, lb_->stats().table_rebuilt_.value());
+
+  setHosts({});
+  EXPECT_EQ(0, lb_->stats().capacity_.value());
+  TestLoadBalancerContext context(1);
+  EXPECT_EQ(nullptr, lb_->factory()->create()->chooseHost(&context));
+
+  setHosts({makeHost(90)});
+  EXPECT_EQ(3, lb_->stats().table_rebuilt_.value());
+  EXPECT_EQ(0, lb_->stats().table_updated_.value());
+  EXPECT_EQ(host_set_.hosts_[0], lb_->factory()->create()->chooseHost(&context));
+}
+
+// Retries with a host predicate pick another host.
+TEST_F(AnchorHashLoadBalancerTest, HostPredicate) {
+  setHosts({makeHost(90), makeHost(91)});
+  init();
+
+  Upstream::LoadBalancerPtr lb = lb_->factory()->create();
+  for (uint32_t i = 0; i < 10; ++i) {
+    TestLoadBalancerContext context(i);
+    const Upstream::HostConstSharedPtr host = lb->chooseHost(&context);
+    TestLoadBalancerContext retry_context(i, 100, [&host](const Upstream::Host& candidate) {
+      return &candidate == host.get();
+    });
+    EXPECT_NE(host, lb->chooseHost(&retry_context));
+  }
+}
+
+// With a hash balance factor, an overloaded host is replaced by another host.
+TEST_F(AnchorHashLoadBalancerTest, HashBalanceFactor) {
+  setHosts({makeHost(90), makeHost(91)});
+  init(0, 150);
+
+  Upstream::LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext context(1);
+  const Upstream::HostConstSharedPtr host = lb->chooseHost(&context);
+  host->stats().rq_active_.set(10);
+  EXPECT_NE(host, lb->chooseHost(&context));
+}
+
+TEST(AnchorHashLbFactoryTest, CreatesLoadBalancer) {
+  auto& factory = Config::Utility::getAndCheckFactoryByName<Upstream::TypedLoadBalancerFactory>(
+      "envoy.load_balancing_policies.anchor_hash");
+
+  NiceMock<Upstream::MockClusterInfo> cluster_info;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  dynamic_cast<envoy::extensions::load_balancing_policies::anchor_hash::v3::AnchorHash&>(*config)
+      .mutable_capacity()
+      ->set_value(16);
+  ON_CALL(cluster_info, loadBalancingPolicy()).WillByDefault(ReturnRef(config));
+  NiceMock<Upstream::MockPrioritySet> priority_set;
+  priority_set.getMockHostSet(0);
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Random::MockRandomGenerator> random;
+  Event::SimulatedTimeSystem time_system;
+
+  Upstream::ThreadAwareLoadBalancerPtr thread_aware_lb =
+      factory.create(cluster_info, priority_set, runtime, random, time_system);
+  thread_aware_lb->initialize();
+  EXPECT_EQ(nullptr, thread_aware_lb->factory()->create()->chooseHost(nullptr));
+}
+
+} // namespace
+} // namespace AnchorHash
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,211 @@
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "envoy/extensions/load_balancing_policies/peak_ewma/v3/peak_ewma.pb.h"
+
+#include "source/extensions/load_balancing_policies/peak_ewma/config.h"
+#include "source/extensions/load_balancing_policies/peak_ewma/peak_ewma_lb.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/cluster_info.h"
+#include "test/mocks/upstream/host_set.h"
+#include "test/mocks/upstream/priority_set.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace LoadBalancingPolicies {
+namespace PeakEwma {
+namespace {
+
+class PeakEwmaLoadBalancerTest : public Event::TestUsingSimulatedTime, public testing::Test {
+public:
+  PeakEwmaLoadBalancerTest()
+      : stat_names_(stats_store_.symbolTable()), stats_(stat_names_, stats_store_) {}
+
+  void init() {
+    lb_ = std::make_unique<PeakEwmaLoadBalancer>(
+        priority_set_, nullptr, stats_, runtime_, random_, common_config_,
+        std::chrono::seconds(10), std::chrono::milliseconds(10), std::chrono::seconds(1),
+        simTime());
+  }
+
+  void initHosts(uint32_t num_hosts) {
+    for (uint32_t i = 0; i < num_hosts; ++i) {
+      host_set_.hosts_.push_back(
+          Upstream::makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 80 + i), simTime()));
+    }
+    host_set_.healthy_hosts_ = host_set_.hosts_;
+    host_set_.runCallbacks({}, {});
+  }
+
+  NiceMock<Upstream::MockPrioritySet> priority_set_;
+  Upstream::MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<Upstream::MockClusterInfo> info_{new NiceMock<Upstream::MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  Upstream::ClusterLbStatNames stat_names_;
+  Upstream::ClusterLbStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Random::MockRandomGenerator> random_;
+  envoy::config::cluster::v3::Cluster::CommonLbConfig common_config_;
+  std::unique_ptr<PeakEwmaLoadBalancer> lb_;
+};
+
+TEST_F(PeakEwmaLoadBalancerTest, NoHosts) {
+  init();
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr));
+  EXPECT_EQ(nullptr, lb_->peekAnotherHost(nullptr));
+}
+
+TEST_F(PeakEwmaLoadBalancerTest, SingleHost) {
+  initHosts(1);
+  init();
+  EXPECT_EQ(host_set_.healthy_hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// With two hosts both are always sampled, so the host with the lower response time wins
+// whatever the random value.
+TEST_F(PeakEwmaLoadBalancerTest, PrefersFasterHost) {
+  initHosts(2);
+  init();
+  ASSERT_TRUE(lb_->responseTimeCallbacks().has_value());
+  lb_->responseTimeCallbacks()->onHostResponseTime(*host_set_.hosts_[0],
+                                                   std::chrono::milliseconds(100));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+}
+
+TEST_F(PeakEwmaLoadBalancerTest, ActiveRequestsRaiseCost) {
+  initHosts(2);
+  init();
+  host_set_.hosts_[1]->stats().rq_active_.set(1);
+  const MonotonicTime now = simTime().monotonicTime();
+  EXPECT_DOUBLE_EQ(10000, lb_->hostCost(*host_set_.hosts_[0], now));
+  EXPECT_DOUBLE_EQ(20000, lb_->hostCost(*host_set_.hosts_[1], now));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(1));
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(nullptr));
+}
+
+// A slower response replaces the estimate, faster ones are blended in by elapsed time.
+TEST_F(PeakEwmaLoadBalancerTest, PeakEwma) {
+  initHosts(1);
+  init();
+  const auto& host = *host_set_.hosts_[0];
+
+  lb_->onHostResponseTime(host, std::chrono::milliseconds(50));
+  EXPECT_DOUBLE_EQ(50000, lb_->hostCost(host, simTime().monotonicTime()));
+
+  // No time has passed, so a faster response has no weight yet.
+  lb_->onHostResponseTime(host, std::chrono::milliseconds(10));
+  EXPECT_DOUBLE_EQ(50000, lb_->hostCost(host, simTime().monotonicTime()));
+
+  // Without responses the estimate decays towards zero.
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  EXPECT_NEAR(50000 * std::exp(-1.0), lb_->hostCost(host, simTime().monotonicTime()), 1);
+
+  lb_->onHostResponseTime(host, std::chrono::milliseconds(10));
+  EXPECT_NEAR(50000 * std::exp(-1.0) + 10000 * (1 - std::exp(-1.0)),
+              lb_->hostCost(host, simTime().monotonicTime()), 1);
+}
+
+// Estimates of removed hosts are dropped, and responses that arrive after the removal ignored.
+TEST_F(PeakEwmaLoadBalancerTest, RemovedHost) {
+  initHosts(2);
+  init();
+  const Upstream::HostSharedPtr host = host_set_.hosts_[0];
+  lb_->onHostResponseTime(*host, std::chrono::milliseconds(50));
+
+  host_set_.hosts_.erase(host_set_.hosts_.begin());
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {host});
+  lb_->onHostResponseTime(*host, std::chrono::milliseconds(70));
+
+  host_set_.hosts_.push_back(host);
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({host}, {});
+  EXPECT_DOUBLE_EQ(10000, lb_->hostCost(*host, simTime().monotonicTime()));
+}
+
+// A reset or timed out request counts as a response of at least the failure penalty.
+TEST_F(PeakEwmaLoadBalancerTest, HostFailure) {
+  initHosts(2);
+  init();
+  const auto& host = *host_set_.hosts_[0];
+
+  lb_->onHostResponseTime(host, std::chrono::milliseconds(5));
+  lb_->onHostFailure(host, std::chrono::milliseconds(20));
+  EXPECT_DOUBLE_EQ(1000000, lb_->hostCost(host, simTime().monotonicTime()));
+
+  lb_->onHostFailure(host, std::chrono::seconds(3));
+  EXPECT_DOUBLE_EQ(3000000, lb_->hostCost(host, simTime().monotonicTime()));
+
+  // The failing host loses every pick against a host with the default estimate.
+  EXPECT_CALL(random_, random()).WillRepeatedly(Return(0));
+  EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+}
+
+TEST_F(PeakEwmaLoadBalancerTest, PeekPredictsChoice) {
+  initHosts(3);
+  init();
+  lb_->onHostResponseTime(*host_set_.hosts_[2], std::chrono::milliseconds(50));
+
+  // Samples hosts 2 and 0.
+  EXPECT_CALL(random_, random()).WillOnce(Return(2));
+  Upstream::HostConstSharedPtr peeked = lb_->peekAnotherHost(nullptr);
+  EXPECT_EQ(host_set_.hosts_[0], peeked);
+  EXPECT_EQ(peeked, lb_->chooseHost(nullptr));
+}
+
+TEST(PeakEwmaLbFactoryTest, CreatesWorkerLoadBalancers) {
+  auto& factory = Config::Utility::getAndCheckFactoryByName<Upstream::TypedLoadBalancerFactory>(
+      "envoy.load_balancing_policies.peak_ewma");
+
+  NiceMock<Upstream::MockClusterInfo> cluster_info;
+  ProtobufTypes::MessagePtr config = factory.createEmptyConfigProto();
+  ON_CALL(cluster_info, loadBalancingPolicy()).WillByDefault(ReturnRef(config));
+  NiceMock<Upstream::MockPrioritySet> priority_set;
+  priority_set.getMockHostSet(0);
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Random::MockRandomGenerator> random;
+  Event::SimulatedTimeSystem time_system;
+
+  Upstream::ThreadAwareLoadBalancerPtr thread_aware_lb =
+      factory.create(cluster_info, priority_set, runtime, random, time_system);
+  thread_aware_lb->initialize();
+  Upstream::LoadBalancerFactorySharedPtr lb_factory = thread_aware_lb->factory();
+  EXPECT_FALSE(lb_factory->recreateOnHostChange());
+
+  Upstream::LoadBalancerPtr lb = lb_factory->create({priority_set, nullptr});
+  EXPECT_TRUE(lb->responseTimeCallbacks().has_value());
+  EXPECT_EQ(nullptr, lb->chooseHost(nullptr));
+
+  // Without parameters, the load balancer uses the priority set of the cluster.
+  auto host_cluster_info = std::make_shared<NiceMock<Upstream::MockClusterInfo>>();
+  Upstream::HostSharedPtr host =
+      Upstream::makeTestHost(host_cluster_info, "tcp://127.0.0.1:80", time_system);
+  priority_set.getMockHostSet(0)->hosts_ = {host};
+  priority_set.getMockHostSet(0)->healthy_hosts_ = {host};
+  priority_set.getMockHostSet(0)->runCallbacks({host}, {});
+  Upstream::LoadBalancerPtr default_lb = lb_factory->create();
+  EXPECT_TRUE(default_lb->responseTimeCallbacks().has_value());
+  EXPECT_EQ(host, default_lb->chooseHost(nullptr));
+}
+
+} // namespace
+} // namespace PeakEwma
+} // namespace LoadBalancingPolicies
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,53 @@
+#include "envoy/extensions/network/socket_interface/io_uring/v3/io_uring_socket_interface.pb.h"
+
+#include "source/common/io/io_uring_impl.h"
+#include "source/extensions/network/socket_interface/io_uring/config.h"
+#include "source/extensions/network/socket_interface/io_uring/io_uring_socket_handle_impl.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+TEST(IoUringSocketInterfaceTest, Registered) {
+  EXPECT_NE(nullptr, socketInterface("envoy.extensions.network.socket_interface.io_uring"));
+}
+
+TEST(IoUringSocketInterfaceTest, CreatesIoUringHandlesWhileExtensionIsAlive) {
+  auto* factory =
+      Registry::FactoryRegistry<Server::Configuration::BootstrapExtensionFactory>::getFactory(
+          "envoy.extensions.network.socket_interface.io_uring");
+  ASSERT_NE(nullptr, factory);
+  auto* sock_interface = dynamic_cast<SocketInterface*>(factory);
+  ASSERT_NE(nullptr, sock_interface);
+
+  // Without the bootstrap extension the interface behaves like the default one.
+  IoHandlePtr handle = sock_interface->socket(Socket::Type::Stream, Address::Type::Ip,
+                                              Address::IpVersion::v4, false, {});
+  EXPECT_EQ(nullptr, dynamic_cast<IoUringSocketHandleImpl*>(handle.get()));
+
+  testing::NiceMock<Server::Configuration::MockServerFactoryContext> context;
+  envoy::extensions::network::socket_interface::io_uring::v3::IoUringSocketInterface config;
+  config.mutable_io_uring_size()->set_value(16);
+  config.mutable_read_buffer_size()->set_value(4096);
+  Server::BootstrapExtensionPtr extension = factory->createBootstrapExtension(config, context);
+  ASSERT_NE(nullptr, extension);
+
+  handle = sock_interface->socket(Socket::Type::Stream, Address::Type::Ip,
+                                  Address::IpVersion::v4, false, {});
+  EXPECT_EQ(Io::isIoUringSupported(),
+            dynamic_cast<IoUringSocketHandleImpl*>(handle.get()) != nullptr);
+  handle->close();
+
+  extension.reset();
+  handle = sock_interface->socket(Socket::Type::Stream, Address::Type::Ip,
+                                  Address::IpVersion::v4, false, {});
+  EXPECT_EQ(nullptr, dynamic_cast<IoUringSocketHandleImpl*>(handle.get()));
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,306 @@
+#include <sys/socket.h>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/network/address_impl.h"
+#include "source/extensions/network/socket_interface/io_uring/io_uring_socket_handle_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class TestIoUringWorkerFactory : public Io::IoUringWorkerFactory {
+public:
+  OptRef<Io::IoUringWorkerImpl> getIoUringWorker() override {
+    if (worker_ == nullptr) {
+      return absl::nullopt;
+    }
+    return *worker_;
+  }
+  void onServerInitialized() override {}
+
+  std::unique_ptr<Io::IoUringWorkerImpl> worker_;
+};
+
+class IoUringSocketHandleImplTest : public ::testing::Test {
+public:
+  IoUringSocketHandleImplTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")),
+        should_skip_(!Io::isIoUringSupported()) {
+    if (!should_skip_) {
+      factory_.worker_ = std::make_unique<Io::IoUringWorkerImpl>(8, false, 1024, *dispatcher_);
+    }
+  }
+
+  ~IoUringSocketHandleImplTest() override {
+    handle_.reset();
+    peer_.reset();
+    factory_.worker_.reset();
+  }
+
+  void SetUp() override {
+    if (should_skip_) {
+      GTEST_SKIP();
+    }
+  }
+
+  void createSocketPair(int type) {
+    os_fd_t fds[2];
+    ASSERT_EQ(0, Api::OsSysCallsSingleton::get().socketpair(AF_UNIX, type, 0, fds).return_value_);
+    Api::OsSysCallsSingleton::get().setsocketblocking(fds[0], false);
+    Api::OsSysCallsSingleton::get().setsocketblocking(fds[1], false);
+    handle_ = std::make_unique<IoUringSocketHandleImpl>(factory_, fds[0], false, absl::nullopt,
+                                                        true);
+    peer_ = std::make_unique<IoSocketHandleImpl>(fds[1]);
+  }
+
+  void initializeFileEvent(uint32_t events) {
+    handle_->initializeFileEvent(
+        *dispatcher_, [this](uint32_t events) { events_ |= events; },
+        Event::FileTriggerType::Edge, events);
+  }
+
+  void runUntil(const std::function<bool()>& condition) {
+    while (!condition()) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  const bool should_skip_;
+  TestIoUringWorkerFactory factory_;
+  std::unique_ptr<IoUringSocketHandleImpl> handle_;
+  std::unique_ptr<IoSocketHandleImpl> peer_;
+  uint32_t events_{0};
+};
+
+TEST_F(IoUringSocketHandleImplTest, FallbackWithoutWorker) {
+  factory_.worker_.reset();
+  createSocketPair(SOCK_STREAM);
+  initializeFileEvent(Event::FileReadyType::Read);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(5, peer_->write(data).return_value_);
+  runUntil([this]() { return events_ & Event::FileReadyType::Read; });
+
+  Buffer::OwnedImpl received;
+  EXPECT_EQ(5, handle_->read(received, absl::nullopt).return_value_);
+  EXPECT_EQ("hello", received.toString());
+}
+
+TEST_F(IoUringSocketHandleImplTest, FallbackForDatagramSockets) {
+  createSocketPair(SOCK_DGRAM);
+  initializeFileEvent(Event::FileReadyType::Read);
+  EXPECT_EQ(0, factory_.worker_->numSockets());
+}
+
+TEST_F(IoUringSocketHandleImplTest, FallbackForOtherDispatchers) {
+  createSocketPair(SOCK_STREAM);
+  auto other_dispatcher = api_->allocateDispatcher("other_thread");
+  handle_->initializeFileEvent(
+      *other_dispatcher, [](uint32_t) {}, Event::FileTriggerType::Edge,
+      Event::FileReadyType::Read);
+  EXPECT_EQ(0, factory_.worker_->numSockets());
+  handle_->resetFileEvents();
+}
+
+TEST_F(IoUringSocketHandleImplTest, ReadWrite) {
+  createSocketPair(SOCK_STREAM);
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  EXPECT_EQ(1, factory_.worker_->numSockets());
+
+  // Nothing has been read yet.
+  Buffer::OwnedImpl received;
+  auto result = handle_->read(received, absl::nullopt);
+  EXPECT_EQ(Api::IoError::IoErrorCode::Again, result.err_->getErrorCode());
+
+  Buffer::OwnedImpl data("hello world");
+  EXPECT_EQ(11, peer_->write(data).return_value_);
+  runUntil([this]() { return events_ & Event::FileReadyType::Read; });
+
+  EXPECT_EQ(5, handle_->read(received, 5).return_value_);
+  EXPECT_EQ("hello", received.toString());
+
+  char peeked[6];
+  EXPECT_EQ(6, handle_->recv(peeked, 6, MSG_PEEK).return_value_);
+  EXPECT_EQ(" world", absl::string_view(peeked, 6));
+
+  char buf[6];
+  Buffer::RawSlice slice{buf, 6};
+  EXPECT_EQ(6, handle_->readv(6, &slice, 1).return_value_);
+  EXPECT_EQ(" world", absl::string_view(buf, 6));
+
+  Buffer::OwnedImpl reply("pong");
+  EXPECT_EQ(4, handle_->write(reply).return_value_);
+  Buffer::OwnedImpl peer_received;
+  runUntil([&]() {
+    peer_->read(peer_received, absl::nullopt);
+    return peer_received.length() == 4;
+  });
+  EXPECT_EQ("pong", peer_received.toString());
+
+  EXPECT_TRUE(handle_->close().ok());
+  EXPECT_FALSE(handle_->isOpen());
+  runUntil([this]() { return factory_.worker_->numSockets() == 0; });
+}
+
+TEST_F(IoUringSocketHandleImplTest, EnableReadReportsBufferedData) {
+  createSocketPair(SOCK_STREAM);
+  initializeFileEvent(Event::FileReadyType::Read);
+
+  Buffer::OwnedImpl data("hello");
+  peer_->write(data);
+  runUntil([this]() { return events_ & Event::FileReadyType::Read; });
+
+  // Reset and re-initialize, as a connection does when taking the socket over from listener
+  // filters. The data read in between must still be reported.
+  handle_->resetFileEvents();
+  events_ = 0;
+  initializeFileEvent(Event::FileReadyType::Read);
+  runUntil([this]() { return events_ & Event::FileReadyType::Read; });
+
+  Buffer::OwnedImpl received;
+  EXPECT_EQ(5, handle_->read(received, absl::nullopt).return_value_);
+}
+
+TEST_F(IoUringSocketHandleImplTest, PeerCloseReportsEof) {
+  createSocketPair(SOCK_STREAM);
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Closed);
+
+  peer_->close();
+  runUntil([this]() { return events_ & Event::FileReadyType::Closed; });
+
+  Buffer::OwnedImpl received;
+  auto result = handle_->read(received, absl::nullopt);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(0, result.return_value_);
+}
+
+TEST_F(IoUringSocketHandleImplTest, ActivateFileEvents) {
+  createSocketPair(SOCK_STREAM);
+  initializeFileEvent(Event::FileReadyType::Read);
+
+  handle_->activateFileEvents(Event::FileReadyType::Write);
+  runUntil([this]() { return events_ & Event::FileReadyType::Write; });
+}
+
+TEST_F(IoUringSocketHandleImplTest, AcceptAndConnect) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  auto listener = std::make_unique<IoUringSocketHandleImpl>(
+      factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  EXPECT_EQ(0,
+            listener->bind(std::make_shared<Address::Ipv4Instance>("127.0.0.1", 0)).return_value_);
+  EXPECT_EQ(0, listener->listen(5).return_value_);
+  uint32_t listener_events = 0;
+  listener->initializeFileEvent(
+      *dispatcher_, [&listener_events](uint32_t events) { listener_events |= events; },
+      Event::FileTriggerType::Level, Event::FileReadyType::Read);
+  // Nothing to accept yet.
+  EXPECT_EQ(nullptr, listener->accept(nullptr, nullptr));
+
+  handle_ = std::make_unique<IoUringSocketHandleImpl>(
+      factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  auto result = handle_->connect(listener->localAddress());
+  EXPECT_EQ(-1, result.return_value_);
+  EXPECT_EQ(SOCKET_ERROR_IN_PROGRESS, result.errno_);
+
+  runUntil([&]() {
+    return (listener_events & Event::FileReadyType::Read) &&
+           (events_ & Event::FileReadyType::Write);
+  });
+  int error = -1;
+  socklen_t error_size = sizeof(error);
+  EXPECT_EQ(0, handle_->getOption(SOL_SOCKET, SO_ERROR, &error, &error_size).return_value_);
+  EXPECT_EQ(0, error);
+
+  sockaddr_storage remote_addr;
+  socklen_t remote_addr_len = sizeof(remote_addr);
+  IoHandlePtr accepted =
+      listener->accept(reinterpret_cast<sockaddr*>(&remote_addr), &remote_addr_len);
+  ASSERT_NE(nullptr, accepted);
+  EXPECT_EQ(AF_INET, remote_addr.ss_family);
+  EXPECT_EQ(nullptr, listener->accept(nullptr, nullptr));
+
+  accepted->close();
+  listener->close();
+}
+
+// A connect issued before the ring takes the socket over is awaited before the socket is used.
+TEST_F(IoUringSocketHandleImplTest, ConnectBeforeInitializeFileEvent) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  auto listener = std::make_unique<IoSocketHandleImpl>(
+      os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  EXPECT_EQ(0,
+            listener->bind(std::make_shared<Address::Ipv4Instance>("127.0.0.1", 0)).return_value_);
+  EXPECT_EQ(0, listener->listen(5).return_value_);
+
+  handle_ = std::make_unique<IoUringSocketHandleImpl>(
+      factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  auto result = handle_->connect(listener->localAddress());
+  EXPECT_TRUE(result.return_value_ == 0 || result.errno_ == SOCKET_ERROR_IN_PROGRESS);
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  runUntil([this]() { return events_ & Event::FileReadyType::Write; });
+  int error = -1;
+  socklen_t error_size = sizeof(error);
+  EXPECT_EQ(0, handle_->getOption(SOL_SOCKET, SO_ERROR, &error, &error_size).return_value_);
+  EXPECT_EQ(0, error);
+
+  IoHandlePtr accepted;
+  runUntil([&]() {
+    accepted = listener->accept(nullptr, nullptr);
+    return accepted != nullptr;
+  });
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(5, handle_->write(data).return_value_);
+  Buffer::OwnedImpl received;
+  runUntil([&]() {
+    accepted->read(received, absl::nullopt);
+    return received.length() == 5;
+  });
+  EXPECT_EQ("hello", received.toString());
+
+  accepted->close();
+  listener->close();
+}
+
+// A connect issued before the ring takes the socket over reports its failure like a connect
+// submitted to the ring.
+TEST_F(IoUringSocketHandleImplTest, ConnectBeforeInitializeFileEventRefused) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  // Bound but not listening, so connecting to it is refused.
+  auto closed = std::make_unique<IoSocketHandleImpl>(
+      os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  EXPECT_EQ(0,
+            closed->bind(std::make_shared<Address::Ipv4Instance>("127.0.0.1", 0)).return_value_);
+
+  handle_ = std::make_unique<IoUringSocketHandleImpl>(
+      factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+  auto result = handle_->connect(closed->localAddress());
+  if (result.errno_ != SOCKET_ERROR_IN_PROGRESS) {
+    // The connect failed right away.
+    EXPECT_EQ(ECONNREFUSED, result.errno_);
+    closed->close();
+    return;
+  }
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  runUntil([this]() { return events_ & Event::FileReadyType::Write; });
+  int error = 0;
+  socklen_t error_size = sizeof(error);
+  EXPECT_EQ(0, handle_->getOption(SOL_SOCKET, SO_ERROR, &error, &error_size).return_value_);
+  EXPECT_EQ(ECONNREFUSED, error);
+
+  // Nothing is written to a socket which isn't connected.
+  Buffer::OwnedImpl data("hello");
+  EXPECT_FALSE(handle_->write(data).ok());
+  closed->close();
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
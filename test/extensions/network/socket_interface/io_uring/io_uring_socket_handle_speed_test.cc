@@ -0,0 +1,119 @@
+// Compares request/response round trips over a loopback TCP connection driven by epoll
+// (IoSocketHandleImpl) with the same exchange driven by the thread's io_uring worker
+// (IoUringSocketHandleImpl).
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/io/io_uring_impl.h"
+#include "source/common/network/address_impl.h"
+#include "source/extensions/network/socket_interface/io_uring/io_uring_socket_handle_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class BenchmarkIoUringWorkerFactory : public Io::IoUringWorkerFactory {
+public:
+  OptRef<Io::IoUringWorkerImpl> getIoUringWorker() override {
+    if (worker_ == nullptr) {
+      return absl::nullopt;
+    }
+    return *worker_;
+  }
+  void onServerInitialized() override {}
+
+  std::unique_ptr<Io::IoUringWorkerImpl> worker_;
+};
+
+class LoopbackConnection {
+public:
+  LoopbackConnection(bool use_io_uring) : api_(Api::createApiForTest()) {
+    dispatcher_ = api_->allocateDispatcher("bench");
+    if (use_io_uring) {
+      factory_.worker_ = std::make_unique<Io::IoUringWorkerImpl>(256, false, 16384, *dispatcher_);
+    }
+
+    Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+    IoUringSocketHandleImpl listener(
+        factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+    RELEASE_ASSERT(
+        listener.bind(std::make_shared<Address::Ipv4Instance>("127.0.0.1", 0)).return_value_ == 0,
+        "");
+    RELEASE_ASSERT(listener.listen(1).return_value_ == 0, "");
+
+    client_ = std::make_unique<IoUringSocketHandleImpl>(
+        factory_, os_sys_calls.socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0).return_value_);
+    client_->connect(listener.localAddress());
+    while ((server_ = listener.accept(nullptr, nullptr)) == nullptr) {
+    }
+
+    // Initialized after connecting so both paths use an established socket.
+    for (IoHandle* handle : {client_.get(), server_.get()}) {
+      handle->initializeFileEvent(
+          *dispatcher_, [](uint32_t) {}, Event::FileTriggerType::Edge,
+          Event::FileReadyType::Read | Event::FileReadyType::Write);
+    }
+  }
+
+  ~LoopbackConnection() {
+    client_.reset();
+    server_.reset();
+    factory_.worker_.reset();
+  }
+
+  // Sends `message` from `from` and spins the event loop until `to` has received all of it.
+  void transfer(IoHandle& from, IoHandle& to, Buffer::Instance& message) {
+    const uint64_t length = message.length();
+    Buffer::OwnedImpl pending;
+    pending.add(message);
+    Buffer::OwnedImpl received;
+    while (received.length() < length) {
+      if (pending.length() > 0) {
+        from.write(pending);
+      }
+      to.read(received, absl::nullopt);
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  BenchmarkIoUringWorkerFactory factory_;
+  IoHandlePtr client_;
+  IoHandlePtr server_;
+};
+
+// Args: message size, use io_uring.
+void roundTrip(benchmark::State& state) {
+  const bool use_io_uring = state.range(1) != 0;
+  if (use_io_uring && !Io::isIoUringSupported()) {
+    state.SkipWithError("io_uring is not supported");
+    return;
+  }
+
+  LoopbackConnection connection(use_io_uring);
+  Buffer::OwnedImpl message(std::string(state.range(0), 'a'));
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    connection.transfer(*connection.client_, *connection.server_, message);
+    connection.transfer(*connection.server_, *connection.client_, message);
+  }
+  state.SetBytesProcessed(2 * state.iterations() * state.range(0));
+}
+BENCHMARK(roundTrip)
+    ->Args({128, 0})
+    ->Args({128, 1})
+    ->Args({4096, 0})
+    ->Args({4096, 1})
+    ->Args({65536, 0})
+    ->Args({65536, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
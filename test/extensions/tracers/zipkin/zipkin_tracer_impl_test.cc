@@ -314,7 +314,9 @@ TEST_F(ZipkinDriverTest, SkipReportIfCollectorClusterHasBeenRemoved) {
     // Simulate addition of an irrelevant cluster.
     NiceMock<Upstream::MockThreadLocalCluster> unrelated_cluster;
     unrelated_cluster.cluster_.info_->name_ = "unrelated_cluster";
-    cluster_update_callbacks->onClusterAddOrUpdate(unrelated_cluster);
+    cluster_update_callbacks->onClusterAddOrUpdate(
+        unrelated_cluster.info()->name(),
+        [&]() -> Upstream::ThreadLocalCluster& { return unrelated_cluster; });
 
     // Verify that no report will be sent.
     EXPECT_CALL(cm_.thread_local_cluster_, httpAsyncClient()).Times(0);
@@ -336,7 +338,9 @@ TEST_F(ZipkinDriverTest, SkipReportIfCollectorClusterHasBeenRemoved) {
 
   {
     // Simulate addition of the relevant cluster.
-    cluster_update_callbacks->onClusterAddOrUpdate(cm_.thread_local_cluster_);
+    cluster_update_callbacks->onClusterAddOrUpdate(
+        cm_.thread_local_cluster_.info()->name(),
+        [&]() -> Upstream::ThreadLocalCluster& { return cm_.thread_local_cluster_; });
 
     // Verify that report will be sent.
     EXPECT_CALL(cm_.thread_local_cluster_, httpAsyncClient())
@@ -945,6 +945,11 @@ protected:
                                    const std::string& client_ctx_yaml, bool expect_reuse,
                                    const Network::Address::IpVersion version);
 
+  // Exchanges data over a connection with kernel TLS offload enabled on both sides, ending with a
+  // close_notify from the server. Returns the ktls_tx_enabled, ktls_rx_enabled, ktls_unsupported,
+  // ktls_failed and ktls_skipped stats of the server followed by those of the client.
+  std::vector<uint64_t> testKernelTlsOffload(const std::string& tls_params_yaml);
+
   NiceMock<Runtime::MockLoader> runtime_;
   Event::DispatcherPtr dispatcher_;
   StreamInfo::StreamInfoImpl stream_info_;
@@ -3314,6 +3319,161 @@ TEST_P(SslSocketTest, ShutdownWithoutCloseNotify) {
   dispatcher_->run(Event::Dispatcher::RunType::Block);
 }
 
+std::vector<uint64_t> SslSocketTest::testKernelTlsOffload(const std::string& tls_params_yaml) {
+  const std::string server_ctx_yaml = absl::StrCat(R"EOF(
+  common_tls_context:
+    enable_kernel_tls_offload: true
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/unittest_cert.pem"
+      private_key:
+        filename: "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/unittest_key.pem"
+)EOF",
+                                                   tls_params_yaml);
+
+  envoy::extensions::transport_sockets::tls::v3::DownstreamTlsContext server_tls_context;
+  TestUtility::loadFromYaml(TestEnvironment::substitute(server_ctx_yaml), server_tls_context);
+  auto server_cfg = std::make_unique<ServerContextConfigImpl>(server_tls_context, factory_context_);
+  ContextManagerImpl manager(time_system_);
+  Stats::TestUtil::TestStore server_stats_store;
+  ServerSslSocketFactory server_ssl_socket_factory(std::move(server_cfg), manager,
+                                                   server_stats_store, std::vector<std::string>{});
+
+  auto socket = std::make_shared<Network::Test::TcpListenSocketImmediateListen>(
+      Network::Test::getCanonicalLoopbackAddress(version_));
+  Network::MockTcpListenerCallbacks listener_callbacks;
+  Network::ListenerPtr listener =
+      dispatcher_->createListener(socket, listener_callbacks, runtime_, true, false);
+  std::shared_ptr<Network::MockReadFilter> server_read_filter(new Network::MockReadFilter());
+  std::shared_ptr<Network::MockReadFilter> client_read_filter(new Network::MockReadFilter());
+
+  const std::string client_ctx_yaml = absl::StrCat(R"EOF(
+  common_tls_context:
+    enable_kernel_tls_offload: true
+)EOF",
+                                                   tls_params_yaml);
+
+  envoy::extensions::transport_sockets::tls::v3::UpstreamTlsContext tls_context;
+  TestUtility::loadFromYaml(TestEnvironment::substitute(client_ctx_yaml), tls_context);
+  auto client_cfg = std::make_unique<ClientContextConfigImpl>(tls_context, factory_context_);
+  Stats::TestUtil::TestStore client_stats_store;
+  ClientSslSocketFactory client_ssl_socket_factory(std::move(client_cfg), manager,
+                                                   client_stats_store);
+  Network::ClientConnectionPtr client_connection = dispatcher_->createClientConnection(
+      socket->connectionInfoProvider().localAddress(), Network::Address::InstanceConstSharedPtr(),
+      client_ssl_socket_factory.createTransportSocket(nullptr, nullptr), nullptr, nullptr);
+  Network::MockConnectionCallbacks client_connection_callbacks;
+  client_connection->enableHalfClose(true);
+  client_connection->addReadFilter(client_read_filter);
+  client_connection->addConnectionCallbacks(client_connection_callbacks);
+  client_connection->connect();
+
+  Network::ConnectionPtr server_connection;
+  Network::MockConnectionCallbacks server_connection_callbacks;
+  EXPECT_CALL(listener_callbacks, onAccept_(_))
+      .WillOnce(Invoke([&](Network::ConnectionSocketPtr& socket) -> void {
+        server_connection = dispatcher_->createServerConnection(
+            std::move(socket), server_ssl_socket_factory.createDownstreamTransportSocket(),
+            stream_info_);
+        server_connection->enableHalfClose(true);
+        server_connection->addReadFilter(server_read_filter);
+        server_connection->addConnectionCallbacks(server_connection_callbacks);
+      }));
+  EXPECT_CALL(*server_read_filter, onNewConnection());
+  EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected));
+
+  EXPECT_CALL(*client_read_filter, onNewConnection())
+      .WillOnce(Return(Network::FilterStatus::Continue));
+  EXPECT_CALL(client_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+        Buffer::OwnedImpl data("hello");
+        client_connection->write(data, false);
+      }));
+  EXPECT_CALL(*server_read_filter, onData(BufferStringEqual("hello"), false))
+      .WillOnce(Invoke([&](Buffer::Instance& read_buffer, bool) -> Network::FilterStatus {
+        read_buffer.drain(read_buffer.length());
+        Buffer::OwnedImpl data("world");
+        server_connection->write(data, true);
+        return Network::FilterStatus::StopIteration;
+      }));
+  // The close_notify alert may or may not be read together with the data.
+  std::string client_received;
+  EXPECT_CALL(*client_read_filter, onData(_, _))
+      .WillRepeatedly(
+          Invoke([&](Buffer::Instance& read_buffer, bool end_stream) -> Network::FilterStatus {
+            client_received.append(read_buffer.toString());
+            read_buffer.drain(read_buffer.length());
+            if (end_stream) {
+              EXPECT_EQ("world", client_received);
+              client_connection->close(Network::ConnectionCloseType::NoFlush);
+            }
+            return Network::FilterStatus::StopIteration;
+          }));
+  EXPECT_CALL(*server_read_filter, onData(_, true));
+
+  EXPECT_CALL(client_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+  EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+        server_connection->close(Network::ConnectionCloseType::NoFlush);
+        dispatcher_->exit();
+      }));
+
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  std::vector<uint64_t> stats;
+  for (Stats::TestUtil::TestStore* store : {&server_stats_store, &client_stats_store}) {
+    for (const std::string name : {"ssl.ktls_tx_enabled", "ssl.ktls_rx_enabled",
+                                   "ssl.ktls_unsupported", "ssl.ktls_failed", "ssl.ktls_skipped"}) {
+      stats.push_back(store->counter(name).value());
+    }
+  }
+  return stats;
+}
+
+// Whether the kernel offloads the session depends on the host, so this only checks that the
+// connection works and that the session is considered supported.
+TEST_P(SslSocketTest, KernelTlsOffload) {
+  const std::vector<uint64_t> stats = testKernelTlsOffload(R"EOF(
+    tls_params:
+      tls_maximum_protocol_version: TLSv1_2
+      cipher_suites:
+      - ECDHE-RSA-AES128-GCM-SHA256
+)EOF");
+  for (size_t side = 0; side < 2; ++side) {
+    const uint64_t tx_enabled = stats[side * 5];
+    const uint64_t rx_enabled = stats[side * 5 + 1];
+    const uint64_t unsupported = stats[side * 5 + 2];
+    const uint64_t failed = stats[side * 5 + 3];
+    const uint64_t skipped = stats[side * 5 + 4];
+    EXPECT_EQ(0, unsupported);
+    // A skipped offload isn't counted as failed, and doesn't offload any direction.
+    EXPECT_EQ(tx_enabled == 1 && rx_enabled == 1 ? 0 : 1, failed + skipped);
+    if (skipped == 1) {
+      EXPECT_EQ(0, rx_enabled);
+    }
+    // The transmit direction is only offloaded with the receive one.
+    EXPECT_LE(tx_enabled, rx_enabled);
+  }
+}
+
+TEST_P(SslSocketTest, KernelTlsOffloadUnsupportedCipher) {
+  const std::vector<uint64_t> stats = testKernelTlsOffload(R"EOF(
+    tls_params:
+      tls_maximum_protocol_version: TLSv1_2
+      cipher_suites:
+      - ECDHE-RSA-CHACHA20-POLY1305
+)EOF");
+  EXPECT_EQ((std::vector<uint64_t>{0, 0, 1, 0, 0, 0, 0, 1, 0, 0}), stats);
+}
+
+TEST_P(SslSocketTest, KernelTlsOffloadUnsupportedVersion) {
+  const std::vector<uint64_t> stats = testKernelTlsOffload(R"EOF(
+    tls_params:
+      tls_minimum_protocol_version: TLSv1_3
+)EOF");
+  EXPECT_EQ((std::vector<uint64_t>{0, 0, 1, 0, 0, 0, 0, 1, 0, 0}), stats);
+}
+
 TEST_P(SslSocketTest, ClientAuthMultipleCAs) {
   const std::string server_ctx_yaml = R"EOF(
   common_tls_context:
@@ -1,4 +1,9 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/transport_sockets/tls/kernel_tls.h"
 
 #include "test/test_common/environment.h"
 
@@ -64,6 +69,35 @@ static void addFullSlices(Buffer::Instance& output_buffer, unsigned num_slices,
   }
 }
 
+// Creates a connected pair of non-blocking TCP sockets over loopback. Kernel TLS requires TCP, so
+// the userspace TLS cases use the same transport to be comparable.
+static void tcpLoopbackPair(int sockets[2]) {
+  const int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  RELEASE_ASSERT(bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len) == 0, "bind");
+  RELEASE_ASSERT(listen(listener, 1) == 0, "listen");
+  RELEASE_ASSERT(getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0,
+                 "getsockname");
+
+  sockets[1] = socket(AF_INET, SOCK_STREAM, 0);
+  RELEASE_ASSERT(connect(sockets[1], reinterpret_cast<sockaddr*>(&addr), addr_len) == 0,
+                 "connect");
+  sockets[0] = accept(listener, nullptr, nullptr);
+  RELEASE_ASSERT(sockets[0] >= 0, "accept");
+  ::close(listener);
+
+  for (int i = 0; i < 2; i++) {
+    // Make the socket buffers large enough for a whole iteration, so that writes never block.
+    const int buffer_size = 4 * 1024 * 1024;
+    setsockopt(sockets[i], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    setsockopt(sockets[i], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    fcntl(sockets[i], F_SETFL, fcntl(sockets[i], F_GETFL) | O_NONBLOCK);
+  }
+}
+
 static void testThroughput(benchmark::State& state) {
   std::string error;
   std::unique_ptr<bazel::tools::cpp::runfiles::Runfiles> runfiles(
@@ -71,10 +105,19 @@ static void testThroughput(benchmark::State& state) {
   Envoy::TestEnvironment::setRunfiles(runfiles.get());
 
   int sockets[2];
-  socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets);
+  tcpLoopbackPair(sockets);
+  Network::IoSocketHandleImpl server_io_handle(sockets[0]);
+  Network::IoSocketHandleImpl client_io_handle(sockets[1]);
 
   bssl::UniquePtr<SSL_CTX> server_ctx(SSL_CTX_new(TLS_method()));
   bssl::UniquePtr<SSL_CTX> client_ctx(SSL_CTX_new(TLS_method()));
+  // Kernel TLS only supports TLS 1.2 with AES-GCM. Use that for all cases, so that only the
+  // record layer implementation differs between them.
+  for (SSL_CTX* ctx : {server_ctx.get(), client_ctx.get()}) {
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    RELEASE_ASSERT(SSL_CTX_set_strict_cipher_list(ctx, "ECDHE-RSA-AES128-GCM-SHA256") == 1,
+                   "SSL_CTX_set_strict_cipher_list");
+  }
   std::string cert_path = TestEnvironment::substitute(
       "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/san_dns_cert.pem");
   std::string key_path = TestEnvironment::substitute(
@@ -113,6 +156,14 @@ static void testThroughput(benchmark::State& state) {
   unsigned num_short_slices = state.range(1);
   unsigned align_to_16kb = state.range(2);
   unsigned move_slices = state.range(3);
+  unsigned kernel_tls = state.range(4);
+
+  if (kernel_tls &&
+      (!KernelTls::enable(client_ssl.get(), client_io_handle, KernelTls::Direction::Tx) ||
+       !KernelTls::enable(server_ssl.get(), server_io_handle, KernelTls::Direction::Rx))) {
+    state.SkipWithError("kernel TLS is not supported");
+    return;
+  }
 
   uint64_t bytes_written = 0;
   for (auto _ : state) {
@@ -120,7 +171,12 @@ static void testThroughput(benchmark::State& state) {
     state.PauseTiming();
 
     // Empty out the read side to make space for the writes.
-    while (SSL_read(server_ssl.get(), read_buf, sizeof(read_buf)) > 0) {
+    if (kernel_tls) {
+      while (::read(sockets[0], read_buf, sizeof(read_buf)) > 0) {
+      }
+    } else {
+      while (SSL_read(server_ssl.get(), read_buf, sizeof(read_buf)) > 0) {
+      }
     }
 
     Buffer::OwnedImpl write_buf;
@@ -149,6 +205,12 @@ static void testThroughput(benchmark::State& state) {
     state.ResumeTiming();
     uint32_t num_writes = 0;
     uint32_t num_times_linearize_did_something = 0;
+    while (kernel_tls && write_buf.length() > 0) {
+      // The kernel splits the data into records itself, so the slices are written as they are.
+      const Api::IoCallUint64Result result = client_io_handle.write(write_buf);
+      RELEASE_ASSERT(result.ok(), "kernel TLS write failed");
+      num_writes++;
+    }
     while (write_buf.length() > 0) {
       const Buffer::RawSlice initial = write_buf.frontSlice();
       void* mem;
@@ -169,21 +231,20 @@ static void testThroughput(benchmark::State& state) {
     state.counters["num_linearized"] = num_times_linearize_did_something;
   }
   state.counters["throughput"] = benchmark::Counter(bytes_written, benchmark::Counter::kIsRate);
-
-  ::close(sockets[0]);
-  ::close(sockets[1]);
 }
 
 static void testParams(benchmark::internal::Benchmark* b) {
-  for (auto move_slices : {false, true}) {
-    for (auto align_to_16kb : {false, true}) {
-      // Add a single case of no short slices; don't iterate over the sizes
-      // which duplicates test cases when count is zero.
-      b->Args({0, 0, align_to_16kb, move_slices});
-
-      for (auto short_slice_size : {1, 128, 4095, 4096, 4097}) {
-        for (auto num_short_slices : {1, 2, 3}) {
-          b->Args({short_slice_size, num_short_slices, align_to_16kb, move_slices});
+  for (auto kernel_tls : {false, true}) {
+    for (auto move_slices : {false, true}) {
+      for (auto align_to_16kb : {false, true}) {
+        // Add a single case of no short slices; don't iterate over the sizes
+        // which duplicates test cases when count is zero.
+        b->Args({0, 0, align_to_16kb, move_slices, kernel_tls});
+
+        for (auto short_slice_size : {1, 128, 4095, 4096, 4097}) {
+          for (auto num_short_slices : {1, 2, 3}) {
+            b->Args({short_slice_size, num_short_slices, align_to_16kb, move_slices, kernel_tls});
+          }
         }
       }
     }
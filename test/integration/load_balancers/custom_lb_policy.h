@@ -33,6 +33,7 @@ private:
     OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks> lifetimeCallbacks() override {
       return {};
     }
+    OptRef<Upstream::ResponseTimeCallbacks> responseTimeCallbacks() override { return {}; }
     absl::optional<Upstream::SelectedPoolAndConnection>
     selectExistingConnection(Upstream::LoadBalancerContext*, const Upstream::Host&,
                              std::vector<uint8_t>&) override {
@@ -605,6 +605,8 @@ TEST_P(XfccIntegrationTest, TagExtractedNameGenerationTest) {
       {"http.config_test.downstream_cx_protocol_error", "http.downstream_cx_protocol_error"},
       {"cluster.cluster_0.upstream_rq_tx_reset", "cluster.upstream_rq_tx_reset"},
       {"server.dropped_stat_flushes", "server.dropped_stat_flushes"},
+      {"server.buffer_slice_pool_hits", "server.buffer_slice_pool_hits"},
+      {"server.buffer_slice_pool_misses", "server.buffer_slice_pool_misses"},
       {"http.admin.downstream_rq_response_before_rq_complete",
        "http.downstream_rq_response_before_rq_complete"},
       {"http.config_test.tracing.service_forced", "http.tracing.service_forced"},
@@ -849,6 +851,7 @@ TEST_P(XfccIntegrationTest, TagExtractedNameGenerationTest) {
       {"http.admin.downstream_cx_http3_active", "http.downstream_cx_http3_active"},
       {"cluster.cluster_0.membership_excluded", "cluster.membership_excluded"},
       {"server.concurrency", "server.concurrency"},
+      {"server.buffer_slice_pool_bytes", "server.buffer_slice_pool_bytes"},
       {"runtime.num_layers", "runtime.num_layers"},
       {"listener.admin.downstream_pre_cx_active", "listener.admin.downstream_pre_cx_active"},
       {"http.config_test.downstream_cx_tx_bytes_buffered", "http.downstream_cx_tx_bytes_buffered"},
@@ -68,6 +68,9 @@ MockRateLimitPolicy::MockRateLimitPolicy() {
 
 MockRateLimitPolicy::~MockRateLimitPolicy() = default;
 
+MockShadowStream::MockShadowStream() = default;
+MockShadowStream::~MockShadowStream() = default;
+
 MockShadowWriter::MockShadowWriter() = default;
 MockShadowWriter::~MockShadowWriter() = default;
 
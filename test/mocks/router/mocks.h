@@ -97,10 +97,16 @@ public:
     return additional_request_chance_;
   }
   bool hedgeOnPerTryTimeout() const override { return hedge_on_per_try_timeout_; }
+  absl::optional<double> hedgeOnResponseTimePercentile() const override {
+    return hedge_on_response_time_percentile_;
+  }
+  double hedgeBudgetPercent() const override { return hedge_budget_percent_; }
 
   uint32_t initial_requests_{};
   envoy::type::v3::FractionalPercent additional_request_chance_{};
   bool hedge_on_per_try_timeout_{};
+  absl::optional<double> hedge_on_response_time_percentile_;
+  double hedge_budget_percent_{};
 };
 
 class TestRetryPolicy : public RetryPolicy {
@@ -253,6 +259,17 @@ public:
   std::vector<std::reference_wrapper<const Router::RateLimitPolicyEntry>> rate_limit_policy_entry_;
 };
 
+class MockShadowStream : public ShadowStream {
+public:
+  MockShadowStream();
+  ~MockShadowStream() override;
+
+  // Router::ShadowStream
+  MOCK_METHOD(void, sendData, (Buffer::Instance & data, bool end_stream));
+  MOCK_METHOD(void, sendTrailers, (const Http::RequestTrailerMap& trailers));
+  MOCK_METHOD(void, reset, ());
+};
+
 class MockShadowWriter : public ShadowWriter {
 public:
   MockShadowWriter();
@@ -263,10 +280,17 @@ public:
               const Http::AsyncClient::RequestOptions& options) override {
     shadow_(cluster, request, options);
   }
+  ShadowStream* streamingShadow(const std::string& cluster, Http::RequestHeaderMapPtr&& headers,
+                                const Http::AsyncClient::RequestOptions& options) override {
+    return streamingShadow_(cluster, headers, options);
+  }
 
   MOCK_METHOD(void, shadow_,
               (const std::string& cluster, Http::RequestMessagePtr& request,
                const Http::AsyncClient::RequestOptions& options));
+  MOCK_METHOD(ShadowStream*, streamingShadow_,
+              (const std::string& cluster, Http::RequestHeaderMapPtr& headers,
+               const Http::AsyncClient::RequestOptions& options));
 };
 
 class TestVirtualCluster : public VirtualCluster {
@@ -14,8 +14,10 @@ public:
   MockClusterUpdateCallbacks();
   ~MockClusterUpdateCallbacks() override;
 
-  MOCK_METHOD(void, onClusterAddOrUpdate, (ThreadLocalCluster & cluster));
+  MOCK_METHOD(void, onClusterAddOrUpdate,
+              (absl::string_view cluster_name, ThreadLocalClusterCommand& get_cluster));
   MOCK_METHOD(void, onClusterRemoval, (const std::string& cluster_name));
+  MOCK_METHOD(bool, tracksCluster, (absl::string_view cluster_name), (const));
 };
 } // namespace Upstream
 } // namespace Envoy
@@ -22,6 +22,7 @@ public:
                std::vector<uint8_t>& hash_key));
   MOCK_METHOD(OptRef<Envoy::Http::ConnectionPool::ConnectionLifetimeCallbacks>, lifetimeCallbacks,
               ());
+  MOCK_METHOD(OptRef<ResponseTimeCallbacks>, responseTimeCallbacks, ());
 
   std::shared_ptr<MockHost> host_{new MockHost()};
 };
@@ -1,13 +1,19 @@
 // Note: this should be run with --compilation_mode=opt, and would benefit from a
 // quiescent system with disabled cstate power management.
 
+#include <algorithm>
+#include <chrono>
+
 #include "source/common/buffer/buffer_impl.h"
 #include "source/common/http/header_map_impl.h"
+#include "source/common/memory/stats.h"
 #include "source/common/stats/custom_stat_namespaces_impl.h"
 #include "source/common/stats/thread_local_store.h"
+#include "source/server/admin/prometheus_stats.h"
 #include "source/server/admin/stats_handler.h"
 
 #include "test/test_common/test_runtime.h"
+#include "test/test_common/test_time.h"
 
 #include "benchmark/benchmark.h"
 
@@ -38,11 +44,7 @@ public:
    */
   uint64_t handlerStats(const StatsParams& params) {
     Buffer::OwnedImpl data;
-    if (params.format_ == Envoy::Server::StatsFormat::Prometheus) {
-      Envoy::Server::StatsHandler::prometheusRender(store_, custom_namespaces_, params, data);
-      return data.length();
-    }
-    Admin::RequestPtr request = StatsHandler::makeRequest(store_, params);
+    Admin::RequestPtr request = StatsHandler::makeRequest(store_, params, custom_namespaces_);
     auto response_headers = Http::ResponseHeaderMapImpl::create();
     request->start(*response_headers);
     uint64_t count = 0;
@@ -55,11 +57,65 @@ public:
     return count;
   }
 
+  /**
+   * Issues an admin request as handlerStats does, sampling the bytes allocated
+   * after each chunk, which is when the most response data is held. Memory
+   * is only accounted for in tcmalloc builds.
+   *
+   * @param params the request parameters.
+   * @param time_to_first_byte receives the time until the first chunk was rendered.
+   * @param peak_bytes receives the peak number of bytes allocated by the request.
+   * @return the number of bytes rendered.
+   */
+  uint64_t profileHandlerStats(const StatsParams& params,
+                               std::chrono::nanoseconds& time_to_first_byte,
+                               uint64_t& peak_bytes) {
+    const uint64_t initial_bytes = Memory::Stats::totalCurrentlyAllocated();
+    const MonotonicTime start_time = time_system_.monotonicTime();
+    Buffer::OwnedImpl data;
+    Admin::RequestPtr request = StatsHandler::makeRequest(store_, params, custom_namespaces_);
+    auto response_headers = Http::ResponseHeaderMapImpl::create();
+    request->start(*response_headers);
+    uint64_t count = 0;
+    uint64_t max_bytes = initial_bytes;
+    bool more = true;
+    do {
+      more = request->nextChunk(data);
+      if (count == 0) {
+        time_to_first_byte = time_system_.monotonicTime() - start_time;
+      }
+      max_bytes = std::max(max_bytes, Memory::Stats::totalCurrentlyAllocated());
+      count += data.length();
+      data.drain(data.length());
+    } while (more);
+    peak_bytes = max_bytes - initial_bytes;
+    return count;
+  }
+
+  /**
+   * Renders all stats as Prometheus into a single buffer, as the admin handler
+   * did before Prometheus output was streamed. Measured as profileHandlerStats.
+   */
+  uint64_t profileBufferedPrometheus(const StatsParams& params,
+                                     std::chrono::nanoseconds& time_to_first_byte,
+                                     uint64_t& peak_bytes) {
+    const uint64_t initial_bytes = Memory::Stats::totalCurrentlyAllocated();
+    const MonotonicTime start_time = time_system_.monotonicTime();
+    Buffer::OwnedImpl data;
+    PrometheusStatsFormatter::statsAsPrometheus(store_.counters(), store_.gauges(),
+                                                store_.histograms(), {}, data, params,
+                                                custom_namespaces_);
+    time_to_first_byte = time_system_.monotonicTime() - start_time;
+    peak_bytes = Memory::Stats::totalCurrentlyAllocated() - initial_bytes;
+    return data.length();
+  }
+
   Stats::SymbolTableImpl symbol_table_;
   Stats::AllocatorImpl alloc_;
   Stats::ThreadLocalStoreImpl store_;
   std::vector<Stats::ScopeSharedPtr> scopes_;
   Envoy::Stats::CustomStatNamespacesImpl custom_namespaces_;
+  Event::TestRealTimeSystem time_system_;
 };
 
 } // namespace Server
@@ -254,3 +310,37 @@ static void BM_Re2FilteredCountersPrometheus(benchmark::State& state) {
   }
 }
 BENCHMARK(BM_Re2FilteredCountersPrometheus)->Unit(benchmark::kMillisecond);
+
+// Compares the streamed Prometheus output with rendering it into one buffer,
+// reporting the time until the first bytes can be sent and the peak memory
+// held by the request.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_AllCountersPrometheusTimeToFirstByte(benchmark::State& state) {
+  Envoy::Server::StatsHandlerTest& test_context = testContext();
+  const bool buffered = state.range(0) != 0;
+  Envoy::Server::StatsParams params;
+  Envoy::Buffer::OwnedImpl response;
+  params.parse("?format=prometheus", response);
+
+  std::chrono::nanoseconds time_to_first_byte{0};
+  std::chrono::nanoseconds total_time_to_first_byte{0};
+  uint64_t peak_bytes = 0;
+  uint64_t max_peak_bytes = 0;
+  for (auto _ : state) { // NOLINT
+    uint64_t count =
+        buffered ? test_context.profileBufferedPrometheus(params, time_to_first_byte, peak_bytes)
+                 : test_context.profileHandlerStats(params, time_to_first_byte, peak_bytes);
+    RELEASE_ASSERT(count > 250 * 1000 * 1000, "expected count > 250M");
+    total_time_to_first_byte += time_to_first_byte;
+    max_peak_bytes = std::max(max_peak_bytes, peak_bytes);
+  }
+  state.SetLabel(buffered ? "buffered" : "streamed");
+  state.counters["time_to_first_byte_ms"] =
+      std::chrono::duration<double, std::milli>(total_time_to_first_byte).count() /
+      state.iterations();
+  state.counters["peak_bytes"] = max_peak_bytes;
+}
+BENCHMARK(BM_AllCountersPrometheusTimeToFirstByte)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
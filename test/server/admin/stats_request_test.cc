@@ -1,6 +1,7 @@
 #include <memory>
 
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/stats/custom_stat_namespaces_impl.h"
 #include "source/common/stats/thread_local_store.h"
 #include "source/server/admin/stats_request.h"
 
@@ -35,7 +36,7 @@ protected:
     params.used_only_ = used_only;
     params.type_ = type;
     params.format_ = format;
-    return std::make_unique<StatsRequest>(store_, params);
+    return std::make_unique<StatsRequest>(store_, params, custom_namespaces_);
   }
 
   // Executes a request, counting the chunks that were generated.
@@ -83,6 +84,7 @@ protected:
   NiceMock<Event::MockDispatcher> main_thread_dispatcher_;
   NiceMock<ThreadLocal::MockInstance> tls_;
   Stats::ThreadLocalStoreImpl store_;
+  Stats::CustomStatNamespacesImpl custom_namespaces_;
   Buffer::OwnedImpl response_;
 };
 
@@ -153,14 +155,66 @@ TEST_F(StatsRequestTest, OneStatJson) {
 }
 
 TEST_F(StatsRequestTest, OneStatPrometheus) {
-  // Currently the rendering infrastructure does not support Prometheus -- that
-  // gets rendered using a different code-path. This will be fixed at some
-  // point, to make Prometheus consume less resource, and when that occurs this
-  // test can exercise that.
   store_.rootScope()->counterFromStatName(makeStatName("foo"));
-  EXPECT_ENVOY_BUG(iterateChunks(*makeRequest(false, StatsFormat::Prometheus, StatsType::All), true,
-                                 Http::Code::BadRequest),
-                   "reached Prometheus case in switch unexpectedly");
+  EXPECT_EQ("# TYPE envoy_foo counter\nenvoy_foo{} 0\n",
+            response(*makeRequest(false, StatsFormat::Prometheus, StatsType::All)));
+}
+
+TEST_F(StatsRequestTest, PrometheusGroupsAcrossScopes) {
+  // Tag-extracted names don't follow the scope hierarchy, so stats held by
+  // different scopes can end up in the same group.
+  Stats::StatNameTagVector c1_tags{{makeStatName("cluster"), makeStatName("c1")}};
+  Stats::StatNameTagVector c2_tags{{makeStatName("cluster"), makeStatName("c2")}};
+  Stats::ScopeSharedPtr scope = store_.createScope("a");
+  store_.rootScope()->counterFromStatNameWithTags(makeStatName("a.x"), c2_tags).add(2);
+  scope->counterFromStatNameWithTags(makeStatName("x"), c1_tags).add(1);
+  store_.rootScope()->gaugeFromStatName(makeStatName("a.gauge"),
+                                        Stats::Gauge::ImportMode::Accumulate);
+
+  EXPECT_EQ("# TYPE envoy_a_x counter\n"
+            "envoy_a_x{cluster=\"c1\"} 1\n"
+            "envoy_a_x{cluster=\"c2\"} 2\n"
+            "# TYPE envoy_a_gauge gauge\n"
+            "envoy_a_gauge{} 0\n",
+            response(*makeRequest(false, StatsFormat::Prometheus, StatsType::All)));
+}
+
+TEST_F(StatsRequestTest, PrometheusSameNamedScopes) {
+  // Stats shared by same-named scopes are rendered once.
+  Stats::ScopeSharedPtr scope1 = store_.createScope("scope");
+  Stats::ScopeSharedPtr scope2 = store_.createScope("scope");
+  scope1->counterFromStatName(makeStatName("foo")).inc();
+  scope2->counterFromStatName(makeStatName("foo")).inc();
+  EXPECT_EQ("# TYPE envoy_scope_foo counter\nenvoy_scope_foo{} 2\n",
+            response(*makeRequest(false, StatsFormat::Prometheus, StatsType::All)));
+}
+
+TEST_F(StatsRequestTest, PrometheusUsedOnly) {
+  store_.rootScope()->counterFromStatName(makeStatName("foo"));
+  store_.rootScope()->counterFromStatName(makeStatName("bar")).inc();
+  EXPECT_EQ("# TYPE envoy_bar counter\nenvoy_bar{} 1\n",
+            response(*makeRequest(true, StatsFormat::Prometheus, StatsType::All)));
+}
+
+TEST_F(StatsRequestTest, PrometheusManyStatsSmallChunkSize) {
+  for (uint32_t i = 0; i < 100; ++i) {
+    store_.rootScope()->counterFromStatName(makeStatName(absl::StrCat("foo", i)));
+  }
+  std::unique_ptr<StatsRequest> request =
+      makeRequest(false, StatsFormat::Prometheus, StatsType::All);
+  request->setChunkSize(100);
+  // Each group renders as 41 or 43 bytes, so chunks end after 3 groups.
+  EXPECT_EQ(34, iterateChunks(*request));
+}
+
+TEST_F(StatsRequestTest, PrometheusManyStatsSmallChunkSizeNoDrain) {
+  for (uint32_t i = 0; i < 100; ++i) {
+    store_.rootScope()->counterFromStatName(makeStatName(absl::StrCat("foo", i)));
+  }
+  std::unique_ptr<StatsRequest> request =
+      makeRequest(false, StatsFormat::Prometheus, StatsType::All);
+  request->setChunkSize(100);
+  EXPECT_EQ(34, iterateChunks(*request, false));
 }
 
 } // namespace Server